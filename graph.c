@@ -5,6 +5,10 @@
  */
 
 #include "graph.h"
+#include "graph_symmetric.h"
+
+#define NOTHING -1
+#define MERGED_WEIGHT -1  // marks an edge that mergeSymmetricEdges drops
 
 /*********************************************************************
  ** Helper function provided in the starter code
@@ -29,6 +33,15 @@ void printEdgeList(EdgeList *head)
   printf("NULL");
 }
 
+/* Prints 'edge' as seen from its endpoint 'vertex'. */
+static void printEdgeFrom(Edge *edge, int vertex)
+{
+  if (edge == NULL)
+    printf("NULL");
+  else
+    printf("(%d -- %d, %d)", vertex, otherEndpoint(edge, vertex), edge->weight);
+}
+
 void printVertex(Vertex *vertex)
 {
   if (vertex == NULL)
@@ -38,7 +51,12 @@ void printVertex(Vertex *vertex)
   else
   {
     printf("%d: ", vertex->id);
-    printEdgeList(vertex->adjList);
+    for (EdgeList *cur = vertex->adjList; cur != NULL; cur = cur->next)
+    {
+      printEdgeFrom(cur->edge, vertex->id);
+      printf(" --> ");
+    }
+    printf("NULL");
   }
 }
 
@@ -156,16 +174,220 @@ void deleteVertex(Vertex *vertex)
   free(vertex);
 }
 
-/* Frees memory allocated for 'graph'.
+/* Frees the adjacency list 'head' of vertex 'id', and every Edge in it that
+ * 'id' is the 'fromVertex' of.
+ */
+static void deleteOwnedEdgeList(EdgeList *head, int id)
+{
+  EdgeList *tmp = NULL;
+  while (head != NULL)
+  {
+    tmp = head->next;
+    if (head->edge->fromVertex == id)
+    {
+      free(head->edge);
+    }
+    free(head);
+    head = tmp;
+  }
+}
+
+/* Frees memory allocated for 'graph'. An Edge is freed from the list of its
+ * 'fromVertex' only, so the shared edges of a symmetric graph (see
+ * graph_symmetric.h) are freed once. Their other endpoint is the larger one,
+ * and vertices are deleted in decreasing ID order, so its list is gone by
+ * then.
  */
 void deleteGraph(Graph *graph)
 {
-  for (int i = 0; i < graph->numVertices; i++)
+  for (int i = graph->numVertices - 1; i >= 0; i--)
   {
-    deleteVertex(graph->vertices[i]);
+    deleteOwnedEdgeList(graph->vertices[i]->adjList, i);
+    free(graph->vertices[i]);
   }
   free(graph->vertices);
 
   free(graph);
 }
 
+
+/*********************************************************************
+ ** Symmetric (undirected) graphs
+ *********************************************************************/
+
+/* Returns the endpoint of 'edge' that is not 'vertex' (or 'vertex' itself for
+ * a self-loop).
+ * Precondition: 'vertex' is an endpoint of 'edge'
+ */
+int otherEndpoint(Edge *edge, int vertex)
+{
+  return edge->fromVertex == vertex ? edge->toVertex : edge->fromVertex;
+}
+
+/* Returns true iff Graph 'graph' is symmetric. Only the first vertex with an
+ * edge to another vertex is looked at.
+ */
+bool isSymmetricGraph(Graph *graph)
+{
+  for (int u = 0; u < graph->numVertices; u++)
+  {
+    if (graph->vertices[u] == NULL)
+    {
+      continue;
+    }
+    for (EdgeList *cur = graph->vertices[u]->adjList; cur != NULL;
+         cur = cur->next)
+    {
+      Edge *edge = cur->edge;
+      int v = otherEndpoint(edge, u);
+      if (v == u)
+      {
+        continue;
+      }
+      if (edge->fromVertex != u)
+      {
+        return true;
+      }
+      // Shared iff the same Edge is in v's list too.
+      for (EdgeList *back = graph->vertices[v]->adjList; back != NULL;
+           back = back->next)
+      {
+        if (back->edge == edge)
+        {
+          return true;
+        }
+      }
+      return false;
+    }
+  }
+  return false;
+}
+
+/* Returns a newly created symmetric Graph with 'numVertices' vertices, all
+ * already present with empty adjacency lists.
+ * Precondition: numVertices >= 0
+ */
+Graph *newSymmetricGraph(int numVertices)
+{
+  Graph *res = newGraph(numVertices);
+  if (res == NULL)
+  {
+    return NULL;
+  }
+  for (int i = 0; i < numVertices; i++)
+  {
+    res->vertices[i] = newVertex(i, NULL, NULL);
+    if (res->vertices[i] == NULL)
+    {
+      res->numVertices = i;
+      deleteGraph(res);
+      return NULL;
+    }
+  }
+  return res;
+}
+
+/* Adds the undirected edge {'u', 'v'} with weight 'weight' to the symmetric
+ * Graph 'graph' and returns it, or NULL if memory could not be allocated.
+ * Parallel edges are kept.
+ * Precondition: 'graph' is symmetric; 0 <= u, v < graph->numVertices
+ */
+Edge *addSymmetricEdge(Graph *graph, int u, int v, int weight)
+{
+  int from = u < v ? u : v;
+  int to = u < v ? v : u;
+  Edge *edge = newEdge(from, to, weight);
+  EdgeList *fromHalf = newEdgeList(edge, graph->vertices[from]->adjList);
+  EdgeList *toHalf = from != to
+                         ? newEdgeList(edge, graph->vertices[to]->adjList)
+                         : NULL;
+  if (edge == NULL || fromHalf == NULL || (from != to && toHalf == NULL))
+  {
+    free(edge);
+    free(fromHalf);
+    free(toHalf);
+    return NULL;
+  }
+  graph->vertices[from]->adjList = fromHalf;
+  if (from != to)
+  {
+    graph->vertices[to]->adjList = toHalf;
+  }
+  graph->numEdges++;
+  return edge;
+}
+
+/* Merges the parallel edges of the symmetric Graph 'graph': of the edges
+ * with the same endpoints only the first found is kept, with the smallest of
+ * their weights. Returns false if memory could not be allocated.
+ * Precondition: no edge of 'graph' has a negative weight
+ */
+bool mergeSymmetricEdges(Graph *graph)
+{
+  int n = graph->numVertices;
+  Edge **kept = malloc(sizeof(Edge *) * (n > 0 ? n : 1));
+  int *keptBy = malloc(sizeof(int) * (n > 0 ? n : 1));
+  if (kept == NULL || keptBy == NULL)
+  {
+    free(kept);
+    free(keptBy);
+    return false;
+  }
+  for (int v = 0; v < n; v++)
+  {
+    keptBy[v] = NOTHING;
+  }
+
+  // Every edge is seen once, from its 'fromVertex' u; kept[v] is then the
+  // first edge {u, v} found, if keptBy[v] == u.
+  for (int u = 0; u < n; u++)
+  {
+    for (EdgeList *cur = graph->vertices[u]->adjList; cur != NULL;
+         cur = cur->next)
+    {
+      Edge *edge = cur->edge;
+      if (edge->fromVertex != u)
+      {
+        continue;
+      }
+      int v = edge->toVertex;
+      if (keptBy[v] != u)
+      {
+        keptBy[v] = u;
+        kept[v] = edge;
+        continue;
+      }
+      if (edge->weight < kept[v]->weight)
+      {
+        kept[v]->weight = edge->weight;
+      }
+      edge->weight = MERGED_WEIGHT;
+      graph->numEdges--;
+    }
+  }
+
+  // Unlink the merged edges, freeing each from its 'fromVertex''s list after
+  // the larger endpoint's list has let go of it, as in deleteGraph.
+  for (int u = n - 1; u >= 0; u--)
+  {
+    EdgeList **link = &graph->vertices[u]->adjList;
+    while (*link != NULL)
+    {
+      EdgeList *cur = *link;
+      if (cur->edge->weight != MERGED_WEIGHT)
+      {
+        link = &cur->next;
+        continue;
+      }
+      *link = cur->next;
+      if (cur->edge->fromVertex == u)
+      {
+        free(cur->edge);
+      }
+      free(cur);
+    }
+  }
+  free(kept);
+  free(keptBy);
+  return true;
+}
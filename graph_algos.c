@@ -5,9 +5,16 @@
  */
 
 #include <limits.h>
+#include <string.h>
 
 #include "graph.h"
+#include "graph_algos.h"
+#include "graph_algos_dense.h"
+#include "graph_algos_view.h"
+#include "graph_symmetric.h"
+#include "graph_view.h"
 #include "minheap.h"
+#include "minheap_build.h"
 
 #define NOTHING -1
 #define DEBUG 0
@@ -36,10 +43,16 @@ typedef struct records
 MinHeap *initHeap(Graph *graph, int startVertex)
 {
   MinHeap *res = newHeap(graph->numVertices);
+  int *ids = malloc(sizeof(int) * (graph->numVertices + 1));
+  int *priorities = malloc(sizeof(int) * (graph->numVertices + 1));
   for (int i = 0; i < graph->numVertices; i++)
   {
-    insert(res, INT_MAX, graph->vertices[i]->id);
+    ids[i] = graph->vertices[i]->id;
+    priorities[i] = INT_MAX;
   }
+  buildHeap(res, ids, priorities, graph->numVertices);
+  free(ids);
+  free(priorities);
   return res;
 }
 
@@ -140,12 +153,13 @@ void printRecords(Records *records)
 /*************************************************************************
  ** Required functions
  *************************************************************************/
-/* Runs Prim's algorithm on Graph 'graph' starting from vertex with ID
- * 'startVertex', and return the resulting MST: an array of Edges.
- * Returns NULL is 'startVertex' is not valid in 'graph'.
- * Precondition: 'graph' is connected.
+/* Runs Prim's algorithm with a MinHeap on 'graph', or, if
+ * 'view' is not NULL, on the part of it in 'view'. On a view the tree stops
+ * at the vertices that cannot be reached; the number of its edges is stored
+ * in 'numTreeEdges'.
  */
-Edge *getMSTprim(Graph *graph, int startVertex)
+static Edge *heapMST(Graph *graph, GraphView *view, int startVertex,
+                     int *numTreeEdges)
 {
   Edge *mstEdges = malloc(sizeof(Edge) * (graph->numVertices - 1));
   Records *records = initRecords(graph, startVertex);
@@ -154,6 +168,10 @@ Edge *getMSTprim(Graph *graph, int startVertex)
   {
     HeapNode minNode = extractMin(records->heap);
     int u = minNode.id;
+    if (view != NULL && minNode.priority == INT_MAX)
+    {
+      break;
+    }
     records->finished[u] = true;
     if (u != startVertex)
     {
@@ -163,16 +181,19 @@ Edge *getMSTprim(Graph *graph, int startVertex)
     EdgeList *adjList = graph->vertices[u]->adjList;
     while (adjList != NULL)
     {
-      int v = adjList->edge->toVertex;
+      int v = otherEndpoint(adjList->edge, u);
       int weight = adjList->edge->weight;
 
-      if (!records->finished[v] && decreasePriority(records->heap, v, weight))
+      if (!records->finished[v] &&
+          (view == NULL || viewHasEdge(view, adjList->edge, u)) &&
+          decreasePriority(records->heap, v, weight))
       {
         records->predecessors[v] = u;
       }
       adjList = adjList->next;
     }
   }
+  *numTreeEdges = records->numTreeEdges;
   // Clean
   deleteHeap(records->heap);
   free(records->tree);
@@ -183,12 +204,199 @@ Edge *getMSTprim(Graph *graph, int startVertex)
   return mstEdges;
 }
 
-/* Runs Dijkstra's algorithm on Graph 'graph' starting from vertex with ID
- * 'startVertex', and return the resulting distance tree: an array of edges.
- * Returns NULL if 'startVertex' is not valid in 'graph'.
+/* Runs Prim's algorithm on Graph 'graph' starting from vertex with ID
+ * 'startVertex', and return the resulting MST: an array of Edges.
+ * Returns NULL is 'startVertex' is not valid in 'graph'.
  * Precondition: 'graph' is connected.
  */
-Edge *getDistanceTreeDijkstra(Graph *graph, int startVertex)
+Edge *getMSTprim(Graph *graph, int startVertex)
+{
+  int numTreeEdges;
+  return heapMST(graph, NULL, startVertex, &numTreeEdges);
+}
+
+/* Runs Prim's algorithm with a MinHeap on the part of a graph in 'view',
+ * starting from vertex with ID 'startVertex', and returns the resulting
+ * minimum spanning tree of the vertices it can reach: an array of Edges as
+ * from getMSTprim, whose number is stored in 'numTreeEdges'.
+ * Returns NULL if 'startVertex' is not in 'view'.
+ */
+Edge *getMSTprimView(GraphView *view, int startVertex, int *numTreeEdges)
+{
+  if (!viewHasVertex(view, startVertex))
+  {
+    return NULL;
+  }
+  return heapMST(view->graph, view, startVertex, numTreeEdges);
+}
+
+/* Returns the index of the smallest of the 'n' keys in 'keys' (the first one
+ * if there are ties). Scans four keys at a time, keeping a running minimum
+ * and its index per lane.
+ * Precondition: n >= 1
+ */
+static int argminKey(int *keys, int n)
+{
+  int i = 0;
+  int best = 0;
+#if defined(__GNUC__)
+  typedef int IntVector __attribute__((vector_size(4 * sizeof(int))));
+  if (n >= 4)
+  {
+    IntVector minKeys;
+    IntVector minIdx = {0, 1, 2, 3};
+    IntVector idx = minIdx;
+    IntVector step = {4, 4, 4, 4};
+    memcpy(&minKeys, keys, sizeof(IntVector));
+    for (i = 4; i + 4 <= n; i += 4)
+    {
+      IntVector cur;
+      memcpy(&cur, keys + i, sizeof(IntVector));
+      idx += step;
+      IntVector less = cur < minKeys; // all ones where cur is smaller
+      minKeys = (cur & less) | (minKeys & ~less);
+      minIdx = (idx & less) | (minIdx & ~less);
+    }
+    best = minIdx[0];
+    for (int lane = 1; lane < 4; lane++)
+    {
+      if (minKeys[lane] < keys[best] ||
+          (minKeys[lane] == keys[best] && minIdx[lane] < best))
+      {
+        best = minIdx[lane];
+      }
+    }
+  }
+#endif
+  for (; i < n; i++)
+  {
+    if (keys[i] < keys[best])
+    {
+      best = i;
+    }
+  }
+  return best;
+}
+
+/* Picks the next vertex to add to the tree in the array-based Prim's
+ * algorithm: the closest one, or, if no vertex outside the tree is reachable,
+ * the first one outside the tree. Returns NOTHING if all vertices are in the
+ * tree.
+ */
+static int nextDenseVertex(int *keys, bool *inTree, int numVertices)
+{
+  int u = argminKey(keys, numVertices);
+  if (keys[u] < INT_MAX)
+  {
+    return u;
+  }
+  for (u = 0; u < numVertices; u++)
+  {
+    if (!inTree[u])
+    {
+      return u;
+    }
+  }
+  return NOTHING;
+}
+
+/* Runs the array-based Prim's algorithm shared by getMSTprimDense and
+ * getMSTprimMatrix, with edges taken from either 'graph' or 'weights'.
+ * Vertices in the tree keep the key INT_MAX, so the scan for the closest
+ * vertex needs no separate check for them.
+ */
+static Edge *denseMST(Graph *graph, int *weights, int numVertices,
+                      int startVertex)
+{
+  if (startVertex < 0 || startVertex >= numVertices)
+  {
+    return NULL;
+  }
+  Edge *mstEdges = malloc(sizeof(Edge) * (numVertices + 1));
+  int *keys = malloc(sizeof(int) * numVertices);
+  int *predecessors = malloc(sizeof(int) * numVertices);
+  bool *inTree = malloc(sizeof(bool) * numVertices);
+  for (int i = 0; i < numVertices; i++)
+  {
+    keys[i] = INT_MAX;
+    predecessors[i] = NOTHING;
+    inTree[i] = false;
+  }
+  keys[startVertex] = 0;
+
+  int numTreeEdges = 0;
+  int u = startVertex;
+  while (u != NOTHING)
+  {
+    int weight = keys[u];
+    inTree[u] = true;
+    keys[u] = INT_MAX;
+    if (u != startVertex)
+    {
+      addTreeeEdge(mstEdges, numTreeEdges++, predecessors[u], u, weight);
+    }
+
+    if (graph != NULL)
+    {
+      for (EdgeList *adjList = graph->vertices[u]->adjList; adjList != NULL;
+           adjList = adjList->next)
+      {
+        int v = otherEndpoint(adjList->edge, u);
+        if (!inTree[v] && adjList->edge->weight < keys[v])
+        {
+          keys[v] = adjList->edge->weight;
+          predecessors[v] = u;
+        }
+      }
+    }
+    else
+    {
+      int *row = weights + (long)u * numVertices;
+      for (int v = 0; v < numVertices; v++)
+      {
+        if (!inTree[v] && row[v] >= 0 && row[v] < keys[v])
+        {
+          keys[v] = row[v];
+          predecessors[v] = u;
+        }
+      }
+    }
+    u = nextDenseVertex(keys, inTree, numVertices);
+  }
+
+  free(keys);
+  free(predecessors);
+  free(inTree);
+  return mstEdges;
+}
+
+/* Same as getMSTprim, using an array of keys that is scanned for the
+ * closest vertex in every step: O(V^2 + E).
+ */
+Edge *getMSTprimDense(Graph *graph, int startVertex)
+{
+  return denseMST(graph, NULL, graph->numVertices, startVertex);
+}
+
+/* Runs the array-based Prim's algorithm of getMSTprimDense on the graph with
+ * 'numVertices' vertices given by the adjacency matrix 'weights', where
+ * weights[u * numVertices + v] is the weight of the edge from u to v, or
+ * negative if there is no such edge. Returns the resulting MST as an array of
+ * Edges, or NULL if 'startVertex' is not valid.
+ * Precondition: the graph is connected.
+ */
+Edge *getMSTprimMatrix(int *weights, int numVertices, int startVertex)
+{
+  return denseMST(NULL, weights, numVertices, startVertex);
+}
+
+/* Runs Dijkstra's algorithm with a MinHeap on 'graph', or, if 'view' is not
+ * NULL, on the part of it in 'view'. On a view the tree stops at the vertices
+ * that cannot be reached; the number of its entries is stored in
+ * 'numEntries'.
+ */
+static Edge *heapDistanceTree(Graph *graph, GraphView *view, int startVertex,
+                              int *numEntries)
 {
   Edge *distanceEdges = malloc(sizeof(Edge) * (graph->numVertices));
   Records *records = initRecords(graph, startVertex);
@@ -198,6 +406,10 @@ Edge *getDistanceTreeDijkstra(Graph *graph, int startVertex)
     HeapNode minNode = extractMin(records->heap);
     int u = minNode.id;
     int u_d = minNode.priority;
+    if (view != NULL && u_d == INT_MAX)
+    {
+      break;
+    }
     records->finished[u] = true;
     if (u != startVertex)
     {
@@ -207,15 +419,18 @@ Edge *getDistanceTreeDijkstra(Graph *graph, int startVertex)
     EdgeList *adjList = graph->vertices[u]->adjList;
     while (adjList != NULL)
     {
-      int v = adjList->edge->toVertex;
+      int v = otherEndpoint(adjList->edge, u);
       int weight = adjList->edge->weight;
-      if (!records->finished[v] && decreasePriority(records->heap, v, weight + u_d))
+      if (!records->finished[v] &&
+          (view == NULL || viewHasEdge(view, adjList->edge, u)) &&
+          decreasePriority(records->heap, v, weight + u_d))
       {
         records->predecessors[v] = u;
       }
       adjList = adjList->next;
     }
   }
+  *numEntries = records->numTreeEdges + 1;
   // just for test
   // printRecords(records);
   deleteHeap(records->heap);
@@ -226,6 +441,33 @@ Edge *getDistanceTreeDijkstra(Graph *graph, int startVertex)
   return distanceEdges;
 }
 
+/* Runs Dijkstra's algorithm on Graph 'graph' starting from vertex with ID
+ * 'startVertex', and return the resulting distance tree: an array of edges.
+ * Returns NULL if 'startVertex' is not valid in 'graph'.
+ * Precondition: 'graph' is connected.
+ */
+Edge *getDistanceTreeDijkstra(Graph *graph, int startVertex)
+{
+  int numEntries;
+  return heapDistanceTree(graph, NULL, startVertex, &numEntries);
+}
+
+/* Runs Dijkstra's algorithm with a MinHeap on the part of a graph in 'view',
+ * starting from vertex with ID 'startVertex', and returns the resulting
+ * distance tree of the vertices it can reach: an array of edges as from
+ * getDistanceTreeDijkstra, whose number is stored in 'numEntries'.
+ * Returns NULL if 'startVertex' is not in 'view'.
+ */
+Edge *getDistanceTreeDijkstraView(GraphView *view, int startVertex,
+                                  int *numEntries)
+{
+  if (!viewHasVertex(view, startVertex))
+  {
+    return NULL;
+  }
+  return heapDistanceTree(view->graph, view, startVertex, numEntries);
+}
+
 
 Edge* cloneEdge(Edge* originalEdge) {
     if (originalEdge == NULL) return NULL;
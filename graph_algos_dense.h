@@ -0,0 +1,41 @@
+/*
+ * Header file for Prim's algorithm on dense graphs.
+ *
+ * With E close to V^2 a heap costs O(V^2 log V). These versions keep the
+ * key of every vertex in an array and scan it for the closest vertex in
+ * every step, in O(V^2 + E) time. They find an MST of the same weight as
+ * getMSTprim (see graph_algos.h), but may list its edges in another order,
+ * so they are only used when asked for, e.g. by the planner (see
+ * graph_plan.h).
+ */
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "graph.h"
+
+#ifndef __Graph_Algos_Dense_header
+#define __Graph_Algos_Dense_header
+
+/* Graphs with at least this many vertices and at least this fraction of all
+ * possible edges are considered dense.
+ */
+#define DENSE_PRIM_MIN_VERTICES 64
+#define DENSE_PRIM_MIN_DENSITY 0.25
+
+/* Same as getMSTprim, using an array of keys that is scanned for the
+ * closest vertex in every step: O(V^2 + E), with a vectorized scan.
+ */
+Edge* getMSTprimDense(Graph* graph, int startVertex);
+
+/* Runs the array-based Prim's algorithm of getMSTprimDense on the graph with
+ * 'numVertices' vertices given by the adjacency matrix 'weights', where
+ * weights[u * numVertices + v] is the weight of the edge from u to v, or
+ * negative if there is no such edge. Returns the resulting MST as an array of
+ * Edges, or NULL if 'startVertex' is not valid.
+ * Precondition: the graph is connected.
+ */
+Edge* getMSTprimMatrix(int* weights, int numVertices, int startVertex);
+
+#endif
@@ -0,0 +1,35 @@
+/*
+ * Header file for Prim's and Dijkstra's algorithms on graph views (see
+ * graph_view.h): the same searches as getMSTprim and getDistanceTreeDijkstra
+ * (see graph_algos.h), over only the vertices and edges a view keeps.
+ */
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "graph.h"
+#include "graph_view.h"
+
+#ifndef __Graph_Algos_View_header
+#define __Graph_Algos_View_header
+
+/* Runs Prim's algorithm with a MinHeap on the part of a graph in 'view',
+ * starting from vertex with ID 'startVertex', and returns the resulting
+ * minimum spanning tree of the vertices it can reach: an array of Edges as
+ * from getMSTprim, whose number is stored in 'numTreeEdges'.
+ * Returns NULL if 'startVertex' is not in 'view'.
+ */
+Edge* getMSTprimView(GraphView* view, int startVertex, int* numTreeEdges);
+
+/* Runs Dijkstra's algorithm with a MinHeap on the part of a graph in 'view',
+ * starting from vertex with ID 'startVertex', and returns the resulting
+ * distance tree of the vertices it can reach: an array of edges as from
+ * getDistanceTreeDijkstra, whose number is stored in 'numEntries'. The graph
+ * itself need not be connected.
+ * Returns NULL if 'startVertex' is not in 'view'.
+ */
+Edge* getDistanceTreeDijkstraView(GraphView* view, int startVertex,
+                                  int* numEntries);
+
+#endif
@@ -0,0 +1,347 @@
+/*
+ * All-pairs shortest paths with the blocked Floyd-Warshall algorithm.
+ */
+
+#include <string.h>
+
+#include "graph_apsp.h"
+#include "graph_symmetric.h"
+#include "parallel.h"
+
+#define NOTHING -1
+#define FAR (INT_MAX / 2)  // "no path" while computing: FAR + FAR fits
+#define APSP_LANES 4       // ints per vector in the row kernels: SSE2
+
+typedef struct blocked
+{
+  DistanceMatrix *matrix;
+  int *edgeCounts;  // if the matrix has next hops: the number of edges of
+                    //   each path in it, FAR where there is none
+  int numTiles;   // tiles per row and column of the matrix
+  int pivot;      // the diagonal tile of the current round
+  bool crossing;  // true for the round on row and column 'pivot', false
+                  //   for the round on every other tile
+} Blocked;
+
+/* Sets c[j] to min(c[j], a + b[j]) for the APSP_TILE entries of a row of a
+ * tile, a vector at a time.
+ * Precondition: a < FAR, and every b[j] <= FAR
+ */
+static void minPlusRow(int *c, const int *b, int a)
+{
+#if defined(__GNUC__)
+  typedef int RowVector
+      __attribute__((vector_size(APSP_LANES * sizeof(int))));
+  for (int j = 0; j < APSP_TILE; j += APSP_LANES)
+  {
+    RowVector cv, bv;
+    memcpy(&cv, c + j, sizeof(RowVector));
+    memcpy(&bv, b + j, sizeof(RowVector));
+    RowVector sum = bv + a;
+    RowVector less = sum < cv;  // all ones where the path via k is shorter
+    cv = (sum & less) | (cv & ~less);
+    memcpy(c + j, &cv, sizeof(RowVector));
+  }
+#else
+  for (int j = 0; j < APSP_TILE; j++)
+  {
+    c[j] = a + b[j] < c[j] ? a + b[j] : c[j];
+  }
+#endif
+}
+
+/* Same as minPlusRow on paths ordered by length and then by number of edges
+ * ('counts', and 'aCount' for 'a'), and sets hops[j] to 'hop' wherever a
+ * path is replaced. Breaking ties this way makes every next hop lead to a
+ * path that is shorter or has fewer edges, so that following next hops
+ * cannot go round a cycle of edges of weight 0.
+ */
+static void minPlusRowHops(int *c, const int *b, int a, int *counts,
+                           const int *bCounts, int aCount, int *hops, int hop)
+{
+#if defined(__GNUC__)
+  typedef int RowVector
+      __attribute__((vector_size(APSP_LANES * sizeof(int))));
+  for (int j = 0; j < APSP_TILE; j += APSP_LANES)
+  {
+    RowVector cv, bv, nv, mv, hv;
+    memcpy(&cv, c + j, sizeof(RowVector));
+    memcpy(&bv, b + j, sizeof(RowVector));
+    memcpy(&nv, counts + j, sizeof(RowVector));
+    memcpy(&mv, bCounts + j, sizeof(RowVector));
+    memcpy(&hv, hops + j, sizeof(RowVector));
+    RowVector sum = bv + a;
+    RowVector count = mv + aCount;
+    RowVector less = (sum < cv) | ((sum == cv) & (count < nv));
+    cv = (sum & less) | (cv & ~less);
+    nv = (count & less) | (nv & ~less);
+    hv = (hop & less) | (hv & ~less);
+    memcpy(c + j, &cv, sizeof(RowVector));
+    memcpy(counts + j, &nv, sizeof(RowVector));
+    memcpy(hops + j, &hv, sizeof(RowVector));
+  }
+#else
+  for (int j = 0; j < APSP_TILE; j++)
+  {
+    if (a + b[j] < c[j] ||
+        (a + b[j] == c[j] && aCount + bCounts[j] < counts[j]))
+    {
+      c[j] = a + b[j];
+      counts[j] = aCount + bCounts[j];
+      hops[j] = hop;
+    }
+  }
+#endif
+}
+
+/* Relaxes every entry (i, j) of the tile at offset 'c' through the
+ * APSP_TILE vertices k of the pivot tile, in order:
+ * c[i][j] = min(c[i][j], a[i][k] + b[k][j]), with 'a' the tile in c's rows
+ * and the pivot's columns and 'b' the tile in the pivot's rows and c's
+ * columns. Tiles are APSP_TILE x APSP_TILE blocks of rows of the matrix,
+ * and may be the same tile: with k the outer loop, this is Floyd-Warshall
+ * on the tile. Next hops and edge counts are kept along if the matrix has
+ * them.
+ */
+static void relaxTile(Blocked *blocked, long c, long a, long b)
+{
+  int stride = blocked->matrix->stride;
+  int *distances = blocked->matrix->distances;
+  int *hops = blocked->matrix->nextHops;
+  int *counts = blocked->edgeCounts;
+  for (int k = 0; k < APSP_TILE; k++)
+  {
+    long bRow = b + (long)k * stride;
+    for (int i = 0; i < APSP_TILE; i++)
+    {
+      long row = (long)i * stride;
+      int aik = distances[a + row + k];
+      if (aik >= FAR)
+      {
+        continue;  // no path through k to improve on anything
+      }
+      if (hops == NULL)
+      {
+        minPlusRow(distances + c + row, distances + bRow, aik);
+      }
+      else
+      {
+        // The path to anything via k starts the way the path to k does.
+        minPlusRowHops(distances + c + row, distances + bRow, aik,
+                       counts + c + row, counts + bRow, counts[a + row + k],
+                       hops + c + row, hops[a + row + k]);
+      }
+    }
+  }
+}
+
+/* Returns the offset in the matrix of 'blocked' of tile ('row', 'column'). */
+static long tileOffset(Blocked *blocked, int row, int column)
+{
+  return ((long)row * blocked->matrix->stride + column) * APSP_TILE;
+}
+
+/* Relaxes tile ('row', 'column') of the matrix of 'blocked' through the
+ * pivot tile.
+ */
+static void relaxThroughPivot(Blocked *blocked, int row, int column)
+{
+  relaxTile(blocked, tileOffset(blocked, row, column),
+            tileOffset(blocked, row, blocked->pivot),
+            tileOffset(blocked, blocked->pivot, column));
+}
+
+/* Body of one thread of a round of getAllPairsFloydWarshall: relaxes its
+ * share of the tiles of the round.
+ */
+static void relaxRound(void *ctx, int thread, int numThreads)
+{
+  Blocked *blocked = ctx;
+  int others = blocked->numTiles - 1;
+  long numTiles = blocked->crossing ? 2L * others : (long)others * others;
+  long end = partStart(numTiles, thread + 1, numThreads);
+  for (long t = partStart(numTiles, thread, numThreads); t < end; t++)
+  {
+    // Tile t among the others of the round, skipping the pivot's index.
+    int first = t % others;
+    int second = blocked->crossing ? 0 : t / others;
+    first += first >= blocked->pivot;
+    second += second >= blocked->pivot;
+    if (!blocked->crossing)
+    {
+      relaxThroughPivot(blocked, second, first);
+    }
+    else if (t < others)
+    {
+      relaxThroughPivot(blocked, blocked->pivot, first);
+    }
+    else
+    {
+      relaxThroughPivot(blocked, first, blocked->pivot);
+    }
+  }
+}
+
+/* Returns a new matrix for 'graph' holding its edges: the weight of the
+ * lightest edge from u to v, 0 from u to itself, and FAR elsewhere. Returns
+ * NULL if memory could not be allocated.
+ */
+static DistanceMatrix *edgeMatrix(Graph *graph, bool withNextHops)
+{
+  DistanceMatrix *matrix = malloc(sizeof(DistanceMatrix));
+  if (matrix == NULL)
+  {
+    return NULL;
+  }
+  int n = graph->numVertices;
+  int stride = (n + APSP_TILE - 1) / APSP_TILE * APSP_TILE;
+  long size = (long)stride * stride;
+  matrix->numVertices = n;
+  matrix->stride = stride;
+  matrix->distances = malloc(sizeof(int) * (size > 0 ? size : 1));
+  matrix->nextHops =
+      withNextHops ? malloc(sizeof(int) * (size > 0 ? size : 1)) : NULL;
+  if (matrix->distances == NULL ||
+      (withNextHops && matrix->nextHops == NULL))
+  {
+    deleteDistanceMatrix(matrix);
+    return NULL;
+  }
+  for (long i = 0; i < size; i++)
+  {
+    matrix->distances[i] = FAR;
+  }
+  if (withNextHops)
+  {
+    memset(matrix->nextHops, 0xFF, sizeof(int) * size);  // all NOTHING
+  }
+
+  for (int u = 0; u < n; u++)
+  {
+    long row = (long)u * stride;
+    matrix->distances[row + u] = 0;
+    if (withNextHops)
+    {
+      matrix->nextHops[row + u] = u;
+    }
+    for (EdgeList *adjList = graph->vertices[u]->adjList; adjList != NULL;
+         adjList = adjList->next)
+    {
+      int v = otherEndpoint(adjList->edge, u);
+      int weight = adjList->edge->weight;
+      if (weight < matrix->distances[row + v])
+      {
+        matrix->distances[row + v] = weight;
+        if (withNextHops)
+        {
+          matrix->nextHops[row + v] = v;
+        }
+      }
+    }
+  }
+  return matrix;
+}
+
+/* Returns the number of edges of each path in 'matrix' as it comes from
+ * edgeMatrix: 0 from a vertex to itself, 1 along an edge, and FAR where
+ * there is no path. Returns NULL if memory could not be allocated.
+ */
+static int *edgeCounts(DistanceMatrix *matrix)
+{
+  long size = (long)matrix->stride * matrix->stride;
+  int *counts = malloc(sizeof(int) * (size > 0 ? size : 1));
+  for (long i = 0; counts != NULL && i < size; i++)
+  {
+    bool diagonal = i / matrix->stride == i % matrix->stride;
+    counts[i] = matrix->distances[i] >= FAR ? FAR : diagonal ? 0 : 1;
+  }
+  return counts;
+}
+
+/* Returns the distances between all pairs of vertices of Graph 'graph',
+ * computed with 'numThreads' threads (0 for the default), and with the next
+ * hops of shortest paths if 'withNextHops' is true.
+ * Returns NULL if memory could not be allocated.
+ * Precondition: every shortest path has a length below INT_MAX / 2
+ */
+DistanceMatrix *getAllPairsFloydWarshall(Graph *graph, bool withNextHops,
+                                         int numThreads)
+{
+  DistanceMatrix *matrix = edgeMatrix(graph, withNextHops);
+  if (matrix == NULL)
+  {
+    return NULL;
+  }
+  if (numThreads < 1)
+  {
+    numThreads = defaultThreadCount();
+  }
+
+  Blocked blocked;
+  blocked.matrix = matrix;
+  blocked.edgeCounts = NULL;
+  if (withNextHops && (blocked.edgeCounts = edgeCounts(matrix)) == NULL)
+  {
+    deleteDistanceMatrix(matrix);
+    return NULL;
+  }
+  blocked.numTiles = matrix->stride / APSP_TILE;
+  for (int pivot = 0; pivot < blocked.numTiles; pivot++)
+  {
+    blocked.pivot = pivot;
+    relaxThroughPivot(&blocked, pivot, pivot);
+    if (blocked.numTiles > 1)
+    {
+      blocked.crossing = true;
+      parallelRun(numThreads, relaxRound, &blocked);
+      blocked.crossing = false;
+      parallelRun(numThreads, relaxRound, &blocked);
+    }
+  }
+
+  free(blocked.edgeCounts);
+  long size = (long)matrix->stride * matrix->stride;
+  for (long i = 0; i < size; i++)
+  {
+    if (matrix->distances[i] >= FAR)
+    {
+      matrix->distances[i] = APSP_UNREACHABLE;
+    }
+  }
+  return matrix;
+}
+
+/* Stores a shortest path from 'source' to 'target' in 'path' and returns
+ * its number of vertices. Returns -1 if 'matrix' has no next hops, if
+ * either vertex is not valid, or if there is no path.
+ */
+int getMatrixPath(DistanceMatrix *matrix, int source, int target, int *path)
+{
+  int n = matrix->numVertices;
+  if (matrix->nextHops == NULL || source < 0 || source >= n || target < 0 ||
+      target >= n ||
+      matrix->nextHops[(long)source * matrix->stride + target] == NOTHING)
+  {
+    return NOTHING;
+  }
+  int length = 0;
+  path[length++] = source;
+  for (int u = source; u != target;)
+  {
+    u = matrix->nextHops[(long)u * matrix->stride + target];
+    path[length++] = u;
+  }
+  return length;
+}
+
+/* Frees all memory allocated for 'matrix'. */
+void deleteDistanceMatrix(DistanceMatrix *matrix)
+{
+  if (matrix == NULL)
+  {
+    return;
+  }
+  free(matrix->distances);
+  free(matrix->nextHops);
+  free(matrix);
+}
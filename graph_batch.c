@@ -0,0 +1,284 @@
+/*
+ * Batches of queries against one loaded graph.
+ */
+
+#include <limits.h>
+#include <pthread.h>
+#include <string.h>
+
+#include "graph_algos.h"
+#include "graph_batch.h"
+#include "graph_query.h"
+#include "parallel.h"
+
+#define NOTHING -1
+#define MAX_QUERY_LINE 256  // longest query line we read
+#define WINDOW 1024         // most answers held back waiting for their turn
+
+typedef struct answer
+{
+  char *text;     // the answer line
+  size_t length;  // its length in bytes
+  bool ready;     // false while the answer is being computed
+} Answer;
+
+typedef struct batch
+{
+  Graph *graph;
+  Query *queries;
+  long numQueries;
+  FILE *out;
+  long nextQuery;         // next query to hand out; claimed atomically
+  long nextAnswer;        // next answer to write
+  Answer window[WINDOW];  // answer i waits in window[i % WINDOW]
+  long numErrors;
+  pthread_mutex_t lock;   // guards nextAnswer, window and numErrors
+  pthread_cond_t moved;   // signalled whenever nextAnswer advances
+} Batch;
+
+/* Reads the queries in 'f' into a newly allocated array, stores their
+ * number in 'numQueries' and returns the array. Malformed lines become
+ * QUERY_ERROR entries.
+ * Returns NULL if memory runs out.
+ */
+Query *readQueries(FILE *f, long *numQueries)
+{
+  static const char *names[] = {NULL, "prim", "dijkstra", "dist", "path",
+                                "knn"};
+  static const int numArgs[] = {0, 1, 1, 2, 2, 2};
+  long capacity = 1024;
+  long count = 0;
+  Query *queries = malloc(sizeof(Query) * capacity);
+  char line[MAX_QUERY_LINE];
+  long lineNumber = 0;
+
+  while (queries != NULL && fgets(line, MAX_QUERY_LINE, f))
+  {
+    lineNumber++;
+    char name[16];
+    int args[2];
+    int numRead = sscanf(line, "%15s %d %d", name, &args[0], &args[1]);
+    if (numRead < 1 || name[0] == '#')
+    {
+      continue;
+    }
+    if (count == capacity)
+    {
+      capacity *= 2;
+      Query *grown = realloc(queries, sizeof(Query) * capacity);
+      if (grown == NULL)
+      {
+        free(queries);
+        return NULL;
+      }
+      queries = grown;
+    }
+
+    Query *query = &queries[count++];
+    query->type = QUERY_ERROR;
+    query->line = lineNumber;
+    for (int t = QUERY_PRIM; t <= QUERY_KNN; t++)
+    {
+      if (strcmp(name, names[t]) == 0 && numRead - 1 == numArgs[t])
+      {
+        query->type = t;
+        query->source = args[0];
+        query->target = numArgs[t] == 2 ? args[1] : NOTHING;
+      }
+    }
+  }
+  *numQueries = count;
+  return queries;
+}
+
+/* Writes the answer to 'query' on 'graph' to 'out', using 'workspace' and
+ * 'path' (room for numVertices IDs) as scratch space. Returns false iff the
+ * query names a vertex that is not in 'graph' or is malformed.
+ */
+static bool answerQuery(Graph *graph, Query *query, QueryWorkspace *workspace,
+                        int *path, FILE *out)
+{
+  int n = graph->numVertices;
+  int s = query->source;
+  int t = query->target;
+  if (query->type == QUERY_ERROR || s < 0 || s >= n ||
+      ((query->type == QUERY_DIST || query->type == QUERY_PATH) &&
+       (t < 0 || t >= n)) ||
+      (query->type == QUERY_KNN && t < 0))
+  {
+    fprintf(out, "error %ld\n", query->line);
+    return false;
+  }
+
+  switch (query->type)
+  {
+  case QUERY_PRIM:
+  {
+    Edge *mst = getMSTprim(graph, s);
+    long total = 0;
+    for (int i = 0; i < n - 1 && total >= 0; i++)
+    {
+      // Prim's leaves vertices it cannot reach at INT_MAX.
+      total = mst[i].weight == INT_MAX ? NOTHING : total + mst[i].weight;
+    }
+    free(mst);
+    fprintf(out, "prim %d %ld\n", s, total);
+    break;
+  }
+  case QUERY_DIJKSTRA:
+    getNearestDijkstra(graph, s, INT_MAX, INT_MAX, workspace);
+    fprintf(out, "dijkstra %d", s);
+    for (int v = 0; v < n; v++)
+    {
+      int d = workspace->distance[v];
+      fprintf(out, " %d", d == INT_MAX ? NOTHING : d);
+    }
+    fprintf(out, "\n");
+    break;
+  case QUERY_DIST:
+  case QUERY_PATH:
+  {
+    int d = getDistanceToDijkstra(graph, s, t, workspace);
+    fprintf(out, "%s %d %d %d", query->type == QUERY_DIST ? "dist" : "path",
+            s, t, d == INT_MAX ? NOTHING : d);
+    if (query->type == QUERY_PATH && d != INT_MAX)
+    {
+      int length = 0;
+      for (int v = t; v != NOTHING; v = workspace->predecessor[v])
+      {
+        path[length++] = v;
+      }
+      while (length > 0)
+      {
+        fprintf(out, " %d", path[--length]);
+      }
+    }
+    fprintf(out, "\n");
+    break;
+  }
+  case QUERY_KNN:
+  {
+    int numReached = getNearestDijkstra(graph, s, INT_MAX, t, workspace);
+    fprintf(out, "knn %d %d %d", s, t, numReached);
+    for (int i = 0; i < numReached; i++)
+    {
+      fprintf(out, " %d:%d", workspace->reached[i].vertex,
+              workspace->reached[i].distance);
+    }
+    fprintf(out, "\n");
+    break;
+  }
+  default:
+    break;
+  }
+  return true;
+}
+
+/* Hands 'text' in as the answer to query 'index' and writes out every answer
+ * that is now next in line.
+ */
+static void deliver(Batch *batch, long index, char *text, size_t length,
+                    bool ok)
+{
+  pthread_mutex_lock(&batch->lock);
+  batch->window[index % WINDOW].text = text;
+  batch->window[index % WINDOW].length = length;
+  batch->window[index % WINDOW].ready = true;
+  if (!ok)
+  {
+    batch->numErrors++;
+  }
+  bool moved = false;
+  Answer *next = &batch->window[batch->nextAnswer % WINDOW];
+  while (batch->nextAnswer < batch->numQueries && next->ready)
+  {
+    fwrite(next->text, 1, next->length, batch->out);
+    free(next->text);
+    next->ready = false;
+    batch->nextAnswer++;
+    next = &batch->window[batch->nextAnswer % WINDOW];
+    moved = true;
+  }
+  if (moved)
+  {
+    pthread_cond_broadcast(&batch->moved);
+  }
+  pthread_mutex_unlock(&batch->lock);
+}
+
+/* Body of one thread of runQueries: claims queries in order and answers
+ * them, waiting whenever it gets more than WINDOW ahead of the output.
+ */
+static void answerQueries(void *ctx, int thread, int numThreads)
+{
+  Batch *batch = ctx;
+  int n = batch->graph->numVertices;
+  QueryWorkspace *workspace = newQueryWorkspace(n);
+  int *path = malloc(sizeof(int) * (n + 1));
+
+  while (true)
+  {
+    long index = __atomic_fetch_add(&batch->nextQuery, 1, __ATOMIC_RELAXED);
+    if (index >= batch->numQueries)
+    {
+      break;
+    }
+    pthread_mutex_lock(&batch->lock);
+    while (index >= batch->nextAnswer + WINDOW)
+    {
+      pthread_cond_wait(&batch->moved, &batch->lock);
+    }
+    pthread_mutex_unlock(&batch->lock);
+
+    char *text = NULL;
+    size_t length = 0;
+    FILE *answer = open_memstream(&text, &length);
+    bool ok = false;
+    if (answer != NULL && workspace != NULL && path != NULL)
+    {
+      ok = answerQuery(batch->graph, &batch->queries[index], workspace, path,
+                       answer);
+    }
+    if (answer != NULL)
+    {
+      fclose(answer);
+    }
+    if (text == NULL)
+    {
+      length = 0;  // out of memory: the answer is lost, but not the rest
+      ok = false;
+    }
+    deliver(batch, index, text, length, ok);
+  }
+  deleteQueryWorkspace(workspace);
+  free(path);
+}
+
+/* Answers the 'numQueries' queries in 'queries' on Graph 'graph' with
+ * 'numThreads' threads, and writes their answers to 'out' in the order of
+ * the queries. Returns the number of queries answered without error.
+ * Precondition: numThreads >= 1
+ */
+long runQueries(Graph *graph, Query *queries, long numQueries, FILE *out,
+                int numThreads)
+{
+  Batch *batch = calloc(1, sizeof(Batch));
+  if (batch == NULL)
+  {
+    return 0;
+  }
+  batch->graph = graph;
+  batch->queries = queries;
+  batch->numQueries = numQueries;
+  batch->out = out;
+  pthread_mutex_init(&batch->lock, NULL);
+  pthread_cond_init(&batch->moved, NULL);
+
+  parallelRun(numThreads, answerQueries, batch);
+
+  long answered = numQueries - batch->numErrors;
+  pthread_mutex_destroy(&batch->lock);
+  pthread_cond_destroy(&batch->moved);
+  free(batch);
+  return answered;
+}
@@ -0,0 +1,64 @@
+/*
+ * Header file for running batches of queries against one loaded graph.
+ *
+ * A batch is a text file with one query per line:
+ *   prim s        weight of the MST found by Prim's algorithm from s
+ *   dijkstra s    distances from s to every vertex, in order of vertex ID
+ *   dist s t      distance from s to t
+ *   path s t      distance from s to t and a shortest path
+ *   knn s k       the k vertices nearest to s with their distances
+ * Blank lines and lines starting with '#' are skipped.
+ *
+ * Each query produces one line of output, starting with the query itself:
+ *   prim s <weight>
+ *   dijkstra s <d0> <d1> ... (-1 for unreachable vertices)
+ *   dist s t <distance>      (-1 if t is unreachable)
+ *   path s t <distance> s ... t   (just -1 if t is unreachable)
+ *   knn s k <n> v:d v:d ...
+ *   error <line number>      for a query that is malformed or names a
+ *                            vertex not in the graph
+ */
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "graph.h"
+
+#ifndef __Graph_Batch_header
+#define __Graph_Batch_header
+
+typedef enum query_type {
+  QUERY_ERROR,
+  QUERY_PRIM,
+  QUERY_DIJKSTRA,
+  QUERY_DIST,
+  QUERY_PATH,
+  QUERY_KNN
+} QueryType;
+
+typedef struct query {
+  QueryType type;
+  int source;  // start vertex
+  int target;  // target vertex for dist and path, k for knn
+  long line;   // line number in the batch file, for errors
+} Query;
+
+/* Reads the queries in 'f' into a newly allocated array, stores their
+ * number in 'numQueries' and returns the array. Malformed lines become
+ * QUERY_ERROR entries rather than stopping the read.
+ * Returns NULL if memory runs out.
+ */
+Query* readQueries(FILE* f, long* numQueries);
+
+/* Answers the 'numQueries' queries in 'queries' on Graph 'graph' with
+ * 'numThreads' threads, and writes their answers to 'out' in the order of
+ * the queries, as soon as every earlier answer has been written. At most a
+ * fixed window of answers is held in memory at any time.
+ * Returns the number of queries answered without error.
+ * Precondition: numThreads >= 1
+ */
+long runQueries(Graph* graph, Query* queries, long numQueries, FILE* out,
+                int numThreads);
+
+#endif
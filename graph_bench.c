@@ -0,0 +1,1395 @@
+/*
+ *  Benchmarks for our graph library.
+ *
+ *  ---------------------------------------------------------------------------
+ *   Compile:
+ *   gcc -O2 -Wall graph.c minheap.c pairing_heap.c rank_pairing_heap.c \
+ *       graph_algos.c graph_apsp.c graph_bfs.c graph_build.c \
+ *       graph_compact.c graph_io.c graph_labels.c graph_many.c \
+ *       graph_oracle.c graph_output.c graph_parallel.c graph_paths.c \
+ *       graph_plan.c graph_query.c graph_snapshot.c graph_view.c \
+ *       multiqueue.c parallel.c graph_bench.c -o bench -lpthread
+ *
+ *   Run:
+ *   ./bench heaps [scale]    binary vs. pairing vs. rank-pairing heap in
+ *                            Dijkstra's and Prim's algorithms, across graph
+ *                            densities; 'scale' (default 1) multiplies the
+ *                            graph sizes
+ *   ./bench server socket_path [clients] [requests]
+ *                            load test for a running ./graph_server: each of
+ *                            'clients' (default 8) connections sends
+ *                            'requests' (default 10000) random DIST queries
+ *                            and the latency percentiles are printed
+ *   ./bench table [vertices] [size]
+ *                            'size' x 'size' (default 64) distance tables
+ *                            vs. one full search per source, for depots and
+ *                            customers spread over a random graph and
+ *                            clustered in one part of it (default 100000
+ *                            vertices)
+ *   ./bench oracle [vertices] [k]
+ *                            build time, size, query time and stretch of a
+ *                            distance oracle (default 100000 vertices,
+ *                            k = 3), and a save/load round trip
+ *   ./bench labels [vertices]
+ *                            build time, label size and query latency of
+ *                            hub labels on a road-like grid with about
+ *                            'vertices' vertices (default 40000), checked
+ *                            against Dijkstra, and a save/load round trip
+ *   ./bench paths [vertices] [k]
+ *                            the 'k' (default 10) shortest loopless paths
+ *                            between random pairs on a road-like grid with
+ *                            about 'vertices' vertices (default 40000),
+ *                            checked, against one Dijkstra search
+ *   ./bench plan [vertices]  every shortest-path and spanning-tree engine
+ *                            of the planner on graphs of different shapes
+ *                            (default 200000 vertices), with the planner's
+ *                            choice marked
+ *   ./bench many [graphs]    small graphs one at a time vs. runManyGraphs
+ *                            (default 200000 graphs of 9 vertices)
+ *   ./bench apsp [vertices]  blocked Floyd-Warshall vs. Dijkstra's algorithm
+ *                            from every vertex, from sparse to complete
+ *                            graphs (default 1000 vertices)
+ *   ./bench multiqueue [vertices] [workers]
+ *                            parallel Dijkstra on a MultiQueue on 1, 2, 4,
+ *                            ... threads vs. a sequential search, with the
+ *                            work wasted on relaxed order, on a random
+ *                            graph and a grid (default 1000000 vertices,
+ *                            one worker per CPU)
+ *   ./bench compact [vertices]
+ *                            Dijkstra's and Prim's algorithms on a Graph
+ *                            vs. on compact copies in every layout, with
+ *                            their sizes (default 1000000 vertices)
+ *   ./bench sched [workers]  overhead of the work-stealing scheduler: tasks,
+ *                            parallel-for pieces and parallel runs, per
+ *                            operation, against plain loops and threads
+ *   ./bench snapshots [readers] [seconds]
+ *                            k-nearest queries on graph snapshots, first
+ *                            alone, then while a writer publishes new
+ *                            versions as fast as it can
+ *  ---------------------------------------------------------------------------
+ */
+
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "graph.h"
+#include "graph_algos.h"
+#include "graph_apsp.h"
+#include "graph_build.h"
+#include "graph_compact.h"
+#include "graph_io.h"
+#include "graph_labels.h"
+#include "graph_many.h"
+#include "graph_oracle.h"
+#include "graph_parallel.h"
+#include "graph_paths.h"
+#include "graph_plan.h"
+#include "graph_query.h"
+#include "graph_snapshot.h"
+#include "graph_symmetric.h"
+#include "minheap.h"
+#include "pairing_heap.h"
+#include "parallel.h"
+#include "rank_pairing_heap.h"
+
+/* Returns the time in seconds on a monotonic clock. */
+static double seconds(void) {
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return now.tv_sec + now.tv_nsec / 1e9;
+}
+
+/* Returns a new random undirected Graph with 'numVertices' vertices, about
+ * 'numEdges' edges with weights in [0, maxWeight), and a path through all
+ * vertices so that it is connected. Delete it with deleteBuiltGraph.
+ */
+static Graph* randomGraph(int numVertices, long numEdges, int maxWeight,
+                          unsigned seed) {
+  srand(seed);
+  long total = numEdges + numVertices;
+  Edge* edges = malloc(sizeof(Edge) * total);
+  long count = 0;
+  for (int v = 1; v < numVertices; v++) {
+    edges[count].fromVertex = v - 1;
+    edges[count].toVertex = v;
+    edges[count++].weight = rand() % maxWeight;
+  }
+  while (count < total) {
+    edges[count].fromVertex = rand() % numVertices;
+    edges[count].toVertex = rand() % numVertices;
+    edges[count++].weight = rand() % maxWeight;
+  }
+  BuildOptions options = defaultBuildOptions();
+  options.symmetrize = true;
+  options.mergeDuplicates = true;
+  Graph* graph = buildGraph(edges, count, numVertices, options);
+  free(edges);
+  return graph;
+}
+
+/***** heaps ***************************************************************/
+
+/* Defines dijkstra<NAME> and prim<NAME>, which run the algorithms the way
+ * graph_algos.c does (every vertex queued up front, one decrease per
+ * improving edge) on the heap type HEAP with the given operations. Both
+ * return a checksum: the sum of distances, or the weight of the MST.
+ */
+#define DEFINE_HEAP_ALGOS(NAME, HEAP, NEW, DELETE, INSERT, EXTRACT, DECREASE) \
+  static long dijkstra##NAME(Graph* graph, int source) {                      \
+    int n = graph->numVertices;                                               \
+    HEAP* heap = NEW(n);                                                      \
+    bool* finished = calloc(n, sizeof(bool));                                 \
+    for (int i = 0; i < n; i++) INSERT(heap, i == source ? 0 : INT_MAX, i);   \
+    long total = 0;                                                           \
+    while (heap->size > 0) {                                                  \
+      HeapNode min = EXTRACT(heap);                                           \
+      finished[min.id] = true;                                                \
+      total += min.priority;                                                  \
+      for (EdgeList* e = graph->vertices[min.id]->adjList; e; e = e->next) {  \
+        int v = otherEndpoint(e->edge, min.id);                               \
+        if (!finished[v]) DECREASE(heap, v, min.priority + e->edge->weight);  \
+      }                                                                       \
+    }                                                                         \
+    free(finished);                                                           \
+    DELETE(heap);                                                             \
+    return total;                                                             \
+  }                                                                           \
+  static long prim##NAME(Graph* graph, int source) {                          \
+    int n = graph->numVertices;                                               \
+    HEAP* heap = NEW(n);                                                      \
+    bool* finished = calloc(n, sizeof(bool));                                 \
+    for (int i = 0; i < n; i++) INSERT(heap, i == source ? 0 : INT_MAX, i);   \
+    long total = 0;                                                           \
+    while (heap->size > 0) {                                                  \
+      HeapNode min = EXTRACT(heap);                                           \
+      finished[min.id] = true;                                                \
+      total += min.priority;                                                  \
+      for (EdgeList* e = graph->vertices[min.id]->adjList; e; e = e->next) {  \
+        int v = otherEndpoint(e->edge, min.id);                               \
+        if (!finished[v]) DECREASE(heap, v, e->edge->weight);                 \
+      }                                                                       \
+    }                                                                         \
+    free(finished);                                                           \
+    DELETE(heap);                                                             \
+    return total;                                                             \
+  }
+
+DEFINE_HEAP_ALGOS(Binary, MinHeap, newHeap, deleteHeap, insert, extractMin,
+                  decreasePriority)
+DEFINE_HEAP_ALGOS(Pairing, PairingHeap, newPairingHeap, deletePairingHeap,
+                  pairingInsert, pairingExtractMin, pairingDecreasePriority)
+DEFINE_HEAP_ALGOS(RankPairing, RankPairingHeap, newRankPairingHeap,
+                  deleteRankPairingHeap, rankPairingInsert,
+                  rankPairingExtractMin, rankPairingDecreasePriority)
+
+typedef long (*HeapAlgo)(Graph* graph, int source);
+
+/* Runs 'algos' (one per heap) on 'graph', prints their times in a row
+ * labelled 'label', and checks that they agree.
+ */
+static void timeHeaps(Graph* graph, const char* label, HeapAlgo* algos) {
+  long first = 0;
+  printf("%-28s", label);
+  for (int h = 0; h < 3; h++) {
+    double start = seconds();
+    long checksum = algos[h](graph, 0);
+    printf("%14.1f", (seconds() - start) * 1000);
+    if (h == 0) first = checksum;
+    if (checksum != first) printf(" (MISMATCH)");
+  }
+  printf("\n");
+}
+
+/* Compares the binary, pairing and rank-pairing heaps in Dijkstra's and
+ * Prim's algorithms on random graphs from sparse to nearly complete.
+ */
+static int benchHeaps(int scale) {
+  // { vertices, average degree } from sparse to nearly complete
+  int configs[][2] = {
+      {200000, 4}, {100000, 16}, {50000, 64}, {10000, 512}, {3000, 2000}};
+  HeapAlgo dijkstras[] = {dijkstraBinary, dijkstraPairing,
+                          dijkstraRankPairing};
+  HeapAlgo prims[] = {primBinary, primPairing, primRankPairing};
+
+  printf("%-28s%14s%14s%14s\n", "graph (times in ms)", "binary", "pairing",
+         "rank-pairing");
+  for (size_t c = 0; c < sizeof(configs) / sizeof(configs[0]); c++) {
+    int numVertices = configs[c][0] * scale;
+    long numEdges = (long)numVertices * configs[c][1] / 2;
+    Graph* graph = randomGraph(numVertices, numEdges, 1000000, 42 + c);
+    if (graph == NULL) {
+      printf("Could not create a graph with %d vertices.\n", numVertices);
+      return 1;
+    }
+    char label[64];
+    snprintf(label, sizeof(label), "V=%d deg=%d dijkstra", numVertices,
+             configs[c][1]);
+    timeHeaps(graph, label, dijkstras);
+    snprintf(label, sizeof(label), "V=%d deg=%d prim", numVertices,
+             configs[c][1]);
+    timeHeaps(graph, label, prims);
+    deleteBuiltGraph(graph);
+  }
+  return 0;
+}
+
+/***** server **************************************************************/
+
+typedef struct load {
+  const char* socketPath;  // where ./graph_server listens
+  int numVertices;         // queries use vertices 0 .. numVertices-1
+  int numRequests;         // requests per client
+  double* latency;         // latency[c * numRequests + i]: in microseconds
+  int failures;            // clients that could not finish
+} Load;
+
+/* Returns a stream connected to the Unix domain socket at 'path', or NULL. */
+static FILE* connectTo(const char* path) {
+  struct sockaddr_un address;
+  memset(&address, 0, sizeof(address));
+  address.sun_family = AF_UNIX;
+  strncpy(address.sun_path, path, sizeof(address.sun_path) - 1);
+  int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (fd < 0) return NULL;
+  if (connect(fd, (struct sockaddr*)&address, sizeof(address)) != 0) {
+    close(fd);
+    return NULL;
+  }
+  return fdopen(fd, "r+");
+}
+
+/* One client of the load test: sends its requests one at a time and records
+ * how long each answer took.
+ */
+static void runClient(void* ctx, int client, int numClients) {
+  Load* load = ctx;
+  FILE* server = connectTo(load->socketPath);
+  if (server == NULL) {
+    __atomic_fetch_add(&load->failures, 1, __ATOMIC_RELAXED);
+    return;
+  }
+  unsigned seed = 7 + client;
+  char response[1 << 16];
+  double* latency = &load->latency[(long)client * load->numRequests];
+  for (int i = 0; i < load->numRequests; i++) {
+    double start = seconds();
+    fprintf(server, "DIST %d %d\n", rand_r(&seed) % load->numVertices,
+            rand_r(&seed) % load->numVertices);
+    fflush(server);
+    if (!fgets(response, sizeof(response), server)) {
+      __atomic_fetch_add(&load->failures, 1, __ATOMIC_RELAXED);
+      break;
+    }
+    latency[i] = (seconds() - start) * 1e6;
+  }
+  fprintf(server, "QUIT\n");
+  fclose(server);
+}
+
+static int compareDoubles(const void* a, const void* b) {
+  double x = *(const double*)a, y = *(const double*)b;
+  return (x > y) - (x < y);
+}
+
+/* Load-tests the ./graph_server listening at 'socketPath' with 'numClients'
+ * concurrent connections of 'numRequests' requests each.
+ */
+static int benchServer(const char* socketPath, int numClients,
+                       int numRequests) {
+  FILE* server = connectTo(socketPath);
+  char info[256];
+  Load load = {socketPath, 0, numRequests, NULL, 0};
+  if (server == NULL || fprintf(server, "INFO\n") < 0 || fflush(server) ||
+      !fgets(info, sizeof(info), server) ||
+      sscanf(info, "vertices %d", &load.numVertices) != 1 ||
+      load.numVertices < 1) {
+    printf("Could not get graph information from %s.\n", socketPath);
+    if (server != NULL) fclose(server);
+    return 1;
+  }
+  fclose(server);
+
+  long total = (long)numClients * numRequests;
+  load.latency = calloc(total, sizeof(double));
+  double start = seconds();
+  runThreads(numClients, runClient, &load);
+  double elapsed = seconds() - start;
+  if (load.failures > 0) {
+    printf("%d clients failed.\n", load.failures);
+    free(load.latency);
+    return 1;
+  }
+
+  qsort(load.latency, total, sizeof(double), compareDoubles);
+  printf("%ld requests from %d clients in %.2f s: %.0f requests/s\n", total,
+         numClients, elapsed, total / elapsed);
+  printf("latency (us): p50 %.1f  p99 %.1f  p999 %.1f  max %.1f\n",
+         load.latency[total / 2], load.latency[total * 99 / 100],
+         load.latency[total * 999 / 1000], load.latency[total - 1]);
+  free(load.latency);
+  return 0;
+}
+
+/***** scheduler ***********************************************************/
+
+/* Returns the n-th Fibonacci number, the slow way. */
+static long fib(int n) { return n < 2 ? n : fib(n - 1) + fib(n - 2); }
+
+typedef struct fib_task {
+  int n;
+  long result;
+} FibTask;
+
+/* Computes the Fibonacci number of ((FibTask*)arg)->n with one task per
+ * call, as a worst case for scheduling overhead.
+ */
+static void fibTask(void* arg) {
+  FibTask* job = arg;
+  if (job->n < 2) {
+    job->result = job->n;
+    return;
+  }
+  FibTask left = {job->n - 1, 0};
+  FibTask right = {job->n - 2, 0};
+  TaskGroup group = {0};
+  Task task;
+  spawnTask(&task, &group, fibTask, &left);
+  fibTask(&right);
+  waitTasks(&group);
+  job->result = left.result + right.result;
+}
+
+/* parallelFor body: adds up the squares of the indices in the range. */
+static void sumSquares(void* ctx, long begin, long end) {
+  long sum = 0;
+  for (long i = begin; i < end; i++) sum += i * i % 7;
+  __atomic_fetch_add((long*)ctx, sum, __ATOMIC_RELAXED);
+}
+
+/* parallelRun / runThreads body that does nothing. */
+static void doNothing(void* ctx, int thread, int numThreads) {}
+
+/* Measures what the scheduler costs per task, per parallelFor piece and per
+ * parallelRun, with 'numWorkers' workers.
+ */
+static int benchScheduler(int numWorkers) {
+  configureScheduler(numWorkers, false);
+  numWorkers = defaultThreadCount();
+  printf("%d workers\n", numWorkers);
+
+  int n = 27;
+  double start = seconds();
+  long expected = fib(n);
+  double plain = seconds() - start;
+  FibTask job = {n, 0};
+  start = seconds();
+  fibTask(&job);
+  double tasked = seconds() - start;
+  double numTasks = 2.0 * expected;  // fib(n) leaves, as many inner calls
+  printf("fork/join fib(%d): %.3f s plain, %.3f s with a task per call: "
+         "%.0f ns per task%s\n", n, plain, tasked,
+         (tasked - plain) / numTasks * 1e9,
+         job.result == expected ? "" : " (WRONG RESULT)");
+
+  long length = 100000000;
+  for (long grain = 1 << 20; grain >= 256; grain /= 16) {
+    long sum = 0;
+    start = seconds();
+    sumSquares(&sum, 0, length);
+    plain = seconds() - start;
+    long parallelSum = 0;
+    start = seconds();
+    parallelFor(0, length, grain, sumSquares, &parallelSum);
+    double parallel = seconds() - start;
+    printf("parallelFor over %ld, grain %7ld: %.3f s plain, %.3f s "
+           "parallel%s\n", length, grain, plain, parallel,
+           parallelSum == sum ? "" : " (WRONG RESULT)");
+  }
+
+  int rounds = 20000;
+  start = seconds();
+  for (int r = 0; r < rounds; r++) parallelRun(numWorkers, doNothing, NULL);
+  double pooled = (seconds() - start) / rounds;
+  int threadRounds = 500;
+  start = seconds();
+  for (int r = 0; r < threadRounds; r++) {
+    runThreads(numWorkers, doNothing, NULL);
+  }
+  double spawned = (seconds() - start) / threadRounds;
+  printf("empty parallelRun of %d parts: %.2f us; with new threads: %.2f us\n",
+         numWorkers, pooled * 1e6, spawned * 1e6);
+  return 0;
+}
+
+/***** snapshots ***********************************************************/
+
+typedef struct snapshot_load {
+  GraphSnapshots* snapshots;
+  double duration;  // seconds each phase runs for
+  bool writing;     // true iff thread 0 publishes versions
+  long reads;       // queries answered by all readers
+  long versions;    // versions published
+} SnapshotLoad;
+
+/* Thread 0 publishes versions of 100 random reweights each, if asked to;
+ * the other threads run k-nearest queries on pinned snapshots.
+ */
+static void runSnapshotThread(void* ctx, int thread, int numThreads) {
+  SnapshotLoad* load = ctx;
+  unsigned seed = 11 + thread;
+  double end = seconds() + load->duration;
+  if (thread == 0) {
+    while (load->writing && seconds() < end) {
+      GraphDraft draft;
+      if (!beginDraft(load->snapshots, &draft)) break;
+      Graph* graph = pinSnapshot(load->snapshots, 0);
+      int n = graph->numVertices;
+      unpinSnapshot(load->snapshots, 0);
+      for (int i = 0; i < 100; i++) {
+        draftSetEdge(&draft, rand_r(&seed) % n, rand_r(&seed) % n,
+                     rand_r(&seed) % 1000000);
+      }
+      publishDraft(&draft);
+      load->versions++;
+    }
+    return;
+  }
+  int reader = registerSnapshotReader(load->snapshots);
+  Graph* graph = pinSnapshot(load->snapshots, reader);
+  int n = graph->numVertices;
+  unpinSnapshot(load->snapshots, reader);
+  QueryWorkspace* workspace = newQueryWorkspace(n);
+  long reads = 0;
+  while (seconds() < end) {
+    graph = pinSnapshot(load->snapshots, reader);
+    getNearestDijkstra(graph, rand_r(&seed) % n, INT_MAX, 1000, workspace);
+    unpinSnapshot(load->snapshots, reader);
+    reads++;
+  }
+  deleteQueryWorkspace(workspace);
+  unregisterSnapshotReader(load->snapshots, reader);
+  __atomic_fetch_add(&load->reads, reads, __ATOMIC_RELAXED);
+}
+
+/* Measures read throughput on snapshots of a random graph with and without
+ * a writer publishing versions concurrently.
+ */
+static int benchSnapshots(int numReaders, double duration) {
+  Graph* graph = randomGraph(200000, 800000, 1000000, 7);
+  GraphSnapshots* snapshots =
+      graph == NULL ? NULL : newGraphSnapshots(graph, deleteBuiltGraph);
+  if (snapshots == NULL) {
+    printf("Could not create the graph.\n");
+    return 1;
+  }
+  // Reader 0 is the writer's, for looking up the graph size.
+  registerSnapshotReader(snapshots);
+  for (int writing = 0; writing <= 1; writing++) {
+    SnapshotLoad load = {snapshots, duration, writing, 0, 0};
+    runThreads(numReaders + 1, runSnapshotThread, &load);
+    printf("%-16s %10.0f reads/s  %8.0f versions/s  %d versions waiting\n",
+           writing ? "with writer:" : "readers only:", load.reads / duration,
+           load.versions / duration, reclaimSnapshots(snapshots));
+  }
+  deleteGraphSnapshots(snapshots);
+  return 0;
+}
+
+/***** distance tables ***************************************************/
+
+/* Times getDistanceTable for 'size' sources and 'size' targets drawn from
+ * 'pool', against one unbounded search per source, and checks that they
+ * agree.
+ */
+static void benchTableOn(Graph* graph, const char* name, int* pool,
+                         int poolSize, int size, QueryWorkspace* workspace) {
+  int* sources = malloc(sizeof(int) * size);
+  int* targets = malloc(sizeof(int) * size);
+  int64_t* table = malloc(sizeof(int64_t) * size * size);
+  int64_t* expected = malloc(sizeof(int64_t) * size * size);
+  if (!sources || !targets || !table || !expected) {
+    printf("Out of memory.\n");
+    exit(1);
+  }
+  for (int i = 0; i < size; i++) {
+    sources[i] = pool[rand() % poolSize];
+    targets[i] = pool[rand() % poolSize];
+  }
+
+  double start = seconds();
+  for (int i = 0; i < size; i++) {
+    getNearestDijkstra(graph, sources[i], INT_MAX, INT_MAX, workspace);
+    for (int j = 0; j < size; j++) {
+      int d = workspace->distance[targets[j]];
+      expected[i * size + j] = d == INT_MAX ? TABLE_UNREACHABLE : d;
+    }
+  }
+  double trees = seconds() - start;
+
+  start = seconds();
+  bool ok = getDistanceTable(graph, sources, size, targets, size, table, 1);
+  double alone = seconds() - start;
+  bool same =
+      ok && memcmp(table, expected, sizeof(int64_t) * size * size) == 0;
+  start = seconds();
+  getDistanceTable(graph, sources, size, targets, size, table, 0);
+  double parallel = seconds() - start;
+
+  printf("%-10s full searches %7.3f s   table %7.3f s (x%.1f)   "
+         "%d threads %7.3f s%s\n",
+         name, trees, alone, trees / alone, defaultThreadCount(), parallel,
+         same ? "" : "  MISMATCH");
+  free(sources);
+  free(targets);
+  free(table);
+  free(expected);
+}
+
+/* Runs benchTableOn on a random graph with 'numVertices' vertices, with the
+ * vertices drawn from all of the graph and from the numVertices/100
+ * vertices nearest to one vertex.
+ */
+static int benchTable(int numVertices, int size) {
+  Graph* graph = randomGraph(numVertices, 4L * numVertices, 1000000, 11);
+  QueryWorkspace* workspace = newQueryWorkspace(numVertices);
+  int* everywhere = malloc(sizeof(int) * numVertices);
+  int* cluster = malloc(sizeof(int) * numVertices);
+  if (graph == NULL || workspace == NULL || !everywhere || !cluster) {
+    printf("Could not create the graph.\n");
+    return 1;
+  }
+  for (int v = 0; v < numVertices; v++) everywhere[v] = v;
+  int clusterSize = getNearestDijkstra(graph, 0, INT_MAX,
+                                       numVertices / 100 + 1, workspace);
+  for (int i = 0; i < clusterSize; i++) {
+    cluster[i] = workspace->reached[i].vertex;
+  }
+
+  srand(13);
+  printf("V=%d, %d x %d tables\n", numVertices, size, size);
+  benchTableOn(graph, "spread:", everywhere, numVertices, size, workspace);
+  benchTableOn(graph, "clustered:", cluster, clusterSize, size, workspace);
+  free(everywhere);
+  free(cluster);
+  deleteQueryWorkspace(workspace);
+  deleteBuiltGraph(graph);
+  return 0;
+}
+
+/***** distance oracles **************************************************/
+
+/* Builds a distance oracle with parameter 'k' for a random graph with
+ * 'numVertices' vertices, and measures it against exact searches.
+ */
+static int benchOracle(int numVertices, int k) {
+  Graph* graph = randomGraph(numVertices, 4L * numVertices, 1000000, 17);
+  QueryWorkspace* workspace = newQueryWorkspace(numVertices);
+  if (graph == NULL || workspace == NULL) {
+    printf("Could not create the graph.\n");
+    return 1;
+  }
+  double start = seconds();
+  DistanceOracle* oracle = newDistanceOracle(graph, k, 1, 0);
+  double build = seconds() - start;
+  if (oracle == NULL) {
+    printf("Could not build the oracle.\n");
+    return 1;
+  }
+  printf("V=%d, k=%d: built in %.2f s with %d threads, %.1f MB, "
+         "%.1f bunch entries per vertex\n",
+         numVertices, k, build, defaultThreadCount(),
+         getOracleSize(oracle) / 1e6, (double)oracle->numEntries / numVertices);
+
+  int numQueries = 1000000;
+  srand(19);
+  int64_t sum = 0;
+  start = seconds();
+  for (int q = 0; q < numQueries; q++) {
+    sum += getOracleDistance(oracle, rand() % numVertices,
+                             rand() % numVertices);
+  }
+  double queries = seconds() - start;
+  printf("queries: %.2f us each (checksum %lld)\n", queries / numQueries * 1e6,
+         (long long)sum);
+
+  int numChecked = 200;
+  double totalStretch = 0, maxStretch = 1;
+  bool bounded = true;
+  for (int q = 0; q < numChecked; q++) {
+    int u = rand() % numVertices;
+    int v = rand() % numVertices;
+    int exact = getDistanceToDijkstra(graph, u, v, workspace);
+    int64_t estimate = getOracleDistance(oracle, u, v);
+    double stretch = exact > 0 ? (double)estimate / exact : 1;
+    bounded = bounded && estimate >= exact &&
+              estimate <= (int64_t)(2 * k - 1) * exact;
+    totalStretch += stretch;
+    if (stretch > maxStretch) maxStretch = stretch;
+  }
+  printf("stretch over %d queries: average %.3f, max %.3f (bound %d)%s\n",
+         numChecked, totalStretch / numChecked, maxStretch, 2 * k - 1,
+         bounded ? "" : "  OUT OF BOUNDS");
+
+  FILE* f = tmpfile();
+  bool saved = f != NULL && saveOracle(oracle, f);
+  DistanceOracle* loaded = NULL;
+  if (saved) {
+    rewind(f);
+    loaded = loadOracle(f);
+  }
+  bool same = loaded != NULL;
+  for (int q = 0; same && q < 10000; q++) {
+    int u = rand() % numVertices;
+    int v = rand() % numVertices;
+    same = getOracleDistance(oracle, u, v) == getOracleDistance(loaded, u, v);
+  }
+  printf("save/load: %s\n", same ? "same answers" : "FAILED");
+
+  if (f != NULL) fclose(f);
+  deleteDistanceOracle(loaded);
+  deleteDistanceOracle(oracle);
+  deleteQueryWorkspace(workspace);
+  deleteBuiltGraph(graph);
+  return 0;
+}
+
+/***** hub labels ********************************************************/
+
+/* Returns a 'side' x 'side' grid with weights in [1, 100], with one in
+ * eight edges missing, as a stand-in for a road network. Delete it with
+ * deleteBuiltGraph.
+ */
+static Graph* gridGraph(int side, unsigned seed) {
+  srand(seed);
+  Edge* edges = malloc(sizeof(Edge) * 2L * side * side);
+  long count = 0;
+  for (int row = 0; row < side; row++) {
+    for (int col = 0; col < side; col++) {
+      int v = row * side + col;
+      if (col + 1 < side && rand() % 8 != 0) {
+        edges[count++] = (Edge){v, v + 1, 1 + rand() % 100};
+      }
+      if (row + 1 < side && rand() % 8 != 0) {
+        edges[count++] = (Edge){v, v + side, 1 + rand() % 100};
+      }
+    }
+  }
+  BuildOptions options = defaultBuildOptions();
+  options.symmetrize = true;
+  Graph* graph = buildGraph(edges, count, side * side, options);
+  free(edges);
+  return graph;
+}
+
+/* Builds hub labels for a grid with about 'numVertices' vertices and
+ * measures them against Dijkstra's algorithm.
+ */
+static int benchLabels(int numVertices) {
+  int side = 1;
+  while ((side + 1) * (side + 1) <= numVertices) side++;
+  numVertices = side * side;
+  Graph* graph = gridGraph(side, 23);
+  QueryWorkspace* workspace = newQueryWorkspace(numVertices);
+  if (graph == NULL || workspace == NULL) {
+    printf("Could not create the graph.\n");
+    return 1;
+  }
+  double start = seconds();
+  HubLabels* labels = newHubLabels(graph);
+  double build = seconds() - start;
+  if (labels == NULL) {
+    printf("Could not build the labels.\n");
+    return 1;
+  }
+  printf("%d x %d grid: built in %.2f s, %.1f MB, %.1f hubs per label\n",
+         side, side, build, getHubLabelsSize(labels) / 1e6,
+         (double)labels->numEntries / numVertices);
+
+  int numQueries = 1000000;
+  srand(29);
+  long sum = 0;
+  start = seconds();
+  for (int q = 0; q < numQueries; q++) {
+    sum += getLabelDistance(labels, rand() % numVertices,
+                            rand() % numVertices);
+  }
+  double queries = seconds() - start;
+  int numChecked = 200;
+  start = seconds();
+  bool exact = true;
+  for (int q = 0; q < numChecked; q++) {
+    int s = rand() % numVertices;
+    int t = rand() % numVertices;
+    exact = exact && getDistanceToDijkstra(graph, s, t, workspace) ==
+                         getLabelDistance(labels, s, t);
+  }
+  double dijkstra = seconds() - start;
+  printf("queries: %.2f us each (checksum %ld), Dijkstra %.0f us each, "
+         "%s\n",
+         queries / numQueries * 1e6, sum, dijkstra / numChecked * 1e6,
+         exact ? "exact" : "WRONG DISTANCES");
+
+  FILE* f = tmpfile();
+  HubLabels* loaded = NULL;
+  if (f != NULL && saveHubLabels(labels, f)) {
+    rewind(f);
+    loaded = loadHubLabels(f);
+  }
+  bool same = loaded != NULL;
+  for (int q = 0; same && q < 10000; q++) {
+    int s = rand() % numVertices;
+    int t = rand() % numVertices;
+    same = getLabelDistance(labels, s, t) == getLabelDistance(loaded, s, t);
+  }
+  printf("save/load: %s\n", same ? "same answers" : "FAILED");
+
+  if (f != NULL) fclose(f);
+  deleteHubLabels(loaded);
+  deleteHubLabels(labels);
+  deleteQueryWorkspace(workspace);
+  deleteBuiltGraph(graph);
+  return 0;
+}
+
+/***** alternative routes ************************************************/
+
+/* Returns true iff 'route' is a loopless path in 'graph' from 'source' to
+ * 'target' whose edges add up to its distance; 'seen' holds graph->
+ * numVertices bools, all false, and is left that way.
+ */
+static bool validRoute(Graph* graph, Route* route, int source, int target,
+                       bool* seen) {
+  bool valid = route->vertices[0] == source &&
+               route->vertices[route->numVertices - 1] == target;
+  long distance = 0;
+  for (int i = 0; i < route->numVertices; i++) {
+    int v = route->vertices[i];
+    valid = valid && !seen[v];
+    seen[v] = true;
+    if (i + 1 == route->numVertices) break;
+    int lightest = INT_MAX;
+    for (EdgeList* adjList = graph->vertices[v]->adjList; adjList != NULL;
+         adjList = adjList->next) {
+      if (otherEndpoint(adjList->edge, v) == route->vertices[i + 1] &&
+          adjList->edge->weight < lightest) {
+        lightest = adjList->edge->weight;
+      }
+    }
+    valid = valid && lightest != INT_MAX;
+    distance += lightest;
+  }
+  for (int i = 0; i < route->numVertices; i++) {
+    seen[route->vertices[i]] = false;
+  }
+  return valid && distance == route->distance;
+}
+
+/* Finds the 'k' shortest loopless paths between random pairs on a grid with
+ * about 'numVertices' vertices and checks them.
+ */
+static int benchPaths(int numVertices, int k) {
+  int side = 1;
+  while ((side + 1) * (side + 1) <= numVertices) side++;
+  numVertices = side * side;
+  Graph* graph = gridGraph(side, 31);
+  QueryWorkspace* workspace = newQueryWorkspace(numVertices);
+  bool* seen = calloc(numVertices, sizeof(bool));
+  if (graph == NULL || workspace == NULL || seen == NULL) {
+    printf("Could not create the graph.\n");
+    return 1;
+  }
+  int numQueries = 20;
+  srand(37);
+  double total = 0;
+  double dijkstra = 0;
+  long numRoutes = 0;
+  bool valid = true;
+  for (int q = 0; q < numQueries; q++) {
+    int s = rand() % numVertices;
+    int t = rand() % numVertices;
+    double start = seconds();
+    int count;
+    Route* routes = getKShortestPaths(graph, s, t, k, &count);
+    total += seconds() - start;
+    start = seconds();
+    int distance = getDistanceToDijkstra(graph, s, t, workspace);
+    dijkstra += seconds() - start;
+    if (routes == NULL) {
+      printf("Could not find the paths.\n");
+      return 1;
+    }
+    valid = valid && (count > 0 ? routes[0].distance == distance
+                                : distance == INT_MAX);
+    for (int i = 0; i < count; i++) {
+      valid = valid && validRoute(graph, &routes[i], s, t, seen) &&
+              (i == 0 || routes[i - 1].distance <= routes[i].distance);
+      for (int j = 0; j < i; j++) {
+        valid = valid && (routes[i].numVertices != routes[j].numVertices ||
+                          memcmp(routes[i].vertices, routes[j].vertices,
+                                 sizeof(int) * routes[i].numVertices) != 0);
+      }
+    }
+    numRoutes += count;
+    deleteRoutes(routes, count);
+  }
+  printf("%d x %d grid, k = %d: %.2f ms per query (%.1f paths), one "
+         "Dijkstra %.2f ms, %s\n",
+         side, side, k, total / numQueries * 1e3,
+         (double)numRoutes / numQueries, dijkstra / numQueries * 1e3,
+         valid ? "valid" : "INVALID PATHS");
+
+  free(seen);
+  deleteQueryWorkspace(workspace);
+  deleteBuiltGraph(graph);
+  return 0;
+}
+
+/***** planner *************************************************************/
+
+/* Returns the sum of the weights of the 'numEdges' edges in 'tree', or -1
+ * if it is NULL: the sum of distances for a distance tree, the total weight
+ * for a spanning tree.
+ */
+static long treeWeight(Edge* tree, int numEdges) {
+  if (tree == NULL) return -1;
+  long sum = 0;
+  for (int i = 0; i < numEdges; i++) sum += tree[i].weight;
+  free(tree);
+  return sum;
+}
+
+#define DENSE_LIMIT 20000  // dense Prim is quadratic: skipped above this
+
+/* Times every engine that fits 'graph' (times in ms), marks the one the
+ * planner picks with '*', and checks that the engines agree. '-' marks an
+ * engine that does not fit, or dense Prim on more than DENSE_LIMIT vertices.
+ */
+static void timeEngines(Graph* graph, const char* label) {
+  GraphProfile profile;
+  double start = seconds();
+  profileGraph(graph, &profile);
+  double profiling = seconds() - start;
+  Plan chosen = planAlgorithms(&profile, defaultPlan());
+  printf("%-26s%9.1f", label, profiling * 1000);
+
+  int n = graph->numVertices;
+  long first = -1;
+  bool agree = true;
+  for (int e = SSSP_BFS; e <= SSSP_RADIX_HEAP; e++) {
+    Plan plan = chosen;
+    plan.sssp = e;
+    start = seconds();
+    long sum =
+        treeWeight(getDistanceTreePlanned(graph, 0, &profile, &plan), n);
+    double elapsed = seconds() - start;
+    if (sum < 0) {
+      printf("%10s", "-");
+      continue;
+    }
+    printf("%9.1f%c", elapsed * 1000, e == (int)chosen.sssp ? '*' : ' ');
+    agree = agree && (first < 0 || sum == first);
+    first = sum;
+  }
+  first = -1;
+  for (int e = MST_PRIM_HEAP; e <= MST_PRIM_BUCKETS; e++) {
+    Plan plan = chosen;
+    plan.mst = e;
+    start = seconds();
+    long sum = e == MST_PRIM_DENSE && n > DENSE_LIMIT
+                   ? -1
+                   : treeWeight(getMSTplanned(graph, 0, &profile, &plan),
+                                n - 1);
+    double elapsed = seconds() - start;
+    if (sum < 0) {
+      printf("%10s", "-");
+      continue;
+    }
+    printf("%9.1f%c", elapsed * 1000, e == (int)chosen.mst ? '*' : ' ');
+    agree = agree && (first < 0 || sum == first);
+    first = sum;
+  }
+  printf("%s\n", agree ? "" : "  MISMATCH");
+}
+
+/* Sets every weight in 'graph' to 1 and returns it. */
+static Graph* unitWeights(Graph* graph) {
+  for (int v = 0; v < graph->numVertices; v++) {
+    for (EdgeList* adjList = graph->vertices[v]->adjList; adjList != NULL;
+         adjList = adjList->next) {
+      adjList->edge->weight = 1;
+    }
+  }
+  return graph;
+}
+
+/* Runs every engine the planner can choose on graphs of different shapes
+ * with about 'numVertices' vertices.
+ */
+static int benchPlan(int numVertices) {
+  int denseVertices = numVertices / 50 > 100 ? numVertices / 50 : 100;
+  struct {
+    const char* label;
+    Graph* graph;
+  } graphs[] = {
+      {"deg 8, unit weights",
+       unitWeights(randomGraph(numVertices, 4L * numVertices, 2, 51))},
+      {"deg 8, weights < 16", randomGraph(numVertices, 4L * numVertices, 16,
+                                          52)},
+      {"deg 8, weights < 1000", randomGraph(numVertices, 4L * numVertices,
+                                            1000, 53)},
+      {"deg 8, weights < 10^6", randomGraph(numVertices, 4L * numVertices,
+                                            1000000, 54)},
+      {"deg 3, weights < 100", randomGraph(numVertices, numVertices / 2,
+                                           100, 55)},
+      {"dense, weights < 1000",
+       randomGraph(denseVertices, (long)denseVertices * denseVertices / 4,
+                   1000, 56)},
+  };
+  printf("%-26s%9s%10s%10s%10s%10s%10s%10s%10s\n", "graph (times in ms)",
+         "profile", "bfs", "heap", "buckets", "radix", "prim-heap", "dense",
+         "buckets");
+  for (size_t g = 0; g < sizeof(graphs) / sizeof(graphs[0]); g++) {
+    if (graphs[g].graph == NULL) {
+      printf("Could not create the graph.\n");
+      return 1;
+    }
+    timeEngines(graphs[g].graph, graphs[g].label);
+    deleteBuiltGraph(graphs[g].graph);
+  }
+  return 0;
+}
+
+/***** many graphs *********************************************************/
+
+#define MANY_DEGREE 4  // most neighbours of a vertex in benchMany's graphs
+
+/* Adds the undirected edge {'u', 'v'} with a random weight to the lists in
+ * 'neighbours' and 'weights' (MANY_DEGREE entries per vertex), unless it is
+ * a self-loop or either list is full.
+ */
+static void addManyEdge(int u, int v, int* neighbours, int* weights,
+                        int* degree) {
+  if (u == v || degree[u] == MANY_DEGREE || degree[v] == MANY_DEGREE) return;
+  int weight = 1 + rand() % 20;
+  neighbours[MANY_DEGREE * u + degree[u]] = v;
+  weights[MANY_DEGREE * u + degree[u]++] = weight;
+  neighbours[MANY_DEGREE * v + degree[v]] = u;
+  weights[MANY_DEGREE * v + degree[v]++] = weight;
+}
+
+/* Writes 'numGraphs' random connected graphs in the multi-graph format to a
+ * new buffer, with 'numVertices' vertices each, a ring plus random chords,
+ * stores where each graph starts in 'starts' (numGraphs + 1 entries) and
+ * returns the buffer.
+ */
+static char* manyGraphsText(long numGraphs, int numVertices, long* starts) {
+  char* text = NULL;
+  size_t length = 0;
+  FILE* f = open_memstream(&text, &length);
+  if (f == NULL) return NULL;
+  srand(71);
+  int* neighbours = malloc(sizeof(int) * MANY_DEGREE * numVertices);
+  int* weights = malloc(sizeof(int) * MANY_DEGREE * numVertices);
+  int* degree = malloc(sizeof(int) * numVertices);
+  for (long g = 0; g < numGraphs; g++) {
+    starts[g] = ftell(f);
+    for (int v = 0; v < numVertices; v++) degree[v] = 0;
+    for (int v = 1; v < numVertices; v++) {
+      addManyEdge(v - 1, v, neighbours, weights, degree);
+    }
+    addManyEdge(numVertices - 1, 0, neighbours, weights, degree);
+    for (int v = 0; v < numVertices; v++) {
+      addManyEdge(v, rand() % numVertices, neighbours, weights, degree);
+    }
+    fprintf(f, "%d\n", numVertices);
+    for (int v = 0; v < numVertices; v++) {
+      fprintf(f, "%d", v);
+      for (int i = 0; i < degree[v]; i++) {
+        fprintf(f, " %d %d", neighbours[MANY_DEGREE * v + i],
+                weights[MANY_DEGREE * v + i]);
+      }
+      fprintf(f, "\n");
+    }
+  }
+  starts[numGraphs] = ftell(f);
+  fclose(f);
+  free(neighbours);
+  free(weights);
+  free(degree);
+  return text;
+}
+
+/* Runs 'numGraphs' graphs like sample_input.txt one at a time, reading each
+ * with createGraph, as one tester process per graph would, and then with
+ * runManyGraphs.
+ */
+static int benchMany(long numGraphs) {
+  long* starts = malloc(sizeof(long) * (numGraphs + 1));
+  char* text = starts != NULL ? manyGraphsText(numGraphs, 9, starts) : NULL;
+  FILE* out = fopen("/dev/null", "w");
+  if (text == NULL || out == NULL) {
+    printf("Could not create the graphs.\n");
+    return 1;
+  }
+  printf("%-32s%12s%14s\n", "method", "time (s)", "graphs/s");
+
+  double start = seconds();
+  long total = 0;
+  for (long g = 0; g < numGraphs; g++) {
+    FILE* f = fmemopen(text + starts[g], starts[g + 1] - starts[g], "r");
+    Graph* graph = createGraph(f, false);
+    fclose(f);
+    Edge* mst = getMSTprim(graph, 0);
+    Edge* tree = getDistanceTreeDijkstra(graph, 0);
+    for (int i = 0; i < graph->numVertices; i++) {
+      total += tree[i].weight + (i > 0 ? mst[i - 1].weight : 0);
+    }
+    free(mst);
+    free(tree);
+    deleteGraph(graph);
+  }
+  double elapsed = seconds() - start;
+  printf("%-32s%12.3f%14.0f\n", "createGraph per graph", elapsed,
+         numGraphs / elapsed);
+
+  int threads[] = {1, defaultThreadCount()};
+  for (int i = 0; i < 2 && (i == 0 || threads[1] > 1); i++) {
+    FILE* in = fmemopen(text, starts[numGraphs], "r");
+    long numErrors;
+    start = seconds();
+    long numRun = runManyGraphs(in, out, threads[i], &numErrors);
+    elapsed = seconds() - start;
+    fclose(in);
+    char label[64];
+    snprintf(label, sizeof(label), "runManyGraphs, %d threads", threads[i]);
+    printf("%-32s%12.3f%14.0f%s\n", label, elapsed, numRun / elapsed,
+           numRun == numGraphs && numErrors == 0 ? "" : "  ERRORS");
+  }
+  printf("(checksum %ld)\n", total);
+  fclose(out);
+  free(text);
+  free(starts);
+  return 0;
+}
+
+/***** all pairs ***********************************************************/
+
+/* Returns the sum of all distances in 'matrix', or -1 if it is NULL. */
+static long matrixSum(DistanceMatrix* matrix) {
+  if (matrix == NULL) return -1;
+  long sum = 0;
+  for (int u = 0; u < matrix->numVertices; u++) {
+    for (int v = 0; v < matrix->numVertices; v++) {
+      sum += matrix->distances[(long)u * matrix->stride + v];
+    }
+  }
+  deleteDistanceMatrix(matrix);
+  return sum;
+}
+
+/* Computes all distances on random graphs with 'numVertices' vertices and
+ * increasing density, with Floyd-Warshall and with Dijkstra's algorithm from
+ * every vertex.
+ */
+static int benchAllPairs(int numVertices) {
+  double densities[] = {0.008, 0.05, 0.2, 0.5, 1.0};
+  int threads = defaultThreadCount();
+  printf("%d vertices, times in s; Floyd-Warshall on %d threads\n",
+         numVertices, threads);
+  printf("%-10s%12s%12s%12s%12s\n", "density", "dijkstra", "fw 1 thread",
+         "fw", "fw + hops");
+  for (int d = 0; d < 5; d++) {
+    long numEdges = densities[d] * numVertices * (numVertices - 1) / 2;
+    Graph* graph = randomGraph(numVertices, numEdges, 1000, 81 + d);
+    if (graph == NULL) {
+      printf("Could not create the graph.\n");
+      return 1;
+    }
+
+    double start = seconds();
+    long dijkstraSum = 0;
+    for (int s = 0; s < numVertices; s++) {
+      Edge* tree = getDistanceTreeDijkstra(graph, s);
+      for (int i = 0; i < numVertices; i++) dijkstraSum += tree[i].weight;
+      free(tree);
+    }
+    double dijkstra = seconds() - start;
+    start = seconds();
+    long sum = matrixSum(getAllPairsFloydWarshall(graph, false, 1));
+    double single = seconds() - start;
+    bool agree = sum == dijkstraSum;
+    start = seconds();
+    sum = matrixSum(getAllPairsFloydWarshall(graph, false, threads));
+    double parallel = seconds() - start;
+    agree = agree && sum == dijkstraSum;
+    start = seconds();
+    sum = matrixSum(getAllPairsFloydWarshall(graph, true, threads));
+    double hops = seconds() - start;
+    agree = agree && sum == dijkstraSum;
+
+    printf("%-10.3f%12.3f%12.3f%12.3f%12.3f%s\n", densities[d], dijkstra,
+           single, parallel, hops, agree ? "" : "  MISMATCH");
+    deleteBuiltGraph(graph);
+  }
+  return 0;
+}
+
+/***** relaxed frontier ****************************************************/
+
+/* Times getDistanceTreeMultiQueue from vertex 0 of 'graph' on 1, 2, 4, ...
+ * threads against a sequential Dijkstra search, and prints per vertex
+ * reached the stale copies the queue dropped, those it handed out all the
+ * same, and the vertices whose edges were relaxed more than once.
+ */
+static void timeMultiQueue(Graph* graph, const char* label) {
+  int n = graph->numVertices;
+  QueryWorkspace* workspace = newQueryWorkspace(n);
+  double start = seconds();
+  int reached = getNearestDijkstra(graph, 0, INT_MAX, INT_MAX, workspace);
+  double sequential = seconds() - start;
+  long expected = 0;
+  for (int i = 0; i < reached; i++) expected += workspace->reached[i].distance;
+  deleteQueryWorkspace(workspace);
+  printf("%s: %d of %d vertices reached\n", label, reached, n);
+  printf("%-12s%10.1f\n", "  dijkstra", sequential * 1000);
+
+  int maxThreads = defaultThreadCount() > 4 ? defaultThreadCount() : 4;
+  for (int threads = 1; threads <= maxThreads; threads *= 2) {
+    SearchStats stats;
+    start = seconds();
+    Edge* tree = getDistanceTreeMultiQueue(graph, 0, threads, &stats);
+    double elapsed = seconds() - start;
+    if (tree == NULL) {
+      printf("  %-10d out of memory\n", threads);
+      continue;
+    }
+    long sum = 0;
+    for (int i = 0; i < n && tree[i].weight < INT_MAX; i++) {
+      sum += tree[i].weight;
+    }
+    free(tree);
+    printf("  %-10d%10.1f%10.2f%10.1f%%%10.1f%%%10.1f%%%s\n", threads,
+           elapsed * 1000, sequential / elapsed,
+           100.0 * stats.drops / reached, 100.0 * stats.stalePops / reached,
+           100.0 * stats.resettles / reached,
+           sum == expected ? "" : "  MISMATCH");
+  }
+}
+
+/* Runs the MultiQueue search on a random graph and on a grid with about
+ * 'numVertices' vertices, with 'numWorkers' workers (0 for the default).
+ */
+static int benchMultiQueue(int numVertices, int numWorkers) {
+  configureScheduler(numWorkers, false);
+  printf("%d worker threads, times in ms\n", defaultThreadCount());
+  printf("%-12s%10s%10s%11s%11s%11s\n", "threads", "time", "speedup",
+         "dropped", "stale", "resettled");
+  Graph* graph = randomGraph(numVertices, 4L * numVertices, 1000, 91);
+  if (graph == NULL) {
+    printf("Could not create the graph.\n");
+    return 1;
+  }
+  timeMultiQueue(graph, "random, degree 8");
+  deleteBuiltGraph(graph);
+
+  int side = 1;
+  while ((side + 1) * (side + 1) <= numVertices) side++;
+  graph = gridGraph(side, 92);
+  if (graph == NULL) {
+    printf("Could not create the graph.\n");
+    return 1;
+  }
+  timeMultiQueue(graph, "grid");
+  deleteBuiltGraph(graph);
+  return 0;
+}
+
+/***** compact graphs ******************************************************/
+
+/* Returns the number of bytes of a Graph from buildGraph. */
+static long graphBytes(Graph* graph) {
+  long numArcs = 0;
+  for (int v = 0; v < graph->numVertices; v++) {
+    for (EdgeList* adjList = graph->vertices[v]->adjList; adjList != NULL;
+         adjList = adjList->next) {
+      numArcs++;
+    }
+  }
+  return sizeof(Graph) + (sizeof(Vertex*) + sizeof(Vertex)) *
+                             (long)graph->numVertices +
+         (sizeof(EdgeList) + sizeof(Edge)) * numArcs;
+}
+
+/* Times Dijkstra's and Prim's algorithms from vertex 0 of 'graph' with a
+ * MinHeap on the Graph, and then on a copy in every layout it fits (times
+ * in ms, sizes in MB), marking the narrowest with '*'.
+ */
+static void timeLayouts(Graph* graph, const char* label) {
+  int n = graph->numVertices;
+  QueryWorkspace* workspace = newQueryWorkspace(n);
+  double start = seconds();
+  int reached = getNearestDijkstra(graph, 0, INT_MAX, INT_MAX, workspace);
+  double dijkstra = seconds() - start;
+  int64_t distanceSum = 0;
+  for (int i = 0; i < reached; i++) {
+    distanceSum += workspace->reached[i].distance;
+  }
+  start = seconds();
+  reached = getSpanningTreePrim(graph, 0, workspace);
+  double prim = seconds() - start;
+  int64_t treeWeight = 0;
+  for (int i = 0; i < reached; i++) {
+    treeWeight += workspace->reached[i].distance;
+  }
+  deleteQueryWorkspace(workspace);
+  printf("%s\n", label);
+  printf("  %-14s%10.1f%12.1f%10.1f\n", "graph", graphBytes(graph) / 1e6,
+         dijkstra * 1000, prim * 1000);
+
+  CompactGraph* narrowest = newCompactGraph(graph, COMPACT_NARROWEST);
+  int64_t* distances = malloc(sizeof(int64_t) * n);
+  int* predecessors = malloc(sizeof(int) * n);
+  for (int layout = COMPACT_ID16_W16_D32; layout <= COMPACT_ID32_W32_D64;
+       layout++) {
+    CompactGraph* compact = newCompactGraph(graph, layout);
+    if (compact == NULL) continue;
+    start = seconds();
+    getDistancesCompact(compact, 0, distances, predecessors);
+    dijkstra = seconds() - start;
+    int64_t sum = 0;
+    for (int v = 0; v < n; v++) {
+      if (distances[v] != COMPACT_UNREACHABLE) sum += distances[v];
+    }
+    start = seconds();
+    int64_t weight = getSpanningTreeCompact(compact, 0, predecessors);
+    prim = seconds() - start;
+    printf("  %-13s%c%10.1f%12.1f%10.1f%s\n", compactLayoutName(layout),
+           layout == (int)narrowest->layout ? '*' : ' ',
+           compactGraphBytes(compact) / 1e6, dijkstra * 1000, prim * 1000,
+           sum == distanceSum && weight == treeWeight ? "" : "  MISMATCH");
+    deleteCompactGraph(compact);
+  }
+  free(distances);
+  free(predecessors);
+  deleteCompactGraph(narrowest);
+}
+
+/* Compares the compact layouts with the Graph on a random graph and a grid
+ * with about 'numVertices' vertices, and on a random graph small enough for
+ * 16-bit IDs.
+ */
+static int benchCompact(int numVertices) {
+  printf("times in ms, sizes in MB\n");
+  printf("  %-14s%10s%12s%10s\n", "layout", "size", "dijkstra", "prim");
+  Graph* graph = randomGraph(numVertices, 4L * numVertices, 1000, 93);
+  if (graph == NULL) {
+    printf("Could not create the graph.\n");
+    return 1;
+  }
+  timeLayouts(graph, "random, degree 8, weights below 1000");
+  deleteBuiltGraph(graph);
+
+  int side = 1;
+  while ((side + 1) * (side + 1) <= numVertices) side++;
+  graph = gridGraph(side, 94);
+  if (graph == NULL) {
+    printf("Could not create the graph.\n");
+    return 1;
+  }
+  timeLayouts(graph, "grid, weights 1 to 100");
+  deleteBuiltGraph(graph);
+
+  graph = randomGraph(60000, 240000, 1000, 95);
+  if (graph == NULL) {
+    printf("Could not create the graph.\n");
+    return 1;
+  }
+  timeLayouts(graph, "random, 60000 vertices, degree 8");
+  deleteBuiltGraph(graph);
+  return 0;
+}
+
+/***** driver **************************************************************/
+
+int main(int argc, char* argv[]) {
+  if (argc >= 2 && strcmp(argv[1], "heaps") == 0) {
+    int scale = argc >= 3 ? atoi(argv[2]) : 1;
+    return benchHeaps(scale > 0 ? scale : 1);
+  }
+  if (argc >= 3 && strcmp(argv[1], "server") == 0) {
+    int clients = argc >= 4 ? atoi(argv[3]) : 8;
+    int requests = argc >= 5 ? atoi(argv[4]) : 10000;
+    return benchServer(argv[2], clients > 0 ? clients : 1,
+                       requests > 0 ? requests : 1);
+  }
+  if (argc >= 2 && strcmp(argv[1], "table") == 0) {
+    int vertices = argc >= 3 ? atoi(argv[2]) : 100000;
+    int size = argc >= 4 ? atoi(argv[3]) : 64;
+    return benchTable(vertices > 1 ? vertices : 100000, size > 0 ? size : 64);
+  }
+  if (argc >= 2 && strcmp(argv[1], "oracle") == 0) {
+    int vertices = argc >= 3 ? atoi(argv[2]) : 100000;
+    int k = argc >= 4 ? atoi(argv[3]) : 3;
+    return benchOracle(vertices > 1 ? vertices : 100000, k > 0 ? k : 3);
+  }
+  if (argc >= 2 && strcmp(argv[1], "labels") == 0) {
+    int vertices = argc >= 3 ? atoi(argv[2]) : 40000;
+    return benchLabels(vertices > 1 ? vertices : 40000);
+  }
+  if (argc >= 2 && strcmp(argv[1], "paths") == 0) {
+    int vertices = argc >= 3 ? atoi(argv[2]) : 40000;
+    int k = argc >= 4 ? atoi(argv[3]) : 10;
+    return benchPaths(vertices > 1 ? vertices : 40000, k > 0 ? k : 10);
+  }
+  if (argc >= 2 && strcmp(argv[1], "plan") == 0) {
+    int vertices = argc >= 3 ? atoi(argv[2]) : 200000;
+    return benchPlan(vertices > 1 ? vertices : 200000);
+  }
+  if (argc >= 2 && strcmp(argv[1], "many") == 0) {
+    long graphs = argc >= 3 ? atol(argv[2]) : 200000;
+    return benchMany(graphs > 0 ? graphs : 200000);
+  }
+  if (argc >= 2 && strcmp(argv[1], "apsp") == 0) {
+    int vertices = argc >= 3 ? atoi(argv[2]) : 1000;
+    return benchAllPairs(vertices > 1 ? vertices : 1000);
+  }
+  if (argc >= 2 && strcmp(argv[1], "multiqueue") == 0) {
+    int vertices = argc >= 3 ? atoi(argv[2]) : 1000000;
+    int workers = argc >= 4 ? atoi(argv[3]) : 0;
+    return benchMultiQueue(vertices > 1 ? vertices : 1000000,
+                           workers > 0 ? workers : 0);
+  }
+  if (argc >= 2 && strcmp(argv[1], "compact") == 0) {
+    int vertices = argc >= 3 ? atoi(argv[2]) : 1000000;
+    return benchCompact(vertices > 1 ? vertices : 1000000);
+  }
+  if (argc >= 2 && strcmp(argv[1], "sched") == 0) {
+    return benchScheduler(argc >= 3 ? atoi(argv[2]) : 0);
+  }
+  if (argc >= 2 && strcmp(argv[1], "snapshots") == 0) {
+    int readers = argc >= 3 ? atoi(argv[2]) : defaultThreadCount();
+    double duration = argc >= 4 ? atof(argv[3]) : 3;
+    return benchSnapshots(readers > 0 ? readers : 1,
+                          duration > 0 ? duration : 3);
+  }
+  printf("Usage: %s heaps [scale]\n", argv[0]);
+  printf("       %s server socket_path [clients] [requests]\n", argv[0]);
+  printf("       %s table [vertices] [size]\n", argv[0]);
+  printf("       %s oracle [vertices] [k]\n", argv[0]);
+  printf("       %s labels [vertices]\n", argv[0]);
+  printf("       %s paths [vertices] [k]\n", argv[0]);
+  printf("       %s plan [vertices]\n", argv[0]);
+  printf("       %s many [graphs]\n", argv[0]);
+  printf("       %s apsp [vertices]\n", argv[0]);
+  printf("       %s multiqueue [vertices] [workers]\n", argv[0]);
+  printf("       %s compact [vertices]\n", argv[0]);
+  printf("       %s sched [workers]\n", argv[0]);
+  printf("       %s snapshots [readers] [seconds]\n", argv[0]);
+  return 1;
+}
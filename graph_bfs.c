@@ -0,0 +1,472 @@
+/*
+ * Direction-optimizing breadth-first search.
+ */
+
+#include <limits.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "graph_bfs.h"
+#include "graph_symmetric.h"
+#include "parallel.h"
+
+#define NOTHING -1
+
+// Switch to bottom-up once the frontier's edges exceed 1/ALPHA of the edges
+// still to check, and back to top-down once the frontier shrinks below
+// 1/BETA of the vertices (Beamer et al.).
+#define ALPHA 14
+#define BETA 24
+
+// Graphs with fewer vertices than this are searched on one thread.
+#define MIN_PARALLEL_VERTICES 16384
+
+// Vertices a thread collects before appending them to the next frontier.
+#define LOCAL_BATCH 256
+
+typedef struct bfs_state
+{
+  int numVertices;      // vertex IDs are 0, 1, ..., numVertices-1
+  int *outOffsets;      // out-neighbours of v: outTargets[outOffsets[v]..]
+  int *outTargets;      //   up to outOffsets[v+1]
+  int *inOffsets;       // in-neighbours, laid out the same way; the same
+  int *inTargets;       //   arrays as above for symmetric graphs
+  int *parent;          // parent[v]: BFS predecessor, NOTHING if unvisited
+  int *frontier;        // vertices of the current level
+  int frontierSize;     // number of vertices in 'frontier'
+  int *next;            // vertices of the next level
+  int nextSize;         // number of vertices in 'next'
+  uint64_t *frontierBits; // bitmap of 'frontier', for bottom-up steps
+  long scout;           // sum of out-degrees of 'next'
+  Graph *graph;         // the graph being converted, during setup only
+  int **threadTargets;  // per-thread neighbour buffers, during setup only
+  int *inCounts;        // per-thread in-degree histograms, during setup only
+} BfsState;
+
+/* Returns true iff all edges of Graph 'graph' have the same weight, and in
+ * that case stores it in '*weight' (0 if there are no edges).
+ */
+bool hasUniformWeights(Graph *graph, int *weight)
+{
+  bool seen = false;
+  int first = 0;
+  for (int u = 0; u < graph->numVertices; u++)
+  {
+    for (EdgeList *adjList = graph->vertices[u]->adjList; adjList != NULL;
+         adjList = adjList->next)
+    {
+      if (!seen)
+      {
+        first = adjList->edge->weight;
+        seen = true;
+      }
+      else if (adjList->edge->weight != first)
+      {
+        return false;
+      }
+    }
+  }
+  *weight = first;
+  return true;
+}
+
+/* Appends the 'count' vertices in 'batch' to the next frontier. */
+static void flushBatch(BfsState *state, int *batch, int count)
+{
+  int pos = __atomic_fetch_add(&state->nextSize, count, __ATOMIC_RELAXED);
+  memcpy(state->next + pos, batch, sizeof(int) * count);
+}
+
+/* Setup: copies the adjacency lists of this thread's range of vertices into
+ * a buffer of its own, and their degrees into outOffsets. This is the only
+ * pass over the linked lists.
+ */
+static void copyLists(void *ctx, int thread, int numThreads)
+{
+  BfsState *state = (BfsState *)ctx;
+  int capacity = 1024;
+  int count = 0;
+  int *targets = malloc(sizeof(int) * capacity);
+  int end = (int)partStart(state->numVertices, thread + 1, numThreads);
+  for (int u = (int)partStart(state->numVertices, thread, numThreads);
+       targets != NULL && u < end; u++)
+  {
+    int first = count;
+    for (EdgeList *adjList = state->graph->vertices[u]->adjList;
+         adjList != NULL; adjList = adjList->next)
+    {
+      if (count == capacity)
+      {
+        capacity *= 2;
+        int *grown = realloc(targets, sizeof(int) * capacity);
+        if (grown == NULL)
+        {
+          free(targets);
+          targets = NULL;
+          break;
+        }
+        targets = grown;
+      }
+      Edge *edge = adjList->edge;
+      targets[count++] = edge->fromVertex == u ? edge->toVertex
+                                               : edge->fromVertex;
+    }
+    state->outOffsets[u + 1] = count - first;
+  }
+  state->threadTargets[thread] = targets;
+}
+
+/* Setup: moves this thread's buffer from copyLists into outTargets. */
+static void placeLists(void *ctx, int thread, int numThreads)
+{
+  BfsState *state = (BfsState *)ctx;
+  int first = (int)partStart(state->numVertices, thread, numThreads);
+  int end = (int)partStart(state->numVertices, thread + 1, numThreads);
+  memcpy(state->outTargets + state->outOffsets[first],
+         state->threadTargets[thread],
+         sizeof(int) * (state->outOffsets[end] - state->outOffsets[first]));
+}
+
+/* Setup: counts, in a histogram of its own, the in-degrees contributed by
+ * this thread's range of vertices.
+ */
+static void countInDegrees(void *ctx, int thread, int numThreads)
+{
+  BfsState *state = (BfsState *)ctx;
+  int *counts = state->inCounts + (long)thread * state->numVertices;
+  int end = (int)partStart(state->numVertices, thread + 1, numThreads);
+  for (int u = (int)partStart(state->numVertices, thread, numThreads);
+       u < end; u++)
+  {
+    for (int e = state->outOffsets[u]; e < state->outOffsets[u + 1]; e++)
+    {
+      counts[state->outTargets[e]]++;
+    }
+  }
+}
+
+/* Setup: for this thread's range of vertices, turns the per-thread in-degree
+ * histograms into per-thread starting slots within each in-neighbour list,
+ * and leaves the in-degree of each vertex in inOffsets.
+ */
+static void sumInDegrees(void *ctx, int thread, int numThreads)
+{
+  BfsState *state = (BfsState *)ctx;
+  int numVertices = state->numVertices;
+  int end = (int)partStart(numVertices, thread + 1, numThreads);
+  for (int v = (int)partStart(numVertices, thread, numThreads); v < end; v++)
+  {
+    int degree = 0;
+    for (int t = 0; t < numThreads; t++)
+    {
+      int count = state->inCounts[(long)t * numVertices + v];
+      state->inCounts[(long)t * numVertices + v] = degree;
+      degree += count;
+    }
+    state->inOffsets[v + 1] = degree;
+  }
+}
+
+/* Setup: adds the reverse of the edges of this thread's range of vertices to
+ * the in-neighbour arrays. Every thread owns its own slots, so no
+ * synchronization is needed.
+ */
+static void fillInNeighbours(void *ctx, int thread, int numThreads)
+{
+  BfsState *state = (BfsState *)ctx;
+  int *cursors = state->inCounts + (long)thread * state->numVertices;
+  int end = (int)partStart(state->numVertices, thread + 1, numThreads);
+  for (int u = (int)partStart(state->numVertices, thread, numThreads);
+       u < end; u++)
+  {
+    for (int e = state->outOffsets[u]; e < state->outOffsets[u + 1]; e++)
+    {
+      int v = state->outTargets[e];
+      state->inTargets[state->inOffsets[v] + cursors[v]++] = u;
+    }
+  }
+}
+
+/* Top-down step: every vertex in this thread's slice of the frontier claims
+ * its unvisited out-neighbours for the next level.
+ */
+static void topDownStep(void *ctx, int thread, int numThreads)
+{
+  BfsState *state = (BfsState *)ctx;
+  int batch[LOCAL_BATCH];
+  int count = 0;
+  long scout = 0;
+  int end = (int)partStart(state->frontierSize, thread + 1, numThreads);
+  for (int i = (int)partStart(state->frontierSize, thread, numThreads);
+       i < end; i++)
+  {
+    int u = state->frontier[i];
+    for (int e = state->outOffsets[u]; e < state->outOffsets[u + 1]; e++)
+    {
+      int v = state->outTargets[e];
+      int unvisited = NOTHING;
+      if (__atomic_load_n(&state->parent[v], __ATOMIC_RELAXED) == NOTHING &&
+          __atomic_compare_exchange_n(&state->parent[v], &unvisited, u, false,
+                                      __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+      {
+        scout += state->outOffsets[v + 1] - state->outOffsets[v];
+        batch[count++] = v;
+        if (count == LOCAL_BATCH)
+        {
+          flushBatch(state, batch, count);
+          count = 0;
+        }
+      }
+    }
+  }
+  flushBatch(state, batch, count);
+  __atomic_fetch_add(&state->scout, scout, __ATOMIC_RELAXED);
+}
+
+/* Bottom-up step: every unvisited vertex in this thread's range looks for an
+ * in-neighbour in the frontier bitmap. Every thread writes only the entries
+ * of 'parent' in its own range.
+ */
+static void bottomUpStep(void *ctx, int thread, int numThreads)
+{
+  BfsState *state = (BfsState *)ctx;
+  int batch[LOCAL_BATCH];
+  int count = 0;
+  long scout = 0;
+  long numWords = (state->numVertices + 63) / 64;
+  long endWord = partStart(numWords, thread + 1, numThreads);
+  for (long w = partStart(numWords, thread, numThreads); w < endWord; w++)
+  {
+    int end = w * 64 + 64 < state->numVertices ? (int)(w * 64 + 64)
+                                               : state->numVertices;
+    for (int v = (int)(w * 64); v < end; v++)
+    {
+      if (state->parent[v] != NOTHING)
+      {
+        continue;
+      }
+      for (int e = state->inOffsets[v]; e < state->inOffsets[v + 1]; e++)
+      {
+        int u = state->inTargets[e];
+        if (state->frontierBits[u / 64] & ((uint64_t)1 << (u % 64)))
+        {
+          state->parent[v] = u;
+          scout += state->outOffsets[v + 1] - state->outOffsets[v];
+          batch[count++] = v;
+          if (count == LOCAL_BATCH)
+          {
+            flushBatch(state, batch, count);
+            count = 0;
+          }
+          break;
+        }
+      }
+    }
+  }
+  flushBatch(state, batch, count);
+  __atomic_fetch_add(&state->scout, scout, __ATOMIC_RELAXED);
+}
+
+/* Frees the arrays of 'state'. */
+static void freeBfsState(BfsState *state)
+{
+  if (state->inOffsets != state->outOffsets)
+  {
+    free(state->inOffsets);
+  }
+  if (state->inTargets != state->outTargets)
+  {
+    free(state->inTargets);
+  }
+  free(state->outOffsets);
+  free(state->outTargets);
+  free(state->parent);
+  free(state->frontier);
+  free(state->next);
+  free(state->frontierBits);
+  free(state->threadTargets);
+  free(state->inCounts);
+}
+
+/* Copies the adjacency lists of state->graph into the neighbour arrays of
+ * 'state', using 'numThreads' threads. Returns false if memory could not be
+ * allocated.
+ */
+static bool buildNeighbours(BfsState *state, int numThreads)
+{
+  int numVertices = state->numVertices;
+  state->outOffsets = calloc(numVertices + 1, sizeof(int));
+  state->threadTargets = calloc(numThreads, sizeof(int *));
+  if (state->outOffsets == NULL || state->threadTargets == NULL)
+  {
+    return false;
+  }
+  state->inOffsets = state->outOffsets;
+
+  parallelRun(numThreads, copyLists, state);
+  bool copied = true;
+  for (int t = 0; t < numThreads; t++)
+  {
+    copied = copied && state->threadTargets[t] != NULL;
+  }
+  for (int v = 0; v < numVertices; v++)
+  {
+    state->outOffsets[v + 1] += state->outOffsets[v];
+  }
+  int numArcs = state->outOffsets[numVertices];
+  state->outTargets = copied ? malloc(sizeof(int) * (numArcs + 1)) : NULL;
+  if (state->outTargets != NULL)
+  {
+    parallelRun(numThreads, placeLists, state);
+  }
+  for (int t = 0; t < numThreads; t++)
+  {
+    free(state->threadTargets[t]);
+  }
+  free(state->threadTargets);
+  state->threadTargets = NULL;
+  state->inTargets = state->outTargets;
+  if (state->outTargets == NULL || isSymmetricGraph(state->graph))
+  {
+    return state->outTargets != NULL;
+  }
+
+  // Bottom-up steps need the in-neighbours of every vertex. Per-thread
+  // histograms cost numThreads * numVertices counters; do not let them
+  // outgrow the graph itself.
+  while (numThreads > 1 &&
+         (long)numThreads * numVertices > 2L * numArcs + numVertices)
+  {
+    numThreads--;
+  }
+  state->inOffsets = calloc(numVertices + 1, sizeof(int));
+  state->inTargets = malloc(sizeof(int) * (numArcs + 1));
+  state->inCounts = calloc((size_t)numThreads * numVertices + 1, sizeof(int));
+  if (state->inOffsets == NULL || state->inTargets == NULL ||
+      state->inCounts == NULL)
+  {
+    return false;
+  }
+  parallelRun(numThreads, countInDegrees, state);
+  parallelRun(numThreads, sumInDegrees, state);
+  for (int v = 0; v < numVertices; v++)
+  {
+    state->inOffsets[v + 1] += state->inOffsets[v];
+  }
+  parallelRun(numThreads, fillInNeighbours, state);
+  free(state->inCounts);
+  state->inCounts = NULL;
+  return true;
+}
+
+/* Computes the same distance tree as getDistanceTreeDijkstra for a Graph
+ * 'graph' whose edges all have weight 'weight', with a direction-optimizing
+ * breadth-first search from vertex 'startVertex'.
+ * Returns NULL if 'startVertex' is not valid in 'graph'.
+ * Precondition: every edge of 'graph' has weight 'weight'
+ */
+Edge *getDistanceTreeBFS(Graph *graph, int startVertex, int weight,
+                         int numThreads)
+{
+  int numVertices = graph->numVertices;
+  if (startVertex < 0 || startVertex >= numVertices)
+  {
+    return NULL;
+  }
+  if (numThreads <= 0)
+  {
+    numThreads =
+        numVertices < MIN_PARALLEL_VERTICES ? 1 : defaultThreadCount();
+  }
+
+  BfsState state;
+  memset(&state, 0, sizeof(BfsState));
+  state.numVertices = numVertices;
+  state.graph = graph;
+  long numWords = (numVertices + 63) / 64;
+  state.parent = malloc(sizeof(int) * numVertices);
+  state.frontier = malloc(sizeof(int) * numVertices);
+  state.next = malloc(sizeof(int) * numVertices);
+  state.frontierBits = calloc(numWords + 1, sizeof(uint64_t));
+  Edge *distanceEdges = malloc(sizeof(Edge) * numVertices);
+  if (state.parent == NULL || state.frontier == NULL || state.next == NULL ||
+      state.frontierBits == NULL || distanceEdges == NULL ||
+      !buildNeighbours(&state, numThreads))
+  {
+    freeBfsState(&state);
+    free(distanceEdges);
+    return NULL;
+  }
+  for (int v = 0; v < numVertices; v++)
+  {
+    state.parent[v] = NOTHING;
+  }
+
+  int numTreeEdges = 0;
+  distanceEdges[numTreeEdges].fromVertex = startVertex;
+  distanceEdges[numTreeEdges].toVertex = startVertex;
+  distanceEdges[numTreeEdges++].weight = 0;
+  state.parent[startVertex] = startVertex;
+  state.frontier[0] = startVertex;
+  state.frontierSize = 1;
+
+  long edgesToCheck = state.outOffsets[numVertices];
+  long scout =
+      state.outOffsets[startVertex + 1] - state.outOffsets[startVertex];
+  bool bottomUp = false;
+  for (int distance = weight; state.frontierSize > 0; distance += weight)
+  {
+    if (!bottomUp && scout > edgesToCheck / ALPHA)
+    {
+      bottomUp = true;
+    }
+    else if (bottomUp && state.frontierSize < numVertices / BETA)
+    {
+      bottomUp = false;
+    }
+
+    state.nextSize = 0;
+    state.scout = 0;
+    if (bottomUp)
+    {
+      memset(state.frontierBits, 0, sizeof(uint64_t) * numWords);
+      for (int i = 0; i < state.frontierSize; i++)
+      {
+        int u = state.frontier[i];
+        state.frontierBits[u / 64] |= (uint64_t)1 << (u % 64);
+      }
+      parallelRun(numThreads, bottomUpStep, &state);
+    }
+    else
+    {
+      parallelRun(numThreads, topDownStep, &state);
+    }
+    edgesToCheck -= state.scout;
+    scout = state.scout;
+
+    for (int i = 0; i < state.nextSize; i++)
+    {
+      int v = state.next[i];
+      distanceEdges[numTreeEdges].fromVertex = v;
+      distanceEdges[numTreeEdges].toVertex = state.parent[v];
+      distanceEdges[numTreeEdges++].weight = distance;
+    }
+    int *tmp = state.frontier;
+    state.frontier = state.next;
+    state.next = tmp;
+    state.frontierSize = state.nextSize;
+  }
+
+  // Like Dijkstra's algorithm, list unreachable vertices last.
+  for (int v = 0; v < numVertices; v++)
+  {
+    if (state.parent[v] == NOTHING)
+    {
+      distanceEdges[numTreeEdges].fromVertex = v;
+      distanceEdges[numTreeEdges].toVertex = NOTHING;
+      distanceEdges[numTreeEdges++].weight = INT_MAX;
+    }
+  }
+  freeBfsState(&state);
+  return distanceEdges;
+}
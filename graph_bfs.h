@@ -0,0 +1,37 @@
+/*
+ * Header file for breadth-first search on graphs whose edges all have the
+ * same weight.
+ */
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "graph.h"
+
+#ifndef __Graph_BFS_header
+#define __Graph_BFS_header
+
+/* Returns true iff all edges of Graph 'graph' have the same weight, and in
+ * that case stores it in '*weight' (0 if there are no edges).
+ */
+bool hasUniformWeights(Graph* graph, int* weight);
+
+/* Computes the same distance tree as getDistanceTreeDijkstra for a Graph
+ * 'graph' whose edges all have weight 'weight', with a direction-optimizing
+ * breadth-first search from vertex 'startVertex': levels with a small
+ * frontier are expanded top-down from a list of frontier vertices, and
+ * levels with a large frontier bottom-up, by unvisited vertices checking for
+ * a neighbour in a bitmap of the frontier. Uses 'numThreads' threads, or 0 to
+ * choose from the size of the graph. Where several predecessors are equally
+ * close, which one a vertex gets may vary between runs.
+ * getDistanceTreeDijkstra never switches to this search by itself: call it
+ * directly, or let the planner (see graph_plan.h) choose it once from its
+ * profile of the graph.
+ * Returns NULL if 'startVertex' is not valid in 'graph'.
+ * Precondition: every edge of 'graph' has weight 'weight'
+ */
+Edge* getDistanceTreeBFS(Graph* graph, int startVertex, int weight,
+                         int numThreads);
+
+#endif
@@ -0,0 +1,316 @@
+/*
+ * Building graphs in bulk from edge arrays.
+ */
+
+#include <limits.h>
+
+#include "graph_build.h"
+#include "parallel.h"
+
+typedef struct build_state
+{
+  Edge *edges;          // the input edges
+  long numEdges;        // number of input edges
+  int numVertices;      // number of vertices of the graph being built
+  BuildOptions options; // what to build
+  int *counts;          // counts[t * numVertices + v]: edges leaving v in
+                        //   thread t's slice of the input; later the next
+                        //   free slot for those edges relative to offsets[v]
+  int *offsets;         // offsets[v]: first slot of v's edges; numVertices+1
+  int *kept;            // kept[v]: number of v's edges left after merging
+  long *threadTotals;   // per-thread partial sums
+  bool *threadInvalid;  // per-thread: saw an invalid input edge
+  Vertex *vertexBlock;  // all Vertices of the graph
+  EdgeList *listBlock;  // all EdgeList nodes of the graph
+  Edge *edgeBlock;      // all Edges of the graph
+  Graph *graph;         // the graph being built
+} BuildState;
+
+/* Returns the default options: one thread per CPU, edges taken as given. */
+BuildOptions defaultBuildOptions(void)
+{
+  BuildOptions res;
+  res.numThreads = 0;
+  res.symmetrize = false;
+  res.mergeDuplicates = false;
+  return res;
+}
+
+/* Pass 1: validates this thread's slice of the input and counts the edges
+ * leaving every vertex in it.
+ */
+static void countDegrees(void *ctx, int thread, int numThreads)
+{
+  BuildState *state = (BuildState *)ctx;
+  int *counts = state->counts + (long)thread * state->numVertices;
+  long end = partStart(state->numEdges, thread + 1, numThreads);
+  for (long i = partStart(state->numEdges, thread, numThreads); i < end; i++)
+  {
+    Edge *edge = &state->edges[i];
+    if (edge->fromVertex < 0 || edge->fromVertex >= state->numVertices ||
+        edge->toVertex < 0 || edge->toVertex >= state->numVertices ||
+        edge->weight < 0)
+    {
+      state->threadInvalid[thread] = true;
+      return;
+    }
+    counts[edge->fromVertex]++;
+    if (state->options.symmetrize && edge->fromVertex != edge->toVertex)
+    {
+      counts[edge->toVertex]++;
+    }
+  }
+}
+
+/* Pass 2a: for this thread's range of vertices, turns the per-thread counts
+ * into per-thread starting slots within each vertex's list, and leaves the
+ * degree of each vertex in offsets.
+ */
+static void sumDegrees(void *ctx, int thread, int numThreads)
+{
+  BuildState *state = (BuildState *)ctx;
+  int numVertices = state->numVertices;
+  int end = (int)partStart(numVertices, thread + 1, numThreads);
+  long total = 0;
+  for (int v = (int)partStart(numVertices, thread, numThreads); v < end; v++)
+  {
+    int degree = 0;
+    for (int t = 0; t < numThreads; t++)
+    {
+      int count = state->counts[(long)t * numVertices + v];
+      state->counts[(long)t * numVertices + v] = degree;
+      degree += count;
+    }
+    state->offsets[v] = degree;
+    total += degree;
+  }
+  state->threadTotals[thread] = total;
+}
+
+/* Pass 2b: turns the degrees of this thread's range of vertices into list
+ * offsets, given the exclusive prefix sums in threadTotals.
+ */
+static void computeOffsets(void *ctx, int thread, int numThreads)
+{
+  BuildState *state = (BuildState *)ctx;
+  int end = (int)partStart(state->numVertices, thread + 1, numThreads);
+  int offset = (int)state->threadTotals[thread];
+  for (int v = (int)partStart(state->numVertices, thread, numThreads);
+       v < end; v++)
+  {
+    int degree = state->offsets[v];
+    state->offsets[v] = offset;
+    offset += degree;
+  }
+}
+
+/* Pass 3: copies this thread's slice of the input into place. Every thread
+ * owns a disjoint set of slots, so no synchronization is needed.
+ */
+static void scatterEdges(void *ctx, int thread, int numThreads)
+{
+  BuildState *state = (BuildState *)ctx;
+  int *cursors = state->counts + (long)thread * state->numVertices;
+  long end = partStart(state->numEdges, thread + 1, numThreads);
+  for (long i = partStart(state->numEdges, thread, numThreads); i < end; i++)
+  {
+    Edge *edge = &state->edges[i];
+    int from = edge->fromVertex;
+    int to = edge->toVertex;
+    state->edgeBlock[state->offsets[from] + cursors[from]++] = *edge;
+    if (state->options.symmetrize && from != to)
+    {
+      Edge *back = &state->edgeBlock[state->offsets[to] + cursors[to]++];
+      back->fromVertex = to;
+      back->toVertex = from;
+      back->weight = edge->weight;
+    }
+  }
+}
+
+/* Orders Edges by 'toVertex', lightest first. */
+static int compareTargets(const void *a, const void *b)
+{
+  const Edge *edge1 = (const Edge *)a;
+  const Edge *edge2 = (const Edge *)b;
+  if (edge1->toVertex != edge2->toVertex)
+    return edge1->toVertex < edge2->toVertex ? -1 : 1;
+  if (edge1->weight != edge2->weight)
+    return edge1->weight < edge2->weight ? -1 : 1;
+  return 0;
+}
+
+/* Optional pass: sorts the lists of this thread's range of vertices and
+ * keeps only the lightest of every group of parallel edges, at the front of
+ * the list.
+ */
+static void mergeDuplicates(void *ctx, int thread, int numThreads)
+{
+  BuildState *state = (BuildState *)ctx;
+  int end = (int)partStart(state->numVertices, thread + 1, numThreads);
+  for (int v = (int)partStart(state->numVertices, thread, numThreads);
+       v < end; v++)
+  {
+    Edge *list = state->edgeBlock + state->offsets[v];
+    int degree = state->offsets[v + 1] - state->offsets[v];
+    qsort(list, degree, sizeof(Edge), compareTargets);
+    int numKept = 0;
+    for (int i = 0; i < degree; i++)
+    {
+      if (numKept == 0 || list[numKept - 1].toVertex != list[i].toVertex)
+      {
+        list[numKept++] = list[i];
+      }
+    }
+    state->kept[v] = numKept;
+  }
+}
+
+/* Last pass: creates the Vertices of this thread's range and links their
+ * edges into adjacency lists. Counts the edges kept; when symmetrizing, an
+ * undirected edge is counted once, in the list of its lower endpoint.
+ */
+static void linkLists(void *ctx, int thread, int numThreads)
+{
+  BuildState *state = (BuildState *)ctx;
+  int end = (int)partStart(state->numVertices, thread + 1, numThreads);
+  long total = 0;
+  for (int v = (int)partStart(state->numVertices, thread, numThreads);
+       v < end; v++)
+  {
+    int first = state->offsets[v];
+    int degree = state->kept != NULL ? state->kept[v]
+                                     : state->offsets[v + 1] - first;
+    EdgeList *list = state->listBlock + first;
+    for (int i = 0; i < degree; i++)
+    {
+      list[i].edge = &state->edgeBlock[first + i];
+      list[i].next = i + 1 < degree ? &list[i + 1] : NULL;
+      total += !state->options.symmetrize || list[i].edge->toVertex >= v;
+    }
+    Vertex *vertex = &state->vertexBlock[v];
+    vertex->id = v;
+    vertex->value = NULL;
+    vertex->adjList = degree > 0 ? list : NULL;
+    state->graph->vertices[v] = vertex;
+  }
+  state->threadTotals[thread] = total;
+}
+
+/* Frees the scratch arrays of 'state'. */
+static void freeBuildState(BuildState *state)
+{
+  free(state->counts);
+  free(state->offsets);
+  free(state->kept);
+  free(state->threadTotals);
+  free(state->threadInvalid);
+}
+
+/* Builds and returns a new Graph with 'numVertices' vertices from the
+ * 'numEdges' edges in 'edges', which may be in any order.
+ * Returns NULL if an edge has an invalid endpoint or a negative weight, if
+ * the graph would have more than INT_MAX edges, or if memory could not be
+ * allocated.
+ * Precondition: numVertices >= 0, numEdges >= 0
+ */
+Graph *buildGraph(Edge *edges, long numEdges, int numVertices,
+                  BuildOptions options)
+{
+  long maxArcs = options.symmetrize ? 2 * numEdges : numEdges;
+  if (maxArcs > INT_MAX)
+  {
+    return NULL;
+  }
+
+  // Per-thread histograms cost numThreads * numVertices counters; do not let
+  // them outgrow the graph itself.
+  int numThreads =
+      options.numThreads > 0 ? options.numThreads : defaultThreadCount();
+  while (numThreads > 1 &&
+         (long)numThreads * numVertices > 2 * maxArcs + numVertices)
+  {
+    numThreads--;
+  }
+
+  BuildState state;
+  state.edges = edges;
+  state.numEdges = numEdges;
+  state.numVertices = numVertices;
+  state.options = options;
+  state.counts = calloc((size_t)numThreads * numVertices + 1, sizeof(int));
+  state.offsets = malloc(sizeof(int) * (numVertices + 1));
+  state.kept = options.mergeDuplicates
+                   ? malloc(sizeof(int) * (numVertices + 1))
+                   : NULL;
+  state.threadTotals = malloc(sizeof(long) * numThreads);
+  state.threadInvalid = calloc(numThreads, sizeof(bool));
+  state.graph = NULL;
+  if (state.counts == NULL || state.offsets == NULL ||
+      (options.mergeDuplicates && state.kept == NULL) ||
+      state.threadTotals == NULL || state.threadInvalid == NULL)
+  {
+    freeBuildState(&state);
+    return NULL;
+  }
+
+  parallelRun(numThreads, countDegrees, &state);
+  for (int t = 0; t < numThreads; t++)
+  {
+    if (state.threadInvalid[t])
+    {
+      freeBuildState(&state);
+      return NULL;
+    }
+  }
+
+  parallelRun(numThreads, sumDegrees, &state);
+  long numArcs = 0;
+  for (int t = 0; t < numThreads; t++)
+  {
+    long total = state.threadTotals[t];
+    state.threadTotals[t] = numArcs;
+    numArcs += total;
+  }
+  parallelRun(numThreads, computeOffsets, &state);
+  state.offsets[numVertices] = (int)numArcs;
+
+  // One block for everything, so that deleteBuiltGraph is a single free.
+  state.graph = malloc(sizeof(Graph) +
+                       (sizeof(Vertex *) + sizeof(Vertex)) * numVertices +
+                       (sizeof(EdgeList) + sizeof(Edge)) * numArcs);
+  if (state.graph == NULL)
+  {
+    freeBuildState(&state);
+    return NULL;
+  }
+  state.graph->numVertices = numVertices;
+  state.graph->vertices = (Vertex **)(state.graph + 1);
+  state.vertexBlock = (Vertex *)(state.graph->vertices + numVertices);
+  state.listBlock = (EdgeList *)(state.vertexBlock + numVertices);
+  state.edgeBlock = (Edge *)(state.listBlock + numArcs);
+
+  parallelRun(numThreads, scatterEdges, &state);
+  if (options.mergeDuplicates)
+  {
+    parallelRun(numThreads, mergeDuplicates, &state);
+  }
+  parallelRun(numThreads, linkLists, &state);
+
+  long numKept = 0;
+  for (int t = 0; t < numThreads; t++)
+  {
+    numKept += state.threadTotals[t];
+  }
+  state.graph->numEdges = (int)numKept;
+
+  Graph *res = state.graph;
+  freeBuildState(&state);
+  return res;
+}
+
+/* Frees all memory allocated for 'graph', a Graph returned by buildGraph. */
+void deleteBuiltGraph(Graph *graph)
+{
+  free(graph);
+}
@@ -0,0 +1,57 @@
+/*
+ * Header file for building graphs in bulk from edge arrays.
+ *
+ * A graph built here keeps itself and all of its vertices, list nodes and
+ * edges in one block, with the adjacency list of every vertex laid out
+ * contiguously, CSR style. It is used like any other Graph, but deleted with
+ * deleteBuiltGraph rather than deleteGraph.
+ *
+ * Nothing in a Graph records how it was made, so the caller has to keep
+ * track of which delete function to use, and a mismatch is not caught:
+ * deleteGraph on a built graph frees pointers into the middle of its block,
+ * and deleteBuiltGraph on any other Graph leaks all but the Graph itself.
+ * Graphs from buildGraph, createGraphFromEdges (graph_io.h) and
+ * createGraphWithIds (graph_ids.h) are built graphs; those from newGraph,
+ * newSymmetricGraph and createGraph are not.
+ */
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "graph.h"
+
+#ifndef __Graph_Build_header
+#define __Graph_Build_header
+
+typedef struct build_options {
+  int numThreads;        // number of threads to use; 0 for one per CPU
+  bool symmetrize;       // also add the edge (to -- from) for every
+                         //   (from -- to); self-loops are added once, and
+                         //   numEdges counts each pair once
+  bool mergeDuplicates;  // keep only the lightest of parallel edges
+} BuildOptions;
+
+/* Returns the default options: one thread per CPU, edges taken as given. */
+BuildOptions defaultBuildOptions(void);
+
+/* Builds and returns a new Graph with 'numVertices' vertices from the
+ * 'numEdges' edges in 'edges', which may be in any order. Every vertex's
+ * adjacency list keeps its edges in input order (or, if duplicates are
+ * merged, in increasing order of 'toVertex').
+ * Works in three parallel passes: per-thread degree histograms, a prefix sum
+ * into list offsets, and a scatter of the edges into place.
+ * Returns NULL if an edge has an invalid endpoint or a negative weight, if
+ * the graph would have more than INT_MAX edges, or if memory could not be
+ * allocated.
+ * Precondition: numVertices >= 0, numEdges >= 0
+ */
+Graph* buildGraph(Edge* edges, long numEdges, int numVertices,
+                  BuildOptions options);
+
+/* Frees all memory allocated for 'graph', a Graph returned by buildGraph.
+ * deleteGraph must not be used on such a graph, nor this on any other.
+ */
+void deleteBuiltGraph(Graph* graph);
+
+#endif
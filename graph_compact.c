@@ -0,0 +1,228 @@
+/*
+ * Compact graphs, with Dijkstra's and Prim's algorithms instantiated for
+ * every layout.
+ */
+
+#include <stdint.h>
+
+#include "graph_compact.h"
+
+#define COMPACT_HEAP_ARITY 4  // faster overall than 2 or 8 in "bench compact"
+
+#define COMPACT_PREFIX id16w16d32
+#define COMPACT_ID uint16_t
+#define COMPACT_WEIGHT uint16_t
+#define COMPACT_WEIGHT_MAX UINT16_MAX
+#define COMPACT_DISTANCE uint32_t
+#define COMPACT_DISTANCE_MAX UINT32_MAX
+#define COMPACT_ARITY COMPACT_HEAP_ARITY
+#include "graph_compact_template.h"
+
+#define COMPACT_PREFIX id32w16d32
+#define COMPACT_ID uint32_t
+#define COMPACT_WEIGHT uint16_t
+#define COMPACT_WEIGHT_MAX UINT16_MAX
+#define COMPACT_DISTANCE uint32_t
+#define COMPACT_DISTANCE_MAX UINT32_MAX
+#define COMPACT_ARITY COMPACT_HEAP_ARITY
+#include "graph_compact_template.h"
+
+#define COMPACT_PREFIX id32w16d64
+#define COMPACT_ID uint32_t
+#define COMPACT_WEIGHT uint16_t
+#define COMPACT_WEIGHT_MAX UINT16_MAX
+#define COMPACT_DISTANCE int64_t
+#define COMPACT_DISTANCE_MAX INT64_MAX
+#define COMPACT_ARITY COMPACT_HEAP_ARITY
+#include "graph_compact_template.h"
+
+#define COMPACT_PREFIX id32w32d32
+#define COMPACT_ID uint32_t
+#define COMPACT_WEIGHT uint32_t
+#define COMPACT_WEIGHT_MAX UINT32_MAX
+#define COMPACT_DISTANCE uint32_t
+#define COMPACT_DISTANCE_MAX UINT32_MAX
+#define COMPACT_ARITY COMPACT_HEAP_ARITY
+#include "graph_compact_template.h"
+
+#define COMPACT_PREFIX id32w32d64
+#define COMPACT_ID uint32_t
+#define COMPACT_WEIGHT uint32_t
+#define COMPACT_WEIGHT_MAX UINT32_MAX
+#define COMPACT_DISTANCE int64_t
+#define COMPACT_DISTANCE_MAX INT64_MAX
+#define COMPACT_ARITY COMPACT_HEAP_ARITY
+#include "graph_compact_template.h"
+
+typedef struct layout_ops
+{
+  const char *name;
+  int idBytes;
+  int weightBytes;
+  int64_t maxDistance;  // distances must stay below this
+  bool (*fill)(CompactGraph *compact, Graph *graph);
+  bool (*dijkstra)(CompactGraph *compact, int startVertex, int64_t *distances,
+                   int *predecessors);
+  int64_t (*prim)(CompactGraph *compact, int startVertex, int *predecessors);
+} LayoutOps;
+
+// Indexed by CompactLayout; entry 0 stands for COMPACT_NARROWEST.
+static const LayoutOps layouts[] = {
+    {"narrowest", 0, 0, 0, NULL, NULL, NULL},
+    {"id16 w16 d32", 2, 2, UINT32_MAX, id16w16d32_fill, id16w16d32_dijkstra,
+     id16w16d32_prim},
+    {"id32 w16 d32", 4, 2, UINT32_MAX, id32w16d32_fill, id32w16d32_dijkstra,
+     id32w16d32_prim},
+    {"id32 w16 d64", 4, 2, INT64_MAX, id32w16d64_fill, id32w16d64_dijkstra,
+     id32w16d64_prim},
+    {"id32 w32 d32", 4, 4, UINT32_MAX, id32w32d32_fill, id32w32d32_dijkstra,
+     id32w32d32_prim},
+    {"id32 w32 d64", 4, 4, INT64_MAX, id32w32d64_fill, id32w32d64_dijkstra,
+     id32w32d64_prim},
+};
+
+#define NUM_LAYOUTS (int)(sizeof(layouts) / sizeof(layouts[0]))
+
+/* Returns true iff a graph with 'numVertices' vertices and weights up to
+ * 'maxWeight' fits 'layout': its IDs and weights stay below the largest
+ * value of their types, and no path is as long as the largest distance.
+ */
+static bool layoutFits(CompactLayout layout, int numVertices, int maxWeight)
+{
+  const LayoutOps *ops = &layouts[layout];
+  int64_t longestPath = (int64_t)(numVertices > 0 ? numVertices - 1 : 0) *
+                        maxWeight;
+  return (ops->idBytes == 4 || numVertices < UINT16_MAX) &&
+         (ops->weightBytes == 4 || maxWeight < UINT16_MAX) &&
+         longestPath < ops->maxDistance;
+}
+
+/* Returns a compact copy of Graph 'graph' in layout 'layout', or in the
+ * narrowest layout it fits if 'layout' is COMPACT_NARROWEST.
+ * Returns NULL if 'graph' does not fit 'layout', if it has a negative
+ * weight, or if memory could not be allocated.
+ */
+CompactGraph *newCompactGraph(Graph *graph, CompactLayout layout)
+{
+  int n = graph->numVertices;
+  if (layout < COMPACT_NARROWEST || layout >= NUM_LAYOUTS)
+  {
+    return NULL;
+  }
+  CompactGraph *compact = malloc(sizeof(CompactGraph));
+  if (compact == NULL)
+  {
+    return NULL;
+  }
+  compact->numVertices = n;
+  compact->targets = NULL;
+  compact->weights = NULL;
+  compact->offsets = malloc(sizeof(uint32_t) * (n + 1));
+  if (compact->offsets == NULL)
+  {
+    free(compact);
+    return NULL;
+  }
+
+  long numArcs = 0;
+  int maxWeight = 0;
+  for (int u = 0; u < n; u++)
+  {
+    compact->offsets[u] = numArcs;
+    for (EdgeList *adjList = graph->vertices[u]->adjList; adjList != NULL;
+         adjList = adjList->next)
+    {
+      int weight = adjList->edge->weight;
+      maxWeight = weight > maxWeight ? weight : maxWeight;
+      if (weight < 0)
+      {
+        deleteCompactGraph(compact);
+        return NULL;
+      }
+      numArcs++;
+    }
+  }
+  compact->offsets[n] = numArcs;
+  compact->numArcs = numArcs;
+
+  if (layout == COMPACT_NARROWEST)
+  {
+    layout = COMPACT_ID16_W16_D32;
+    while (layout < NUM_LAYOUTS - 1 && !layoutFits(layout, n, maxWeight))
+    {
+      layout++;
+    }
+  }
+  compact->layout = layout;
+  if (!layoutFits(layout, n, maxWeight) ||
+      !layouts[layout].fill(compact, graph))
+  {
+    deleteCompactGraph(compact);
+    return NULL;
+  }
+  return compact;
+}
+
+/* Frees all memory allocated for 'compact'. */
+void deleteCompactGraph(CompactGraph *compact)
+{
+  if (compact == NULL)
+  {
+    return;
+  }
+  free(compact->offsets);
+  free(compact->targets);
+  free(compact->weights);
+  free(compact);
+}
+
+/* Returns the number of bytes 'compact' takes. */
+long compactGraphBytes(CompactGraph *compact)
+{
+  const LayoutOps *ops = &layouts[compact->layout];
+  return sizeof(CompactGraph) + sizeof(uint32_t) * (compact->numVertices + 1) +
+         (long)(ops->idBytes + ops->weightBytes) * compact->numArcs;
+}
+
+/* Returns the name of 'layout', such as "id16 w16 d32". */
+const char *compactLayoutName(CompactLayout layout)
+{
+  return layout >= COMPACT_NARROWEST && layout < NUM_LAYOUTS
+             ? layouts[layout].name
+             : "unknown";
+}
+
+/* Runs Dijkstra's algorithm on 'compact' from vertex 'startVertex', and
+ * stores in distances[v] the distance to v (COMPACT_UNREACHABLE if there is
+ * no path) and in predecessors[v] its predecessor on a shortest path (-1 for
+ * the start vertex and for unreachable vertices).
+ * Returns false if 'startVertex' is not valid or if memory could not be
+ * allocated.
+ */
+bool getDistancesCompact(CompactGraph *compact, int startVertex,
+                         int64_t *distances, int *predecessors)
+{
+  if (startVertex < 0 || startVertex >= compact->numVertices)
+  {
+    return false;
+  }
+  return layouts[compact->layout].dijkstra(compact, startVertex, distances,
+                                           predecessors);
+}
+
+/* Runs Prim's algorithm on 'compact' from vertex 'startVertex', stores in
+ * predecessors[v] the other end of v's tree edge (-1 for the start vertex
+ * and for vertices it cannot reach), and returns the total weight of the
+ * tree. It spans the vertices that can be reached from 'startVertex'.
+ * Returns -1 if 'startVertex' is not valid or if memory could not be
+ * allocated.
+ */
+int64_t getSpanningTreeCompact(CompactGraph *compact, int startVertex,
+                               int *predecessors)
+{
+  if (startVertex < 0 || startVertex >= compact->numVertices)
+  {
+    return -1;
+  }
+  return layouts[compact->layout].prim(compact, startVertex, predecessors);
+}
@@ -0,0 +1,86 @@
+/*
+ * Header file for compact graphs: read-only copies of a Graph in the
+ * narrowest integer types its size and weights allow, with Dijkstra's and
+ * Prim's algorithms compiled separately for each.
+ *
+ * A CompactGraph keeps every adjacency list as a run of the arrays 'targets'
+ * and 'weights' (CSR), with 16-bit vertex IDs if there are fewer than 65535
+ * vertices and 16-bit weights if all weights are below 65535, and 32-bit
+ * ones otherwise. Distances are 32-bit if no path can be longer than that,
+ * and 64-bit otherwise. Prim's algorithm keys its heap on weights, so with
+ * 16-bit weights its heap nodes are 4 bytes.
+ *
+ * The algorithms and their heaps are written once, in
+ * graph_compact_template.h and heap_template.h, and instantiated in
+ * graph_compact.c for every layout, so the types are fixed in each copy and
+ * the only dispatch on the layout is once per call. An arc takes 4 to 8
+ * bytes here, against the 40 or more of an EdgeList node and its Edge.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "graph.h"
+
+#ifndef __Graph_Compact_header
+#define __Graph_Compact_header
+
+#define COMPACT_UNREACHABLE INT64_MAX  // distance of a vertex with no path
+
+typedef enum compact_layout {
+  COMPACT_NARROWEST,     // for newCompactGraph: the smallest that fits
+  COMPACT_ID16_W16_D32,  // 16-bit IDs and weights, 32-bit distances
+  COMPACT_ID32_W16_D32,
+  COMPACT_ID32_W16_D64,
+  COMPACT_ID32_W32_D32,
+  COMPACT_ID32_W32_D64   // fits every graph with non-negative weights
+} CompactLayout;
+
+typedef struct compact_graph {
+  int numVertices;       // vertex IDs are 0, 1, ..., numVertices-1
+  long numArcs;          // entries in 'targets' and 'weights'
+  CompactLayout layout;  // the types of 'targets', 'weights' and distances
+  uint32_t* offsets;     // the arcs of v are offsets[v] .. offsets[v+1]-1
+  void* targets;         // targets[i]: the vertex arc i leads to
+  void* weights;         // weights[i]: the weight of arc i
+} CompactGraph;
+
+/* Returns a compact copy of Graph 'graph' in layout 'layout', or in the
+ * narrowest layout it fits if 'layout' is COMPACT_NARROWEST.
+ * Returns NULL if 'graph' does not fit 'layout', if it has a negative
+ * weight, or if memory could not be allocated.
+ */
+CompactGraph* newCompactGraph(Graph* graph, CompactLayout layout);
+
+/* Frees all memory allocated for 'compact'. */
+void deleteCompactGraph(CompactGraph* compact);
+
+/* Returns the number of bytes 'compact' takes. */
+long compactGraphBytes(CompactGraph* compact);
+
+/* Returns the name of 'layout', such as "id16 w16 d32". */
+const char* compactLayoutName(CompactLayout layout);
+
+/* Runs Dijkstra's algorithm on 'compact' from vertex 'startVertex', and
+ * stores in distances[v] the distance to v (COMPACT_UNREACHABLE if there is
+ * no path) and in predecessors[v] its predecessor on a shortest path (-1 for
+ * the start vertex and for unreachable vertices).
+ * Returns false if 'startVertex' is not valid or if memory could not be
+ * allocated.
+ */
+bool getDistancesCompact(CompactGraph* compact, int startVertex,
+                         int64_t* distances, int* predecessors);
+
+/* Runs Prim's algorithm on 'compact' from vertex 'startVertex', stores in
+ * predecessors[v] the other end of v's tree edge (-1 for the start vertex
+ * and for vertices it cannot reach), and returns the total weight of the
+ * tree. It spans the vertices that can be reached from 'startVertex'.
+ * Returns -1 if 'startVertex' is not valid or if memory could not be
+ * allocated.
+ */
+int64_t getSpanningTreeCompact(CompactGraph* compact, int startVertex,
+                               int* predecessors);
+
+#endif
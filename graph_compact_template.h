@@ -0,0 +1,163 @@
+/*
+ * Template for the algorithms on one layout of CompactGraph (see
+ * graph_compact.h): filling it from a Graph, Dijkstra's algorithm and
+ * Prim's algorithm, each with its own heap from heap_template.h.
+ *
+ * There is no include guard: every inclusion generates the functions of one
+ * more layout. Define these first; they are undefined again at the end:
+ *   COMPACT_PREFIX        prefix of the generated names, e.g. id16w16d32 for
+ *                         id16w16d32_fill, id16w16d32_dijkstra and
+ *                         id16w16d32_prim
+ *   COMPACT_ID            the unsigned type of 'targets'
+ *   COMPACT_WEIGHT        the unsigned type of 'weights'
+ *   COMPACT_WEIGHT_MAX    its largest value, which no weight may have
+ *   COMPACT_DISTANCE      the type of distances
+ *   COMPACT_DISTANCE_MAX  its largest value, which no distance may reach
+ *   COMPACT_ARITY         the arity of the heaps
+ * The functions are static, for the file that includes the template.
+ */
+
+#include <stdint.h>
+
+#include "graph_compact.h"
+#include "graph_symmetric.h"
+
+#define COMPACT_CAT2(a, b) a##_##b
+#define COMPACT_CAT(a, b) COMPACT_CAT2(a, b)
+#define COMPACT_FN(name) COMPACT_CAT(COMPACT_PREFIX, name)
+
+#define HEAP_PREFIX COMPACT_FN(distance)
+#define HEAP_KEY COMPACT_DISTANCE
+#define HEAP_KEY_MAX COMPACT_DISTANCE_MAX
+#define HEAP_ID COMPACT_ID
+#define HEAP_ARITY COMPACT_ARITY
+#include "heap_template.h"
+
+#define HEAP_PREFIX COMPACT_FN(weight)
+#define HEAP_KEY COMPACT_WEIGHT
+#define HEAP_KEY_MAX COMPACT_WEIGHT_MAX
+#define HEAP_ID COMPACT_ID
+#define HEAP_ARITY COMPACT_ARITY
+#include "heap_template.h"
+
+/* Allocates the targets and weights of 'compact' and copies into them the
+ * adjacency lists of 'graph', which 'compact' has the offsets of. Returns
+ * false if memory could not be allocated.
+ */
+static bool COMPACT_FN(fill)(CompactGraph* compact, Graph* graph) {
+  long numArcs = compact->numArcs > 0 ? compact->numArcs : 1;
+  COMPACT_ID* targets = malloc(sizeof(COMPACT_ID) * numArcs);
+  COMPACT_WEIGHT* weights = malloc(sizeof(COMPACT_WEIGHT) * numArcs);
+  compact->targets = targets;
+  compact->weights = weights;
+  if (targets == NULL || weights == NULL) return false;
+  for (int u = 0; u < graph->numVertices; u++) {
+    uint32_t i = compact->offsets[u];
+    for (EdgeList* adjList = graph->vertices[u]->adjList; adjList != NULL;
+         adjList = adjList->next, i++) {
+      targets[i] = (COMPACT_ID)otherEndpoint(adjList->edge, u);
+      weights[i] = (COMPACT_WEIGHT)adjList->edge->weight;
+    }
+  }
+  return true;
+}
+
+/* Dijkstra's algorithm for getDistancesCompact. */
+static bool COMPACT_FN(dijkstra)(CompactGraph* compact, int startVertex,
+                                 int64_t* distances, int* predecessors) {
+  int n = compact->numVertices;
+  const uint32_t* offsets = compact->offsets;
+  const COMPACT_ID* targets = compact->targets;
+  const COMPACT_WEIGHT* weights = compact->weights;
+  COMPACT_DISTANCE* distance = malloc(sizeof(COMPACT_DISTANCE) * n);
+  COMPACT_FN(distance_Heap) heap;
+  if (distance == NULL || !COMPACT_FN(distance_heapInit)(&heap, n)) {
+    free(distance);
+    return false;
+  }
+  for (int v = 0; v < n; v++) {
+    distance[v] = COMPACT_DISTANCE_MAX;
+    predecessors[v] = -1;
+  }
+
+  distance[startVertex] = 0;
+  COMPACT_FN(distance_heapPush)(&heap, 0, (COMPACT_ID)startVertex);
+  while (heap.size > 0) {
+    COMPACT_FN(distance_HeapNode) node = COMPACT_FN(distance_heapPop)(&heap);
+    COMPACT_ID u = node.id;
+    for (uint32_t i = offsets[u]; i < offsets[u + 1]; i++) {
+      COMPACT_ID v = targets[i];
+      COMPACT_DISTANCE through = node.key + weights[i];
+      // Settled vertices are never closer via u: weights are >= 0.
+      if (through < distance[v]) {
+        distance[v] = through;
+        predecessors[v] = u;
+        COMPACT_FN(distance_heapPush)(&heap, through, v);
+      }
+    }
+  }
+
+  for (int v = 0; v < n; v++) {
+    distances[v] = distance[v] == COMPACT_DISTANCE_MAX ? COMPACT_UNREACHABLE
+                                                       : distance[v];
+  }
+  COMPACT_FN(distance_heapFree)(&heap);
+  free(distance);
+  return true;
+}
+
+/* Prim's algorithm for getSpanningTreeCompact. */
+static int64_t COMPACT_FN(prim)(CompactGraph* compact, int startVertex,
+                                int* predecessors) {
+  int n = compact->numVertices;
+  const uint32_t* offsets = compact->offsets;
+  const COMPACT_ID* targets = compact->targets;
+  const COMPACT_WEIGHT* weights = compact->weights;
+  COMPACT_WEIGHT* key = malloc(sizeof(COMPACT_WEIGHT) * n);
+  bool* inTree = calloc(n, sizeof(bool));
+  COMPACT_FN(weight_Heap) heap;
+  if (key == NULL || inTree == NULL ||
+      !COMPACT_FN(weight_heapInit)(&heap, n)) {
+    free(key);
+    free(inTree);
+    return -1;
+  }
+  for (int v = 0; v < n; v++) {
+    key[v] = COMPACT_WEIGHT_MAX;
+    predecessors[v] = -1;
+  }
+
+  int64_t total = 0;
+  key[startVertex] = 0;
+  COMPACT_FN(weight_heapPush)(&heap, 0, (COMPACT_ID)startVertex);
+  while (heap.size > 0) {
+    COMPACT_FN(weight_HeapNode) node = COMPACT_FN(weight_heapPop)(&heap);
+    COMPACT_ID u = node.id;
+    inTree[u] = true;
+    total += node.key;
+    for (uint32_t i = offsets[u]; i < offsets[u + 1]; i++) {
+      COMPACT_ID v = targets[i];
+      if (!inTree[v] && weights[i] < key[v]) {
+        key[v] = weights[i];
+        predecessors[v] = u;
+        COMPACT_FN(weight_heapPush)(&heap, weights[i], v);
+      }
+    }
+  }
+
+  COMPACT_FN(weight_heapFree)(&heap);
+  free(key);
+  free(inTree);
+  return total;
+}
+
+#undef COMPACT_CAT2
+#undef COMPACT_CAT
+#undef COMPACT_FN
+#undef COMPACT_PREFIX
+#undef COMPACT_ID
+#undef COMPACT_WEIGHT
+#undef COMPACT_WEIGHT_MAX
+#undef COMPACT_DISTANCE
+#undef COMPACT_DISTANCE_MAX
+#undef COMPACT_ARITY
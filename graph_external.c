@@ -0,0 +1,541 @@
+/*
+ * Algorithms on edge sets too large to hold in memory.
+ */
+
+#include <string.h>
+#include <unistd.h>
+
+#include "graph_external.h"
+#include "graph_io.h"
+
+/* Receives the merged edges in order; returns false to stop the merge. */
+typedef bool (*EdgeSink)(void *ctx, Edge *edge);
+
+typedef struct run_file {
+  FILE *file;           // the sorted runs, one after another
+  long *runStart;       // run r is edges runStart[r] .. runStart[r+1]-1
+  int numRuns;
+  int capacity;         // the number of runs that fit in 'runStart'
+  long numEdges;        // the number of edges in 'file'
+} RunFile;
+
+typedef struct run_reader {
+  long position;        // the index in the file of the next edge to read
+  long end;             // the index just past the run
+  Edge *buffer;         // the next edges of the run
+  long size;            // the number of edges in 'buffer'
+  long next;            // the index of the next edge in 'buffer'
+  bool failed;          // true iff a read failed
+} RunReader;
+
+typedef struct run_writer {
+  RunFile *runs;        // the file the run is appended to
+  Edge *buffer;         // edges not yet written
+  long size;            // the number of edges in 'buffer'
+  long capacity;        // the number of edges that fit in 'buffer'
+  ExternalStats *stats;
+  bool failed;          // true iff a write failed
+} RunWriter;
+
+typedef struct kruskal {
+  int *parent;          // union-find over the vertices
+  unsigned char *rank;
+  Output *tree;
+  ExternalStats *stats;
+} Kruskal;
+
+/* Orders edges by weight, then by endpoints, for qsort. */
+static int compareEdges(const void *a, const void *b)
+{
+  const Edge *x = a;
+  const Edge *y = b;
+  if (x->weight != y->weight)
+  {
+    return x->weight < y->weight ? -1 : 1;
+  }
+  if (x->fromVertex != y->fromVertex)
+  {
+    return x->fromVertex < y->fromVertex ? -1 : 1;
+  }
+  return (x->toVertex > y->toVertex) - (x->toVertex < y->toVertex);
+}
+
+/* Returns a new temporary file in 'tempDir' (the system default if NULL),
+ * open for reading and writing and already unlinked, so that it goes away
+ * when it is closed. Returns NULL if it could not be created.
+ */
+static FILE *newTempFile(const char *tempDir)
+{
+  if (tempDir == NULL)
+  {
+    return tmpfile();
+  }
+  size_t length = strlen(tempDir) + sizeof("/graph_runs_XXXXXX");
+  char *path = malloc(length);
+  if (path == NULL)
+  {
+    return NULL;
+  }
+  snprintf(path, length, "%s/graph_runs_XXXXXX", tempDir);
+  int fd = mkstemp(path);
+  FILE *res = NULL;
+  if (fd >= 0)
+  {
+    unlink(path);
+    res = fdopen(fd, "w+b");
+    if (res == NULL)
+    {
+      close(fd);
+    }
+  }
+  free(path);
+  return res;
+}
+
+/* Initializes 'runs' with a new, empty temporary file in 'tempDir'.
+ * Returns false if it could not be created.
+ */
+static bool newRunFile(RunFile *runs, const char *tempDir)
+{
+  memset(runs, 0, sizeof(RunFile));
+  runs->file = newTempFile(tempDir);
+  runs->runStart = malloc(sizeof(long) * 16);
+  runs->capacity = runs->runStart != NULL ? 15 : 0;
+  if (runs->file == NULL || runs->runStart == NULL)
+  {
+    return false;
+  }
+  runs->runStart[0] = 0;
+  return true;
+}
+
+/* Closes the file of 'runs' and frees its memory, but not 'runs' itself. */
+static void freeRunFile(RunFile *runs)
+{
+  if (runs->file != NULL)
+  {
+    fclose(runs->file);
+  }
+  free(runs->runStart);
+}
+
+/* Ends the run being written to 'runs' at its current end. Returns false
+ * if memory could not be allocated.
+ */
+static bool endRun(RunFile *runs)
+{
+  if (runs->numRuns == runs->capacity)
+  {
+    int capacity = 2 * (runs->capacity + 1);
+    long *runStart = realloc(runs->runStart, sizeof(long) * capacity);
+    if (runStart == NULL)
+    {
+      return false;
+    }
+    runs->runStart = runStart;
+    runs->capacity = capacity - 1;
+  }
+  runs->runStart[++runs->numRuns] = runs->numEdges;
+  return true;
+}
+
+/* Appends the 'count' edges in 'edges' to 'runs'. Returns false iff the
+ * write failed.
+ */
+static bool appendEdges(RunFile *runs, Edge *edges, long count,
+                        ExternalStats *stats)
+{
+  if (fwrite(edges, sizeof(Edge), count, runs->file) != (size_t)count)
+  {
+    return false;
+  }
+  runs->numEdges += count;
+  stats->bytesWritten += sizeof(Edge) * count;
+  return true;
+}
+
+/* Reads the next edge of 'f' into 'edge': a record of an edge file, or if
+ * 'text' is true, a line of the edge stream format with 'numVertices'
+ * vertices, skipping blank lines. Returns 1 if an edge was read, 0 at the
+ * end of the file and -1 if the edge is not valid.
+ */
+static int readEdge(FILE *f, bool text, int numVertices, Edge *edge,
+                    ExternalStats *stats)
+{
+  if (!text)
+  {
+    if (fread(edge, sizeof(Edge), 1, f) != 1)
+    {
+      return 0;
+    }
+    stats->bytesRead += sizeof(Edge);
+    return edge->fromVertex < 0 || edge->toVertex < 0 || edge->weight < 0
+               ? -1
+               : 1;
+  }
+  char line[MAX_LIMIT];
+  char *token = NULL;
+  while (token == NULL || *token == '\n')
+  {
+    if (!fgets(line, MAX_LIMIT, f))
+    {
+      return 0;
+    }
+    stats->bytesRead += strlen(line);
+    token = strtok(line, " ");
+  }
+  edge->fromVertex = readVertexID(token, numVertices);
+  edge->toVertex = readVertexID(strtok(NULL, " "), numVertices);
+  edge->weight = readWeight(strtok(NULL, " "));
+  return edge->fromVertex == -1 || edge->toVertex == -1 || edge->weight == -1
+             ? -1
+             : 1;
+}
+
+/* Reads all edges of 'f' and writes them to 'runs' in sorted runs that fit
+ * in 'memoryBudget' bytes. If they all fit in one, they are not written out
+ * but left sorted in '*edges', and their number in '*count'. Returns false
+ * if an edge is not valid or a run could not be written.
+ */
+static bool formRuns(RunFile *runs, FILE *f, bool text, size_t memoryBudget,
+                     Edge **edges, long *count, ExternalStats *stats)
+{
+  char line[MAX_LIMIT];
+  if (text)
+  {
+    if (!fgets(line, MAX_LIMIT, f) || atoi(line) < 0)
+    {
+      return false;
+    }
+    stats->bytesRead += strlen(line);
+    stats->numVertices = atoi(line);
+  }
+
+  long capacity = memoryBudget / sizeof(Edge);
+  Edge *buffer = malloc(sizeof(Edge) * capacity);
+  if (buffer == NULL)
+  {
+    return false;
+  }
+  long size = 0;
+  int status;
+  while ((status = readEdge(f, text, stats->numVertices, &buffer[size],
+                            stats)) == 1)
+  {
+    Edge *edge = &buffer[size++];
+    stats->numEdges++;
+    int larger = edge->fromVertex > edge->toVertex ? edge->fromVertex
+                                                   : edge->toVertex;
+    if (larger >= stats->numVertices)
+    {
+      stats->numVertices = larger + 1;
+    }
+    if (size == capacity)
+    {
+      qsort(buffer, size, sizeof(Edge), compareEdges);
+      if (!appendEdges(runs, buffer, size, stats) || !endRun(runs))
+      {
+        status = -1;
+        break;
+      }
+      size = 0;
+    }
+  }
+
+  qsort(buffer, size, sizeof(Edge), compareEdges);
+  if (status == 0 && runs->numRuns == 0)
+  {
+    *edges = buffer;
+    *count = size;
+    return true;
+  }
+  if (status == 0 && size > 0 &&
+      (!appendEdges(runs, buffer, size, stats) || !endRun(runs)))
+  {
+    status = -1;
+  }
+  free(buffer);
+  stats->numRuns = runs->numRuns;
+  return status == 0 && fflush(runs->file) == 0;
+}
+
+/* Refills the buffer of 'reader', which has room for 'capacity' edges, from
+ * its run in 'runs'. Returns false at the end of the run or if the read
+ * failed.
+ */
+static bool refill(RunReader *reader, long capacity, RunFile *runs,
+                   ExternalStats *stats)
+{
+  long count = reader->end - reader->position;
+  if (count > capacity)
+  {
+    count = capacity;
+  }
+  size_t bytes = sizeof(Edge) * count;
+  size_t done = 0;
+  while (done < bytes)
+  {
+    ssize_t got = pread(fileno(runs->file), (char *)reader->buffer + done,
+                        bytes - done,
+                        (off_t)sizeof(Edge) * reader->position + done);
+    if (got <= 0)
+    {
+      reader->failed = true;
+      return false;
+    }
+    done += got;
+  }
+  stats->bytesRead += bytes;
+  reader->position += count;
+  reader->size = count;
+  reader->next = 0;
+  return count > 0;
+}
+
+/* Returns the next edge of the run of 'reader'. */
+static Edge *peekEdge(RunReader *reader)
+{
+  return &reader->buffer[reader->next];
+}
+
+/* Moves the run at index 'i' of the heap 'heap' of 'size' runs down until
+ * the run with the smallest next edge (by compareEdges) is at the top. The
+ * heap orders whole edges, not just weights, so that the forest does not
+ * depend on how the edges were split into runs.
+ */
+static void siftDown(int *heap, int size, int i, RunReader *readers)
+{
+  while (true)
+  {
+    int smallest = i;
+    for (int child = 2 * i + 1; child <= 2 * i + 2 && child < size; child++)
+    {
+      if (compareEdges(peekEdge(&readers[heap[child]]),
+                       peekEdge(&readers[heap[smallest]])) < 0)
+      {
+        smallest = child;
+      }
+    }
+    if (smallest == i)
+    {
+      return;
+    }
+    int swap = heap[i];
+    heap[i] = heap[smallest];
+    heap[smallest] = swap;
+    i = smallest;
+  }
+}
+
+/* Merges the 'count' runs of 'runs' from run 'first' on and passes their
+ * edges to 'sink' in order, until it asks to stop, using at most
+ * 'memoryBudget' bytes of buffers.
+ * Returns false if memory could not be allocated or a read failed.
+ */
+static bool mergeRuns(RunFile *runs, int first, int count,
+                      size_t memoryBudget, EdgeSink sink, void *ctx,
+                      ExternalStats *stats)
+{
+  long capacity = memoryBudget / count / sizeof(Edge);
+  RunReader *readers = calloc(count, sizeof(RunReader));
+  int *heap = malloc(sizeof(int) * count);
+  int size = 0;
+  bool ok = readers != NULL && heap != NULL;
+  for (int r = 0; ok && r < count; r++)
+  {
+    readers[r].position = runs->runStart[first + r];
+    readers[r].end = runs->runStart[first + r + 1];
+    readers[r].buffer = malloc(sizeof(Edge) * capacity);
+    ok = readers[r].buffer != NULL;
+    if (ok && refill(&readers[r], capacity, runs, stats))
+    {
+      heap[size++] = r;
+    }
+  }
+  for (int i = size / 2 - 1; ok && i >= 0; i--)
+  {
+    siftDown(heap, size, i, readers);
+  }
+
+  while (ok && size > 0)
+  {
+    RunReader *reader = &readers[heap[0]];
+    if (!sink(ctx, &reader->buffer[reader->next++]))
+    {
+      break;
+    }
+    if (reader->next == reader->size &&
+        !refill(reader, capacity, runs, stats))
+    {
+      heap[0] = heap[--size];  // the run is used up
+    }
+    siftDown(heap, size, 0, readers);
+  }
+
+  for (int r = 0; readers != NULL && r < count; r++)
+  {
+    ok = ok && !readers[r].failed;
+    free(readers[r].buffer);
+  }
+  free(readers);
+  free(heap);
+  return ok;
+}
+
+/* Appends the edges buffered in 'writer' to its file. */
+static void flushWriter(RunWriter *writer)
+{
+  writer->failed = writer->failed ||
+                   !appendEdges(writer->runs, writer->buffer, writer->size,
+                                writer->stats);
+  writer->size = 0;
+}
+
+/* EdgeSink that appends 'edge' to the run of the RunWriter 'ctx'. */
+static bool writeEdge(void *ctx, Edge *edge)
+{
+  RunWriter *writer = ctx;
+  writer->buffer[writer->size++] = *edge;
+  if (writer->size == writer->capacity)
+  {
+    flushWriter(writer);
+  }
+  return !writer->failed;
+}
+
+/* Merges the runs in 'runs' 'fanIn' at a time into longer runs in a new
+ * file in 'tempDir', until at most 'fanIn' are left. Uses at most
+ * 'memoryBudget' bytes. Returns false if a run could not be written.
+ */
+static bool mergePasses(RunFile *runs, int fanIn, size_t memoryBudget,
+                        const char *tempDir, ExternalStats *stats)
+{
+  while (runs->numRuns > fanIn)
+  {
+    stats->numMergePasses++;
+    RunFile merged;
+    // The writer's buffer counts as one more run in the budget.
+    RunWriter writer = {&merged, NULL, 0,
+                        memoryBudget / (fanIn + 1) / sizeof(Edge), stats,
+                        false};
+    writer.buffer = malloc(sizeof(Edge) * writer.capacity);
+    bool ok = newRunFile(&merged, tempDir) && writer.buffer != NULL;
+    for (int first = 0; ok && first < runs->numRuns; first += fanIn)
+    {
+      int count = runs->numRuns - first < fanIn ? runs->numRuns - first
+                                                : fanIn;
+      ok = mergeRuns(runs, first, count,
+                     memoryBudget - sizeof(Edge) * writer.capacity,
+                     writeEdge, &writer, stats);
+      flushWriter(&writer);
+      ok = ok && !writer.failed && endRun(&merged);
+    }
+    ok = ok && fflush(merged.file) == 0;
+    free(writer.buffer);
+    freeRunFile(runs);
+    *runs = merged;
+    if (!ok)
+    {
+      return false;
+    }
+  }
+  return true;
+}
+
+/* Returns the root of the set of 'v' in the union-find of 'kruskal',
+ * halving the path to it on the way.
+ */
+static int findRoot(Kruskal *kruskal, int v)
+{
+  while (kruskal->parent[v] != v)
+  {
+    kruskal->parent[v] = kruskal->parent[kruskal->parent[v]];
+    v = kruskal->parent[v];
+  }
+  return v;
+}
+
+/* EdgeSink that adds 'edge' to the forest of the Kruskal 'ctx' if it joins
+ * two of its trees. Stops once the forest spans all vertices.
+ */
+static bool addToForest(void *ctx, Edge *edge)
+{
+  Kruskal *kruskal = ctx;
+  int u = findRoot(kruskal, edge->fromVertex);
+  int v = findRoot(kruskal, edge->toVertex);
+  if (u != v)
+  {
+    if (kruskal->rank[u] < kruskal->rank[v])
+    {
+      int swap = u;
+      u = v;
+      v = swap;
+    }
+    kruskal->parent[v] = u;
+    if (kruskal->rank[u] == kruskal->rank[v])
+    {
+      kruskal->rank[u]++;
+    }
+    outputEdge(kruskal->tree, edge);
+    kruskal->stats->numTreeEdges++;
+    kruskal->stats->totalWeight += edge->weight;
+  }
+  return kruskal->stats->numTreeEdges < kruskal->stats->numVertices - 1;
+}
+
+/* Computes a minimum spanning forest of the edges in 'edges' (an edge file,
+ * or in the edge stream format if 'text') and writes its edges to 'tree',
+ * sorting with at most 'memoryBudget' bytes and temporary files in
+ * 'tempDir'. Stores counts and I/O volume in 'stats'.
+ * Returns false if an edge is not valid or memory, a temporary file or a
+ * write ran out.
+ */
+bool getMSTexternal(FILE *edges, bool text, Output *tree, size_t memoryBudget,
+                    const char *tempDir, ExternalStats *stats)
+{
+  memset(stats, 0, sizeof(ExternalStats));
+  if (memoryBudget < 3 * MIN_MERGE_BUFFER)
+  {
+    memoryBudget = 3 * MIN_MERGE_BUFFER;
+  }
+  RunFile runs;
+  Edge *inMemory = NULL;
+  long numInMemory = 0;
+  bool ok = newRunFile(&runs, tempDir) &&
+            formRuns(&runs, edges, text, memoryBudget, &inMemory,
+                     &numInMemory, stats);
+  // Every run in a merge gets at least MIN_MERGE_BUFFER bytes of buffer.
+  int fanIn = memoryBudget / MIN_MERGE_BUFFER - 1;
+  ok = ok && mergePasses(&runs, fanIn, memoryBudget, tempDir, stats);
+
+  int n = stats->numVertices;
+  Kruskal kruskal = {malloc(sizeof(int) * (n + 1)), malloc(n + 1), tree,
+                     stats};
+  ok = ok && kruskal.parent != NULL && kruskal.rank != NULL;
+  for (int v = 0; ok && v < n; v++)
+  {
+    kruskal.parent[v] = v;
+    kruskal.rank[v] = 0;
+  }
+  long written = tree->written + tree->size;
+  if (ok && inMemory != NULL)
+  {
+    for (long i = 0; i < numInMemory && addToForest(&kruskal, &inMemory[i]);
+         i++)
+    {
+    }
+  }
+  else if (ok && runs.numRuns > 0)
+  {
+    ok = mergeRuns(&runs, 0, runs.numRuns, memoryBudget, addToForest,
+                   &kruskal, stats);
+  }
+  ok = flushOutput(tree) && ok;
+  stats->bytesWritten += tree->written - written;
+
+  freeRunFile(&runs);
+  free(inMemory);
+  free(kruskal.parent);
+  free(kruskal.rank);
+  return ok;
+}
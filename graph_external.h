@@ -0,0 +1,50 @@
+/*
+ * Header file for algorithms on edge sets too large to hold in memory.
+ *
+ * getMSTexternal is semi-external: it keeps only a union-find over the
+ * vertices in memory, and reads the edges from a file. It sorts them by
+ * weight in runs that fit in a memory budget, merges the runs k at a time,
+ * and streams the last merge through Kruskal's algorithm, so the sorted
+ * edge set is never written out whole.
+ *
+ * Edge files hold Edge records as they are in memory: fromVertex, toVertex
+ * and weight as native ints, the format ./tester -b writes trees in.
+ */
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "graph.h"
+#include "graph_output.h"
+
+#ifndef __Graph_External_header
+#define __Graph_External_header
+
+#define MIN_MERGE_BUFFER 65536  // bytes of buffer for each run in a merge
+
+typedef struct external_stats {
+  long numEdges;        // the number of edges read
+  int numVertices;      // vertex IDs are 0, 1, ..., numVertices-1
+  int numRuns;          // the number of sorted runs written
+  int numMergePasses;   // merge passes before the one that feeds Kruskal's
+  long bytesRead;       // bytes read from the input and from runs
+  long bytesWritten;    // bytes written to runs and to the output
+  long numTreeEdges;    // the number of edges in the spanning forest
+  long totalWeight;     // their total weight
+} ExternalStats;
+
+/* Computes a minimum spanning forest of the edges in 'edges' and writes its
+ * edges to 'tree' in order of weight, as with outputEdge. 'edges' is an
+ * edge file, or if 'text' is true, in the edge stream format of graph_io.h.
+ * Sorting uses at most 'memoryBudget' bytes (at least 3 *
+ * MIN_MERGE_BUFFER), plus the union-find, and keeps its runs in temporary
+ * files in 'tempDir' (or the system default if NULL). The counts and I/O
+ * volume are stored in 'stats'.
+ * Returns false if an edge is not valid (a vertex ID or weight is
+ * negative), or if memory, a temporary file or a write ran out.
+ */
+bool getMSTexternal(FILE* edges, bool text, Output* tree, size_t memoryBudget,
+                    const char* tempDir, ExternalStats* stats);
+
+#endif
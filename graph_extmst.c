@@ -0,0 +1,95 @@
+/*
+ *  Minimum spanning forests of edge sets too large to load, with only a
+ *  union-find over the vertices in memory (see graph_external.h).
+ *
+ *  ---------------------------------------------------------------------------
+ *   Compile:
+ *   gcc -Wall -Werror graph.c minheap.c graph_build.c graph_io.c \
+ *       graph_output.c graph_external.c parallel.c graph_extmst.c \
+ *       -o graph_extmst -lpthread
+ *
+ *   Run:
+ *   ./graph_extmst [-e] [-m megabytes] [-d directory] edge_file tree_file
+ *     -e            the edge file is in the edge stream format of ./tester -e
+ *                   rather than binary Edge records
+ *     -m megabytes  memory budget for sorting (default 256)
+ *     -d directory  where the sorted runs go (default: the system's
+ *                   temporary directory)
+ *   The forest is written to tree_file as binary Edge records, as
+ *   ./tester -b writes trees, and a summary with the I/O volume to stderr.
+ *  ---------------------------------------------------------------------------
+ */
+
+#include <fcntl.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "graph_external.h"
+#include "graph_output.h"
+
+int main(int argc, char* argv[]) {
+  bool edgeStream = false;
+  long megabytes = 256;
+  const char* tempDir = NULL;
+  int arg = 1;
+  for (; arg < argc && argv[arg][0] == '-'; arg++) {
+    if (strcmp(argv[arg], "-e") == 0) {
+      edgeStream = true;
+    } else if (strcmp(argv[arg], "-m") == 0 && arg + 1 < argc) {
+      megabytes = atol(argv[++arg]);
+    } else if (strcmp(argv[arg], "-d") == 0 && arg + 1 < argc) {
+      tempDir = argv[++arg];
+    } else {
+      printf("Unknown option: %s. Please, try again.\n", argv[arg]);
+      return 1;
+    }
+  }
+  if (arg + 2 != argc || megabytes <= 0) {
+    printf("Usage: %s [-e] [-m megabytes] [-d directory] edge_file "
+           "tree_file\n", argv[0]);
+    return 1;
+  }
+
+  FILE* edges = fopen(argv[arg], edgeStream ? "r" : "rb");
+  if (edges == NULL) {
+    fprintf(stderr, "Unable to open the edge file: %s\n", argv[arg]);
+    return 1;
+  }
+  int fd = open(argv[arg + 1], O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  Output* tree = fd >= 0 ? newOutput(fd, 0, true) : NULL;
+  if (tree == NULL) {
+    fprintf(stderr, "Unable to open the tree file: %s\n", argv[arg + 1]);
+    fclose(edges);
+    return 1;
+  }
+
+  struct timespec start, end;
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  ExternalStats stats;
+  bool ok = getMSTexternal(edges, edgeStream, tree, megabytes << 20, tempDir,
+                           &stats);
+  clock_gettime(CLOCK_MONOTONIC, &end);
+  ok = deleteOutput(tree) && ok;
+  close(fd);
+  fclose(edges);
+  if (!ok) {
+    fprintf(stderr, "Could not compute the spanning forest.\n");
+    return 1;
+  }
+
+  double seconds =
+      end.tv_sec - start.tv_sec + (end.tv_nsec - start.tv_nsec) / 1e9;
+  fprintf(stderr, "%ld edges, %d vertices: %ld tree edges, total weight %ld\n",
+          stats.numEdges, stats.numVertices, stats.numTreeEdges,
+          stats.totalWeight);
+  fprintf(stderr,
+          "%d runs, %d merge passes, %.1f MB read, %.1f MB written, "
+          "%.2f s\n",
+          stats.numRuns, stats.numMergePasses, stats.bytesRead / 1e6,
+          stats.bytesWritten / 1e6, seconds);
+  return 0;
+}
@@ -0,0 +1,459 @@
+/*
+ * Graphs whose vertices have arbitrary 64-bit IDs: parallel parsing and
+ * interning of external IDs.
+ */
+
+#include <errno.h>
+#include <limits.h>
+#include <sched.h>
+#include <string.h>
+
+#include "graph_build.h"
+#include "graph_ids.h"
+#include "parallel.h"
+
+#define EMPTY_SLOT -1        // IdSlot.id of a free slot
+#define BUSY_SLOT -2         // IdSlot.id while its key is being written
+#define MIN_PART_BYTES 65536 // smallest piece of text worth its own thread
+
+typedef struct parsed_edge
+{
+  long from;   // the slot of the external ID of the "from" vertex
+  long to;     // the slot of the external ID of the "to" vertex
+  int weight;
+} ParsedEdge;
+
+typedef struct load_state
+{
+  char *text;            // the edge lines, ending in "\n\0"
+  long *partBegin;       // part p parses text[partBegin[p] ..
+                         //   partBegin[p+1]-1], whole lines only
+  long *partStart;       // part p parses into parsed[partStart[p] ..]
+  long *numParsed;       // the number of edges part p parsed
+  bool *partInvalid;     // part p found a malformed line
+  ParsedEdge *parsed;    // the edges with their IDs interned
+  Edge *edges;           // the edges with internal IDs
+  IdSlot *slots;         // the table shared by all parts while parsing
+  unsigned long mask;    // its number of slots - 1
+  int shift;             // 64 - log2 of its number of slots
+  long numKeys;          // the number of keys in it
+} LoadState;
+
+/* Returns the slot at which the search for 'key' starts in a table with
+ * 2^(64 - 'shift') slots: the top bits of a multiplicative hash.
+ */
+static unsigned long hashKey(int64_t key, int shift)
+{
+  return (unsigned long)(((uint64_t)key * 0x9E3779B97F4A7C15ull) >> shift);
+}
+
+/* Returns the smallest power of 2 that is at least 'n' and 16, and stores
+ * the shift for hashKey in 'shift'.
+ */
+static long tableCapacity(long n, int *shift)
+{
+  long capacity = 16;
+  *shift = 60;
+  while (capacity < n)
+  {
+    capacity *= 2;
+    (*shift)--;
+  }
+  return capacity;
+}
+
+/* Returns a newly allocated table of 'capacity' empty slots, or NULL. */
+static IdSlot *newSlots(long capacity)
+{
+  IdSlot *slots = malloc(sizeof(IdSlot) * capacity);
+  if (slots != NULL)
+  {
+    for (long i = 0; i < capacity; i++)
+    {
+      slots[i].id = EMPTY_SLOT;
+    }
+  }
+  return slots;
+}
+
+/* Returns the slot of 'key' in the shared table of 'state', claiming an
+ * empty one for it if it is not there yet. A slot is claimed by swapping
+ * its id from EMPTY_SLOT to BUSY_SLOT; the key is then written and the id
+ * published, so other threads that meet a busy slot wait for its key.
+ * Precondition: the table has an empty slot
+ */
+static long internKey(LoadState *state, int64_t key)
+{
+  unsigned long mask = state->mask;
+  for (unsigned long h = hashKey(key, state->shift);; h = (h + 1) & mask)
+  {
+    IdSlot *slot = &state->slots[h];
+    int id = __atomic_load_n(&slot->id, __ATOMIC_ACQUIRE);
+    if (id == EMPTY_SLOT)
+    {
+      if (__atomic_compare_exchange_n(&slot->id, &id, BUSY_SLOT, false,
+                                      __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE))
+      {
+        slot->key = key;
+        __atomic_store_n(&slot->id, 0, __ATOMIC_RELEASE);
+        __atomic_fetch_add(&state->numKeys, 1, __ATOMIC_RELAXED);
+        return h;
+      }
+    }
+    while (id == BUSY_SLOT)
+    {
+      sched_yield();
+      id = __atomic_load_n(&slot->id, __ATOMIC_ACQUIRE);
+    }
+    if (slot->key == key)
+    {
+      return h;
+    }
+  }
+}
+
+/* Returns the slot of 'key' in the table 'slots' with 'mask' + 1 slots and
+ * the given 'shift', or -1 if it is not there.
+ */
+static long findKey(IdSlot *slots, unsigned long mask, int shift, int64_t key)
+{
+  for (unsigned long h = hashKey(key, shift);; h = (h + 1) & mask)
+  {
+    if (slots[h].id == EMPTY_SLOT)
+    {
+      return -1;
+    }
+    if (slots[h].key == key)
+    {
+      return h;
+    }
+  }
+}
+
+/* Reads the rest of 'f' into a newly allocated buffer that ends in "\n\0"
+ * and stores its length, without the '\0', in 'length'. Returns NULL if
+ * memory could not be allocated.
+ */
+static char *readRest(FILE *f, long *length)
+{
+  long capacity = 1 << 16;
+  long size = 0;
+  char *text = malloc(capacity);
+  while (text != NULL)
+  {
+    size += fread(text + size, 1, capacity - size - 2, f);
+    if (size < capacity - 2)
+    {
+      break;
+    }
+    char *grown = realloc(text, 2 * capacity);
+    if (grown == NULL)
+    {
+      free(text);
+      return NULL;
+    }
+    text = grown;
+    capacity *= 2;
+  }
+  if (text != NULL)
+  {
+    text[size++] = '\n';
+    text[size] = '\0';
+    *length = size;
+  }
+  return text;
+}
+
+/* Pass 1: counts the lines in this part of the text, an upper bound on the
+ * number of edges in it.
+ */
+static void countLines(void *ctx, int part, int numParts)
+{
+  (void)numParts;
+  LoadState *state = (LoadState *)ctx;
+  char *p = state->text + state->partBegin[part];
+  char *end = state->text + state->partBegin[part + 1];
+  long count = 0;
+  while (p < end && (p = memchr(p, '\n', end - p)) != NULL)
+  {
+    count++;
+    p++;
+  }
+  state->numParsed[part] = count;
+}
+
+/* Parses a decimal integer at 'p' that must end before 'lineEnd', stores it
+ * in 'value' and returns the character after it, or NULL if there is none.
+ */
+static char *parseNumber(char *p, char *lineEnd, long long *value)
+{
+  char *next;
+  errno = 0;
+  *value = strtoll(p, &next, 10);
+  return next == p || next > lineEnd || errno == ERANGE ? NULL : next;
+}
+
+/* Pass 2: parses the lines in this part of the text and interns the IDs in
+ * them. Blank lines are skipped.
+ */
+static void parseLines(void *ctx, int part, int numParts)
+{
+  (void)numParts;
+  LoadState *state = (LoadState *)ctx;
+  char *p = state->text + state->partBegin[part];
+  char *end = state->text + state->partBegin[part + 1];
+  ParsedEdge *out = state->parsed + state->partStart[part];
+  long count = 0;
+  while (p < end)
+  {
+    char *lineEnd = memchr(p, '\n', end - p);
+    while (p < lineEnd && (*p == ' ' || *p == '\t' || *p == '\r'))
+    {
+      p++;
+    }
+    if (p < lineEnd)
+    {
+      long long from, to, weight;
+      p = parseNumber(p, lineEnd, &from);
+      p = p != NULL ? parseNumber(p, lineEnd, &to) : NULL;
+      p = p != NULL ? parseNumber(p, lineEnd, &weight) : NULL;
+      if (p == NULL || weight < 0 || weight > INT_MAX)
+      {
+        state->partInvalid[part] = true;
+        return;
+      }
+      out[count].from = internKey(state, from);
+      out[count].to = internKey(state, to);
+      out[count++].weight = (int)weight;
+    }
+    p = lineEnd + 1;
+  }
+  state->numParsed[part] = count;
+}
+
+/* Pass 3: translates the edges of this part to internal IDs, which by now
+ * are in the ids of the shared table.
+ */
+static void translateEdges(void *ctx, int part, int numParts)
+{
+  LoadState *state = (LoadState *)ctx;
+  ParsedEdge *in = state->parsed + state->partStart[part];
+  Edge *out = state->edges;
+  for (int p = 0; p < part; p++)
+  {
+    out += state->numParsed[p];
+  }
+  (void)numParts;
+  for (long i = 0; i < state->numParsed[part]; i++)
+  {
+    out[i].fromVertex = state->slots[in[i].from].id;
+    out[i].toVertex = state->slots[in[i].to].id;
+    out[i].weight = in[i].weight;
+  }
+}
+
+/* Compares two external IDs, for qsort. */
+static int compareIds(const void *a, const void *b)
+{
+  int64_t x = *(const int64_t *)a;
+  int64_t y = *(const int64_t *)b;
+  return (x > y) - (x < y);
+}
+
+/* Numbers the keys of the shared table of 'state' in increasing order,
+ * writing the numbers into its ids, and returns a new IdMap for them in a
+ * table of its own, at most half full. Returns NULL if memory could not be
+ * allocated.
+ */
+static IdMap *numberKeys(LoadState *state)
+{
+  IdMap *ids = malloc(sizeof(IdMap));
+  if (ids == NULL)
+  {
+    return NULL;
+  }
+  ids->numVertices = (int)state->numKeys;
+  ids->capacity = tableCapacity(2 * state->numKeys, &ids->shift);
+  ids->externalIds = malloc(sizeof(int64_t) * (state->numKeys + 1));
+  ids->slots = newSlots(ids->capacity);
+  if (ids->externalIds == NULL || ids->slots == NULL)
+  {
+    deleteIdMap(ids);
+    return NULL;
+  }
+  long count = 0;
+  for (unsigned long h = 0; h <= state->mask; h++)
+  {
+    if (state->slots[h].id != EMPTY_SLOT)
+    {
+      ids->externalIds[count++] = state->slots[h].key;
+    }
+  }
+  qsort(ids->externalIds, count, sizeof(int64_t), compareIds);
+  unsigned long mask = ids->capacity - 1;
+  for (int v = 0; v < ids->numVertices; v++)
+  {
+    int64_t key = ids->externalIds[v];
+    state->slots[findKey(state->slots, state->mask, state->shift, key)].id = v;
+    unsigned long h = hashKey(key, ids->shift);
+    while (ids->slots[h].id != EMPTY_SLOT)
+    {
+      h = (h + 1) & mask;
+    }
+    ids->slots[h].key = key;
+    ids->slots[h].id = v;
+  }
+  return ids;
+}
+
+/* Frees the memory of 'state' and returns NULL. */
+static Graph *freeLoadState(LoadState *state)
+{
+  free(state->text);
+  free(state->partBegin);
+  free(state->partStart);
+  free(state->numParsed);
+  free(state->partInvalid);
+  free(state->parsed);
+  free(state->edges);
+  free(state->slots);
+  return NULL;
+}
+
+/* Creates and returns a new Graph from the edge stream with external IDs in
+ * the file 'f', parsed with 'numThreads' threads (0 for the default), and
+ * stores the mapping between external and internal IDs in 'ids'.
+ * The text is split into one part per thread at line boundaries. The parts
+ * count their lines, parse them while interning IDs in a table sized for
+ * two new IDs per line, and after the IDs are numbered, translate their
+ * edges into one array for buildGraph.
+ * Returns NULL if a line is malformed, there are more than INT_MAX
+ * vertices, or memory could not be allocated.
+ */
+Graph *createGraphWithIds(FILE *f, bool symmetric, int numThreads,
+                          IdMap **ids)
+{
+  char line[64];
+  *ids = NULL;
+  if (!fgets(line, sizeof(line), f))
+  {
+    printf("Could not read number of vertices from input file. Giving up.\n");
+    return NULL;
+  }
+  LoadState state = {0};
+  long length;
+  state.text = readRest(f, &length);
+  if (state.text == NULL)
+  {
+    printf("Could not allocate the edge stream. Giving up.\n");
+    return NULL;
+  }
+
+  int numParts = numThreads > 0 ? numThreads : defaultThreadCount();
+  if (numParts > length / MIN_PART_BYTES + 1)
+  {
+    numParts = (int)(length / MIN_PART_BYTES + 1);
+  }
+  state.partBegin = malloc(sizeof(long) * (numParts + 1));
+  state.partStart = malloc(sizeof(long) * (numParts + 1));
+  state.numParsed = malloc(sizeof(long) * numParts);
+  state.partInvalid = calloc(numParts, sizeof(bool));
+  if (state.partBegin == NULL || state.partStart == NULL ||
+      state.numParsed == NULL || state.partInvalid == NULL)
+  {
+    printf("Could not allocate the edge stream. Giving up.\n");
+    return freeLoadState(&state);
+  }
+  state.partBegin[0] = 0;
+  for (int p = 1; p <= numParts; p++)
+  {
+    long begin = partStart(length, p, numParts);
+    while (begin > 0 && begin < length && state.text[begin - 1] != '\n')
+    {
+      begin++;
+    }
+    state.partBegin[p] = begin > state.partBegin[p - 1]
+                             ? begin
+                             : state.partBegin[p - 1];
+  }
+
+  parallelRun(numParts, countLines, &state);
+  long numLines = 0;
+  for (int p = 0; p < numParts; p++)
+  {
+    state.partStart[p] = numLines;
+    numLines += state.numParsed[p];
+  }
+  long capacity = tableCapacity(2 * numLines * 4 / 3 + 1, &state.shift);
+  state.mask = capacity - 1;
+  state.slots = newSlots(capacity);
+  state.parsed = malloc(sizeof(ParsedEdge) * (numLines + 1));
+  if (state.slots == NULL || state.parsed == NULL)
+  {
+    printf("Could not allocate the edge stream. Giving up.\n");
+    return freeLoadState(&state);
+  }
+
+  parallelRun(numParts, parseLines, &state);
+  long numEdges = 0;
+  for (int p = 0; p < numParts; p++)
+  {
+    if (state.partInvalid[p])
+    {
+      printf("Could not read an edge from input file. Giving up.\n");
+      return freeLoadState(&state);
+    }
+    numEdges += state.numParsed[p];
+  }
+  if (state.numKeys > INT_MAX)
+  {
+    printf("Too many vertices. Giving up.\n");
+    return freeLoadState(&state);
+  }
+
+  *ids = numberKeys(&state);
+  state.edges = malloc(sizeof(Edge) * (numEdges + 1));
+  if (*ids == NULL || state.edges == NULL)
+  {
+    printf("Could not allocate the edge stream. Giving up.\n");
+    deleteIdMap(*ids);
+    return freeLoadState(&state);
+  }
+  parallelRun(numParts, translateEdges, &state);
+
+  BuildOptions options = defaultBuildOptions();
+  options.numThreads = numThreads;
+  options.symmetrize = symmetric;
+  options.mergeDuplicates = symmetric;
+  Graph *graph = buildGraph(state.edges, numEdges, (*ids)->numVertices,
+                            options);
+  freeLoadState(&state);
+  if (graph == NULL)
+  {
+    printf("Could not create a new graph. Giving up.\n");
+    deleteIdMap(*ids);
+    *ids = NULL;
+  }
+  return graph;
+}
+
+/* Returns the internal ID of the external ID 'externalId' in 'ids', or -1
+ * if no vertex has it.
+ */
+int getInternalId(IdMap *ids, int64_t externalId)
+{
+  long slot = findKey(ids->slots, ids->capacity - 1, ids->shift, externalId);
+  return slot < 0 ? -1 : ids->slots[slot].id;
+}
+
+/* Frees all memory allocated for 'ids'. */
+void deleteIdMap(IdMap *ids)
+{
+  if (ids == NULL)
+  {
+    return;
+  }
+  free(ids->externalIds);
+  free(ids->slots);
+  free(ids);
+}
@@ -0,0 +1,60 @@
+/*
+ * Header file for graphs whose vertices have arbitrary 64-bit IDs.
+ *
+ * Edge stream format with external IDs: as the edge stream format of
+ * graph_io.h, but "from" and "to" may be any 64-bit integers, sparse or
+ * negative. The count on the first line is not checked.
+ *
+ * The loader parses the stream in parallel parts and interns every ID as
+ * it reads it, in one shared open-addressing hash table with linear probing
+ * whose slots are claimed with compare-and-swap. Afterwards the IDs are
+ * numbered in increasing order, so the internal IDs do not depend on the
+ * thread count, and IDs that were dense already (0 .. n-1, all present)
+ * keep their values.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "graph.h"
+
+#ifndef __Graph_Ids_header
+#define __Graph_Ids_header
+
+typedef struct id_slot {
+  int64_t key;  // an external ID
+  int id;       // its internal ID; -1 if the slot is empty
+} IdSlot;
+
+typedef struct id_map {
+  int numVertices;       // internal IDs are 0, 1, ..., numVertices-1
+  int64_t* externalIds;  // externalIds[v] is the external ID of v; they
+                         //   increase with v
+  IdSlot* slots;         // hash table from external to internal IDs
+  long capacity;         // the number of slots, a power of 2
+  int shift;             // 64 - log2(capacity): hashes keep the top bits
+} IdMap;
+
+/* Creates and returns a new Graph from the edge stream with external IDs in
+ * the file 'f', parsed with 'numThreads' threads (0 for the default), and
+ * stores the mapping between external and internal IDs in 'ids'. If
+ * 'symmetric' is true every edge is added in both directions and parallel
+ * edges are merged, keeping the lightest. The graph comes from buildGraph:
+ * delete it with deleteBuiltGraph (see graph_build.h).
+ * Returns NULL if a line is malformed, there are more than INT_MAX
+ * vertices, or memory could not be allocated.
+ */
+Graph* createGraphWithIds(FILE* f, bool symmetric, int numThreads,
+                          IdMap** ids);
+
+/* Returns the internal ID of the external ID 'externalId' in 'ids', or -1
+ * if no vertex has it.
+ */
+int getInternalId(IdMap* ids, int64_t externalId);
+
+/* Frees all memory allocated for 'ids'. */
+void deleteIdMap(IdMap* ids);
+
+#endif
@@ -0,0 +1,237 @@
+/*
+ * Reading graphs from files.
+ *
+ * Author: A. Tafliovich.
+ */
+
+#include <ctype.h>
+#include <string.h>
+
+#include "graph_build.h"
+#include "graph_io.h"
+#include "graph_symmetric.h"
+
+static bool readVertexLine(Graph* graph, char* line, bool symmetric);
+
+/* Creates and returns a new Graph from the information in the file 'f'. If
+ * 'symmetric' is true the input is taken to be undirected, with every edge
+ * listed in the lines of both of its endpoints: it is stored only once, with
+ * the weight given in the line of its lower endpoint.
+ */
+Graph* createGraph(FILE* f, bool symmetric) {
+  char line[MAX_LIMIT];
+
+  if (!fgets(line, MAX_LIMIT, f)) {  // read first line
+    printf("Could not read number of vertices from input file. Giving up.\n");
+    return NULL;
+  }
+
+  int numVertices = atoi(line);  // first line is number of vertices
+  if (numVertices < 0) {
+    printf("Number of vertices must be positive. Read: %d. Giving up.\n",
+           numVertices);
+    return NULL;
+  }
+
+  Graph* graph =
+      symmetric ? newSymmetricGraph(numVertices) : newGraph(numVertices);
+  if (graph == NULL) {
+    printf("Could not create a new graph. Giving up.\n");
+    return NULL;
+  }
+
+  while (fgets(line, MAX_LIMIT, f)) {  // read next line
+    if (!readVertexLine(graph, line, symmetric)) {
+      printf("Could not get vertex info from a line. Giving up.\n");
+      deleteGraph(graph);
+      return NULL;
+    }
+  }
+  return graph;
+}
+
+/* Creates and returns a new Graph from the edge stream in the file 'f': the
+ * number of vertices on the first line, then one "from to weight" line per
+ * edge, in any order. If 'symmetric' is true every edge is added in both
+ * directions and parallel edges are merged, keeping the lightest. Delete the
+ * graph with deleteBuiltGraph.
+ */
+Graph* createGraphFromEdges(FILE* f, bool symmetric) {
+  char line[MAX_LIMIT];
+
+  if (!fgets(line, MAX_LIMIT, f)) {  // read first line
+    printf("Could not read number of vertices from input file. Giving up.\n");
+    return NULL;
+  }
+  int numVertices = atoi(line);
+  if (numVertices < 0) {
+    printf("Number of vertices must be positive. Read: %d. Giving up.\n",
+           numVertices);
+    return NULL;
+  }
+
+  long numEdges = 0;
+  long capacity = 1024;
+  Edge* edges = malloc(sizeof(Edge) * capacity);
+  while (edges != NULL && fgets(line, MAX_LIMIT, f)) {
+    if (numEdges == capacity) {
+      capacity *= 2;
+      Edge* grown = realloc(edges, sizeof(Edge) * capacity);
+      if (grown == NULL) {
+        free(edges);
+        edges = NULL;
+        break;
+      }
+      edges = grown;
+    }
+    char* token = strtok(line, " ");
+    if (token == NULL || *token == '\n') continue;  // blank line
+    int fromVertex = readVertexID(token, numVertices);
+    int toVertex = readVertexID(strtok(NULL, " "), numVertices);
+    int weight = readWeight(strtok(NULL, " "));
+    if (fromVertex == -1 || toVertex == -1 || weight == -1) {
+      free(edges);
+      return NULL;
+    }
+    edges[numEdges].fromVertex = fromVertex;
+    edges[numEdges].toVertex = toVertex;
+    edges[numEdges].weight = weight;
+    numEdges++;
+  }
+  if (edges == NULL) {
+    printf("Could not allocate the edge stream. Giving up.\n");
+    return NULL;
+  }
+
+  BuildOptions options = defaultBuildOptions();
+  options.symmetrize = symmetric;
+  options.mergeDuplicates = symmetric;
+  Graph* graph = buildGraph(edges, numEdges, numVertices, options);
+  free(edges);
+  if (graph == NULL) {
+    printf("Could not create a new graph. Giving up.\n");
+  }
+  return graph;
+}
+
+/* Updates / populates the corresponding vertex in 'graph' using information
+ * from the line 'line' in an input file. Returns true iff update was
+ * successful.
+ */
+bool updateVertex(Graph* graph, char* line) {
+  return readVertexLine(graph, line, false);
+}
+
+/* Does updateVertex for a directed 'graph', or for a symmetric one (see
+ * graph_symmetric.h) if 'symmetric' is true, adding the edges of the line to
+ * the lists of both of their endpoints. An edge to a lower vertex is skipped
+ * then: it was added from the line of that vertex.
+ */
+static bool readVertexLine(Graph* graph, char* line, bool symmetric) {
+  if (graph == NULL) return false;
+
+  // parse vertex ID
+  char* token = strtok(line, " ");
+  int id = readVertexID(token, graph->numVertices);
+  if (id == -1) return false;
+
+  // parse adjacency list
+  EdgeList* head = NULL;
+  int toVertex = 0;
+  int weight = 0;
+  token = strtok(NULL, " ");
+  while (token) {
+    toVertex = readVertexID(token, graph->numVertices);
+    if (toVertex == -1) return false;
+
+    token = strtok(NULL, " ");
+    weight = readWeight(token);
+    if (weight == -1) return false;
+
+    if (symmetric) {
+      if (toVertex >= id &&
+          addSymmetricEdge(graph, id, toVertex, weight) == NULL) {
+        printf("Could not allocate a new Edge. Giving up.\n");
+        return false;
+      }
+    } else {
+      head = addEdge(head, id, toVertex, weight);
+      if (head == NULL) return false;
+      graph->numEdges++;
+    }
+
+    token = strtok(NULL, " ");
+  }
+  if (!symmetric) {
+    graph->vertices[id] = newVertex(id, NULL, head);  // no values in our file
+  }
+
+  return true;
+}
+
+/* Prepends a new Edge from vertex 'fromVertex' to vertex 'toVertex' with
+ * weight 'weight', to the edge list 'head' and returns the result.
+ */
+EdgeList* addEdge(EdgeList* head, int fromVertex, int toVertex, int weight) {
+  Edge* edge = newEdge(fromVertex, toVertex, weight);
+  if (edge == NULL) {
+    printf("Could not allocate a new Edge. Giving up.\n");
+    return NULL;
+  }
+  EdgeList* edgeList = newEdgeList(edge, head);
+  if (edgeList == NULL) {
+    printf("Could not allocate a new EdgeList. Giving up.\n");
+    return NULL;
+  }
+  return edgeList;
+}
+
+/* Reads a number in [0, 'limit'] at '*p', after any blanks, and moves '*p'
+ * past it. Returns -1, and leaves '*p' as it was, if there is none or it is
+ * followed by something other than white space or the end of the string.
+ */
+long readNumber(char** p, long limit) {
+  char* start = *p;
+  while (*start == ' ' || *start == '\t' || *start == '\r') start++;
+  if (!isdigit((unsigned char)*start)) return -1;
+  char* end;
+  long value = strtol(start, &end, 10);
+  if (value > limit || (*end != '\0' && !isspace((unsigned char)*end))) {
+    return -1;
+  }
+  *p = end;
+  return value;
+}
+
+/* Parses and validates a vertex ID for a graph with 'numVertices' vertices,
+ * from 'token'. Returns the ID if validation is successful, and -1 if it is
+ * not.
+ */
+int readVertexID(char* token, int numVertices) {
+  if (!token) {
+    printf("Could not read vertex ID from input file. Giving up.\n");
+    return -1;
+  }
+  int id = atoi(token);
+  if (id < 0 || id >= numVertices) {
+    printf("Invalid vertex ID: %d. Giving up.\n", id);
+    return -1;
+  }
+  return id;
+}
+
+/* Parses and validates an edge weight from 'token'. Returns the weight if
+ * validation is successful, and -1 if it not.
+ */
+int readWeight(char* token) {
+  if (!token) {
+    printf("Could not read edge weight from input file. Giving up.\n");
+    return -1;
+  }
+  int weight = atoi(token);
+  if (weight < 0) {
+    printf("Invalid edge weight: %d. Giving up.\n", weight);
+    return -1;
+  }
+  return weight;
+}
@@ -0,0 +1,64 @@
+/*
+ * Header file for reading graphs from files.
+ *
+ * Adjacency format: the number of vertices on the first line, then one line
+ * per vertex: its ID followed by "neighbour weight" pairs.
+ * Edge stream format: the number of vertices on the first line, then one
+ * "from to weight" line per edge, in any order.
+ */
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "graph.h"
+
+#ifndef __Graph_IO_header
+#define __Graph_IO_header
+
+#define MAX_LIMIT 1024  // longest line we read
+
+/* Creates and returns a new Graph from the adjacency format in the file 'f'.
+ * If 'symmetric' is true the input is taken to be undirected, with every edge
+ * listed in the lines of both of its endpoints: it is stored only once, with
+ * the weight given in the line of its lower endpoint.
+ */
+Graph* createGraph(FILE* f, bool symmetric);
+
+/* Creates and returns a new Graph from the edge stream format in the file
+ * 'f'. If 'symmetric' is true every edge is added in both directions and
+ * parallel edges are merged, keeping the lightest. The graph comes from
+ * buildGraph: delete it with deleteBuiltGraph (see graph_build.h).
+ */
+Graph* createGraphFromEdges(FILE* f, bool symmetric);
+
+/* Updates / populates the corresponding vertex in 'graph' using information
+ * from the line 'line' in an input file. Returns true iff update was
+ * successful.
+ */
+bool updateVertex(Graph* graph, char* line);
+
+/* Prepends a new Edge from vertex 'fromVertex' to vertex 'toVertex' with
+ * weight 'weight', to the edge list 'head' and returns the result.
+ */
+EdgeList* addEdge(EdgeList* head, int fromVertex, int toVertex, int weight);
+
+/* Reads a number in [0, 'limit'] at '*p', after any blanks, and moves '*p'
+ * past it. Returns -1, and leaves '*p' as it was, if there is none or it is
+ * followed by something other than white space or the end of the string.
+ * Prints nothing.
+ */
+long readNumber(char** p, long limit);
+
+/* Parses and validates a vertex ID for a graph with 'numVertices' vertices,
+ * from 'token'. Returns the ID if validation is successful, and -1 if it is
+ * not.
+ */
+int readVertexID(char* token, int numVertices);
+
+/* Parses and validates an edge weight from 'token'. Returns the weight if
+ * validation is successful, and -1 if it not.
+ */
+int readWeight(char* token);
+
+#endif
@@ -0,0 +1,465 @@
+/*
+ * Hub labels (pruned landmark labeling).
+ */
+
+#include <string.h>
+
+#include "graph_labels.h"
+#include "graph_symmetric.h"
+#include "minheap.h"
+
+#define LABELS_MAGIC 0x4c425548  // "HUBL" in a little-endian file
+
+typedef struct label {
+  int *hubs;       // hub ranks, in the order the hubs were processed
+  int *distances;
+  int size;        // the number of hubs in the label
+  int capacity;    // the number of hubs that fit in the arrays
+} Label;
+
+typedef struct labels_file_header {
+  int magic;
+  int numVertices;
+  int longSize;    // sizeof(long) where the file was written
+  long numEntries;
+  long numSlots;   // the size of the hubs and distances arrays
+} LabelsFileHeader;
+
+typedef struct ranked_vertex {
+  long key;  // vertices are ranked by increasing key
+  int id;
+} RankedVertex;
+
+/* Orders RankedVertex records by key, for qsort. */
+static int compareKeys(const void *a, const void *b)
+{
+  long x = ((const RankedVertex *)a)->key;
+  long y = ((const RankedVertex *)b)->key;
+  return (x > y) - (x < y);
+}
+
+/* Appends hub 'hub' at distance 'distance' to 'label'. Returns false if
+ * memory could not be allocated.
+ */
+static bool addHub(Label *label, int hub, int distance)
+{
+  if (label->size == label->capacity)
+  {
+    int capacity = label->capacity > 0 ? 2 * label->capacity : 4;
+    int *hubs = realloc(label->hubs, sizeof(int) * capacity);
+    if (hubs == NULL)
+    {
+      return false;
+    }
+    label->hubs = hubs;
+    int *distances = realloc(label->distances, sizeof(int) * capacity);
+    if (distances == NULL)
+    {
+      return false;
+    }
+    label->distances = distances;
+    label->capacity = capacity;
+  }
+  label->hubs[label->size] = hub;
+  label->distances[label->size++] = distance;
+  return true;
+}
+
+/* Returns true iff 'label' has a hub h whose distance hubDistance[h] from
+ * the start of the current search plus its distance in 'label' is at most
+ * 'distance'.
+ */
+static bool covered(Label *label, int *hubDistance, int distance)
+{
+  for (int i = 0; i < label->size; i++)
+  {
+    int d = hubDistance[label->hubs[i]];
+    if (d != INT_MAX && (long)d + label->distances[i] <= distance)
+    {
+      return true;
+    }
+  }
+  return false;
+}
+
+/* Runs the pruned Dijkstra search from 'hub', the vertex of rank 'rank',
+ * over Graph 'graph', adding the hub to the label of every vertex whose
+ * distance from it the labels in 'labels' do not give yet, and searching on
+ * only from those. 'distance' must be all INT_MAX and is left that way;
+ * 'touched' is scratch space.
+ * Returns false if memory could not be allocated.
+ */
+static bool searchFromHub(Graph *graph, Label *labels, int hub, int rank,
+                          MinHeap *heap, int *distance, int *touched,
+                          int *hubDistance)
+{
+  Label *own = &labels[hub];
+  for (int i = 0; i < own->size; i++)
+  {
+    hubDistance[own->hubs[i]] = own->distances[i];
+  }
+  bool ok = true;
+  int numTouched = 0;
+  distance[hub] = 0;
+  touched[numTouched++] = hub;
+  insert(heap, 0, hub);
+  while (heap->size > 0)
+  {
+    HeapNode minNode = extractMin(heap);
+    int u = minNode.id;
+    int uDistance = minNode.priority;
+    if (!ok || covered(&labels[u], hubDistance, uDistance))
+    {
+      continue;  // the labels already know this distance: prune
+    }
+    ok = addHub(&labels[u], rank, uDistance);
+    for (EdgeList *adjList = graph->vertices[u]->adjList; adjList != NULL;
+         adjList = adjList->next)
+    {
+      int v = otherEndpoint(adjList->edge, u);
+      int weight = adjList->edge->weight;
+      if (weight > INT_MAX - uDistance || uDistance + weight >= distance[v])
+      {
+        continue;
+      }
+      if (distance[v] == INT_MAX)
+      {
+        touched[numTouched++] = v;
+        insert(heap, uDistance + weight, v);
+      }
+      else
+      {
+        decreasePriority(heap, v, uDistance + weight);
+      }
+      distance[v] = uDistance + weight;
+    }
+  }
+
+  for (int i = 0; i < numTouched; i++)
+  {
+    distance[touched[i]] = INT_MAX;
+  }
+  for (int i = 0; i < own->size; i++)
+  {
+    hubDistance[own->hubs[i]] = INT_MAX;
+  }
+  return ok;
+}
+
+/* Returns new labels for 'numVertices' vertices whose arrays have room for
+ * 'numSlots' entries. Returns NULL if memory could not be allocated.
+ */
+static HubLabels *allocateLabels(int numVertices, long numSlots)
+{
+  HubLabels *res = calloc(1, sizeof(HubLabels));
+  if (res == NULL)
+  {
+    return NULL;
+  }
+  res->numVertices = numVertices;
+  res->labelStart = malloc(sizeof(long) * (numVertices + 1));
+  res->hubs = malloc(sizeof(int) * (numSlots + 1));
+  res->distances = malloc(sizeof(int) * (numSlots + 1));
+  if (res->labelStart == NULL || res->hubs == NULL || res->distances == NULL)
+  {
+    deleteHubLabels(res);
+    return NULL;
+  }
+  return res;
+}
+
+/* Copies the 'n' labels in 'labels' into one pair of arrays, each padded
+ * with HUB_END to a multiple of HUB_BLOCK, and returns them as HubLabels.
+ * Returns NULL if memory could not be allocated.
+ */
+static HubLabels *packLabels(Label *labels, int n)
+{
+  long numSlots = 0;
+  for (int v = 0; v < n; v++)
+  {
+    numSlots += (labels[v].size / HUB_BLOCK + 1) * HUB_BLOCK;
+  }
+  HubLabels *res = allocateLabels(n, numSlots);
+  if (res == NULL)
+  {
+    return NULL;
+  }
+  long slot = 0;
+  for (int v = 0; v < n; v++)
+  {
+    res->labelStart[v] = slot;
+    memcpy(res->hubs + slot, labels[v].hubs, sizeof(int) * labels[v].size);
+    memcpy(res->distances + slot, labels[v].distances,
+           sizeof(int) * labels[v].size);
+    slot += labels[v].size;
+    res->numEntries += labels[v].size;
+    do
+    {
+      res->hubs[slot] = HUB_END;
+      res->distances[slot++] = INT_MAX;
+    } while (slot % HUB_BLOCK != 0);
+  }
+  res->labelStart[n] = slot;
+  return res;
+}
+
+/* Builds hub labels for Graph 'graph'. Returns NULL if memory could not be
+ * allocated.
+ * Precondition: 'graph' is undirected and no weight is negative
+ */
+HubLabels *newHubLabels(Graph *graph)
+{
+  int n = graph->numVertices;
+  RankedVertex *order = malloc(sizeof(RankedVertex) * (n + 1));
+  int *distance = malloc(sizeof(int) * (n + 1));
+  int *touched = malloc(sizeof(int) * (n + 1));
+  int *hubDistance = malloc(sizeof(int) * (n + 1));
+  Label *labels = calloc(n + 1, sizeof(Label));
+  MinHeap *heap = newHeap(n);
+  bool ok = order != NULL && distance != NULL &&
+            touched != NULL && hubDistance != NULL && labels != NULL &&
+            heap != NULL;
+
+  if (ok)
+  {
+    // Hubs on many shortest paths first: high degree is a cheap proxy.
+    // Ties are broken by a hash of the ID rather than by the ID itself,
+    // which in grid-like graphs would rank whole rows ahead of the rest.
+    for (int v = 0; v < n; v++)
+    {
+      long degree = 0;
+      for (EdgeList *cur = graph->vertices[v]->adjList; cur != NULL;
+           cur = cur->next)
+      {
+        degree++;
+      }
+      unsigned int h = (unsigned int)v * 0x9E3779B1u;
+      order[v].key = -degree * ((long)UINT_MAX + 1) + (h ^ h >> 16);
+      order[v].id = v;
+      distance[v] = INT_MAX;
+      hubDistance[v] = INT_MAX;
+    }
+    qsort(order, n, sizeof(RankedVertex), compareKeys);
+  }
+  for (int rank = 0; ok && rank < n; rank++)
+  {
+    ok = searchFromHub(graph, labels, order[rank].id, rank, heap, distance,
+                       touched, hubDistance);
+  }
+
+  HubLabels *res = ok ? packLabels(labels, n) : NULL;
+  for (int v = 0; labels != NULL && v < n; v++)
+  {
+    free(labels[v].hubs);
+    free(labels[v].distances);
+  }
+  free(labels);
+  free(order);
+  free(distance);
+  free(touched);
+  free(hubDistance);
+  if (heap != NULL)
+  {
+    deleteHeap(heap);
+  }
+  return res;
+}
+
+/* Frees all memory allocated for 'labels'. */
+void deleteHubLabels(HubLabels *labels)
+{
+  if (labels == NULL)
+  {
+    return;
+  }
+  free(labels->labelStart);
+  free(labels->hubs);
+  free(labels->distances);
+  free(labels);
+}
+
+/* Lowers '*best' to d + e for every i, j < HUB_BLOCK at which the blocks
+ * 'hubsS' and 'hubsT' hold the same hub, with d and e its distances in
+ * 'distS' and 'distT'.
+ */
+static void matchBlocks(int *hubsS, int *distS, int *hubsT, int *distT,
+                        long *best)
+{
+  for (int i = 0; i < HUB_BLOCK; i++)
+  {
+    for (int j = 0; j < HUB_BLOCK; j++)
+    {
+      if (hubsS[i] == hubsT[j] && hubsS[i] != HUB_END &&
+          (long)distS[i] + distT[j] < *best)
+      {
+        *best = (long)distS[i] + distT[j];
+      }
+    }
+  }
+}
+
+/* Returns the distance from 'source' to 'target', INT_MAX if there is no
+ * path, and -1 if either vertex is not valid in 'labels'. Merges the two
+ * labels a block at a time: all HUB_BLOCK x HUB_BLOCK hubs of two blocks
+ * are compared at once, and the block whose last hub is smaller moves on.
+ */
+int getLabelDistance(HubLabels *labels, int source, int target)
+{
+  int n = labels->numVertices;
+  if (source < 0 || source >= n || target < 0 || target >= n)
+  {
+    return -1;
+  }
+  int *hubsS = labels->hubs + labels->labelStart[source];
+  int *distS = labels->distances + labels->labelStart[source];
+  int *hubsT = labels->hubs + labels->labelStart[target];
+  int *distT = labels->distances + labels->labelStart[target];
+  long best = INT_MAX;
+  while (true)
+  {
+    bool match = false;
+#if defined(__GNUC__)
+    typedef int IntVector __attribute__((vector_size(HUB_BLOCK * sizeof(int))));
+    IntVector s, t;
+    memcpy(&s, hubsS, sizeof(IntVector));
+    memcpy(&t, hubsT, sizeof(IntVector));
+    IntVector equal = s == t[0];
+    for (int lane = 1; lane < HUB_BLOCK; lane++)
+    {
+      equal |= s == t[lane];
+    }
+    for (int lane = 0; lane < HUB_BLOCK; lane++)
+    {
+      match = match || equal[lane] != 0;
+    }
+#else
+    match = true;
+#endif
+    if (match)
+    {
+      matchBlocks(hubsS, distS, hubsT, distT, &best);
+    }
+    int lastS = hubsS[HUB_BLOCK - 1];
+    int lastT = hubsT[HUB_BLOCK - 1];
+    if (lastS == HUB_END && lastT == HUB_END)
+    {
+      break;
+    }
+    // A label's last block ends in HUB_END, so neither runs past its end.
+    if (lastS <= lastT)
+    {
+      hubsS += HUB_BLOCK;
+      distS += HUB_BLOCK;
+    }
+    if (lastT <= lastS)
+    {
+      hubsT += HUB_BLOCK;
+      distT += HUB_BLOCK;
+    }
+  }
+  return best;
+}
+
+/* Returns the number of bytes 'labels' takes up in memory. */
+size_t getHubLabelsSize(HubLabels *labels)
+{
+  return sizeof(HubLabels) + sizeof(long) * (labels->numVertices + 1) +
+         2 * sizeof(int) * labels->labelStart[labels->numVertices];
+}
+
+/* Writes 'labels' to the binary file 'f'. Returns false iff a write failed.
+ */
+bool saveHubLabels(HubLabels *labels, FILE *f)
+{
+  int n = labels->numVertices;
+  LabelsFileHeader header = {LABELS_MAGIC, n, sizeof(long),
+                             labels->numEntries, labels->labelStart[n]};
+  size_t numStarts = (size_t)n + 1;
+  size_t numSlots = header.numSlots;
+  return fwrite(&header, sizeof(header), 1, f) == 1 &&
+         fwrite(labels->labelStart, sizeof(long), numStarts, f) ==
+             numStarts &&
+         fwrite(labels->hubs, sizeof(int), numSlots, f) == numSlots &&
+         fwrite(labels->distances, sizeof(int), numSlots, f) == numSlots &&
+         fflush(f) == 0;
+}
+
+/* Returns true iff the arrays of 'labels', just read from a file, are
+ * consistent: every label is a whole number of blocks, its hubs increase,
+ * and the HUB_END padding is all in its last block, so that queries stay
+ * within the arrays.
+ */
+static bool validLabels(HubLabels *labels, long numSlots)
+{
+  int n = labels->numVertices;
+  if (labels->labelStart[0] != 0 || labels->labelStart[n] != numSlots)
+  {
+    return false;
+  }
+  long numEntries = 0;
+  for (int v = 0; v < n; v++)
+  {
+    long start = labels->labelStart[v];
+    long end = labels->labelStart[v + 1];
+    if (end - start < HUB_BLOCK || (end - start) % HUB_BLOCK != 0 ||
+        start % HUB_BLOCK != 0)
+    {
+      return false;
+    }
+    long i = start;
+    for (; i < end && labels->hubs[i] != HUB_END; i++)
+    {
+      if (labels->hubs[i] < 0 || labels->hubs[i] >= n ||
+          (i > start && labels->hubs[i] <= labels->hubs[i - 1]))
+      {
+        return false;
+      }
+    }
+    numEntries += i - start;
+    if (i == end || i < end - HUB_BLOCK)
+    {
+      return false;
+    }
+    for (; i < end; i++)
+    {
+      if (labels->hubs[i] != HUB_END)
+      {
+        return false;
+      }
+    }
+  }
+  return numEntries == labels->numEntries;
+}
+
+/* Reads labels written by saveHubLabels from 'f' and returns them, or NULL
+ * if 'f' does not hold valid labels or memory could not be allocated.
+ */
+HubLabels *loadHubLabels(FILE *f)
+{
+  LabelsFileHeader header;
+  if (fread(&header, sizeof(header), 1, f) != 1 ||
+      header.magic != LABELS_MAGIC || header.longSize != sizeof(long) ||
+      header.numVertices < 0 || header.numSlots < 0 ||
+      header.numEntries < 0)
+  {
+    return NULL;
+  }
+  int n = header.numVertices;
+  HubLabels *res = allocateLabels(n, header.numSlots);
+  if (res == NULL)
+  {
+    return NULL;
+  }
+  size_t numStarts = (size_t)n + 1;
+  size_t numSlots = header.numSlots;
+  res->numEntries = header.numEntries;
+  if (fread(res->labelStart, sizeof(long), numStarts, f) != numStarts ||
+      fread(res->hubs, sizeof(int), numSlots, f) != numSlots ||
+      fread(res->distances, sizeof(int), numSlots, f) != numSlots ||
+      !validLabels(res, header.numSlots))
+  {
+    deleteHubLabels(res);
+    return NULL;
+  }
+  return res;
+}
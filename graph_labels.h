@@ -0,0 +1,72 @@
+/*
+ * Header file for hub labels: an index that answers exact distance queries
+ * by merging two short sorted arrays (pruned landmark labeling, Akiba et
+ * al.).
+ *
+ * Every vertex v gets a label: a list of hubs h with their distances d(h,
+ * v), such that every pair s, t has a hub on a shortest path between them
+ * in both of their labels (a 2-hop cover). The distance from s to t is then
+ * the smallest d(h, s) + d(h, t) over the hubs h the two labels share.
+ *
+ * The labels are built by one Dijkstra search from every vertex in order
+ * of decreasing degree. A search stops at every vertex whose distance the
+ * labels built so far already give, so later searches, from vertices that
+ * lie on few shortest paths, stay small.
+ *
+ * Labels can be saved to a file and loaded back. The file holds the arrays
+ * as they are in memory, so it is only readable on machines with the same
+ * byte order and int size.
+ */
+
+#include <limits.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "graph.h"
+
+#ifndef __Graph_Labels_header
+#define __Graph_Labels_header
+
+#define HUB_BLOCK 4      // labels are padded to a multiple of this length
+#define HUB_END INT_MAX  // the hub that pads labels
+
+typedef struct hub_labels {
+  int numVertices;  // vertex IDs are 0, 1, ..., numVertices-1
+  long* labelStart;  // the label of v is entries labelStart[v] ..
+                     //   labelStart[v+1]-1 of the arrays below
+  int* hubs;         // hubs by rank in the build order, increasing within
+                     //   each label, which ends in at least one HUB_END
+  int* distances;    // distances[i] is the distance to hubs[i]
+  long numEntries;   // the number of hubs in all labels, without padding
+} HubLabels;
+
+/* Builds hub labels for Graph 'graph'. Returns NULL if memory could not be
+ * allocated.
+ * Precondition: 'graph' is undirected (symmetric, or with every edge stored
+ *               in both directions) and no weight is negative
+ */
+HubLabels* newHubLabels(Graph* graph);
+
+/* Frees all memory allocated for 'labels'. */
+void deleteHubLabels(HubLabels* labels);
+
+/* Returns the distance from 'source' to 'target', INT_MAX if there is no
+ * path, and -1 if either vertex is not valid in 'labels'.
+ */
+int getLabelDistance(HubLabels* labels, int source, int target);
+
+/* Returns the number of bytes 'labels' takes up in memory. */
+size_t getHubLabelsSize(HubLabels* labels);
+
+/* Writes 'labels' to the binary file 'f'. Returns false iff a write failed.
+ */
+bool saveHubLabels(HubLabels* labels, FILE* f);
+
+/* Reads labels written by saveHubLabels from 'f' into a newly allocated
+ * HubLabels and returns it. Returns NULL if 'f' does not hold valid labels
+ * or memory could not be allocated.
+ */
+HubLabels* loadHubLabels(FILE* f);
+
+#endif
@@ -0,0 +1,490 @@
+/*
+ * Running many small graphs in one pass.
+ */
+
+#include <ctype.h>
+#include <limits.h>
+#include <pthread.h>
+#include <string.h>
+
+#include "graph_io.h"
+#include "graph_many.h"
+#include "graph_output.h"
+#include "graph_query.h"
+#include "parallel.h"
+
+#define NOTHING -1
+#define WINDOW 1024     // most results held back waiting for their turn
+#define MIN_READ 256    // free bytes wanted in a Text before each fgets
+
+typedef struct text
+{
+  char *bytes;      // 'length' bytes of text, not NUL-terminated
+  size_t length;
+  size_t capacity;  // size of 'bytes'
+} Text;
+
+typedef struct arena
+{
+  Graph graph;                // the current graph; all of its parts live
+                              //   in the arrays below
+  Vertex *vertices;           // room for 'vertexCapacity' vertices
+  Vertex **pointers;          // graph.vertices
+  bool *seen;                 // seen[id] is true once id's line was read
+  int vertexCapacity;
+  EdgeList *nodes;            // room for 'edgeCapacity' list nodes and edges
+  Edge *edges;
+  long edgeCapacity;
+  QueryWorkspace *workspace;  // for graphs of up to vertexCapacity vertices
+  Text input;                 // the vertex lines of the current graph
+  Text output;                // its result line
+  int numVertices;            // as given on its first line; NOTHING if that
+                              //   line could not be read
+  int numLines;               // vertex lines in 'input'
+  long firstLine;             // line number of the first vertex line
+} Arena;
+
+typedef struct slot
+{
+  Text text;   // the result line; its buffer is reused
+  bool ready;  // false while the result is being computed
+} Slot;
+
+typedef struct many
+{
+  FILE *in;
+  FILE *out;
+  long numGraphs;          // graphs claimed so far
+  long lineNumber;         // lines read so far
+  bool ended;              // true once no graph can follow
+  pthread_mutex_t input;   // guards the reading and the three fields above
+  long nextResult;         // next result to write
+  Slot window[WINDOW];     // result i waits in window[i % WINDOW]
+  long numErrors;
+  pthread_mutex_t lock;    // guards nextResult, window and numErrors
+  pthread_cond_t moved;    // signalled whenever nextResult advances
+} Many;
+
+/* Makes room for at least 'needed' bytes in 'text'. Returns false if memory
+ * could not be allocated.
+ */
+static bool reserveText(Text *text, size_t needed)
+{
+  if (needed <= text->capacity)
+  {
+    return true;
+  }
+  size_t capacity = text->capacity > 0 ? text->capacity : MIN_READ;
+  while (capacity < needed)
+  {
+    capacity *= 2;
+  }
+  char *bytes = realloc(text->bytes, capacity);
+  if (bytes == NULL)
+  {
+    return false;
+  }
+  text->bytes = bytes;
+  text->capacity = capacity;
+  return true;
+}
+
+/* Appends 'string' to 'text', or as much of it as fits if memory runs out. */
+static void appendString(Text *text, const char *string)
+{
+  size_t length = strlen(string);
+  if (reserveText(text, text->length + length))
+  {
+    memcpy(text->bytes + text->length, string, length);
+    text->length += length;
+  }
+}
+
+/* Appends ' ' and 'value' in decimal to 'text'. */
+static void appendNumber(Text *text, long value)
+{
+  char digits[MAX_LONG_DIGITS + 1];
+  digits[0] = ' ';
+  size_t length = 1 + formatLong(digits + 1, value);
+  if (reserveText(text, text->length + length))
+  {
+    memcpy(text->bytes + text->length, digits, length);
+    text->length += length;
+  }
+}
+
+/* Appends the next line of 'f' to 'text', with its '\n' if it has one.
+ * Returns false at the end of 'f', or if memory could not be allocated.
+ */
+static bool readLine(FILE *f, Text *text)
+{
+  size_t start = text->length;
+  while (reserveText(text, text->length + MIN_READ) &&
+         fgets(text->bytes + text->length, text->capacity - text->length, f))
+  {
+    text->length += strlen(text->bytes + text->length);
+    if (text->bytes[text->length - 1] == '\n')
+    {
+      return true;
+    }
+  }
+  return text->length > start;
+}
+
+/* Moves '*p' past blanks, but not past the end of the line. */
+static void skipBlanks(char **p)
+{
+  while (**p == ' ' || **p == '\t' || **p == '\r')
+  {
+    (*p)++;
+  }
+}
+
+/* Claims the next graph of 'many' for 'arena' and reads its lines into
+ * arena->input. Returns its index, or NOTHING if the input has ended.
+ * Precondition: the caller holds many->input
+ */
+static long readGraph(Many *many, Arena *arena)
+{
+  Text *input = &arena->input;
+  input->length = 0;
+  bool read = false;
+  char *p = NULL;
+  while (!many->ended && (read = readLine(many->in, input)))
+  {
+    many->lineNumber++;
+    p = input->bytes;  // fgets left it NUL-terminated
+    skipBlanks(&p);
+    if (*p != '\n' && *p != '\0')
+    {
+      break;  // not a blank line
+    }
+    input->length = 0;
+  }
+  if (many->ended || !read)
+  {
+    many->ended = true;
+    return NOTHING;
+  }
+
+  long numVertices = readNumber(&p, MAX_MANY_VERTICES);
+  skipBlanks(&p);
+  arena->numVertices = *p == '\n' || *p == '\0' ? numVertices : NOTHING;
+  arena->firstLine = many->lineNumber + 1;
+  input->length = 0;
+  arena->numLines = 0;
+  if (arena->numVertices == NOTHING)
+  {
+    many->ended = true;  // we cannot tell where the next graph starts
+  }
+  while (arena->numLines < arena->numVertices &&
+         readLine(many->in, input))
+  {
+    many->lineNumber++;
+    arena->numLines++;
+  }
+  if (arena->numLines < arena->numVertices)
+  {
+    many->ended = true;
+  }
+  return many->numGraphs++;
+}
+
+/* Makes room in 'arena' for a graph with 'numVertices' vertices and
+ * 'numEdges' edges. Returns false if memory could not be allocated.
+ */
+static bool reserveArena(Arena *arena, int numVertices, long numEdges)
+{
+  if (numVertices > arena->vertexCapacity)
+  {
+    int capacity = arena->vertexCapacity > numVertices / 2
+                       ? 2 * arena->vertexCapacity
+                       : numVertices;
+    Vertex *vertices = realloc(arena->vertices, sizeof(Vertex) * capacity);
+    if (vertices != NULL)
+    {
+      arena->vertices = vertices;
+    }
+    Vertex **pointers =
+        realloc(arena->pointers, sizeof(Vertex *) * capacity);
+    if (pointers != NULL)
+    {
+      arena->pointers = pointers;
+    }
+    bool *seen = realloc(arena->seen, sizeof(bool) * capacity);
+    if (seen != NULL)
+    {
+      arena->seen = seen;
+    }
+    deleteQueryWorkspace(arena->workspace);
+    arena->workspace = newQueryWorkspace(capacity);
+    if (vertices == NULL || pointers == NULL || seen == NULL ||
+        arena->workspace == NULL)
+    {
+      arena->vertexCapacity = 0;
+      return false;
+    }
+    arena->vertexCapacity = capacity;
+  }
+  if (numEdges > arena->edgeCapacity)
+  {
+    long capacity = arena->edgeCapacity > numEdges / 2
+                        ? 2 * arena->edgeCapacity
+                        : numEdges;
+    EdgeList *nodes = realloc(arena->nodes, sizeof(EdgeList) * capacity);
+    if (nodes != NULL)
+    {
+      arena->nodes = nodes;
+    }
+    Edge *edges = realloc(arena->edges, sizeof(Edge) * capacity);
+    if (edges != NULL)
+    {
+      arena->edges = edges;
+    }
+    if (nodes == NULL || edges == NULL)
+    {
+      arena->edgeCapacity = 0;
+      return false;
+    }
+    arena->edgeCapacity = capacity;
+  }
+  return true;
+}
+
+/* Builds arena->graph from the lines in arena->input. Every adjacency list
+ * has its edges in reverse order of the line, as createGraph leaves them.
+ * Returns the number of the first line that is malformed, or NOTHING if
+ * there is none.
+ */
+static long parseGraph(Arena *arena)
+{
+  int n = arena->numVertices;
+  if (n == NOTHING)
+  {
+    return arena->firstLine - 1;
+  }
+  Text *input = &arena->input;
+  if (!reserveText(input, input->length + 1))
+  {
+    return arena->firstLine;
+  }
+  input->bytes[input->length] = '\0';
+  long numTokens = 0;
+  for (size_t i = 0; i < input->length; i++)
+  {
+    numTokens += !isspace((unsigned char)input->bytes[i]) &&
+                 (i == 0 || isspace((unsigned char)input->bytes[i - 1]));
+  }
+  if (!reserveArena(arena, n, numTokens / 2))
+  {
+    return arena->firstLine;
+  }
+  for (int v = 0; v < n; v++)
+  {
+    arena->vertices[v] = (Vertex){v, NULL, NULL};
+    arena->pointers[v] = &arena->vertices[v];
+    arena->seen[v] = false;
+  }
+
+  char *p = input->bytes;
+  long numEdges = 0;
+  for (int line = 0; line < arena->numLines; line++)
+  {
+    long id = readNumber(&p, n - 1);
+    if (id == NOTHING || arena->seen[id])
+    {
+      return arena->firstLine + line;
+    }
+    arena->seen[id] = true;
+    EdgeList *head = NULL;
+    skipBlanks(&p);
+    while (*p != '\n' && *p != '\0')
+    {
+      long toVertex = readNumber(&p, n - 1);
+      long weight = readNumber(&p, INT_MAX);
+      if (toVertex == NOTHING || weight == NOTHING)
+      {
+        return arena->firstLine + line;
+      }
+      Edge *edge = &arena->edges[numEdges];
+      *edge = (Edge){id, toVertex, weight};
+      arena->nodes[numEdges] = (EdgeList){edge, head};
+      head = &arena->nodes[numEdges++];
+      skipBlanks(&p);
+    }
+    arena->vertices[id].adjList = head;
+    if (*p == '\n')
+    {
+      p++;
+    }
+  }
+  if (arena->numLines < n)
+  {
+    return arena->firstLine + arena->numLines;  // the input ended early
+  }
+
+  arena->graph.numVertices = n;
+  arena->graph.numEdges = numEdges;
+  arena->graph.vertices = arena->pointers;
+  return NOTHING;
+}
+
+/* Writes the result line for graph 'index', read into 'arena', to
+ * arena->output. Returns false iff the graph is malformed.
+ */
+static bool runGraph(Arena *arena, long index)
+{
+  Text *output = &arena->output;
+  output->length = 0;
+  appendString(output, "graph");
+  appendNumber(output, index);
+  long errorLine = parseGraph(arena);
+  if (errorLine != NOTHING)
+  {
+    appendString(output, ": error at line");
+    appendNumber(output, errorLine);
+    appendString(output, "\n");
+    return false;
+  }
+
+  Graph *graph = &arena->graph;
+  QueryWorkspace *workspace = arena->workspace;
+  int n = graph->numVertices;
+  long total = 0;
+  if (n > 0 && getSpanningTreePrim(graph, 0, workspace) < n)
+  {
+    total = NOTHING;
+  }
+  for (int i = 0; i < n && total != NOTHING; i++)
+  {
+    total += workspace->reached[i].distance;
+  }
+  appendString(output, ": mst");
+  appendNumber(output, total);
+  appendString(output, " dijkstra");
+  if (n > 0)
+  {
+    getNearestDijkstra(graph, 0, INT_MAX, INT_MAX, workspace);
+    for (int v = 0; v < n; v++)
+    {
+      int d = workspace->distance[v];
+      appendNumber(output, d == INT_MAX ? NOTHING : d);
+    }
+  }
+  appendString(output, "\n");
+  return true;
+}
+
+/* Hands 'result' in as the result of graph 'index' and writes out every
+ * result that is now next in line.
+ */
+static void deliverResult(Many *many, long index, Text *result, bool ok)
+{
+  pthread_mutex_lock(&many->lock);
+  Slot *slot = &many->window[index % WINDOW];
+  slot->text.length = 0;
+  if (reserveText(&slot->text, result->length))
+  {
+    memcpy(slot->text.bytes, result->bytes, result->length);
+    slot->text.length = result->length;
+  }
+  else
+  {
+    ok = false;  // out of memory: the result is lost, but not the rest
+  }
+  slot->ready = true;
+  if (!ok)
+  {
+    many->numErrors++;
+  }
+  bool moved = false;
+  Slot *next = &many->window[many->nextResult % WINDOW];
+  while (next->ready)
+  {
+    fwrite(next->text.bytes, 1, next->text.length, many->out);
+    next->ready = false;
+    many->nextResult++;
+    next = &many->window[many->nextResult % WINDOW];
+    moved = true;
+  }
+  if (moved)
+  {
+    pthread_cond_broadcast(&many->moved);
+  }
+  pthread_mutex_unlock(&many->lock);
+}
+
+/* Body of one thread of runManyGraphs: reads graphs in turn with the other
+ * threads and runs them in its own arena, waiting whenever it gets more
+ * than WINDOW ahead of the output.
+ */
+static void runGraphs(void *ctx, int thread, int numThreads)
+{
+  Many *many = ctx;
+  Arena arena;
+  memset(&arena, 0, sizeof(Arena));
+
+  while (true)
+  {
+    pthread_mutex_lock(&many->input);
+    long index = readGraph(many, &arena);
+    pthread_mutex_unlock(&many->input);
+    if (index == NOTHING)
+    {
+      break;
+    }
+    pthread_mutex_lock(&many->lock);
+    while (index >= many->nextResult + WINDOW)
+    {
+      pthread_cond_wait(&many->moved, &many->lock);
+    }
+    pthread_mutex_unlock(&many->lock);
+
+    bool ok = runGraph(&arena, index);
+    deliverResult(many, index, &arena.output, ok);
+  }
+  free(arena.vertices);
+  free(arena.pointers);
+  free(arena.seen);
+  free(arena.nodes);
+  free(arena.edges);
+  deleteQueryWorkspace(arena.workspace);
+  free(arena.input.bytes);
+  free(arena.output.bytes);
+}
+
+/* Reads the graphs in the multi-graph file 'in', runs Prim's and
+ * Dijkstra's algorithms from vertex 0 on each with 'numThreads' threads
+ * (0 for the default), and writes their results to 'out' in input order.
+ * Stores the number of malformed graphs in 'numErrors' and returns the
+ * number of graphs read.
+ */
+long runManyGraphs(FILE *in, FILE *out, int numThreads, long *numErrors)
+{
+  Many *many = calloc(1, sizeof(Many));
+  if (many == NULL)
+  {
+    *numErrors = 0;
+    return 0;
+  }
+  many->in = in;
+  many->out = out;
+  pthread_mutex_init(&many->input, NULL);
+  pthread_mutex_init(&many->lock, NULL);
+  pthread_cond_init(&many->moved, NULL);
+
+  parallelRun(numThreads > 0 ? numThreads : defaultThreadCount(), runGraphs,
+              many);
+
+  long numGraphs = many->numGraphs;
+  *numErrors = many->numErrors;
+  for (int i = 0; i < WINDOW; i++)
+  {
+    free(many->window[i].text.bytes);
+  }
+  pthread_mutex_destroy(&many->input);
+  pthread_mutex_destroy(&many->lock);
+  pthread_cond_destroy(&many->moved);
+  free(many);
+  return numGraphs;
+}
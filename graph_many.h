@@ -0,0 +1,44 @@
+/*
+ * Header file for running many small graphs in one pass.
+ *
+ * Multi-graph format: graphs in the adjacency format of graph_io.h, one
+ * after another. Every graph is its number of vertices n on a line of its
+ * own, then exactly n lines, one per vertex, each giving its ID followed by
+ * "neighbour weight" pairs. Blank lines between graphs are skipped, so the
+ * concatenation of files like sample_input.txt is a multi-graph file.
+ *
+ * Each graph produces one line of output, numbered from 0 in input order:
+ *   graph i: mst <weight> dijkstra <d0> <d1> ...
+ * with the weight of the spanning tree Prim's algorithm finds from vertex 0
+ * (-1 if the graph is not connected) and the distances from vertex 0 in
+ * order of vertex ID (-1 for unreachable vertices), or
+ *   graph i: error at line <line number>
+ * for a graph that is malformed. A number of vertices that cannot be read
+ * ends the input, since the next graph cannot be found.
+ *
+ * Every thread keeps one arena for the graph it works on, one query
+ * workspace and one output buffer, and reuses them for every graph it
+ * takes, growing them only when a larger graph comes along. The graphs are
+ * never allocated one by one, and never freed.
+ */
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "graph.h"
+
+#ifndef __Graph_Many_header
+#define __Graph_Many_header
+
+#define MAX_MANY_VERTICES (1 << 24)  // larger graphs are rejected as errors
+
+/* Reads the graphs in the multi-graph file 'in', runs Prim's and
+ * Dijkstra's algorithms from vertex 0 on each with 'numThreads' threads
+ * (0 for the default), and writes their results to 'out' in input order,
+ * each as soon as every earlier one has been written. Stores the number of
+ * malformed graphs in 'numErrors' and returns the number of graphs read.
+ */
+long runManyGraphs(FILE* in, FILE* out, int numThreads, long* numErrors);
+
+#endif
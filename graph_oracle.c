@@ -0,0 +1,667 @@
+/*
+ * Approximate distance oracles (Thorup and Zwick).
+ */
+
+#include <limits.h>
+#include <string.h>
+
+#include "graph_oracle.h"
+#include "graph_symmetric.h"
+#include "minheap.h"
+#include "parallel.h"
+
+#define NOTHING -1
+#define ORACLE_MAGIC 0x4f5a5454  // "TTZO" in a little-endian file
+#define CENTER_CHUNK 64          // centers a thread claims at once
+
+typedef struct bunch_item {
+  int owner;     // the vertex whose bunch 'vertex' is in
+  int vertex;
+  int distance;  // the distance between the two
+} BunchItem;
+
+typedef struct search {
+  MinHeap *heap;      // frontier of the current search
+  int *distance;      // distance[id]: tentative distance, INT_MAX if untouched
+  int *touched;       // the IDs whose distance is not INT_MAX
+  int numTouched;
+  BunchItem *items;   // the bunch entries found by this search's thread
+  long numItems;
+  long capacity;      // the number of items that fit in 'items'
+} Search;
+
+typedef struct oracle_build {
+  Graph *graph;
+  DistanceOracle *oracle;
+  int *level;         // level[v] is the largest i with v in A_i
+  Search *searches;   // one per thread
+  long nextCenter;    // next center to hand out; claimed atomically
+  bool failed;        // true iff some thread ran out of memory
+} OracleBuild;
+
+typedef struct oracle_file_header {
+  int magic;
+  int k;
+  int numVertices;
+  int longSize;       // sizeof(long) where the file was written
+  long numEntries;
+  long numSlots;      // the size of the bunches array
+} OracleFileHeader;
+
+/* Returns a uniformly distributed number in [0, 1) and advances the
+ * xorshift generator 'state'.
+ */
+static double nextRandom(unsigned *state)
+{
+  *state ^= *state << 13;
+  *state ^= *state >> 17;
+  *state ^= *state << 5;
+  return *state / 4294967296.0;
+}
+
+/* Returns p with p^k = 1/n: the probability with which a vertex of one
+ * sample goes on to the next. Bisection keeps us clear of libm.
+ */
+static double sampleProbability(int n, int k)
+{
+  double low = 0, high = 1;
+  for (int round = 0; round < 60; round++)
+  {
+    double p = (low + high) / 2;
+    double power = 1;
+    for (int i = 0; i < k; i++)
+    {
+      power *= p;
+    }
+    if (power * n < 1)
+    {
+      low = p;
+    }
+    else
+    {
+      high = p;
+    }
+  }
+  return high;
+}
+
+/* Returns the slot at which the search for 'vertex' starts in a hash table
+ * with 'mask' + 1 slots.
+ */
+static unsigned long hashVertex(int vertex, unsigned long mask)
+{
+  unsigned int h = (unsigned int)vertex * 0x9E3779B1u;
+  return (h ^ h >> 16) & mask;
+}
+
+/* Returns the distance from 'vertex' to 'owner' if 'vertex' is in the bunch
+ * of 'owner' in 'oracle', and NOTHING otherwise.
+ */
+static int bunchDistance(DistanceOracle *oracle, int owner, int vertex)
+{
+  long start = oracle->bunchStart[owner];
+  long size = oracle->bunchStart[owner + 1] - start;
+  if (size == 0)
+  {
+    return NOTHING;
+  }
+  OracleEntry *bunch = oracle->bunches + start;
+  unsigned long mask = size - 1;
+  for (unsigned long h = hashVertex(vertex, mask);; h = (h + 1) & mask)
+  {
+    if (bunch[h].vertex == vertex)
+    {
+      return bunch[h].distance;
+    }
+    if (bunch[h].vertex == NOTHING)
+    {
+      return NOTHING;
+    }
+  }
+}
+
+/* Initializes 'search' for graphs with 'n' vertices. Returns false if
+ * memory could not be allocated; 'search' can be freed either way.
+ */
+static bool newSearch(Search *search, int n)
+{
+  memset(search, 0, sizeof(Search));
+  search->heap = newHeap(n);
+  search->distance = malloc(sizeof(int) * (n + 1));
+  search->touched = malloc(sizeof(int) * (n + 1));
+  if (search->heap == NULL || search->distance == NULL ||
+      search->touched == NULL)
+  {
+    return false;
+  }
+  for (int i = 0; i < n; i++)
+  {
+    search->distance[i] = INT_MAX;
+  }
+  return true;
+}
+
+/* Frees all memory allocated for 'search', but not 'search' itself. */
+static void freeSearch(Search *search)
+{
+  if (search->heap != NULL)
+  {
+    deleteHeap(search->heap);
+  }
+  free(search->distance);
+  free(search->touched);
+  free(search->items);
+}
+
+/* Lowers the tentative distance of 'v' in 'search' to 'distance', adding
+ * 'v' to the frontier the first time it is reached.
+ */
+static void relaxSearch(Search *search, int v, int distance)
+{
+  if (search->distance[v] == INT_MAX)
+  {
+    search->touched[search->numTouched++] = v;
+    insert(search->heap, distance, v);
+  }
+  else
+  {
+    decreasePriority(search->heap, v, distance);
+  }
+  search->distance[v] = distance;
+}
+
+/* Puts the distances 'search' touched back to INT_MAX. */
+static void resetSearch(Search *search)
+{
+  for (int i = 0; i < search->numTouched; i++)
+  {
+    search->distance[search->touched[i]] = INT_MAX;
+  }
+  search->numTouched = 0;
+}
+
+/* Runs Dijkstra's algorithm on Graph 'graph' from every vertex already on
+ * the frontier of 'search' at once, and stores in nearest[v] the start
+ * vertex closest to v, which every vertex on the frontier must already
+ * hold for itself. The distances are left in search->distance.
+ */
+static void spreadNearest(Graph *graph, Search *search, int *nearest)
+{
+  while (search->heap->size > 0)
+  {
+    HeapNode minNode = extractMin(search->heap);
+    int u = minNode.id;
+    int uDistance = minNode.priority;
+    for (EdgeList *adjList = graph->vertices[u]->adjList; adjList != NULL;
+         adjList = adjList->next)
+    {
+      int v = otherEndpoint(adjList->edge, u);
+      int weight = adjList->edge->weight;
+      if (weight <= INT_MAX - uDistance &&
+          uDistance + weight < search->distance[v])
+      {
+        relaxSearch(search, v, uDistance + weight);
+        nearest[v] = nearest[u];
+      }
+    }
+  }
+}
+
+/* Fills p_i and its distances in the oracle of 'build' for level 'i' >= 1.
+ * At the top level, every vertex that no vertex of A_i reaches is added to
+ * A_i, so that every component has one.
+ */
+static void findNearest(OracleBuild *build, int i, Search *search)
+{
+  DistanceOracle *oracle = build->oracle;
+  int n = oracle->numVertices;
+  int *nearest = oracle->nearest + (long)(i - 1) * n;
+  int *nearestDistance = oracle->nearestDistance + (long)(i - 1) * n;
+  for (int v = 0; v < n; v++)
+  {
+    nearest[v] = NOTHING;
+    if (build->level[v] >= i)
+    {
+      nearest[v] = v;
+      relaxSearch(search, v, 0);
+    }
+  }
+  spreadNearest(build->graph, search, nearest);
+  if (i == oracle->k - 1)
+  {
+    for (int v = 0; v < n; v++)
+    {
+      if (search->distance[v] == INT_MAX)
+      {
+        build->level[v] = i;
+        nearest[v] = v;
+        relaxSearch(search, v, 0);
+        spreadNearest(build->graph, search, nearest);
+      }
+    }
+  }
+  for (int v = 0; v < n; v++)
+  {
+    nearestDistance[v] = search->distance[v];
+  }
+  resetSearch(search);
+}
+
+/* Records that 'vertex' is at distance 'distance' in the bunch of 'owner'.
+ * Returns false if memory could not be allocated.
+ */
+static bool addItem(Search *search, int owner, int vertex, int distance)
+{
+  if (search->numItems == search->capacity)
+  {
+    long capacity = search->capacity > 0 ? 2 * search->capacity : 1024;
+    BunchItem *items = realloc(search->items, sizeof(BunchItem) * capacity);
+    if (items == NULL)
+    {
+      return false;
+    }
+    search->items = items;
+    search->capacity = capacity;
+  }
+  BunchItem *item = &search->items[search->numItems++];
+  item->owner = owner;
+  item->vertex = vertex;
+  item->distance = distance;
+  return true;
+}
+
+/* Finds the cluster of 'center', the vertices v that are closer to it than
+ * to any vertex of the next level, and adds 'center' to their bunches. The
+ * cluster holds every vertex on a shortest path from 'center' to one of its
+ * members, so a search that does not go past its edge finds all of it.
+ * Returns false if memory could not be allocated.
+ */
+static bool growCluster(OracleBuild *build, Search *search, int center)
+{
+  DistanceOracle *oracle = build->oracle;
+  int i = build->level[center];
+  // limit[v] is the distance from v to A_(i+1), which is empty at the top.
+  int *limit = i + 1 < oracle->k
+                   ? oracle->nearestDistance + (long)i * oracle->numVertices
+                   : NULL;
+  if (limit != NULL && limit[center] <= 0)
+  {
+    return true;
+  }
+
+  bool ok = true;
+  relaxSearch(search, center, 0);
+  while (search->heap->size > 0)
+  {
+    HeapNode minNode = extractMin(search->heap);
+    int u = minNode.id;
+    int uDistance = minNode.priority;
+    ok = ok && addItem(search, u, center, uDistance);
+    for (EdgeList *adjList = build->graph->vertices[u]->adjList;
+         adjList != NULL; adjList = adjList->next)
+    {
+      int v = otherEndpoint(adjList->edge, u);
+      int weight = adjList->edge->weight;
+      if (weight > INT_MAX - uDistance)
+      {
+        continue;
+      }
+      int distance = uDistance + weight;
+      if (distance < search->distance[v] &&
+          (limit == NULL || distance < limit[v]))
+      {
+        relaxSearch(search, v, distance);
+      }
+    }
+  }
+  resetSearch(search);
+  return ok;
+}
+
+/* Body of one thread of newDistanceOracle: claims centers in chunks and
+ * grows their clusters. A thread that cannot get a search leaves its share
+ * to the others.
+ */
+static void growClusters(void *ctx, int thread, int numThreads)
+{
+  OracleBuild *build = ctx;
+  int n = build->oracle->numVertices;
+  Search *search = &build->searches[thread];
+  if (!newSearch(search, n))
+  {
+    return;
+  }
+  while (true)
+  {
+    long first = __atomic_fetch_add(&build->nextCenter, CENTER_CHUNK,
+                                    __ATOMIC_RELAXED);
+    if (first >= n)
+    {
+      break;
+    }
+    long last = first + CENTER_CHUNK < n ? first + CENTER_CHUNK : n;
+    for (long center = first; center < last; center++)
+    {
+      if (!growCluster(build, search, center))
+      {
+        __atomic_store_n(&build->failed, true, __ATOMIC_RELAXED);
+      }
+    }
+  }
+}
+
+/* Puts the bunch items found by all 'numThreads' threads of 'build' into
+ * one hash table per vertex. Returns false if memory could not be
+ * allocated.
+ */
+static bool fillBunches(OracleBuild *build, int numThreads)
+{
+  DistanceOracle *oracle = build->oracle;
+  int n = oracle->numVertices;
+  long *count = oracle->bunchStart;
+  for (int v = 0; v <= n; v++)
+  {
+    count[v] = 0;
+  }
+  for (int t = 0; t < numThreads; t++)
+  {
+    for (long j = 0; j < build->searches[t].numItems; j++)
+    {
+      count[build->searches[t].items[j].owner]++;
+    }
+  }
+
+  // Each table is at most three quarters full, so every search ends at an
+  // empty slot. Turn the counts into table sizes and those into starts.
+  long numSlots = 0;
+  for (int v = 0; v < n; v++)
+  {
+    long size = 0;
+    if (count[v] > 0)
+    {
+      for (size = 2; size < count[v] + count[v] / 3 + 1; size *= 2)
+      {
+      }
+    }
+    oracle->numEntries += count[v];
+    count[v] = numSlots;
+    numSlots += size;
+  }
+  oracle->bunchStart[n] = numSlots;
+
+  oracle->bunches = malloc(sizeof(OracleEntry) * (numSlots + 1));
+  if (oracle->bunches == NULL)
+  {
+    return false;
+  }
+  for (long s = 0; s < numSlots; s++)
+  {
+    oracle->bunches[s].vertex = NOTHING;
+  }
+  for (int t = 0; t < numThreads; t++)
+  {
+    for (long j = 0; j < build->searches[t].numItems; j++)
+    {
+      BunchItem *item = &build->searches[t].items[j];
+      long start = oracle->bunchStart[item->owner];
+      OracleEntry *bunch = oracle->bunches + start;
+      unsigned long mask = oracle->bunchStart[item->owner + 1] - start - 1;
+      unsigned long h = hashVertex(item->vertex, mask);
+      while (bunch[h].vertex != NOTHING)
+      {
+        h = (h + 1) & mask;
+      }
+      bunch[h].vertex = item->vertex;
+      bunch[h].distance = item->distance;
+    }
+  }
+  return true;
+}
+
+/* Returns a new oracle with parameter 'k' for 'numVertices' vertices, with
+ * room for p_1 .. p_(k-1) and the bunch starts, but no bunches. Returns
+ * NULL if memory could not be allocated.
+ */
+static DistanceOracle *newOracle(int k, int numVertices)
+{
+  DistanceOracle *res = calloc(1, sizeof(DistanceOracle));
+  if (res == NULL)
+  {
+    return NULL;
+  }
+  long numNearest = (long)(k - 1) * numVertices;
+  res->k = k;
+  res->numVertices = numVertices;
+  res->nearest = malloc(sizeof(int) * (numNearest + 1));
+  res->nearestDistance = malloc(sizeof(int) * (numNearest + 1));
+  res->bunchStart = malloc(sizeof(long) * (numVertices + 1));
+  if (res->nearest == NULL || res->nearestDistance == NULL ||
+      res->bunchStart == NULL)
+  {
+    deleteDistanceOracle(res);
+    return NULL;
+  }
+  return res;
+}
+
+/* Builds a distance oracle with parameter 'k' for Graph 'graph', drawing
+ * the samples from a generator started with 'seed', with 'numThreads'
+ * threads (0 for the default).
+ * Returns NULL if k < 1 or memory could not be allocated.
+ * Precondition: 'graph' is undirected and no weight is negative
+ */
+DistanceOracle *newDistanceOracle(Graph *graph, int k, unsigned seed,
+                                  int numThreads)
+{
+  int n = graph->numVertices;
+  if (k < 1)
+  {
+    return NULL;
+  }
+  if (numThreads <= 0)
+  {
+    numThreads = defaultThreadCount();
+  }
+  OracleBuild build = {graph, newOracle(k, n), calloc(n + 1, sizeof(int)),
+                       calloc(numThreads, sizeof(Search)), 0, false};
+  bool ok = build.oracle != NULL && build.level != NULL &&
+            build.searches != NULL;
+
+  if (ok)
+  {
+    unsigned state = seed != 0 ? seed : 1;
+    double p = sampleProbability(n, k);
+    for (int v = 0; v < n; v++)
+    {
+      while (build.level[v] < k - 1 && nextRandom(&state) < p)
+      {
+        build.level[v]++;
+      }
+    }
+    // Top down: the top level adds vertices to every level below it.
+    Search search;
+    ok = newSearch(&search, n);
+    for (int i = k - 1; ok && i >= 1; i--)
+    {
+      findNearest(&build, i, &search);
+    }
+    freeSearch(&search);
+  }
+
+  if (ok)
+  {
+    parallelRun(numThreads, growClusters, &build);
+    ok = !build.failed && build.nextCenter >= n &&
+         fillBunches(&build, numThreads);
+  }
+
+  for (int t = 0; build.searches != NULL && t < numThreads; t++)
+  {
+    freeSearch(&build.searches[t]);
+  }
+  free(build.searches);
+  free(build.level);
+  if (!ok)
+  {
+    deleteDistanceOracle(build.oracle);
+    return NULL;
+  }
+  return build.oracle;
+}
+
+/* Frees all memory allocated for 'oracle'. */
+void deleteDistanceOracle(DistanceOracle *oracle)
+{
+  if (oracle == NULL)
+  {
+    return;
+  }
+  free(oracle->nearest);
+  free(oracle->nearestDistance);
+  free(oracle->bunchStart);
+  free(oracle->bunches);
+  free(oracle);
+}
+
+/* Returns an estimate of the distance from 'u' to 'v' with stretch at most
+ * 2k-1, ORACLE_UNREACHABLE if there is no path, and -1 if either vertex is
+ * not valid in 'oracle'.
+ */
+int64_t getOracleDistance(DistanceOracle *oracle, int u, int v)
+{
+  int n = oracle->numVertices;
+  if (u < 0 || u >= n || v < 0 || v >= n)
+  {
+    return -1;
+  }
+  // w is p_i(u), at distance wDistance from u.
+  int w = u;
+  int64_t wDistance = 0;
+  for (int i = 0;;)
+  {
+    int distance = bunchDistance(oracle, v, w);
+    if (distance != NOTHING)
+    {
+      return wDistance + distance;
+    }
+    if (++i == oracle->k)
+    {
+      return ORACLE_UNREACHABLE;
+    }
+    int swap = u;
+    u = v;
+    v = swap;
+    w = oracle->nearest[(long)(i - 1) * n + u];
+    wDistance = oracle->nearestDistance[(long)(i - 1) * n + u];
+    if (w == NOTHING)
+    {
+      return ORACLE_UNREACHABLE;
+    }
+  }
+}
+
+/* Returns the number of bytes 'oracle' takes up in memory. */
+size_t getOracleSize(DistanceOracle *oracle)
+{
+  long numNearest = (long)(oracle->k - 1) * oracle->numVertices;
+  return sizeof(DistanceOracle) + 2 * sizeof(int) * numNearest +
+         sizeof(long) * (oracle->numVertices + 1) +
+         sizeof(OracleEntry) * oracle->bunchStart[oracle->numVertices];
+}
+
+/* Writes 'oracle' to the binary file 'f'. Returns false iff a write failed.
+ */
+bool saveOracle(DistanceOracle *oracle, FILE *f)
+{
+  int n = oracle->numVertices;
+  OracleFileHeader header = {ORACLE_MAGIC, oracle->k, n, sizeof(long),
+                             oracle->numEntries, oracle->bunchStart[n]};
+  size_t numNearest = (size_t)(oracle->k - 1) * n;
+  size_t numStarts = (size_t)n + 1;
+  size_t numSlots = header.numSlots;
+  return fwrite(&header, sizeof(header), 1, f) == 1 &&
+         fwrite(oracle->nearest, sizeof(int), numNearest, f) == numNearest &&
+         fwrite(oracle->nearestDistance, sizeof(int), numNearest, f) ==
+             numNearest &&
+         fwrite(oracle->bunchStart, sizeof(long), numStarts, f) ==
+             numStarts &&
+         fwrite(oracle->bunches, sizeof(OracleEntry), numSlots, f) ==
+             numSlots &&
+         fflush(f) == 0;
+}
+
+/* Returns true iff the arrays of 'oracle', just read from a file, are
+ * consistent, so that queries on it stay within its arrays and end.
+ */
+static bool validOracle(DistanceOracle *oracle, long numSlots)
+{
+  int n = oracle->numVertices;
+  long numNearest = (long)(oracle->k - 1) * n;
+  for (long j = 0; j < numNearest; j++)
+  {
+    if (oracle->nearest[j] < NOTHING || oracle->nearest[j] >= n)
+    {
+      return false;
+    }
+  }
+  if (oracle->bunchStart[0] != 0 || oracle->bunchStart[n] != numSlots)
+  {
+    return false;
+  }
+  long numEntries = 0;
+  for (int v = 0; v < n; v++)
+  {
+    long size = oracle->bunchStart[v + 1] - oracle->bunchStart[v];
+    if (size < 0 || (size & (size - 1)) != 0)
+    {
+      return false;
+    }
+    long full = 0;
+    for (long s = oracle->bunchStart[v]; s < oracle->bunchStart[v + 1]; s++)
+    {
+      full += oracle->bunches[s].vertex != NOTHING;
+    }
+    if (size > 0 && full == size)
+    {
+      return false;
+    }
+    numEntries += full;
+  }
+  return numEntries == oracle->numEntries;
+}
+
+/* Reads an oracle written by saveOracle from 'f' and returns it, or NULL if
+ * 'f' does not hold a valid oracle or memory could not be allocated.
+ */
+DistanceOracle *loadOracle(FILE *f)
+{
+  OracleFileHeader header;
+  if (fread(&header, sizeof(header), 1, f) != 1 ||
+      header.magic != ORACLE_MAGIC || header.longSize != sizeof(long) ||
+      header.k < 1 || header.numVertices < 0 || header.numSlots < 0 ||
+      header.numEntries < 0)
+  {
+    return NULL;
+  }
+  DistanceOracle *res = newOracle(header.k, header.numVertices);
+  if (res == NULL)
+  {
+    return NULL;
+  }
+  size_t numNearest = (size_t)(header.k - 1) * header.numVertices;
+  size_t numStarts = (size_t)header.numVertices + 1;
+  size_t numSlots = header.numSlots;
+  res->numEntries = header.numEntries;
+  res->bunches = malloc(sizeof(OracleEntry) * (numSlots + 1));
+  if (res->bunches == NULL ||
+      fread(res->nearest, sizeof(int), numNearest, f) != numNearest ||
+      fread(res->nearestDistance, sizeof(int), numNearest, f) != numNearest ||
+      fread(res->bunchStart, sizeof(long), numStarts, f) != numStarts ||
+      fread(res->bunches, sizeof(OracleEntry), numSlots, f) != numSlots ||
+      !validOracle(res, header.numSlots))
+  {
+    deleteDistanceOracle(res);
+    return NULL;
+  }
+  return res;
+}
@@ -0,0 +1,85 @@
+/*
+ * Header file for approximate distance oracles (Thorup and Zwick).
+ *
+ * An oracle with parameter k answers distance queries in O(k) time with an
+ * estimate that is never below the true distance and at most 2k-1 times
+ * it, from O(k n^(1+1/k)) space (expected). k = 1 stores all distances
+ * exactly; k = 2 gives stretch 3 from O(n^1.5) space, and so on.
+ *
+ * Building it samples vertex sets V = A_0 > A_1 > ... > A_(k-1), each
+ * vertex of A_(i-1) going on to A_i with probability n^(-1/k). Every vertex
+ * v stores, for every level i, its nearest vertex p_i(v) in A_i, and its
+ * bunch: the vertices w of A_i that are closer to v than all of A_(i+1),
+ * with their distances. A query for (u, v) climbs the levels from u and v
+ * in turn until the nearest vertex of one is in the bunch of the other.
+ *
+ * An oracle can be saved to a file and loaded back. The file holds the
+ * oracle's arrays as they are in memory, so it is only readable on machines
+ * with the same byte order and int size.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "graph.h"
+
+#ifndef __Graph_Oracle_header
+#define __Graph_Oracle_header
+
+#define ORACLE_UNREACHABLE INT64_MAX  // getOracleDistance: no path
+
+typedef struct oracle_entry {
+  int vertex;    // a vertex w in the bunch; -1 for an empty slot
+  int distance;  // the distance from w to the bunch's owner
+} OracleEntry;
+
+typedef struct distance_oracle {
+  int k;                 // the estimates have stretch at most 2k-1
+  int numVertices;       // vertex IDs are 0, 1, ..., numVertices-1
+  int* nearest;          // nearest[(i-1) * numVertices + v] is p_i(v), the
+                         //   vertex of A_i nearest to v, for 1 <= i < k
+  int* nearestDistance;  // the distance from v to p_i(v), indexed the same
+  long* bunchStart;      // the bunch of v is bunches[bunchStart[v] ..
+                         //   bunchStart[v+1]-1], a hash table whose size is
+                         //   0 or a power of 2
+  OracleEntry* bunches;  // the bunches of all vertices
+  long numEntries;       // the number of vertices in all bunches together
+} DistanceOracle;
+
+/* Builds a distance oracle with parameter 'k' for Graph 'graph', drawing
+ * the samples from a generator started with 'seed'. Uses 'numThreads'
+ * threads, or 0 for the default. Every connected component gets a vertex in
+ * A_(k-1), so distances within a component are always found.
+ * Returns NULL if k < 1 or memory could not be allocated.
+ * Precondition: 'graph' is undirected (symmetric, or with every edge stored
+ *               in both directions) and no weight is negative
+ */
+DistanceOracle* newDistanceOracle(Graph* graph, int k, unsigned seed,
+                                  int numThreads);
+
+/* Frees all memory allocated for 'oracle'. */
+void deleteDistanceOracle(DistanceOracle* oracle);
+
+/* Returns an estimate d of the distance from 'u' to 'v', with
+ * distance <= d <= (2k-1) * distance, in O(k) time. Returns
+ * ORACLE_UNREACHABLE if there is no path, and -1 if either vertex is not
+ * valid in 'oracle'.
+ */
+int64_t getOracleDistance(DistanceOracle* oracle, int u, int v);
+
+/* Returns the number of bytes 'oracle' takes up in memory. */
+size_t getOracleSize(DistanceOracle* oracle);
+
+/* Writes 'oracle' to the binary file 'f'. Returns false iff a write failed.
+ */
+bool saveOracle(DistanceOracle* oracle, FILE* f);
+
+/* Reads an oracle written by saveOracle from 'f' into a newly allocated
+ * DistanceOracle and returns it. Returns NULL if 'f' does not hold a valid
+ * oracle or memory could not be allocated.
+ */
+DistanceOracle* loadOracle(FILE* f);
+
+#endif
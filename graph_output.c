@@ -0,0 +1,335 @@
+/*
+ * Fast output of graphs and algorithm results.
+ */
+
+#include <errno.h>
+#include <string.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include "graph_output.h"
+#include "graph_symmetric.h"
+
+/* Returns a new Output to the file descriptor 'fd' with a buffer of
+ * 'capacity' bytes (OUTPUT_BUFFER_SIZE if 0), in binary mode iff 'binary'.
+ * Returns NULL if memory could not be allocated.
+ */
+Output *newOutput(int fd, size_t capacity, bool binary)
+{
+  Output *res = malloc(sizeof(Output));
+  if (res == NULL)
+  {
+    return NULL;
+  }
+  res->capacity = capacity > MAX_LONG_DIGITS ? capacity : OUTPUT_BUFFER_SIZE;
+  res->buffer = malloc(res->capacity);
+  if (res->buffer == NULL)
+  {
+    free(res);
+    return NULL;
+  }
+  res->fd = fd;
+  res->binary = binary;
+  res->size = 0;
+  res->written = 0;
+  res->failed = false;
+  res->externalIds = NULL;
+  return res;
+}
+
+/* Flushes 'out' and frees all memory allocated for it. Returns false iff
+ * any write to it failed.
+ */
+bool deleteOutput(Output *out)
+{
+  if (out == NULL)
+  {
+    return true;
+  }
+  bool ok = flushOutput(out);
+  free(out->buffer);
+  free(out);
+  return ok;
+}
+
+/* Writes the 'count' blocks in 'blocks' to the file descriptor of 'out',
+ * retrying after short writes, and empties the buffer.
+ */
+static void writeBlocks(Output *out, struct iovec *blocks, int count)
+{
+  while (count > 0 && !out->failed)
+  {
+    ssize_t done = writev(out->fd, blocks, count);
+    if (done < 0)
+    {
+      out->failed = errno != EINTR;
+      continue;
+    }
+    out->written += done;
+    // Skip what was written; a block may have gone out only in part.
+    while (count > 0 && (size_t)done >= blocks->iov_len)
+    {
+      done -= blocks->iov_len;
+      blocks++;
+      count--;
+    }
+    if (count > 0)
+    {
+      blocks->iov_base = (char *)blocks->iov_base + done;
+      blocks->iov_len -= done;
+    }
+  }
+  out->size = 0;
+}
+
+/* Writes everything buffered in 'out' to its file descriptor. Returns false
+ * iff any write to it has failed.
+ */
+bool flushOutput(Output *out)
+{
+  struct iovec block = {out->buffer, out->size};
+  writeBlocks(out, &block, 1);
+  return !out->failed;
+}
+
+/* Writes the 'length' bytes at 'data' to 'out', in either mode. Blocks that
+ * do not fit in the buffer are written together with it by one writev.
+ */
+void outputBytes(Output *out, const void *data, size_t length)
+{
+  if (length <= out->capacity - out->size)
+  {
+    memcpy(out->buffer + out->size, data, length);
+    out->size += length;
+    return;
+  }
+  struct iovec blocks[2] = {{out->buffer, out->size},
+                            {(void *)data, length}};
+  writeBlocks(out, blocks, 2);
+}
+
+/* Writes the string 'text' to 'out' in text mode only. */
+void outputText(Output *out, const char *text)
+{
+  if (!out->binary)
+  {
+    outputBytes(out, text, strlen(text));
+  }
+}
+
+/* Writes 'value' in decimal to 'buffer', which has room for MAX_LONG_DIGITS
+ * characters, and returns the number written. No '\0' is added.
+ */
+size_t formatLong(char *buffer, int64_t value)
+{
+  unsigned long long magnitude =
+      value < 0 ? 0ull - (unsigned long long)value : (unsigned long long)value;
+  // Digits come out last first, so fill a scratch buffer from its end.
+  char digits[MAX_LONG_DIGITS];
+  char *start = digits + MAX_LONG_DIGITS;
+  do
+  {
+    *--start = '0' + magnitude % 10;
+    magnitude /= 10;
+  } while (magnitude > 0);
+  if (value < 0)
+  {
+    *--start = '-';
+  }
+  size_t length = digits + MAX_LONG_DIGITS - start;
+  memcpy(buffer, start, length);
+  return length;
+}
+
+/* Writes 'value' in decimal to 'out' in text mode. */
+static void outputDecimal(Output *out, int64_t value)
+{
+  if (out->capacity - out->size < MAX_LONG_DIGITS)
+  {
+    flushOutput(out);
+  }
+  out->size += formatLong(out->buffer + out->size, value);
+}
+
+/* Writes 'value' to 'out': in decimal in text mode, as a native int in
+ * binary mode.
+ */
+void outputInt(Output *out, int value)
+{
+  if (out->binary)
+  {
+    outputBytes(out, &value, sizeof(int));
+    return;
+  }
+  outputDecimal(out, value);
+}
+
+/* Writes 'value' to 'out': in decimal in text mode, as a native 8-byte int
+ * in binary mode.
+ */
+void outputLong(Output *out, int64_t value)
+{
+  if (out->binary)
+  {
+    outputBytes(out, &value, sizeof(int64_t));
+    return;
+  }
+  outputDecimal(out, value);
+}
+
+/* Writes the vertex 'vertex' to 'out': its external ID if 'out' has them,
+ * otherwise (or if 'vertex' is negative, for no vertex) 'vertex' itself.
+ */
+static void outputVertex(Output *out, int vertex)
+{
+  if (out->externalIds == NULL)
+  {
+    outputInt(out, vertex);
+  }
+  else
+  {
+    outputLong(out, vertex < 0 ? vertex : out->externalIds[vertex]);
+  }
+}
+
+/* Writes the edge (from -- to, weight) to 'out'. */
+static void outputTriple(Output *out, int from, int to, int weight)
+{
+  outputText(out, "(");
+  outputVertex(out, from);
+  outputText(out, " -- ");
+  outputVertex(out, to);
+  outputText(out, ", ");
+  outputInt(out, weight);
+  outputText(out, ")");
+}
+
+/* Writes 'edge' as printEdge does. In binary mode a NULL edge is written as
+ * three -1s.
+ */
+void outputEdge(Output *out, Edge *edge)
+{
+  if (edge == NULL)
+  {
+    if (out->binary)
+    {
+      outputTriple(out, -1, -1, -1);
+    }
+    outputText(out, "NULL");
+    return;
+  }
+  outputTriple(out, edge->fromVertex, edge->toVertex, edge->weight);
+}
+
+/* Writes the list 'head' as printEdgeList does. */
+void outputEdgeList(Output *out, EdgeList *head)
+{
+  if (out->binary)
+  {
+    int length = 0;
+    for (EdgeList *cur = head; cur != NULL; cur = cur->next)
+    {
+      length++;
+    }
+    outputInt(out, length);
+  }
+  for (; head != NULL; head = head->next)
+  {
+    outputEdge(out, head->edge);
+    outputText(out, " --> ");
+  }
+  outputText(out, "NULL");
+}
+
+/* Writes the 'numTreeEdges' edges of 'tree' one per line, and returns their
+ * total weight (-1 if 'tree' is NULL).
+ */
+int outputTree(Output *out, Edge *tree, int numTreeEdges)
+{
+  if (tree == NULL)
+  {
+    return -1;
+  }
+  int totalWeight = 0;
+  for (int i = 0; i < numTreeEdges; i++)
+  {
+    outputEdge(out, &tree[i]);
+    outputText(out, "\n");
+    totalWeight += tree[i].weight;
+  }
+  return totalWeight;
+}
+
+/* Writes the 'numVertices' lists in 'paths' one per line, each prefixed
+ * with "From vertex <id>: ".
+ */
+void outputPaths(Output *out, EdgeList **paths, int numVertices)
+{
+  if (paths == NULL)
+  {
+    return;
+  }
+  for (int i = 0; i < numVertices; i++)
+  {
+    outputText(out, "From vertex ");
+    if (!out->binary)
+    {
+      outputVertex(out, i);
+    }
+    outputText(out, ": ");
+    outputEdgeList(out, paths[i]);
+    outputText(out, "\n");
+  }
+}
+
+/* Writes 'graph' as printGraph does. */
+void outputGraph(Output *out, Graph *graph)
+{
+  if (graph == NULL)
+  {
+    outputText(out, "NULL");
+    return;
+  }
+  outputText(out, "Number of vertices: ");
+  outputInt(out, graph->numVertices);
+  outputText(out, ". Number of edges: ");
+  outputInt(out, graph->numEdges);
+  outputText(out, ".\n\n");
+
+  for (int i = 0; i < graph->numVertices; i++)
+  {
+    Vertex *vertex = graph->vertices[i];
+    if (vertex == NULL)
+    {
+      outputText(out, "NULL\n");
+      continue;
+    }
+    outputVertex(out, vertex->id);
+    outputText(out, ": ");
+    if (out->binary)
+    {
+      int degree = 0;
+      for (EdgeList *cur = vertex->adjList; cur != NULL; cur = cur->next)
+      {
+        degree++;
+      }
+      outputInt(out, degree);
+    }
+    // Like printVertex, orient every edge away from this vertex.
+    for (EdgeList *cur = vertex->adjList; cur != NULL; cur = cur->next)
+    {
+      if (cur->edge == NULL)
+      {
+        outputEdge(out, NULL);
+      }
+      else
+      {
+        outputTriple(out, vertex->id, otherEndpoint(cur->edge, vertex->id),
+                     cur->edge->weight);
+      }
+      outputText(out, " --> ");
+    }
+    outputText(out, "NULL\n");
+  }
+  outputText(out, "\n");
+}
@@ -0,0 +1,106 @@
+/*
+ * Header file for fast output of graphs and algorithm results.
+ *
+ * An Output collects what is written to it in a large buffer and hands it to
+ * a file descriptor in big writes, formatting integers by hand rather than
+ * through printf. In text mode the results look exactly like the print
+ * functions of graph.h and the tester produce. In binary mode every integer
+ * is written as a native 4-byte int, text is dropped, and lists are preceded
+ * by their length:
+ *   Edge      from, to, weight
+ *   tree      the Edges one after another (the caller knows how many)
+ *   EdgeList  number of Edges, then the Edges
+ *   paths     an EdgeList per vertex
+ *   Graph     numVertices, numEdges, then per vertex its ID and EdgeList
+ *             (each Edge oriented away from that vertex)
+ * If an Output is given external vertex IDs (see graph_ids.h), vertices are
+ * written as those instead, in binary mode as native 8-byte ints.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "graph.h"
+
+#ifndef __Graph_Output_header
+#define __Graph_Output_header
+
+#define OUTPUT_BUFFER_SIZE (1 << 20)  // default buffer size in bytes
+#define MAX_LONG_DIGITS 20  // "-9223372036854775808"
+
+typedef struct output {
+  int fd;           // where the output goes
+  bool binary;      // true for binary mode, false for text mode
+  char* buffer;     // bytes not yet written to 'fd'
+  size_t size;      // number of bytes in 'buffer'
+  size_t capacity;  // size of 'buffer'
+  long written;     // bytes written to 'fd' so far
+  bool failed;      // true once a write to 'fd' has failed
+  const int64_t* externalIds;  // if not NULL, vertex v is written as
+                               //   externalIds[v]
+} Output;
+
+/* Returns a new Output to the file descriptor 'fd' with a buffer of
+ * 'capacity' bytes (OUTPUT_BUFFER_SIZE if 0), in binary mode iff 'binary'.
+ * Returns NULL if memory could not be allocated.
+ */
+Output* newOutput(int fd, size_t capacity, bool binary);
+
+/* Flushes 'out' and frees all memory allocated for it; the file descriptor
+ * stays open. Returns false iff any write to it failed.
+ */
+bool deleteOutput(Output* out);
+
+/* Writes everything buffered in 'out' to its file descriptor. Returns false
+ * iff any write to it has failed.
+ */
+bool flushOutput(Output* out);
+
+/* Writes the 'length' bytes at 'data' to 'out', in either mode. Blocks that
+ * do not fit in the buffer go straight to the file descriptor together with
+ * the buffer, in a single writev, without being copied.
+ */
+void outputBytes(Output* out, const void* data, size_t length);
+
+/* Writes the string 'text' to 'out' in text mode; does nothing in binary
+ * mode.
+ */
+void outputText(Output* out, const char* text);
+
+/* Writes 'value' to 'out': in decimal in text mode, as a native int in
+ * binary mode.
+ */
+void outputInt(Output* out, int value);
+
+/* Writes 'value' to 'out': in decimal in text mode, as a native 8-byte int
+ * in binary mode.
+ */
+void outputLong(Output* out, int64_t value);
+
+/* Writes 'value' in decimal to 'buffer', which has room for MAX_LONG_DIGITS
+ * characters, and returns the number written. No '\0' is added.
+ */
+size_t formatLong(char* buffer, int64_t value);
+
+/* Writes 'edge' as printEdge does: "(from -- to, weight)", or "NULL". */
+void outputEdge(Output* out, Edge* edge);
+
+/* Writes the list 'head' as printEdgeList does. */
+void outputEdgeList(Output* out, EdgeList* head);
+
+/* Writes the 'numTreeEdges' edges of 'tree' one per line, as the tester
+ * prints trees, and returns their total weight (-1 if 'tree' is NULL).
+ */
+int outputTree(Output* out, Edge* tree, int numTreeEdges);
+
+/* Writes the 'numVertices' lists in 'paths' one per line, each prefixed
+ * with "From vertex <id>: ", as the tester prints shortest paths.
+ */
+void outputPaths(Output* out, EdgeList** paths, int numVertices);
+
+/* Writes 'graph' as printGraph does. */
+void outputGraph(Output* out, Graph* graph);
+
+#endif
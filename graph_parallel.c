@@ -0,0 +1,276 @@
+/*
+ * Shortest paths searched by many threads on one shared frontier.
+ */
+
+#include <limits.h>
+#include <sched.h>
+#include <stdint.h>
+
+#include "graph_parallel.h"
+#include "graph_symmetric.h"
+#include "multiqueue.h"
+#include "parallel.h"
+
+#define NOTHING -1
+#define INSERT_BATCH 32  // most nodes a thread inserts under one lock
+
+typedef struct shared_search
+{
+  Graph *graph;
+  MultiQueue *queue;
+  uint64_t *labels;  // labels[v]: atomic; v's tentative distance in the high
+                     //   half and its predecessor in the low half
+  bool *settled;     // settled[v]: atomic; true once v relaxed its edges
+  long pending;      // atomic: nodes inserted and not yet done with; the
+                     //   search is over when it drops to 0
+  bool failed;       // atomic: true if an insert ran out of memory
+  SearchStats stats;  // the totals of all threads
+} SharedSearch;
+
+/* Returns the label of a vertex at distance 'distance' via 'predecessor'. */
+static uint64_t makeLabel(int distance, int predecessor)
+{
+  return (uint64_t)distance << 32 | (uint32_t)predecessor;
+}
+
+/* Returns the distance in 'label'. */
+static int labelDistance(uint64_t label)
+{
+  return (int)(label >> 32);
+}
+
+/* Returns the predecessor in 'label'. */
+static int labelPredecessor(uint64_t label)
+{
+  return (int)(uint32_t)label;
+}
+
+/* Returns true if 'node' has a longer distance than its vertex has in the
+ * SharedSearch 'ctx' by now: a shorter path put another copy in the queue.
+ */
+static bool isStaleNode(void *ctx, HeapNode node)
+{
+  SharedSearch *search = ctx;
+  uint64_t label = __atomic_load_n(&search->labels[node.id],
+                                   __ATOMIC_RELAXED);
+  return node.priority > labelDistance(label);
+}
+
+/* Inserts the 'count' nodes in 'batch' into the queue of 'search'. */
+static void insertBatch(SharedSearch *search, HeapNode *batch, int count,
+                        unsigned *seed)
+{
+  if (!multiQueueInsertMany(search->queue, batch, count, seed))
+  {
+    __atomic_store_n(&search->failed, true, __ATOMIC_RELAXED);
+    __atomic_sub_fetch(&search->pending, count, __ATOMIC_RELEASE);
+  }
+}
+
+/* Lowers the distance of every neighbour of 'u' that is closer via 'u', at
+ * distance 'distance', and puts it in the queue of 'search' again.
+ */
+static void relaxEdges(SharedSearch *search, int u, int distance,
+                       unsigned *seed)
+{
+  HeapNode batch[INSERT_BATCH];
+  int count = 0;
+  for (EdgeList *adjList = search->graph->vertices[u]->adjList;
+       adjList != NULL; adjList = adjList->next)
+  {
+    int v = otherEndpoint(adjList->edge, u);
+    long through = (long)distance + adjList->edge->weight;
+    if (through >= INT_MAX)
+    {
+      continue;
+    }
+    uint64_t label = __atomic_load_n(&search->labels[v], __ATOMIC_RELAXED);
+    while (through < labelDistance(label))
+    {
+      // On failure 'label' is reloaded, and we try again if still longer.
+      if (__atomic_compare_exchange_n(&search->labels[v], &label,
+                                      makeLabel(through, u), true,
+                                      __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+      {
+        __atomic_add_fetch(&search->pending, 1, __ATOMIC_RELAXED);
+        batch[count].priority = through;
+        batch[count++].id = v;
+        if (count == INSERT_BATCH)
+        {
+          insertBatch(search, batch, count, seed);
+          count = 0;
+        }
+        break;
+      }
+    }
+  }
+  if (count > 0)
+  {
+    insertBatch(search, batch, count, seed);
+  }
+}
+
+/* Body of one thread of getDistanceTreeMultiQueue: takes nodes from the
+ * queue and relaxes the edges of their vertices until no thread has any
+ * left.
+ */
+static void searchPart(void *ctx, int thread, int numThreads)
+{
+  (void)numThreads;
+  SharedSearch *search = ctx;
+  unsigned seed = 2654435761u * (thread + 1);  // odd factor: never 0
+  SearchStats stats = {0, 0, 0, 0, 0};
+  HeapNode node;
+  int numDropped;
+  while (!__atomic_load_n(&search->failed, __ATOMIC_RELAXED))
+  {
+    bool found = multiQueueExtractMin(search->queue, &node, &seed,
+                                      &numDropped);
+    if (numDropped > 0)
+    {
+      stats.drops += numDropped;
+      __atomic_sub_fetch(&search->pending, numDropped, __ATOMIC_RELEASE);
+    }
+    if (!found)
+    {
+      // Empty for now; other threads may still be adding to it.
+      if (__atomic_load_n(&search->pending, __ATOMIC_ACQUIRE) == 0)
+      {
+        break;
+      }
+      sched_yield();
+      continue;
+    }
+    stats.pops++;
+    int u = node.id;
+    if (isStaleNode(search, node))
+    {
+      stats.stalePops++;  // it got closer after the queue let this copy out
+    }
+    else
+    {
+      stats.settles++;
+      if (__atomic_exchange_n(&search->settled[u], true, __ATOMIC_RELAXED))
+      {
+        stats.resettles++;
+      }
+      relaxEdges(search, u, node.priority, &seed);
+    }
+    __atomic_sub_fetch(&search->pending, 1, __ATOMIC_RELEASE);
+  }
+  __atomic_add_fetch(&search->stats.drops, stats.drops, __ATOMIC_RELAXED);
+  __atomic_add_fetch(&search->stats.pops, stats.pops, __ATOMIC_RELAXED);
+  __atomic_add_fetch(&search->stats.stalePops, stats.stalePops,
+                     __ATOMIC_RELAXED);
+  __atomic_add_fetch(&search->stats.settles, stats.settles, __ATOMIC_RELAXED);
+  __atomic_add_fetch(&search->stats.resettles, stats.resettles,
+                     __ATOMIC_RELAXED);
+}
+
+/* Orders tree edges by distance, then by vertex ID. */
+static int compareTreeEdges(const void *a, const void *b)
+{
+  const Edge *x = a, *y = b;
+  if (x->weight != y->weight)
+  {
+    return x->weight < y->weight ? -1 : 1;
+  }
+  return (x->fromVertex > y->fromVertex) - (x->fromVertex < y->fromVertex);
+}
+
+/* Returns the distance tree in the labels of 'search', from 'startVertex',
+ * or NULL if memory could not be allocated.
+ */
+static Edge *labelsToTree(SharedSearch *search, int startVertex)
+{
+  int n = search->graph->numVertices;
+  Edge *distanceEdges = malloc(sizeof(Edge) * n);
+  if (distanceEdges == NULL)
+  {
+    return NULL;
+  }
+  distanceEdges[0].fromVertex = startVertex;
+  distanceEdges[0].toVertex = startVertex;
+  distanceEdges[0].weight = 0;
+  int numTreeEdges = 1;
+  for (int v = 0; v < n; v++)
+  {
+    int distance = labelDistance(search->labels[v]);
+    if (v != startVertex && distance < INT_MAX)
+    {
+      distanceEdges[numTreeEdges].fromVertex = v;
+      distanceEdges[numTreeEdges].toVertex =
+          labelPredecessor(search->labels[v]);
+      distanceEdges[numTreeEdges++].weight = distance;
+    }
+  }
+  qsort(distanceEdges + 1, numTreeEdges - 1, sizeof(Edge), compareTreeEdges);
+
+  // Like Dijkstra's algorithm, list unreachable vertices last.
+  for (int v = 0; v < n; v++)
+  {
+    if (labelDistance(search->labels[v]) == INT_MAX)
+    {
+      distanceEdges[numTreeEdges].fromVertex = v;
+      distanceEdges[numTreeEdges].toVertex = NOTHING;
+      distanceEdges[numTreeEdges++].weight = INT_MAX;
+    }
+  }
+  return distanceEdges;
+}
+
+/* Computes the same distances as getDistanceTreeDijkstra on Graph 'graph'
+ * from vertex 'startVertex' with 'numThreads' threads (0 for the default),
+ * and returns its distance tree in the same format. Stores the work done in
+ * 'stats' unless it is NULL.
+ * Returns NULL if 'startVertex' is not valid in 'graph' or if memory could
+ * not be allocated.
+ * Precondition: no edge of 'graph' has a negative weight
+ */
+Edge *getDistanceTreeMultiQueue(Graph *graph, int startVertex, int numThreads,
+                                SearchStats *stats)
+{
+  int n = graph->numVertices;
+  if (startVertex < 0 || startVertex >= n)
+  {
+    return NULL;
+  }
+  if (numThreads < 1)
+  {
+    numThreads = defaultThreadCount();
+  }
+
+  SharedSearch search = {0};
+  search.graph = graph;
+  search.queue = newMultiQueue(numThreads, isStaleNode, &search);
+  search.labels = malloc(sizeof(uint64_t) * n);
+  search.settled = calloc(n, sizeof(bool));
+  Edge *distanceEdges = NULL;
+  unsigned seed = 1;
+  if (search.queue != NULL && search.labels != NULL &&
+      search.settled != NULL)
+  {
+    for (int v = 0; v < n; v++)
+    {
+      search.labels[v] = makeLabel(INT_MAX, NOTHING);
+    }
+    search.labels[startVertex] = makeLabel(0, startVertex);
+    search.pending = 1;
+    if (multiQueueInsert(search.queue, 0, startVertex, &seed))
+    {
+      parallelRun(numThreads, searchPart, &search);
+      if (!search.failed)
+      {
+        distanceEdges = labelsToTree(&search, startVertex);
+      }
+    }
+  }
+  if (stats != NULL)
+  {
+    *stats = search.stats;
+  }
+  deleteMultiQueue(search.queue);
+  free(search.labels);
+  free(search.settled);
+  return distanceEdges;
+}
@@ -0,0 +1,55 @@
+/*
+ * Header file for shortest paths searched by many threads on one shared
+ * frontier.
+ *
+ * getDistanceTreeMultiQueue runs Dijkstra's algorithm with the frontier in
+ * a MultiQueue (see multiqueue.h): every thread takes a vertex with a small
+ * tentative distance, relaxes its edges and puts the vertices it improves
+ * back in. The MultiQueue only hands out one of the smallest distances, not
+ * the smallest, so a vertex can be taken before its distance is final and
+ * then has to be taken, and its edges relaxed, once more when a shorter path
+ * turns up. That is the price of the parallelism, and SearchStats measures
+ * it. Distances are kept with their predecessors in one 64-bit word per
+ * vertex and lowered with compare-and-swap, which also serves as
+ * decrease-key: the vertex goes into the queue again, and the copy with the
+ * old distance is dropped by the queue when it reaches the top of its heap,
+ * or skipped if it was taken before its vertex got closer. The vertices a
+ * thread improves in one relaxation go into the queue together, under one
+ * lock.
+ */
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "graph.h"
+
+#ifndef __Graph_Parallel_header
+#define __Graph_Parallel_header
+
+typedef struct search_stats {
+  long drops;      // stale copies the queue dropped instead of handing out
+  long pops;       // nodes taken from the queue
+  long stalePops;  // of these, copies whose vertex had a shorter distance by
+                   //   then; they are dropped at once
+  long settles;    // the others, each of which relaxed its vertex's edges
+  long resettles;  // of these, vertices that had relaxed their edges before:
+                   //   the work wasted on relaxed order
+} SearchStats;
+
+/* Computes the same distances as getDistanceTreeDijkstra on Graph 'graph'
+ * from vertex 'startVertex' with 'numThreads' threads (0 for the default),
+ * and returns its distance tree in the same format: the start vertex first,
+ * then the vertices it can reach in order of distance and ID, each with a
+ * predecessor on a shortest path, and last the vertices it cannot reach,
+ * with predecessor -1 and distance INT_MAX. Where several predecessors are
+ * equally close, which one a vertex gets may vary between runs. Stores the
+ * work done in 'stats' unless it is NULL.
+ * Returns NULL if 'startVertex' is not valid in 'graph' or if memory could
+ * not be allocated.
+ * Precondition: no edge of 'graph' has a negative weight
+ */
+Edge* getDistanceTreeMultiQueue(Graph* graph, int startVertex, int numThreads,
+                                SearchStats* stats);
+
+#endif
@@ -0,0 +1,511 @@
+/*
+ * Alternative routes: the k shortest loopless paths (Yen's algorithm).
+ */
+
+#include <limits.h>
+#include <string.h>
+
+#include "graph_paths.h"
+#include "graph_symmetric.h"
+#include "minheap.h"
+
+#define NOTHING -1
+
+typedef struct candidate {
+  Route route;
+  int deviation;  // the index on the route of the vertex it deviated at
+} Candidate;
+
+typedef struct yen {
+  Graph *graph;
+  bool symmetric;        // isSymmetricGraph(graph)
+  int target;
+  int *toTarget;         // distance to the target, INT_MAX if none
+  int *next;             // the next vertex on a shortest path to the target
+  int *masked;           // masked[v] == stamp iff v may not be entered
+  int *blocked;          // blocked[v] == stamp iff the spur vertex may not
+                         //   go on to v
+  int stamp;
+  MinHeap *heap;         // frontier of the current search
+  int *fromSpur;         // distance from the spur vertex, INT_MAX if untouched
+  int *predecessor;      // predecessor on the best path from the spur vertex
+  int *touched;          // the IDs whose fromSpur is not INT_MAX
+  int numTouched;
+  int *path;             // scratch for building one path
+  Route *found;          // the paths found so far, in order of distance
+  int *foundDeviation;   // found[i] deviated at foundDeviation[i]
+  int numFound;
+  Candidate *candidates; // by decreasing distance, so the best is last
+  int numCandidates;
+  int capacity;          // the number of candidates that fit
+} Yen;
+
+/* Returns the weight of the lightest edge from 'u' to 'v' in 'graph'. */
+static int edgeWeight(Graph *graph, int u, int v)
+{
+  int res = INT_MAX;
+  for (EdgeList *adjList = graph->vertices[u]->adjList; adjList != NULL;
+       adjList = adjList->next)
+  {
+    if (otherEndpoint(adjList->edge, u) == v && adjList->edge->weight < res)
+    {
+      res = adjList->edge->weight;
+    }
+  }
+  return res;
+}
+
+/* Lowers the distance of 'v' to 'distance' with 'heap' on the frontier of a
+ * search whose distances are 'distance' and whose touched IDs are
+ * 'touched', putting 'priority' on the heap.
+ */
+static void relaxTo(Yen *yen, int *distances, int v, int distance,
+                    int priority)
+{
+  if (distances[v] == INT_MAX)
+  {
+    yen->touched[yen->numTouched++] = v;
+    insert(yen->heap, priority, v);
+  }
+  else
+  {
+    decreasePriority(yen->heap, v, priority);
+  }
+  distances[v] = distance;
+}
+
+/* Runs Dijkstra's algorithm backwards from the target of 'yen', filling
+ * toTarget and next. A symmetric graph is its own reverse; otherwise the
+ * reverse edges are gathered first. Returns false if memory could not be
+ * allocated.
+ */
+static bool searchToTarget(Yen *yen)
+{
+  Graph *graph = yen->graph;
+  int n = graph->numVertices;
+  long *start = NULL;
+  int *from = NULL;
+  int *weight = NULL;
+  if (!yen->symmetric)
+  {
+    start = calloc(n + 2, sizeof(long));
+    if (start == NULL)
+    {
+      return false;
+    }
+    for (int u = 0; u < n; u++)
+    {
+      for (EdgeList *adjList = graph->vertices[u]->adjList; adjList != NULL;
+           adjList = adjList->next)
+      {
+        start[otherEndpoint(adjList->edge, u) + 2]++;
+      }
+    }
+    for (int v = 2; v <= n + 1; v++)
+    {
+      start[v] += start[v - 1];
+    }
+    from = malloc(sizeof(int) * (start[n + 1] + 1));
+    weight = malloc(sizeof(int) * (start[n + 1] + 1));
+    if (from == NULL || weight == NULL)
+    {
+      free(start);
+      free(from);
+      free(weight);
+      return false;
+    }
+    for (int u = 0; u < n; u++)
+    {
+      for (EdgeList *adjList = graph->vertices[u]->adjList; adjList != NULL;
+           adjList = adjList->next)
+      {
+        long slot = start[otherEndpoint(adjList->edge, u) + 1]++;
+        from[slot] = u;
+        weight[slot] = adjList->edge->weight;
+      }
+    }
+  }
+
+  relaxTo(yen, yen->toTarget, yen->target, 0, 0);
+  while (yen->heap->size > 0)
+  {
+    HeapNode minNode = extractMin(yen->heap);
+    int v = minNode.id;
+    int vDistance = minNode.priority;
+    EdgeList *adjList = yen->symmetric ? graph->vertices[v]->adjList : NULL;
+    long first = start != NULL ? start[v] : 0;
+    long last = start != NULL ? start[v + 1] : 0;
+    // Walk either the edge list (symmetric) or the reverse edges.
+    for (long i = first; adjList != NULL || i < last; i++)
+    {
+      int u = adjList != NULL ? otherEndpoint(adjList->edge, v) : from[i];
+      int w = adjList != NULL ? adjList->edge->weight : weight[i];
+      adjList = adjList != NULL ? adjList->next : NULL;
+      if (w <= INT_MAX - vDistance && vDistance + w < yen->toTarget[u])
+      {
+        relaxTo(yen, yen->toTarget, u, vDistance + w, vDistance + w);
+        yen->next[u] = v;
+      }
+    }
+  }
+  yen->numTouched = 0;  // toTarget is kept, not reset
+  free(start);
+  free(from);
+  free(weight);
+  return true;
+}
+
+/* Stores in 'route' a newly allocated copy of the 'numVertices' vertices in
+ * 'vertices', with distance 'distance'. Returns false if memory could not
+ * be allocated.
+ */
+static bool newRoute(Route *route, int *vertices, int numVertices,
+                     long distance)
+{
+  route->vertices = malloc(sizeof(int) * numVertices);
+  if (route->vertices == NULL)
+  {
+    return false;
+  }
+  memcpy(route->vertices, vertices, sizeof(int) * numVertices);
+  route->numVertices = numVertices;
+  route->distance = distance;
+  return true;
+}
+
+/* Returns true iff the routes 'a' and 'b' visit the same vertices. */
+static bool sameRoute(Route *a, Route *b)
+{
+  return a->distance == b->distance && a->numVertices == b->numVertices &&
+         memcmp(a->vertices, b->vertices, sizeof(int) * a->numVertices) == 0;
+}
+
+/* Adds the path of 'numVertices' vertices in yen->path, with distance
+ * 'distance' and deviation index 'deviation', to the candidates of 'yen',
+ * unless it is one already, and then drops the candidates beyond the 'need'
+ * best. Returns false if memory could not be allocated.
+ */
+static bool addCandidate(Yen *yen, int numVertices, long distance,
+                         int deviation, int need)
+{
+  Candidate candidate = {{distance, numVertices, yen->path}, deviation};
+  int position = 0;
+  for (int c = 0; c < yen->numCandidates; c++)
+  {
+    if (sameRoute(&yen->candidates[c].route, &candidate.route))
+    {
+      return true;
+    }
+    if (yen->candidates[c].route.distance > distance)
+    {
+      position = c + 1;  // equal ones stay behind, so the oldest goes first
+    }
+  }
+  if (yen->numCandidates == yen->capacity)
+  {
+    int capacity = yen->capacity > 0 ? 2 * yen->capacity : 16;
+    Candidate *candidates =
+        realloc(yen->candidates, sizeof(Candidate) * capacity);
+    if (candidates == NULL)
+    {
+      return false;
+    }
+    yen->candidates = candidates;
+    yen->capacity = capacity;
+  }
+  if (!newRoute(&candidate.route, yen->path, numVertices, distance))
+  {
+    return false;
+  }
+  memmove(&yen->candidates[position + 1], &yen->candidates[position],
+          sizeof(Candidate) * (yen->numCandidates - position));
+  yen->candidates[position] = candidate;
+  yen->numCandidates++;
+
+  int surplus = yen->numCandidates - need;
+  if (surplus > 0)
+  {
+    for (int c = 0; c < surplus; c++)
+    {
+      free(yen->candidates[c].route.vertices);
+    }
+    memmove(yen->candidates, yen->candidates + surplus,
+            sizeof(Candidate) * need);
+    yen->numCandidates = need;
+  }
+  return true;
+}
+
+/* Searches from 'spur' to the target for the shortest path that enters no
+ * masked vertex and does not go from 'spur' to a blocked one, guided by the
+ * distances to the target (A*). Gives up on paths of length 'bound' or
+ * more. Stores the path in yen->path from index 'offset' on, and returns
+ * its length, or -1 if there is none.
+ */
+static long searchFromSpur(Yen *yen, int spur, long bound, int offset,
+                           int *numVertices)
+{
+  Graph *graph = yen->graph;
+  long res = -1;
+  relaxTo(yen, yen->fromSpur, spur, 0, yen->toTarget[spur]);
+  while (yen->heap->size > 0)
+  {
+    HeapNode minNode = extractMin(yen->heap);
+    int u = minNode.id;
+    if (minNode.priority >= bound)
+    {
+      break;
+    }
+    if (u == yen->target)
+    {
+      res = yen->fromSpur[u];
+      break;
+    }
+    int uDistance = yen->fromSpur[u];
+    for (EdgeList *adjList = graph->vertices[u]->adjList; adjList != NULL;
+         adjList = adjList->next)
+    {
+      int v = otherEndpoint(adjList->edge, u);
+      int w = adjList->edge->weight;
+      if (yen->masked[v] == yen->stamp ||
+          (u == spur && yen->blocked[v] == yen->stamp) ||
+          yen->toTarget[v] == INT_MAX || w > INT_MAX - uDistance)
+      {
+        continue;
+      }
+      long priority = (long)uDistance + w + yen->toTarget[v];
+      if (uDistance + w < yen->fromSpur[v] && priority <= INT_MAX)
+      {
+        relaxTo(yen, yen->fromSpur, v, uDistance + w, priority);
+        yen->predecessor[v] = u;
+      }
+    }
+  }
+
+  if (res >= 0)
+  {
+    int count = 0;
+    for (int v = yen->target; v != spur; v = yen->predecessor[v])
+    {
+      count++;
+    }
+    *numVertices = offset + count + 1;
+    int index = *numVertices - 1;
+    for (int v = yen->target; v != spur; v = yen->predecessor[v])
+    {
+      yen->path[index--] = v;
+    }
+  }
+  while (yen->heap->size > 0)
+  {
+    extractMin(yen->heap);
+  }
+  for (int i = 0; i < yen->numTouched; i++)
+  {
+    yen->fromSpur[yen->touched[i]] = INT_MAX;
+  }
+  yen->numTouched = 0;
+  return res;
+}
+
+/* Finds the best deviation from the path 'prev' at its vertex 'i', whose
+ * distance from the source along 'prev' is 'rootCost', and adds it to the
+ * candidates of 'yen'; 'need' more paths are wanted. Returns false if
+ * memory could not be allocated.
+ */
+static bool deviate(Yen *yen, Route *prev, int i, long rootCost, int need)
+{
+  Graph *graph = yen->graph;
+  int spur = prev->vertices[i];
+  yen->stamp++;
+  for (int j = 0; j <= i; j++)
+  {
+    yen->masked[prev->vertices[j]] = yen->stamp;
+  }
+  // Block the next step of every path found with the same root.
+  for (int f = 0; f < yen->numFound; f++)
+  {
+    Route *route = &yen->found[f];
+    if (route->numVertices > i + 1 &&
+        memcmp(route->vertices, prev->vertices, sizeof(int) * (i + 1)) == 0)
+    {
+      yen->blocked[route->vertices[i + 1]] = yen->stamp;
+    }
+  }
+
+  // No deviation can beat the best unmasked first step plus the rest of
+  // the way in the unmasked graph; skip the spur if that cannot make the
+  // 'need' best.
+  long cutoff = yen->numCandidates >= need
+                    ? yen->candidates[yen->numCandidates - need].route.distance
+                    : LONG_MAX;
+  int best = NOTHING;
+  long bestBound = LONG_MAX;
+  for (EdgeList *adjList = graph->vertices[spur]->adjList; adjList != NULL;
+       adjList = adjList->next)
+  {
+    int v = otherEndpoint(adjList->edge, spur);
+    if (yen->masked[v] != yen->stamp && yen->blocked[v] != yen->stamp &&
+        yen->toTarget[v] != INT_MAX &&
+        (long)adjList->edge->weight + yen->toTarget[v] < bestBound)
+    {
+      best = v;
+      bestBound = (long)adjList->edge->weight + yen->toTarget[v];
+    }
+  }
+  if (best == NOTHING || rootCost + bestBound >= cutoff)
+  {
+    return true;
+  }
+
+  memcpy(yen->path, prev->vertices, sizeof(int) * (i + 1));
+  int numVertices = i + 1;
+  bool treePathClear = true;
+  for (int v = best; treePathClear; v = yen->next[v])
+  {
+    treePathClear = yen->masked[v] != yen->stamp;
+    yen->path[numVertices++] = v;
+    if (v == yen->target)
+    {
+      break;
+    }
+  }
+  long spurCost = bestBound;
+  if (!treePathClear)
+  {
+    spurCost = searchFromSpur(yen, spur,
+                              cutoff == LONG_MAX ? LONG_MAX
+                                                 : cutoff - rootCost,
+                              i, &numVertices);
+    if (spurCost < 0)
+    {
+      return true;
+    }
+  }
+  return addCandidate(yen, numVertices, rootCost + spurCost, i, need);
+}
+
+/* Frees all memory allocated for 'yen' except the found routes. */
+static void freeYen(Yen *yen)
+{
+  free(yen->toTarget);
+  free(yen->next);
+  free(yen->masked);
+  free(yen->blocked);
+  free(yen->fromSpur);
+  free(yen->predecessor);
+  free(yen->touched);
+  free(yen->path);
+  free(yen->foundDeviation);
+  if (yen->heap != NULL)
+  {
+    deleteHeap(yen->heap);
+  }
+  for (int c = 0; c < yen->numCandidates; c++)
+  {
+    free(yen->candidates[c].route.vertices);
+  }
+  free(yen->candidates);
+}
+
+/* Returns a newly allocated array of the (at most) 'k' shortest loopless
+ * paths from 'source' to 'target' in Graph 'graph', in order of distance,
+ * and stores their number in 'numRoutes'.
+ * Returns NULL if a vertex is not valid, k < 1, or memory could not be
+ * allocated.
+ * Precondition: no weight is negative
+ */
+Route *getKShortestPaths(Graph *graph, int source, int target, int k,
+                         int *numRoutes)
+{
+  int n = graph->numVertices;
+  if (source < 0 || source >= n || target < 0 || target >= n || k < 1)
+  {
+    return NULL;
+  }
+  Yen yen = {0};
+  yen.graph = graph;
+  yen.symmetric = isSymmetricGraph(graph);
+  yen.target = target;
+  yen.toTarget = malloc(sizeof(int) * n);
+  yen.next = malloc(sizeof(int) * n);
+  yen.masked = calloc(n, sizeof(int));
+  yen.blocked = calloc(n, sizeof(int));
+  yen.fromSpur = malloc(sizeof(int) * n);
+  yen.predecessor = malloc(sizeof(int) * n);
+  yen.touched = malloc(sizeof(int) * n);
+  yen.path = malloc(sizeof(int) * n);
+  yen.found = calloc(k, sizeof(Route));
+  yen.foundDeviation = malloc(sizeof(int) * k);
+  yen.heap = newHeap(n);
+  bool ok = yen.toTarget && yen.next && yen.masked && yen.blocked &&
+            yen.fromSpur && yen.predecessor && yen.touched && yen.path &&
+            yen.found && yen.foundDeviation && yen.heap;
+  for (int v = 0; ok && v < n; v++)
+  {
+    yen.toTarget[v] = INT_MAX;
+    yen.fromSpur[v] = INT_MAX;
+    yen.next[v] = NOTHING;
+  }
+  ok = ok && searchToTarget(&yen);
+
+  if (ok && yen.toTarget[source] != INT_MAX)
+  {
+    int numVertices = 0;
+    for (int v = source; v != NOTHING; v = yen.next[v])
+    {
+      yen.path[numVertices++] = v;
+    }
+    ok = newRoute(&yen.found[0], yen.path, numVertices,
+                  yen.toTarget[source]);
+    yen.foundDeviation[0] = 0;
+    yen.numFound = ok;
+  }
+  while (ok && yen.numFound > 0 && yen.numFound < k)
+  {
+    // Lawler: deviations before where 'prev' itself deviated were all
+    // tried from the path it deviated from.
+    Route *prev = &yen.found[yen.numFound - 1];
+    long rootCost = 0;
+    for (int i = 0; ok && i + 1 < prev->numVertices; i++)
+    {
+      if (i >= yen.foundDeviation[yen.numFound - 1])
+      {
+        ok = deviate(&yen, prev, i, rootCost, k - yen.numFound);
+      }
+      rootCost += edgeWeight(graph, prev->vertices[i], prev->vertices[i + 1]);
+    }
+    if (!ok || yen.numCandidates == 0)
+    {
+      break;
+    }
+    Candidate *bestCandidate = &yen.candidates[--yen.numCandidates];
+    yen.found[yen.numFound] = bestCandidate->route;
+    yen.foundDeviation[yen.numFound++] = bestCandidate->deviation;
+  }
+
+  Route *res = yen.found;
+  *numRoutes = yen.numFound;
+  freeYen(&yen);
+  if (!ok)
+  {
+    deleteRoutes(res, *numRoutes);
+    *numRoutes = 0;
+    return NULL;
+  }
+  return res;
+}
+
+/* Frees the 'numRoutes' routes in 'routes' and the array itself. */
+void deleteRoutes(Route *routes, int numRoutes)
+{
+  if (routes == NULL)
+  {
+    return;
+  }
+  for (int i = 0; i < numRoutes; i++)
+  {
+    free(routes[i].vertices);
+  }
+  free(routes);
+}
@@ -0,0 +1,51 @@
+/*
+ * Header file for alternative routes: the k shortest loopless paths between
+ * two vertices (Yen's algorithm).
+ *
+ * Yen's algorithm finds each path by deviating from the one before it at
+ * every vertex in turn (the spur vertex), with the edges and vertices that
+ * would repeat an earlier path masked out. Three things keep that cheap:
+ *   - One Dijkstra search towards the target gives every vertex its exact
+ *     distance to the target. That is a lower bound on every deviation
+ *     from it and guides the searches for deviations (A*).
+ *   - If the path along that shortest-path tree from the best unmasked
+ *     neighbour of the spur vertex avoids the masked vertices, it is the
+ *     best deviation and no search is needed.
+ *   - A deviation whose lower bound is no better than enough candidates
+ *     found already is not searched for at all.
+ * Masks are stamps in per-vertex arrays; the graph is never copied.
+ *
+ * Paths are sequences of vertices; between two consecutive vertices a path
+ * takes the lightest edge.
+ */
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "graph.h"
+
+#ifndef __Graph_Paths_header
+#define __Graph_Paths_header
+
+typedef struct route {
+  long distance;    // the total weight of the path
+  int numVertices;  // the number of vertices on the path
+  int* vertices;    // the path: the source ... the target
+} Route;
+
+/* Returns a newly allocated array of the (at most) 'k' shortest loopless
+ * paths from 'source' to 'target' in Graph 'graph', in order of distance,
+ * and stores their number in 'numRoutes'. Fewer than 'k' are returned if
+ * there are no more; none if 'target' cannot be reached.
+ * Returns NULL if a vertex is not valid, k < 1, or memory could not be
+ * allocated.
+ * Precondition: no weight is negative
+ */
+Route* getKShortestPaths(Graph* graph, int source, int target, int k,
+                         int* numRoutes);
+
+/* Frees the 'numRoutes' routes in 'routes' and the array itself. */
+void deleteRoutes(Route* routes, int numRoutes);
+
+#endif
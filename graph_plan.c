@@ -0,0 +1,703 @@
+/*
+ * Graph profiler and algorithm planner, with the bucket and radix heap
+ * engines it can choose besides those of graph_algos.c and graph_bfs.c.
+ */
+
+#include <limits.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "graph_algos.h"
+#include "graph_algos_dense.h"
+#include "graph_bfs.h"
+#include "graph_plan.h"
+#include "graph_symmetric.h"
+#include "parallel.h"
+
+#define NOTHING -1
+#define RADIX_BUCKETS 33  // keys equal to the last minimum, then by top bit
+
+static const char *ssspNames[] = {"auto", "bfs", "heap", "buckets", "radix"};
+static const char *mstNames[] = {"auto", "heap", "dense", "buckets"};
+
+typedef struct bucket_queue
+{
+  int numBuckets;
+  int *heads;  // heads[b]: the first vertex in bucket b, or NOTHING
+  int *next;   // next[v], prev[v]: v's neighbours in its bucket's list
+  int *prev;
+} BucketQueue;
+
+typedef struct radix_entry
+{
+  unsigned int key;
+  int vertex;
+} RadixEntry;
+
+typedef struct radix_heap
+{
+  RadixEntry *buckets[RADIX_BUCKETS];
+  int sizes[RADIX_BUCKETS];
+  int capacities[RADIX_BUCKETS];
+  unsigned int last;  // the last minimum taken out; no key is below it
+} RadixHeap;
+
+/* Returns the default plan: every choice left to planAlgorithms, no log. */
+Plan defaultPlan(void)
+{
+  Plan res;
+  res.sssp = SSSP_AUTO;
+  res.mst = MST_AUTO;
+  res.numThreads = 0;
+  res.log = NULL;
+  return res;
+}
+
+/* Returns a hash of the arc from 'u' to 'v' with weight 'w'. */
+static uint64_t hashArc(int u, int v, int w)
+{
+  uint64_t h = ((uint64_t)(unsigned int)u << 32 | (unsigned int)v) ^
+               (uint64_t)(unsigned int)w * 0xD6E8FEB86659FD93ull;
+  h ^= h >> 32;
+  h *= 0x9E3779B97F4A7C15ull;
+  h ^= h >> 29;
+  return h;
+}
+
+/* Measures Graph 'graph' in one pass over its adjacency lists and stores
+ * the result in 'profile'. An undirected graph has the same arcs as its
+ * reverse, so the sums of the hashes of the arcs and of their reverses
+ * agree.
+ */
+void profileGraph(Graph *graph, GraphProfile *profile)
+{
+  memset(profile, 0, sizeof(GraphProfile));
+  int n = graph->numVertices;
+  profile->numVertices = n;
+  profile->symmetric = isSymmetricGraph(graph);
+  profile->minDegree = n > 0 ? INT_MAX : 0;
+  profile->minWeight = INT_MAX;
+  uint64_t arcSum = 0;
+  uint64_t reverseSum = 0;
+  for (int u = 0; u < n; u++)
+  {
+    int degree = 0;
+    for (EdgeList *adjList = graph->vertices[u]->adjList; adjList != NULL;
+         adjList = adjList->next)
+    {
+      int v = otherEndpoint(adjList->edge, u);
+      int w = adjList->edge->weight;
+      arcSum += hashArc(u, v, w);
+      reverseSum += hashArc(v, u, w);
+      profile->minWeight = w < profile->minWeight ? w : profile->minWeight;
+      profile->maxWeight = w > profile->maxWeight ? w : profile->maxWeight;
+      degree++;
+    }
+    profile->numArcs += degree;
+    profile->minDegree = degree < profile->minDegree ? degree
+                                                     : profile->minDegree;
+    profile->maxDegree = degree > profile->maxDegree ? degree
+                                                     : profile->maxDegree;
+    int degreeClass = degree == 0 ? 0 : 32 - __builtin_clz(degree);
+    profile->degreeClasses[degreeClass]++;
+  }
+  if (profile->numArcs == 0)
+  {
+    profile->minWeight = 0;
+  }
+  profile->undirected = arcSum == reverseSum;
+  profile->uniformWeights = profile->minWeight == profile->maxWeight;
+  profile->averageDegree = n > 0 ? (double)profile->numArcs / n : 0;
+  profile->density =
+      n > 1 ? profile->numArcs / ((double)n * (n - 1)) : 0;
+}
+
+/* Returns true iff the bucket engines fit a graph with profile 'profile':
+ * its weights are in [0, BUCKET_MAX_WEIGHT).
+ */
+static bool bucketsFit(GraphProfile *profile)
+{
+  return profile->minWeight >= 0 && profile->maxWeight < BUCKET_MAX_WEIGHT;
+}
+
+/* Returns 'plan' with every choice it leaves open made for a graph with
+ * profile 'profile', and logs the choice to plan.log if it is not NULL.
+ * The rules follow "bench plan": BFS wherever it applies; buckets while
+ * weights are small, since every operation is then O(1) and touches one
+ * list head; otherwise the radix heap, which beat the binary heap at every
+ * size measured, from 5000 vertices up; the key array for Prim on dense
+ * graphs (getMSTprimDense). The binary heap is left for negative weights.
+ */
+Plan planAlgorithms(GraphProfile *profile, Plan plan)
+{
+  long size = profile->numVertices + profile->numArcs;
+  bool smallWeights = bucketsFit(profile);
+  if (plan.sssp == SSSP_AUTO)
+  {
+    plan.sssp = profile->uniformWeights  ? SSSP_BFS
+                : smallWeights           ? SSSP_BUCKETS
+                : profile->minWeight < 0 ? SSSP_BINARY_HEAP
+                                         : SSSP_RADIX_HEAP;
+  }
+  if (plan.mst == MST_AUTO)
+  {
+    bool dense = profile->numVertices >= DENSE_PRIM_MIN_VERTICES &&
+                 profile->density >= DENSE_PRIM_MIN_DENSITY;
+    plan.mst = dense          ? MST_PRIM_DENSE
+               : smallWeights ? MST_PRIM_BUCKETS
+                              : MST_PRIM_HEAP;
+  }
+  if (plan.numThreads <= 0)
+  {
+    plan.numThreads = size < PLAN_MIN_PARALLEL ? 1 : defaultThreadCount();
+  }
+  if (plan.log != NULL)
+  {
+    fprintf(plan.log,
+            "plan: sssp=%s mst=%s threads=%d for %d vertices, %ld arcs, "
+            "density %.3g, degrees %d..%d, weights %d..%d%s%s\n",
+            ssspNames[plan.sssp], mstNames[plan.mst], plan.numThreads,
+            profile->numVertices, profile->numArcs, profile->density,
+            profile->minDegree, profile->maxDegree, profile->minWeight,
+            profile->maxWeight, profile->uniformWeights ? ", uniform" : "",
+            profile->undirected ? ", undirected" : "");
+  }
+  return plan;
+}
+
+/* Returns the index of 'name' among the 'count' names in 'names', or -1. */
+static int findName(const char *name, int length, const char **names,
+                    int count)
+{
+  for (int i = 0; i < count; i++)
+  {
+    if ((int)strlen(names[i]) == length &&
+        strncmp(name, names[i], length) == 0)
+    {
+      return i;
+    }
+  }
+  return -1;
+}
+
+/* Reads the choices in 'text' into 'plan'. Returns false if 'text' is not a
+ * comma-separated list of choices.
+ */
+bool parsePlan(const char *text, Plan *plan)
+{
+  while (*text != '\0')
+  {
+    const char *end = strchr(text, ',');
+    if (end == NULL)
+    {
+      end = text + strlen(text);
+    }
+    const char *value = memchr(text, '=', end - text);
+    if (value == NULL)
+    {
+      return false;
+    }
+    int keyLength = value - text;
+    value++;
+    int valueLength = end - value;
+    if (keyLength == 4 && strncmp(text, "sssp", 4) == 0)
+    {
+      int engine = findName(value, valueLength, ssspNames, 5);
+      if (engine < 0)
+      {
+        return false;
+      }
+      plan->sssp = engine;
+    }
+    else if (keyLength == 3 && strncmp(text, "mst", 3) == 0)
+    {
+      int engine = findName(value, valueLength, mstNames, 4);
+      if (engine < 0)
+      {
+        return false;
+      }
+      plan->mst = engine;
+    }
+    else if (keyLength == 7 && strncmp(text, "threads", 7) == 0)
+    {
+      char *numberEnd;
+      long threads = strtol(value, &numberEnd, 10);
+      bool isAuto = valueLength == 4 && strncmp(value, "auto", 4) == 0;
+      if (!isAuto && (numberEnd != end || threads < 0 || threads > INT_MAX))
+      {
+        return false;
+      }
+      plan->numThreads = isAuto ? 0 : (int)threads;
+    }
+    else
+    {
+      return false;
+    }
+    text = *end == ',' ? end + 1 : end;
+  }
+  return true;
+}
+
+/***** bucket queue ********************************************************/
+
+/* Sets up 'queue' with 'numBuckets' empty buckets for 'numVertices'
+ * vertices. Returns false if memory could not be allocated.
+ */
+static bool initBuckets(BucketQueue *queue, int numBuckets, int numVertices)
+{
+  queue->numBuckets = numBuckets;
+  queue->heads = malloc(sizeof(int) * numBuckets);
+  queue->next = malloc(sizeof(int) * (numVertices + 1));
+  queue->prev = malloc(sizeof(int) * (numVertices + 1));
+  if (queue->heads == NULL || queue->next == NULL || queue->prev == NULL)
+  {
+    return false;
+  }
+  for (int b = 0; b < numBuckets; b++)
+  {
+    queue->heads[b] = NOTHING;
+  }
+  return true;
+}
+
+/* Frees the memory of 'queue'. */
+static void freeBuckets(BucketQueue *queue)
+{
+  free(queue->heads);
+  free(queue->next);
+  free(queue->prev);
+}
+
+/* Puts 'vertex' at the front of bucket 'bucket' of 'queue'. */
+static void linkVertex(BucketQueue *queue, int vertex, int bucket)
+{
+  int head = queue->heads[bucket];
+  queue->next[vertex] = head;
+  queue->prev[vertex] = NOTHING;
+  if (head != NOTHING)
+  {
+    queue->prev[head] = vertex;
+  }
+  queue->heads[bucket] = vertex;
+}
+
+/* Takes 'vertex' out of bucket 'bucket' of 'queue', which holds it. */
+static void unlinkVertex(BucketQueue *queue, int vertex, int bucket)
+{
+  int next = queue->next[vertex];
+  int prev = queue->prev[vertex];
+  if (prev == NOTHING)
+  {
+    queue->heads[bucket] = next;
+  }
+  else
+  {
+    queue->next[prev] = next;
+  }
+  if (next != NOTHING)
+  {
+    queue->prev[next] = prev;
+  }
+}
+
+/***** radix heap **********************************************************/
+
+/* Returns the bucket of 'key' in a radix heap whose last minimum is
+ * 'last': 0 if they are equal, otherwise one more than the index of the
+ * highest bit in which they differ.
+ */
+static int radixBucket(unsigned int key, unsigned int last)
+{
+  return key == last ? 0 : 32 - __builtin_clz(key ^ last);
+}
+
+/* Adds 'vertex' with key 'key', at least heap->last, to 'heap'. Returns
+ * false if memory could not be allocated.
+ */
+static bool radixPush(RadixHeap *heap, unsigned int key, int vertex)
+{
+  int b = radixBucket(key, heap->last);
+  if (heap->sizes[b] == heap->capacities[b])
+  {
+    int capacity = heap->capacities[b] > 0 ? 2 * heap->capacities[b] : 64;
+    RadixEntry *grown =
+        realloc(heap->buckets[b], sizeof(RadixEntry) * capacity);
+    if (grown == NULL)
+    {
+      return false;
+    }
+    heap->buckets[b] = grown;
+    heap->capacities[b] = capacity;
+  }
+  heap->buckets[b][heap->sizes[b]++] = (RadixEntry){key, vertex};
+  return true;
+}
+
+/* Removes an entry with the smallest key from 'heap', which is not empty,
+ * and returns it. If bucket 0 is empty, the first non-empty bucket is
+ * emptied into lower ones around its minimum, the new last minimum.
+ * Returns an entry with vertex NOTHING if memory ran out.
+ */
+static RadixEntry radixPop(RadixHeap *heap)
+{
+  if (heap->sizes[0] == 0)
+  {
+    int b = 1;
+    while (heap->sizes[b] == 0)
+    {
+      b++;
+    }
+    RadixEntry *bucket = heap->buckets[b];
+    int size = heap->sizes[b];
+    unsigned int last = bucket[0].key;
+    for (int i = 1; i < size; i++)
+    {
+      last = bucket[i].key < last ? bucket[i].key : last;
+    }
+    heap->last = last;
+    heap->sizes[b] = 0;
+    for (int i = 0; i < size; i++)
+    {
+      if (!radixPush(heap, bucket[i].key, bucket[i].vertex))
+      {
+        return (RadixEntry){0, NOTHING};
+      }
+    }
+  }
+  return heap->buckets[0][--heap->sizes[0]];
+}
+
+/***** engines *************************************************************/
+
+/* Stores in 'tree[index]' the tree edge to 'vertex' from 'predecessor' with
+ * weight 'weight', oriented as getDistanceTreeDijkstra and getMSTprim
+ * orient theirs.
+ */
+static void setTreeEdge(Edge *tree, int index, int vertex, int predecessor,
+                        int weight)
+{
+  tree[index].fromVertex = vertex;
+  tree[index].toVertex = predecessor;
+  tree[index].weight = weight;
+}
+
+/* Appends the vertices not marked in 'reached' to 'tree' from index
+ * 'count', as the heap-based algorithms list vertices they cannot reach.
+ */
+static void addUnreached(Edge *tree, int count, bool *reached, int n)
+{
+  for (int v = 0; v < n; v++)
+  {
+    if (!reached[v])
+    {
+      setTreeEdge(tree, count++, v, NOTHING, INT_MAX);
+    }
+  }
+}
+
+/* Dijkstra's algorithm with a circular array of maxWeight + 1 buckets
+ * (Dial). All queued distances lie in [d, d + maxWeight] for the current
+ * distance d, so they fall in different buckets, and d only moves forward.
+ * Returns NULL if memory could not be allocated.
+ */
+static Edge *bucketDistanceTree(Graph *graph, int startVertex, int maxWeight)
+{
+  int n = graph->numVertices;
+  BucketQueue queue;
+  bool ok = initBuckets(&queue, maxWeight + 1, n);
+  Edge *tree = malloc(sizeof(Edge) * n);
+  int *distance = malloc(sizeof(int) * n);
+  int *predecessor = malloc(sizeof(int) * n);
+  bool *settled = calloc(n, sizeof(bool));
+  if (!ok || tree == NULL || distance == NULL || predecessor == NULL ||
+      settled == NULL)
+  {
+    free(tree);
+    tree = NULL;
+  }
+  for (int v = 0; tree != NULL && v < n; v++)
+  {
+    distance[v] = INT_MAX;
+  }
+
+  long numQueued = 0;
+  int count = 0;
+  int bucket = 0;  // the bucket of the current distance
+  if (tree != NULL)
+  {
+    distance[startVertex] = 0;
+    predecessor[startVertex] = startVertex;
+    linkVertex(&queue, startVertex, 0);
+    numQueued = 1;
+  }
+  while (numQueued > 0)
+  {
+    while (queue.heads[bucket] == NOTHING)
+    {
+      bucket = bucket + 1 == queue.numBuckets ? 0 : bucket + 1;
+    }
+    int u = queue.heads[bucket];
+    unlinkVertex(&queue, u, bucket);
+    numQueued--;
+    settled[u] = true;
+    int uDistance = distance[u];
+    setTreeEdge(tree, count++, u, predecessor[u], uDistance);
+    for (EdgeList *adjList = graph->vertices[u]->adjList; adjList != NULL;
+         adjList = adjList->next)
+    {
+      int v = otherEndpoint(adjList->edge, u);
+      int w = adjList->edge->weight;
+      if (settled[v] || w > INT_MAX - uDistance ||
+          uDistance + w >= distance[v])
+      {
+        continue;
+      }
+      if (distance[v] == INT_MAX)
+      {
+        numQueued++;
+      }
+      else
+      {
+        unlinkVertex(&queue, v, distance[v] % queue.numBuckets);
+      }
+      distance[v] = uDistance + w;
+      predecessor[v] = u;
+      linkVertex(&queue, v, distance[v] % queue.numBuckets);
+    }
+  }
+  if (tree != NULL)
+  {
+    addUnreached(tree, count, settled, n);
+  }
+
+  freeBuckets(&queue);
+  free(distance);
+  free(predecessor);
+  free(settled);
+  return tree;
+}
+
+/* Dijkstra's algorithm with a radix heap. Distances only grow, as a radix
+ * heap requires; improved vertices are pushed again and their stale entries
+ * skipped. Returns NULL if memory could not be allocated.
+ */
+static Edge *radixDistanceTree(Graph *graph, int startVertex)
+{
+  int n = graph->numVertices;
+  RadixHeap heap;
+  memset(&heap, 0, sizeof(RadixHeap));
+  Edge *tree = malloc(sizeof(Edge) * n);
+  int *distance = malloc(sizeof(int) * n);
+  int *predecessor = malloc(sizeof(int) * n);
+  bool *settled = calloc(n, sizeof(bool));
+  bool ok = tree != NULL && distance != NULL && predecessor != NULL &&
+            settled != NULL;
+  for (int v = 0; ok && v < n; v++)
+  {
+    distance[v] = INT_MAX;
+  }
+
+  long numEntries = 0;
+  int count = 0;
+  if (ok)
+  {
+    distance[startVertex] = 0;
+    predecessor[startVertex] = startVertex;
+    ok = radixPush(&heap, 0, startVertex);
+    numEntries = 1;
+  }
+  while (ok && numEntries > 0)
+  {
+    RadixEntry entry = radixPop(&heap);
+    numEntries--;
+    int u = entry.vertex;
+    if (u == NOTHING)
+    {
+      ok = false;
+      break;
+    }
+    if (settled[u] || entry.key != (unsigned int)distance[u])
+    {
+      continue;  // stale
+    }
+    settled[u] = true;
+    int uDistance = distance[u];
+    setTreeEdge(tree, count++, u, predecessor[u], uDistance);
+    for (EdgeList *adjList = graph->vertices[u]->adjList; adjList != NULL;
+         adjList = adjList->next)
+    {
+      int v = otherEndpoint(adjList->edge, u);
+      int w = adjList->edge->weight;
+      if (!settled[v] && w <= INT_MAX - uDistance &&
+          uDistance + w < distance[v])
+      {
+        distance[v] = uDistance + w;
+        predecessor[v] = u;
+        ok = ok && radixPush(&heap, distance[v], v);
+        numEntries++;
+      }
+    }
+  }
+  if (ok)
+  {
+    addUnreached(tree, count, settled, n);
+  }
+  else
+  {
+    free(tree);
+    tree = NULL;
+  }
+
+  for (int b = 0; b < RADIX_BUCKETS; b++)
+  {
+    free(heap.buckets[b]);
+  }
+  free(distance);
+  free(predecessor);
+  free(settled);
+  return tree;
+}
+
+/* Prim's algorithm with one bucket per key value 0 .. maxWeight. Keys only
+ * come from single edges, so they stay in that range, and the smallest
+ * non-empty bucket is found by scanning up from the lowest key queued since
+ * the last scan. Returns NULL if memory could not be allocated.
+ */
+static Edge *bucketMST(Graph *graph, int startVertex, int maxWeight)
+{
+  int n = graph->numVertices;
+  BucketQueue queue;
+  bool ok = initBuckets(&queue, maxWeight + 1, n);
+  Edge *tree = malloc(sizeof(Edge) * n);
+  int *key = malloc(sizeof(int) * n);
+  int *predecessor = malloc(sizeof(int) * n);
+  bool *inTree = calloc(n, sizeof(bool));
+  if (!ok || tree == NULL || key == NULL || predecessor == NULL ||
+      inTree == NULL)
+  {
+    free(tree);
+    tree = NULL;
+  }
+  for (int v = 0; tree != NULL && v < n; v++)
+  {
+    key[v] = INT_MAX;
+  }
+
+  long numQueued = 0;
+  int count = 0;
+  int lowest = 0;
+  if (tree != NULL)
+  {
+    key[startVertex] = 0;
+    linkVertex(&queue, startVertex, 0);
+    numQueued = 1;
+  }
+  while (numQueued > 0)
+  {
+    while (queue.heads[lowest] == NOTHING)
+    {
+      lowest++;
+    }
+    int u = queue.heads[lowest];
+    unlinkVertex(&queue, u, lowest);
+    numQueued--;
+    inTree[u] = true;
+    if (u != startVertex)
+    {
+      setTreeEdge(tree, count++, u, predecessor[u], key[u]);
+    }
+    for (EdgeList *adjList = graph->vertices[u]->adjList; adjList != NULL;
+         adjList = adjList->next)
+    {
+      int v = otherEndpoint(adjList->edge, u);
+      int w = adjList->edge->weight;
+      if (inTree[v] || w >= key[v])
+      {
+        continue;
+      }
+      if (key[v] == INT_MAX)
+      {
+        numQueued++;
+      }
+      else
+      {
+        unlinkVertex(&queue, v, key[v]);
+      }
+      key[v] = w;
+      predecessor[v] = u;
+      linkVertex(&queue, v, w);
+      lowest = w < lowest ? w : lowest;
+    }
+  }
+  if (tree != NULL)
+  {
+    inTree[startVertex] = true;
+    addUnreached(tree, count, inTree, n);
+  }
+
+  freeBuckets(&queue);
+  free(key);
+  free(predecessor);
+  free(inTree);
+  return tree;
+}
+
+/* Computes the distance tree of getDistanceTreeDijkstra for Graph 'graph'
+ * from vertex 'startVertex' with the engine 'plan' names, checking with
+ * 'profile', the profile of 'graph', that it fits.
+ * Returns NULL if 'startVertex' is not valid in 'graph', or if the engine
+ * does not fit the graph.
+ * Precondition: 'graph' is connected.
+ */
+Edge *getDistanceTreePlanned(Graph *graph, int startVertex,
+                             GraphProfile *profile, Plan *plan)
+{
+  if (startVertex < 0 || startVertex >= graph->numVertices)
+  {
+    return NULL;
+  }
+  switch (plan->sssp)
+  {
+  case SSSP_BFS:
+    return profile->uniformWeights
+               ? getDistanceTreeBFS(graph, startVertex, profile->maxWeight,
+                                    plan->numThreads)
+               : NULL;
+  case SSSP_BUCKETS:
+    return bucketsFit(profile)
+               ? bucketDistanceTree(graph, startVertex, profile->maxWeight)
+               : NULL;
+  case SSSP_RADIX_HEAP:
+    return profile->minWeight >= 0 ? radixDistanceTree(graph, startVertex)
+                                   : NULL;
+  default:
+    return getDistanceTreeDijkstra(graph, startVertex);
+  }
+}
+
+/* Computes a minimum spanning tree as getMSTprim does for Graph 'graph'
+ * from vertex 'startVertex' with the engine 'plan' names, checking with
+ * 'profile', the profile of 'graph', that it fits.
+ * Returns NULL if 'startVertex' is not valid in 'graph', or if the engine
+ * does not fit the graph.
+ * Precondition: 'graph' is connected.
+ */
+Edge *getMSTplanned(Graph *graph, int startVertex, GraphProfile *profile,
+                    Plan *plan)
+{
+  if (startVertex < 0 || startVertex >= graph->numVertices)
+  {
+    return NULL;
+  }
+  switch (plan->mst)
+  {
+  case MST_PRIM_DENSE:
+    return getMSTprimDense(graph, startVertex);
+  case MST_PRIM_BUCKETS:
+    return bucketsFit(profile)
+               ? bucketMST(graph, startVertex, profile->maxWeight)
+               : NULL;
+  default:
+    return getMSTprim(graph, startVertex);
+  }
+}
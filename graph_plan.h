@@ -0,0 +1,132 @@
+/*
+ * Header file for the graph profiler and the algorithm planner.
+ *
+ * profileGraph measures a graph in one pass over its adjacency lists: size,
+ * density, degree distribution, weight range, and whether it is undirected.
+ * planAlgorithms turns a profile into a Plan: which engine computes
+ * shortest-path trees, which computes minimum spanning trees, and with how
+ * many threads. getDistanceTreePlanned and getMSTplanned run a Plan. A graph
+ * is profiled and planned for once, by the caller, and the profile and Plan
+ * are then passed to every run on it.
+ *
+ * Shortest-path engines:
+ *   SSSP_BFS          breadth-first search (graph_bfs.h); uniform weights
+ *   SSSP_BINARY_HEAP  Dijkstra with the binary MinHeap
+ *   SSSP_BUCKETS      Dijkstra with a circular array of maxWeight + 1
+ *                     buckets (Dial): O(1) per operation for small weights
+ *   SSSP_RADIX_HEAP   Dijkstra with a radix heap: 33 buckets by the highest
+ *                     bit in which a key differs from the last minimum;
+ *                     each entry moves at most 32 times
+ * Spanning-tree engines:
+ *   MST_PRIM_HEAP     Prim with the binary MinHeap
+ *   MST_PRIM_DENSE    Prim with a scanned key array (getMSTprimDense)
+ *   MST_PRIM_BUCKETS  Prim with one bucket per key value; small weights
+ *
+ * All engines return trees in the formats of getDistanceTreeDijkstra and
+ * getMSTprim, with the same distances and total weight. Where paths tie,
+ * different engines may pick different predecessors.
+ */
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "graph.h"
+
+#ifndef __Graph_Plan_header
+#define __Graph_Plan_header
+
+#define PROFILE_DEGREE_CLASSES 33  // degree 0, then [2^(i-1), 2^i)
+#define BUCKET_MAX_WEIGHT 4096     // bucket engines only below this weight
+#define PLAN_MIN_PARALLEL 65536    // fewer vertices + arcs: one thread
+
+typedef enum sssp_engine {
+  SSSP_AUTO,  // let planAlgorithms choose
+  SSSP_BFS,
+  SSSP_BINARY_HEAP,
+  SSSP_BUCKETS,
+  SSSP_RADIX_HEAP
+} SsspEngine;
+
+typedef enum mst_engine {
+  MST_AUTO,  // let planAlgorithms choose
+  MST_PRIM_HEAP,
+  MST_PRIM_DENSE,
+  MST_PRIM_BUCKETS
+} MstEngine;
+
+typedef struct graph_profile {
+  int numVertices;      // vertex IDs are 0, 1, ..., numVertices-1
+  long numArcs;         // adjacency list entries; an edge of a symmetric
+                        //   graph counts in both of its endpoints' lists
+  bool symmetric;       // isSymmetricGraph(graph)
+  bool undirected;      // every arc has a reverse of the same weight;
+                        //   found by comparing order-independent hashes of
+                        //   the arcs and their reverses, so with negligible
+                        //   probability it is wrongly true
+  double density;       // numArcs / (numVertices * (numVertices - 1))
+  int minDegree;        // out-degrees (0 if there are no vertices)
+  int maxDegree;
+  double averageDegree;
+  long degreeClasses[PROFILE_DEGREE_CLASSES];  // [0]: vertices of degree 0;
+                                               //   [i]: degree in
+                                               //   [2^(i-1), 2^i)
+  int minWeight;        // weight range (0 and 0 if there are no edges)
+  int maxWeight;
+  bool uniformWeights;  // all edges have the same weight
+} GraphProfile;
+
+typedef struct plan {
+  SsspEngine sssp;  // engine for distance trees
+  MstEngine mst;    // engine for spanning trees
+  int numThreads;   // threads for engines that use them; 0 to choose
+  FILE* log;        // if not NULL, planAlgorithms writes its choice here
+} Plan;
+
+/* Returns the default plan: every choice left to planAlgorithms, no log. */
+Plan defaultPlan(void);
+
+/* Measures Graph 'graph' in one pass over its adjacency lists and stores
+ * the result in 'profile'.
+ */
+void profileGraph(Graph* graph, GraphProfile* profile);
+
+/* Returns 'plan' with every choice it leaves open (SSSP_AUTO, MST_AUTO,
+ * numThreads 0) made for a graph with profile 'profile', and writes one
+ * line about the choice to plan.log if it is not NULL.
+ */
+Plan planAlgorithms(GraphProfile* profile, Plan plan);
+
+/* Reads the choices in 'text', a comma-separated list of "sssp=bfs|heap|
+ * buckets|radix", "mst=heap|dense|buckets" and "threads=N" (or "auto"),
+ * into 'plan'. Returns false if 'text' is not such a list.
+ */
+bool parsePlan(const char* text, Plan* plan);
+
+/* Computes the distance tree of getDistanceTreeDijkstra for Graph 'graph'
+ * from vertex 'startVertex' with the engine 'plan' names (the binary heap if
+ * it leaves the choice open). 'profile' is the profile of 'graph', used to
+ * check that the engine fits; nothing here passes over the graph for it.
+ * Returns NULL if 'startVertex' is not valid in 'graph', or if the engine
+ * does not fit the graph: SSSP_BFS needs uniform weights, SSSP_BUCKETS
+ * weights in [0, BUCKET_MAX_WEIGHT), and SSSP_RADIX_HEAP weights of 0 or
+ * more.
+ * Precondition: 'graph' is connected; profileGraph(graph, profile) was run
+ * and 'graph' has not changed since
+ */
+Edge* getDistanceTreePlanned(Graph* graph, int startVertex,
+                             GraphProfile* profile, Plan* plan);
+
+/* Computes a minimum spanning tree as getMSTprim does for Graph 'graph'
+ * from vertex 'startVertex' with the engine 'plan' names (the binary heap if
+ * it leaves the choice open), checking with 'profile' as
+ * getDistanceTreePlanned does.
+ * Returns NULL if 'startVertex' is not valid in 'graph', or if the engine
+ * does not fit the graph: MST_PRIM_BUCKETS needs weights in
+ * [0, BUCKET_MAX_WEIGHT).
+ * Precondition: as for getDistanceTreePlanned
+ */
+Edge* getMSTplanned(Graph* graph, int startVertex, GraphProfile* profile,
+                    Plan* plan);
+
+#endif
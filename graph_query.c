@@ -0,0 +1,493 @@
+/*
+ * Local shortest-path queries.
+ */
+
+#include <limits.h>
+
+#include "graph_query.h"
+#include "graph_symmetric.h"
+#include "parallel.h"
+
+#define NOTHING -1
+#define TABLE_HEAP_NONE UINT32_MAX  // HEAP_NONE of the table_Heap
+
+// Distance tables sum distances in 64 bits, past what a MinHeap can hold.
+#define HEAP_PREFIX table
+#define HEAP_KEY int64_t
+#define HEAP_KEY_MAX INT64_MAX
+#define HEAP_ID uint32_t
+#define HEAP_ARITY 4
+#include "heap_template.h"
+
+typedef struct distance_table {
+  Graph *graph;
+  int *sources;
+  int numSources;
+  int *targets;
+  int numTargets;
+  int64_t *table;       // the matrix being filled, one row per source
+  int *bucketStart;     // the targets at vertex v are the columns
+  int *bucketColumns;   //   bucketColumns[bucketStart[v] .. bucketStart[v+1]-1]
+  int numTargetVertices;  // number of distinct valid target vertices
+  long nextSource;      // next row to hand out; claimed atomically
+} DistanceTable;
+
+typedef struct table_search {
+  int64_t *distance;  // distance[id]: tentative distance, TABLE_UNREACHABLE
+                      //   if untouched
+  bool *settled;      // settled[id] is true iff id's distance is final
+  int *touched;       // the IDs whose entries above are not in their
+                      //   initial state; only these are reset between rows
+  int numTouched;     // number of IDs in 'touched'
+  table_Heap heap;    // frontier of the current search
+} TableSearch;
+
+/* Returns a newly created workspace for queries on graphs with
+ * 'numVertices' vertices.
+ * Precondition: numVertices >= 0
+ */
+QueryWorkspace *newQueryWorkspace(int numVertices)
+{
+  QueryWorkspace *res = malloc(sizeof(QueryWorkspace));
+  if (res == NULL)
+  {
+    return NULL;
+  }
+  res->numVertices = numVertices;
+  res->heap = newHeap(numVertices);
+  res->distance = malloc(sizeof(int) * (numVertices + 1));
+  res->predecessor = malloc(sizeof(int) * (numVertices + 1));
+  res->settled = malloc(sizeof(bool) * (numVertices + 1));
+  res->touched = malloc(sizeof(int) * (numVertices + 1));
+  res->reached = malloc(sizeof(Reached) * (numVertices + 1));
+  if (res->heap == NULL || res->distance == NULL ||
+      res->predecessor == NULL || res->settled == NULL ||
+      res->touched == NULL || res->reached == NULL)
+  {
+    deleteQueryWorkspace(res);
+    return NULL;
+  }
+  for (int i = 0; i < numVertices; i++)
+  {
+    res->distance[i] = INT_MAX;
+    res->predecessor[i] = NOTHING;
+    res->settled[i] = false;
+  }
+  res->numTouched = 0;
+  res->numReached = 0;
+  return res;
+}
+
+/* Frees all memory allocated for 'workspace'. */
+void deleteQueryWorkspace(QueryWorkspace *workspace)
+{
+  if (workspace == NULL)
+  {
+    return;
+  }
+  if (workspace->heap != NULL)
+  {
+    deleteHeap(workspace->heap);
+  }
+  free(workspace->distance);
+  free(workspace->predecessor);
+  free(workspace->settled);
+  free(workspace->touched);
+  free(workspace->reached);
+  free(workspace);
+}
+
+/* Puts back into their initial state only the entries of 'workspace' that
+ * the previous query touched, and empties its heap.
+ */
+static void resetWorkspace(QueryWorkspace *workspace)
+{
+  for (int i = 0; i < workspace->numTouched; i++)
+  {
+    int id = workspace->touched[i];
+    workspace->distance[id] = INT_MAX;
+    workspace->predecessor[id] = NOTHING;
+    workspace->settled[id] = false;
+    workspace->heap->indexMap[id] = NOTHING;
+  }
+  workspace->heap->size = 0;
+  workspace->numTouched = 0;
+  workspace->numReached = 0;
+}
+
+/* Lowers the tentative distance of vertex 'v' to 'distance' via vertex
+ * 'predecessor' if that is an improvement, adding 'v' to the frontier the
+ * first time it is reached.
+ */
+static void relax(QueryWorkspace *workspace, int v, int distance,
+                  int predecessor)
+{
+  if (distance >= workspace->distance[v])
+  {
+    return;
+  }
+  if (workspace->distance[v] == INT_MAX)
+  {
+    workspace->touched[workspace->numTouched++] = v;
+    insert(workspace->heap, distance, v);
+  }
+  else
+  {
+    decreasePriority(workspace->heap, v, distance);
+  }
+  workspace->distance[v] = distance;
+  workspace->predecessor[v] = predecessor;
+}
+
+/* Settles vertices of Graph 'graph' in order of distance from the start
+ * vertex already on the frontier of 'workspace', stopping once the next one
+ * is beyond 'radius', 'k' have been settled, or 'target' has been settled.
+ */
+static void settle(Graph *graph, int radius, int k, int target,
+                   QueryWorkspace *workspace)
+{
+  while (workspace->heap->size > 0 && workspace->numReached < k)
+  {
+    HeapNode minNode = extractMin(workspace->heap);
+    int u = minNode.id;
+    int uDistance = minNode.priority;
+    if (uDistance > radius)
+    {
+      break;
+    }
+    workspace->settled[u] = true;
+    Reached *res = &workspace->reached[workspace->numReached++];
+    res->vertex = u;
+    res->distance = uDistance;
+    res->predecessor = workspace->predecessor[u];
+    if (u == target)
+    {
+      break;
+    }
+
+    for (EdgeList *adjList = graph->vertices[u]->adjList; adjList != NULL;
+         adjList = adjList->next)
+    {
+      int v = otherEndpoint(adjList->edge, u);
+      int weight = adjList->edge->weight;
+      // Vertices beyond the radius are never settled, so never queue them.
+      if (!workspace->settled[v] && weight <= radius - uDistance)
+      {
+        relax(workspace, v, uDistance + weight, u);
+      }
+    }
+  }
+}
+
+/* Runs Dijkstra's algorithm on Graph 'graph' from vertex 'startVertex',
+ * settling only vertices at distance at most 'radius', and at most 'k' of
+ * them. The settled vertices are left in workspace->reached in order of
+ * distance, and their number is returned.
+ * Returns -1 if 'startVertex' is not valid in 'graph'.
+ * Precondition: 'workspace' was created for >= graph->numVertices vertices
+ */
+int getNearestDijkstra(Graph *graph, int startVertex, int radius, int k,
+                       QueryWorkspace *workspace)
+{
+  if (startVertex < 0 || startVertex >= graph->numVertices)
+  {
+    return -1;
+  }
+  resetWorkspace(workspace);
+  if (radius < 0 || k <= 0)
+  {
+    return 0;
+  }
+
+  relax(workspace, startVertex, 0, NOTHING);
+  settle(graph, radius, k, NOTHING, workspace);
+  return workspace->numReached;
+}
+
+/* Runs Dijkstra's algorithm on Graph 'graph' from vertex 'startVertex' until
+ * vertex 'targetVertex' is settled, and returns its distance from
+ * 'startVertex'. The path is left in workspace->predecessor.
+ * Returns -1 if either vertex is not valid in 'graph', and INT_MAX if
+ * 'targetVertex' cannot be reached.
+ * Precondition: 'workspace' was created for >= graph->numVertices vertices
+ */
+int getDistanceToDijkstra(Graph *graph, int startVertex, int targetVertex,
+                          QueryWorkspace *workspace)
+{
+  if (startVertex < 0 || startVertex >= graph->numVertices ||
+      targetVertex < 0 || targetVertex >= graph->numVertices)
+  {
+    return -1;
+  }
+  resetWorkspace(workspace);
+  relax(workspace, startVertex, 0, NOTHING);
+  settle(graph, INT_MAX, INT_MAX, targetVertex, workspace);
+  return workspace->distance[targetVertex];
+}
+
+/* Runs Prim's algorithm on Graph 'graph' from vertex 'startVertex'. The
+ * vertices are left in workspace->reached in the order Prim's adds them to
+ * the tree, each with the weight of the tree edge to its predecessor as its
+ * distance, and their number is returned.
+ * Returns -1 if 'startVertex' is not valid in 'graph'.
+ * Precondition: 'workspace' was created for >= graph->numVertices vertices
+ */
+int getSpanningTreePrim(Graph *graph, int startVertex,
+                        QueryWorkspace *workspace)
+{
+  if (startVertex < 0 || startVertex >= graph->numVertices)
+  {
+    return -1;
+  }
+  resetWorkspace(workspace);
+  relax(workspace, startVertex, 0, NOTHING);
+  while (workspace->heap->size > 0)
+  {
+    HeapNode minNode = extractMin(workspace->heap);
+    int u = minNode.id;
+    workspace->settled[u] = true;
+    Reached *res = &workspace->reached[workspace->numReached++];
+    res->vertex = u;
+    res->distance = minNode.priority;
+    res->predecessor = workspace->predecessor[u];
+
+    for (EdgeList *adjList = graph->vertices[u]->adjList; adjList != NULL;
+         adjList = adjList->next)
+    {
+      int v = otherEndpoint(adjList->edge, u);
+      if (!workspace->settled[v])
+      {
+        relax(workspace, v, adjList->edge->weight, u);
+      }
+    }
+  }
+  return workspace->numReached;
+}
+
+/* Returns true iff 'vertex' is a valid vertex ID in Graph 'graph'. */
+static bool isVertex(Graph *graph, int vertex)
+{
+  return vertex >= 0 && vertex < graph->numVertices;
+}
+
+/* Frees all memory allocated for 'search'. */
+static void deleteTableSearch(TableSearch *search)
+{
+  table_heapFree(&search->heap);
+  free(search->distance);
+  free(search->settled);
+  free(search->touched);
+  free(search);
+}
+
+/* Returns a newly created search state for the rows of distance tables on
+ * graphs with 'numVertices' vertices, or NULL if memory could not be
+ * allocated.
+ */
+static TableSearch *newTableSearch(int numVertices)
+{
+  TableSearch *res = malloc(sizeof(TableSearch));
+  if (res == NULL)
+  {
+    return NULL;
+  }
+  res->distance = malloc(sizeof(int64_t) * (numVertices + 1));
+  res->settled = malloc(sizeof(bool) * (numVertices + 1));
+  res->touched = malloc(sizeof(int) * (numVertices + 1));
+  if (res->distance == NULL || res->settled == NULL || res->touched == NULL ||
+      !table_heapInit(&res->heap, numVertices))
+  {
+    free(res->distance);
+    free(res->settled);
+    free(res->touched);
+    free(res);
+    return NULL;
+  }
+  for (int i = 0; i < numVertices; i++)
+  {
+    res->distance[i] = TABLE_UNREACHABLE;
+    res->settled[i] = false;
+  }
+  res->numTouched = 0;
+  return res;
+}
+
+/* Puts back into their initial state only the entries of 'search' that the
+ * previous row touched, and empties its heap.
+ */
+static void resetTableSearch(TableSearch *search)
+{
+  for (int i = 0; i < search->numTouched; i++)
+  {
+    int id = search->touched[i];
+    search->distance[id] = TABLE_UNREACHABLE;
+    search->settled[id] = false;
+  }
+  for (int i = 0; i < search->heap.size; i++)
+  {
+    search->heap.positions[search->heap.nodes[i].id] = TABLE_HEAP_NONE;
+    search->heap.nodes[i].key = INT64_MAX;
+  }
+  search->heap.size = 0;
+  search->numTouched = 0;
+}
+
+/* Lowers the tentative distance of vertex 'v' in 'search' to 'distance' if
+ * that is an improvement.
+ */
+static void relaxTable(TableSearch *search, int v, int64_t distance)
+{
+  if (distance >= search->distance[v])
+  {
+    return;
+  }
+  if (search->distance[v] == TABLE_UNREACHABLE)
+  {
+    search->touched[search->numTouched++] = v;
+  }
+  search->distance[v] = distance;
+  table_heapPush(&search->heap, distance, (uint32_t)v);
+}
+
+/* Fills row 'row' of the matrix of 'dt' with one search from its source in
+ * 'search', which stops once every target vertex has been settled.
+ */
+static void fillRow(DistanceTable *dt, int row, TableSearch *search)
+{
+  int64_t *distances = dt->table + (long)row * dt->numTargets;
+  int source = dt->sources[row];
+  bool validSource = isVertex(dt->graph, source);
+  for (int j = 0; j < dt->numTargets; j++)
+  {
+    distances[j] = validSource && isVertex(dt->graph, dt->targets[j])
+                       ? TABLE_UNREACHABLE
+                       : -1;
+  }
+  if (!validSource)
+  {
+    return;
+  }
+
+  resetTableSearch(search);
+  relaxTable(search, source, 0);
+  int remaining = dt->numTargetVertices;
+  while (remaining > 0 && search->heap.size > 0)
+  {
+    table_HeapNode minNode = table_heapPop(&search->heap);
+    int u = minNode.id;
+    int64_t uDistance = minNode.key;
+    search->settled[u] = true;
+    int first = dt->bucketStart[u];
+    int last = dt->bucketStart[u + 1];
+    if (first < last)
+    {
+      for (int c = first; c < last; c++)
+      {
+        distances[dt->bucketColumns[c]] = uDistance;
+      }
+      if (--remaining == 0)
+      {
+        break;
+      }
+    }
+
+    for (EdgeList *adjList = dt->graph->vertices[u]->adjList; adjList != NULL;
+         adjList = adjList->next)
+    {
+      int v = otherEndpoint(adjList->edge, u);
+      if (!search->settled[v])
+      {
+        relaxTable(search, v, uDistance + adjList->edge->weight);
+      }
+    }
+  }
+}
+
+/* Body of one thread of getDistanceTable: claims rows and fills them. A
+ * thread that cannot get its search state leaves its share to the others.
+ */
+static void fillRows(void *ctx, int thread, int numThreads)
+{
+  DistanceTable *dt = ctx;
+  TableSearch *search = newTableSearch(dt->graph->numVertices);
+  if (search == NULL)
+  {
+    return;
+  }
+  while (true)
+  {
+    long row = __atomic_fetch_add(&dt->nextSource, 1, __ATOMIC_RELAXED);
+    if (row >= dt->numSources)
+    {
+      break;
+    }
+    fillRow(dt, row, search);
+  }
+  deleteTableSearch(search);
+}
+
+/* Fills the dense numSources x numTargets matrix 'table' with the distances
+ * on Graph 'graph' from every vertex in 'sources' to every vertex in
+ * 'targets': table[i * numTargets + j] is the distance from sources[i] to
+ * targets[j], TABLE_UNREACHABLE if there is no path, and -1 if either vertex
+ * is not valid in 'graph'. Uses 'numThreads' threads, or 0 for the default.
+ * Returns false if memory could not be allocated.
+ */
+bool getDistanceTable(Graph *graph, int *sources, int numSources,
+                      int *targets, int numTargets, int64_t *table,
+                      int numThreads)
+{
+  int n = graph->numVertices;
+  DistanceTable dt = {graph, sources, numSources, targets, numTargets, table,
+                      NULL, NULL, 0, 0};
+  dt.bucketStart = calloc(n + 2, sizeof(int));
+  dt.bucketColumns = malloc(sizeof(int) * (numTargets + 1));
+  if (dt.bucketStart == NULL || dt.bucketColumns == NULL)
+  {
+    free(dt.bucketStart);
+    free(dt.bucketColumns);
+    return false;
+  }
+
+  // Counting sort of the target columns by vertex: count into
+  // bucketStart[v + 2], sum up so that bucketStart[v + 1] is where v's
+  // bucket starts, then place, which moves it on to where v's bucket ends.
+  for (int j = 0; j < numTargets; j++)
+  {
+    if (isVertex(graph, targets[j]))
+    {
+      if (dt.bucketStart[targets[j] + 2]++ == 0)
+      {
+        dt.numTargetVertices++;
+      }
+    }
+  }
+  for (int v = 2; v <= n + 1; v++)
+  {
+    dt.bucketStart[v] += dt.bucketStart[v - 1];
+  }
+  for (int j = 0; j < numTargets; j++)
+  {
+    if (isVertex(graph, targets[j]))
+    {
+      dt.bucketColumns[dt.bucketStart[targets[j] + 1]++] = j;
+    }
+  }
+
+  if (numThreads <= 0)
+  {
+    numThreads = defaultThreadCount();
+  }
+  if (numThreads > numSources)
+  {
+    numThreads = numSources;
+  }
+  if (numThreads > 0)
+  {
+    parallelRun(numThreads, fillRows, &dt);
+  }
+
+  free(dt.bucketStart);
+  free(dt.bucketColumns);
+  return dt.nextSource >= numSources;
+}
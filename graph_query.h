@@ -0,0 +1,98 @@
+/*
+ * Header file for local shortest-path queries: Dijkstra searches that stop
+ * early and whose cost depends on the part of the graph they explore, not on
+ * the size of the graph.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "graph.h"
+#include "minheap.h"
+
+#ifndef __Graph_Query_header
+#define __Graph_Query_header
+
+#define TABLE_UNREACHABLE INT64_MAX  // getDistanceTable: no path
+
+typedef struct reached {
+  int vertex;       // a vertex reached by the query
+  int distance;     // its distance from the start vertex
+  int predecessor;  // its predecessor on a shortest path; -1 for the start
+} Reached;
+
+typedef struct query_workspace {
+  int numVertices;   // vertex IDs are 0, 1, ..., numVertices-1
+  MinHeap* heap;     // frontier of the current query
+  int* distance;     // distance[id]: tentative distance, INT_MAX if untouched
+  int* predecessor;  // predecessor[id]: predecessor on the tentative path
+  bool* settled;     // settled[id] is true iff id's distance is final
+  int* touched;      // the IDs whose entries above are not in their initial
+                     //   state; only these are reset between queries
+  int numTouched;    // number of IDs in 'touched'
+  Reached* reached;  // result of the last query, in order of distance
+  int numReached;    // number of results in 'reached'
+} QueryWorkspace;
+
+/* Returns a newly created workspace for queries on graphs with up to
+ * 'numVertices' vertices. One workspace serves any number of queries, on
+ * any number of such graphs, but only one at a time.
+ * Precondition: numVertices >= 0
+ */
+QueryWorkspace* newQueryWorkspace(int numVertices);
+
+/* Frees all memory allocated for 'workspace'. */
+void deleteQueryWorkspace(QueryWorkspace* workspace);
+
+/* Runs Dijkstra's algorithm on Graph 'graph' from vertex 'startVertex',
+ * settling only vertices at distance at most 'radius', and at most 'k' of
+ * them. Pass INT_MAX for either to leave it unbounded. The settled vertices
+ * are left in workspace->reached in order of distance, the start vertex
+ * first, and their number is returned.
+ * Returns -1 if 'startVertex' is not valid in 'graph'.
+ * Precondition: 'workspace' was created for >= graph->numVertices vertices
+ */
+int getNearestDijkstra(Graph* graph, int startVertex, int radius, int k,
+                       QueryWorkspace* workspace);
+
+/* Runs Dijkstra's algorithm on Graph 'graph' from vertex 'startVertex' until
+ * vertex 'targetVertex' is settled, and returns its distance from
+ * 'startVertex'. The path can be read back from the target through
+ * workspace->predecessor; it is valid until the next query.
+ * Returns -1 if either vertex is not valid in 'graph', and INT_MAX if
+ * 'targetVertex' cannot be reached.
+ * Precondition: 'workspace' was created for >= graph->numVertices vertices
+ */
+int getDistanceToDijkstra(Graph* graph, int startVertex, int targetVertex,
+                          QueryWorkspace* workspace);
+
+/* Runs Prim's algorithm on Graph 'graph' from vertex 'startVertex'. The
+ * vertices of the tree are left in workspace->reached in the order they
+ * join it, each with the weight of its tree edge (to 'predecessor') as its
+ * 'distance', and their number is returned; it is less than
+ * graph->numVertices if 'graph' is not connected.
+ * Returns -1 if 'startVertex' is not valid in 'graph'.
+ * Precondition: 'workspace' was created for >= graph->numVertices vertices
+ */
+int getSpanningTreePrim(Graph* graph, int startVertex,
+                        QueryWorkspace* workspace);
+
+/* Fills the dense numSources x numTargets matrix 'table' with the distances
+ * on Graph 'graph' from every vertex in 'sources' to every vertex in
+ * 'targets': table[i * numTargets + j] is the distance from sources[i] to
+ * targets[j], TABLE_UNREACHABLE if there is no path, and -1 if either vertex
+ * is not valid in 'graph'. Distances are summed in 64 bits, so they may be
+ * above INT_MAX.
+ * Runs one Dijkstra search per source, in parallel with 'numThreads' threads
+ * (0 for the default). Every vertex keeps a bucket of the targets at it, and
+ * each search stops as soon as it has settled all of them, so searches only
+ * cover the part of the graph that lies within reach of the targets.
+ * Returns false if memory could not be allocated; 'table' is then undefined.
+ */
+bool getDistanceTable(Graph* graph, int* sources, int numSources,
+                      int* targets, int numTargets, int64_t* table,
+                      int numThreads);
+
+#endif
@@ -0,0 +1,423 @@
+/*
+ *  A query service that loads a graph once and answers shortest-path
+ *  queries over a Unix domain socket.
+ *
+ *  Every worker thread accepts connections of its own and answers them with
+ *  its own QueryWorkspace; the Graph is shared and never modified after it
+ *  is loaded, so workers need no locks.
+ *
+ *  ---------------------------------------------------------------------------
+ *   Compile:
+ *   gcc -Wall -Werror graph.c minheap.c graph_algos.c graph_bfs.c \
+ *       graph_build.c graph_io.c graph_query.c graph_view.c parallel.c \
+ *       graph_server.c -o graph_server -lpthread
+ *
+ *   Run:
+ *   ./graph_server [-u] [-e] [-w workers] socket_path input_file
+ *     -u, -e      as for ./tester
+ *     -w workers  number of worker threads (default: number of CPUs)
+ *
+ *   Protocol: one request per line, one response line per request.
+ *     DIST s t    distance from s to t:       "<distance>" or "unreachable"
+ *     PATH s t    a shortest path from s to t: "<distance> s ... t"
+ *     MST         weight of the MST from vertex 0 (computed at startup)
+ *     KNN s k     the k vertices nearest to s: "<n> v:d v:d ..."
+ *     INFO        "vertices <V> edges <E> workers <W>"
+ *     STATS       number of queries answered and latency percentiles (us)
+ *     QUIT        closes the connection
+ *   Malformed requests are answered with a line starting with "ERROR".
+ *   SIGINT or SIGTERM stops the server and removes the socket.
+ *
+ *   Try:
+ *   ./graph_server /tmp/graph.sock sample_input.txt &
+ *   echo "PATH 0 3" | nc -U /tmp/graph.sock
+ *  ---------------------------------------------------------------------------
+ */
+
+#include <errno.h>
+#include <limits.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "graph.h"
+#include "graph_algos.h"
+#include "graph_build.h"
+#include "graph_io.h"
+#include "graph_query.h"
+#include "parallel.h"
+
+#define MAX_REQUEST 256  // longest request line we accept
+
+// Latencies are kept in log-linear buckets: exact below 2^SUB_BITS+1 us,
+// then 2^SUB_BITS buckets per power of two (relative error < 1/16).
+#define SUB_BITS 4
+#define NUM_BUCKETS ((2 << SUB_BITS) + (64 - SUB_BITS - 1) * (1 << SUB_BITS))
+
+typedef struct server Server;
+
+typedef struct worker {
+  Server* server;
+  pthread_t thread;
+  QueryWorkspace* workspace;  // this worker's scratch space for queries
+  int* path;                  // room for a path through every vertex
+  int client;                 // socket of the connection being served, or -1
+  long latency[NUM_BUCKETS];  // latency[b]: number of requests in bucket b;
+                              //   written only by this worker
+} Worker;
+
+struct server {
+  Graph* graph;       // shared and read-only once loaded
+  long mstWeight;     // weight of the MST from vertex 0, or -1 if none
+  int listener;       // the listening socket
+  int numWorkers;
+  Worker* workers;
+  bool stopping;      // set once when the server shuts down
+  pthread_mutex_t clientsLock;  // guards Worker.client and 'stopping'
+};
+
+static Graph* loadGraph(const char* path, bool symmetric, bool edgeStream);
+static long getMSTWeight(Graph* graph);
+static int openListener(const char* path);
+static void* serveConnections(void* arg);
+static void serveClient(Worker* worker, FILE* in, FILE* out);
+static void answer(Worker* worker, char* request, FILE* out);
+static void printStats(Server* server, FILE* out);
+static int latencyBucket(long micros);
+static long bucketLimit(int bucket);
+
+int main(int argc, char* argv[]) {
+  bool symmetric = false;
+  bool edgeStream = false;
+  int numWorkers = defaultThreadCount();
+  int arg = 1;
+  for (; arg < argc && argv[arg][0] == '-'; arg++) {
+    if (strcmp(argv[arg], "-u") == 0) {
+      symmetric = true;
+    } else if (strcmp(argv[arg], "-e") == 0) {
+      edgeStream = true;
+    } else if (strcmp(argv[arg], "-w") == 0 && arg + 1 < argc) {
+      numWorkers = atoi(argv[++arg]);
+    } else {
+      printf("Unknown option: %s. Please, try again.\n", argv[arg]);
+      return 1;
+    }
+  }
+  if (arg + 2 != argc || numWorkers < 1) {
+    printf("Usage: %s [-u] [-e] [-w workers] socket_path input_file\n",
+           argv[0]);
+    return 1;
+  }
+  const char* socketPath = argv[arg];
+
+  Server server;
+  server.graph = loadGraph(argv[arg + 1], symmetric, edgeStream);
+  if (server.graph == NULL) return 1;
+  // Edge streams are loaded with buildGraph.
+  void (*freeGraph)(Graph*) = edgeStream ? deleteBuiltGraph : deleteGraph;
+  server.mstWeight = getMSTWeight(server.graph);
+  server.listener = openListener(socketPath);
+  if (server.listener < 0) {
+    freeGraph(server.graph);
+    return 1;
+  }
+  server.numWorkers = numWorkers;
+  server.workers = calloc(numWorkers, sizeof(Worker));
+  server.stopping = false;
+  pthread_mutex_init(&server.clientsLock, NULL);
+
+  // Workers inherit this mask, so only the main thread sees the signals.
+  sigset_t signals;
+  sigemptyset(&signals);
+  sigaddset(&signals, SIGINT);
+  sigaddset(&signals, SIGTERM);
+  pthread_sigmask(SIG_BLOCK, &signals, NULL);
+  signal(SIGPIPE, SIG_IGN);  // a client that hangs up is not our problem
+
+  int started = 0;
+  for (; started < numWorkers; started++) {
+    Worker* worker = &server.workers[started];
+    worker->server = &server;
+    worker->client = -1;
+    worker->workspace = newQueryWorkspace(server.graph->numVertices);
+    worker->path = malloc(sizeof(int) * (server.graph->numVertices + 1));
+    if (worker->workspace == NULL || worker->path == NULL ||
+        pthread_create(&worker->thread, NULL, serveConnections, worker) != 0) {
+      deleteQueryWorkspace(worker->workspace);
+      free(worker->path);
+      break;
+    }
+  }
+  if (started == 0) {
+    fprintf(stderr, "Could not start any workers.\n");
+  } else {
+    fprintf(stderr, "Serving %d vertices on %s with %d workers.\n",
+            server.graph->numVertices, socketPath, started);
+    int received;
+    sigwait(&signals, &received);
+    fprintf(stderr, "Shutting down.\n");
+  }
+
+  // Wake the workers: accept() and reads on shut down sockets return at once.
+  pthread_mutex_lock(&server.clientsLock);
+  server.stopping = true;
+  shutdown(server.listener, SHUT_RDWR);
+  for (int w = 0; w < started; w++) {
+    if (server.workers[w].client >= 0) {
+      shutdown(server.workers[w].client, SHUT_RDWR);
+    }
+  }
+  pthread_mutex_unlock(&server.clientsLock);
+  for (int w = 0; w < started; w++) {
+    pthread_join(server.workers[w].thread, NULL);
+  }
+  close(server.listener);
+  unlink(socketPath);
+
+  server.numWorkers = started;
+  printStats(&server, stderr);
+  for (int w = 0; w < started; w++) {
+    deleteQueryWorkspace(server.workers[w].workspace);
+    free(server.workers[w].path);
+  }
+  pthread_mutex_destroy(&server.clientsLock);
+  free(server.workers);
+  freeGraph(server.graph);
+  return 0;
+}
+
+/* Reads a Graph from the file at 'path', in the adjacency format or, if
+ * 'edgeStream' is true, the edge stream format. Returns NULL on failure.
+ */
+static Graph* loadGraph(const char* path, bool symmetric, bool edgeStream) {
+  FILE* f = fopen(path, "r");
+  if (f == NULL) {
+    fprintf(stderr, "Unable to open the specified input file: %s\n", path);
+    return NULL;
+  }
+  Graph* graph = edgeStream ? createGraphFromEdges(f, symmetric)
+                            : createGraph(f, symmetric);
+  fclose(f);
+  return graph;
+}
+
+/* Returns the weight of the MST of 'graph' from vertex 0, or -1 if 'graph'
+ * has no vertices.
+ */
+static long getMSTWeight(Graph* graph) {
+  if (graph->numVertices == 0) return -1;
+  Edge* mst = getMSTprim(graph, 0);
+  if (mst == NULL) return -1;
+  long total = 0;
+  for (int i = 0; i < graph->numVertices - 1; i++) total += mst[i].weight;
+  free(mst);
+  return total;
+}
+
+/* Returns a socket listening on the Unix domain socket at 'path', replacing
+ * any stale socket file there, or -1 on failure.
+ */
+static int openListener(const char* path) {
+  struct sockaddr_un address;
+  memset(&address, 0, sizeof(address));
+  address.sun_family = AF_UNIX;
+  if (strlen(path) >= sizeof(address.sun_path)) {
+    fprintf(stderr, "Socket path too long: %s\n", path);
+    return -1;
+  }
+  strcpy(address.sun_path, path);
+
+  int listener = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (listener < 0) {
+    perror("socket");
+    return -1;
+  }
+  unlink(path);
+  if (bind(listener, (struct sockaddr*)&address, sizeof(address)) != 0 ||
+      listen(listener, SOMAXCONN) != 0) {
+    perror(path);
+    close(listener);
+    return -1;
+  }
+  return listener;
+}
+
+/* Body of a worker thread: accepts connections and serves them one at a
+ * time until the server stops.
+ */
+static void* serveConnections(void* arg) {
+  Worker* worker = arg;
+  Server* server = worker->server;
+  while (true) {
+    int client = accept(server->listener, NULL, NULL);
+    if (client < 0) {
+      if (errno == EINTR || errno == ECONNABORTED) continue;
+      return NULL;  // the listener was shut down
+    }
+    pthread_mutex_lock(&server->clientsLock);
+    bool stopping = server->stopping;
+    worker->client = client;
+    pthread_mutex_unlock(&server->clientsLock);
+
+    FILE* in = stopping ? NULL : fdopen(client, "r");
+    FILE* out = in == NULL ? NULL : fdopen(dup(client), "w");
+    if (out != NULL) serveClient(worker, in, out);
+
+    pthread_mutex_lock(&server->clientsLock);
+    worker->client = -1;
+    pthread_mutex_unlock(&server->clientsLock);
+    if (out != NULL) fclose(out);
+    if (in != NULL) {
+      fclose(in);  // closes 'client'
+    } else {
+      close(client);
+    }
+    if (stopping) return NULL;
+  }
+}
+
+/* Answers the requests of one client, read from 'in', on 'out', until the
+ * client hangs up or sends QUIT.
+ */
+static void serveClient(Worker* worker, FILE* in, FILE* out) {
+  char request[MAX_REQUEST];
+  while (fgets(request, MAX_REQUEST, in)) {
+    if (strncmp(request, "QUIT", 4) == 0) return;
+
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    answer(worker, request, out);
+    // Flush before stopping the clock: the client waits for the whole line.
+    if (fflush(out) != 0) return;
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    long micros = (end.tv_sec - start.tv_sec) * 1000000L +
+                  (end.tv_nsec - start.tv_nsec) / 1000;
+    long* count = &worker->latency[latencyBucket(micros)];
+    // Only this worker writes; STATS in other workers may read concurrently.
+    __atomic_store_n(count, __atomic_load_n(count, __ATOMIC_RELAXED) + 1,
+                     __ATOMIC_RELAXED);
+  }
+}
+
+/* Writes the response to the single request 'request' on 'out'. */
+static void answer(Worker* worker, char* request, FILE* out) {
+  Graph* graph = worker->server->graph;
+  QueryWorkspace* workspace = worker->workspace;
+  char command[16];
+  int a, b;
+  int numArgs = sscanf(request, "%15s %d %d", command, &a, &b);
+  if (numArgs < 1) {
+    fprintf(out, "ERROR empty request\n");
+    return;
+  }
+
+  if (strcmp(command, "DIST") == 0 || strcmp(command, "PATH") == 0) {
+    if (numArgs != 3) {
+      fprintf(out, "ERROR usage: %s source target\n", command);
+      return;
+    }
+    int distance = getDistanceToDijkstra(graph, a, b, workspace);
+    if (distance < 0) {
+      fprintf(out, "ERROR no such vertex\n");
+    } else if (distance == INT_MAX) {
+      fprintf(out, "unreachable\n");
+    } else if (strcmp(command, "DIST") == 0) {
+      fprintf(out, "%d\n", distance);
+    } else {
+      // Walk back from the target, then print the path the right way round.
+      int length = 0;
+      for (int v = b; v != -1; v = workspace->predecessor[v]) {
+        worker->path[length++] = v;
+      }
+      fprintf(out, "%d", distance);
+      while (length > 0) fprintf(out, " %d", worker->path[--length]);
+      fprintf(out, "\n");
+    }
+  } else if (strcmp(command, "KNN") == 0) {
+    if (numArgs != 3 || b < 0) {
+      fprintf(out, "ERROR usage: KNN source k\n");
+      return;
+    }
+    int numReached = getNearestDijkstra(graph, a, INT_MAX, b, workspace);
+    if (numReached < 0) {
+      fprintf(out, "ERROR no such vertex\n");
+      return;
+    }
+    fprintf(out, "%d", numReached);
+    for (int i = 0; i < numReached; i++) {
+      fprintf(out, " %d:%d", workspace->reached[i].vertex,
+              workspace->reached[i].distance);
+    }
+    fprintf(out, "\n");
+  } else if (strcmp(command, "MST") == 0) {
+    fprintf(out, "%ld\n", worker->server->mstWeight);
+  } else if (strcmp(command, "INFO") == 0) {
+    fprintf(out, "vertices %d edges %d workers %d\n", graph->numVertices,
+            graph->numEdges, worker->server->numWorkers);
+  } else if (strcmp(command, "STATS") == 0) {
+    printStats(worker->server, out);
+  } else {
+    fprintf(out, "ERROR unknown request: %s\n", command);
+  }
+}
+
+/* Prints on 'out', in one line, the number of requests answered so far by
+ * all workers of 'server' and the 50th, 99th and 99.9th percentile and
+ * maximum of their latencies in microseconds.
+ */
+static void printStats(Server* server, FILE* out) {
+  static const double percentiles[] = {0.5, 0.99, 0.999};
+  static const char* labels[] = {"p50", "p99", "p999"};
+  long* merged = calloc(NUM_BUCKETS, sizeof(long));
+  long total = 0;
+  for (int w = 0; w < server->numWorkers; w++) {
+    for (int b = 0; b < NUM_BUCKETS; b++) {
+      long count =
+          __atomic_load_n(&server->workers[w].latency[b], __ATOMIC_RELAXED);
+      merged[b] += count;
+      total += count;
+    }
+  }
+
+  fprintf(out, "queries %ld", total);
+  int bucket = 0;
+  long seen = merged[0];
+  for (int p = 0; p < 3 && total > 0; p++) {
+    long rank = (long)(percentiles[p] * total + 0.5);
+    if (rank < 1) rank = 1;
+    while (seen < rank) seen += merged[++bucket];
+    fprintf(out, " %s %ld", labels[p], bucketLimit(bucket));
+  }
+  if (total > 0) {
+    int last = NUM_BUCKETS - 1;
+    while (merged[last] == 0) last--;
+    fprintf(out, " max %ld", bucketLimit(last));
+  }
+  fprintf(out, "\n");
+  free(merged);
+}
+
+/* Returns the latency bucket of a latency of 'micros' microseconds. */
+static int latencyBucket(long micros) {
+  if (micros < 0) micros = 0;
+  if (micros < (2 << SUB_BITS)) return micros;
+  int msb = 63 - __builtin_clzl(micros);
+  int shift = msb - SUB_BITS;
+  return (2 << SUB_BITS) + (shift - 1) * (1 << SUB_BITS) +
+         (int)(micros >> shift) - (1 << SUB_BITS);
+}
+
+/* Returns the largest latency in microseconds that falls in 'bucket'. */
+static long bucketLimit(int bucket) {
+  if (bucket < (2 << SUB_BITS)) return bucket;
+  int shift = (bucket - (2 << SUB_BITS)) / (1 << SUB_BITS) + 1;
+  long sub = (bucket - (2 << SUB_BITS)) % (1 << SUB_BITS) + (1 << SUB_BITS);
+  return ((sub + 1) << shift) - 1;
+}
@@ -0,0 +1,471 @@
+/*
+ * Versioned, copy-on-write snapshots of a graph.
+ */
+
+#include <pthread.h>
+#include <string.h>
+
+#include "graph_snapshot.h"
+#include "graph_symmetric.h"
+
+#define IDLE 0  // the epoch announced by a reader with nothing pinned
+
+struct graph_version
+{
+  Graph graph;   // must stay first: readers are handed &version->graph
+  long number;   // 0, 1, 2, ... in order of publication
+  // While a draft: the vertices whose lists it copied, and the copied
+  // blocks of the previous version it replaces.
+  int *changed;
+  int numChanged;
+  Vertex **replaced;
+  int numReplaced;
+  int capacity;  // room in 'changed' and in 'replaced'
+  // Once replaced itself: the blocks to free along with this version.
+  Vertex **dropped;
+  int numDropped;
+  unsigned long retiredEpoch;  // epoch in which it was replaced
+  GraphVersion *nextRetired;   // next in the list of replaced versions
+};
+
+typedef struct reader_slot
+{
+  unsigned long pinned;  // epoch in which the reader pinned, or IDLE
+  bool registered;       // true iff the slot is in use
+} __attribute__((aligned(64))) ReaderSlot;  // one cache line per reader
+
+struct graph_snapshots
+{
+  GraphVersion *current;   // the version new readers get; atomic
+  unsigned long epoch;     // the global epoch; atomic, starts at 1
+  ReaderSlot readers[MAX_SNAPSHOT_READERS];
+  // Owned by the writer holding 'writerLock':
+  pthread_mutex_t writerLock;
+  Graph *original;         // the graph the snapshots were created with
+  void (*deleteOriginal)(Graph *graph);  // frees 'original'
+  bool symmetric;          // isSymmetricGraph(original)
+  bool *copied;            // copied[v] iff the current version's vertex v is
+                           //   a block allocated here rather than 'original's
+  GraphVersion *retired;   // replaced versions not yet freed
+  int numRetired;
+};
+
+/* Frees 'version' together with the blocks that were dropped with it. */
+static void freeVersion(GraphVersion *version)
+{
+  for (int i = 0; i < version->numDropped; i++)
+  {
+    free(version->dropped[i]);
+  }
+  free(version->dropped);
+  free(version->changed);
+  free(version->replaced);
+  if (version->number > 0)
+  {
+    free(version->graph.vertices);  // version 0 uses the original's array
+  }
+  free(version);
+}
+
+/* Returns new snapshots whose first version is 'graph', or NULL if memory
+ * could not be allocated. They free 'graph' with 'deleteOriginal'.
+ */
+GraphSnapshots *newGraphSnapshots(Graph *graph,
+                                  void (*deleteOriginal)(Graph *graph))
+{
+  GraphSnapshots *res = calloc(1, sizeof(GraphSnapshots));
+  GraphVersion *first = calloc(1, sizeof(GraphVersion));
+  bool *copied = calloc(graph->numVertices + 1, sizeof(bool));
+  if (res == NULL || first == NULL || copied == NULL)
+  {
+    free(res);
+    free(first);
+    free(copied);
+    return NULL;
+  }
+  first->graph = *graph;
+  first->number = 0;
+  res->current = first;
+  res->epoch = 1;
+  pthread_mutex_init(&res->writerLock, NULL);
+  res->original = graph;
+  res->deleteOriginal = deleteOriginal;
+  res->symmetric = isSymmetricGraph(graph);
+  res->copied = copied;
+  res->retired = NULL;
+  res->numRetired = 0;
+  return res;
+}
+
+/* Frees all versions and all memory allocated for 'snapshots', including
+ * the graph it was created with.
+ * Precondition: no reader has a version pinned and no draft is open
+ */
+void deleteGraphSnapshots(GraphSnapshots *snapshots)
+{
+  if (snapshots == NULL)
+  {
+    return;
+  }
+  while (snapshots->retired != NULL)
+  {
+    GraphVersion *next = snapshots->retired->nextRetired;
+    freeVersion(snapshots->retired);
+    snapshots->retired = next;
+  }
+  GraphVersion *current = snapshots->current;
+  for (int v = 0; v < current->graph.numVertices; v++)
+  {
+    if (snapshots->copied[v])
+    {
+      free(current->graph.vertices[v]);
+    }
+  }
+  freeVersion(current);
+  snapshots->deleteOriginal(snapshots->original);
+  pthread_mutex_destroy(&snapshots->writerLock);
+  free(snapshots->copied);
+  free(snapshots);
+}
+
+/***** Readers **************************************************************/
+
+/* Registers a reader of 'snapshots' and returns its ID, or -1 if
+ * MAX_SNAPSHOT_READERS are already registered.
+ */
+int registerSnapshotReader(GraphSnapshots *snapshots)
+{
+  for (int r = 0; r < MAX_SNAPSHOT_READERS; r++)
+  {
+    bool expected = false;
+    if (__atomic_compare_exchange_n(&snapshots->readers[r].registered,
+                                    &expected, true, false, __ATOMIC_ACQ_REL,
+                                    __ATOMIC_RELAXED))
+    {
+      return r;
+    }
+  }
+  return -1;
+}
+
+/* Gives back the reader ID 'reader'.
+ * Precondition: 'reader' has no version pinned
+ */
+void unregisterSnapshotReader(GraphSnapshots *snapshots, int reader)
+{
+  __atomic_store_n(&snapshots->readers[reader].registered, false,
+                   __ATOMIC_RELEASE);
+}
+
+/* Pins the current version of 'snapshots' for reader 'reader' and returns
+ * it.
+ * Precondition: 'reader' has no version pinned
+ */
+Graph *pinSnapshot(GraphSnapshots *snapshots, int reader)
+{
+  // Announce the epoch before looking at 'current': a writer that misses
+  // the announcement published its version before we look, so we see it.
+  unsigned long epoch = __atomic_load_n(&snapshots->epoch, __ATOMIC_SEQ_CST);
+  __atomic_store_n(&snapshots->readers[reader].pinned, epoch,
+                   __ATOMIC_SEQ_CST);
+  GraphVersion *version =
+      __atomic_load_n(&snapshots->current, __ATOMIC_SEQ_CST);
+  return &version->graph;
+}
+
+/* Releases the version pinned by reader 'reader'. */
+void unpinSnapshot(GraphSnapshots *snapshots, int reader)
+{
+  __atomic_store_n(&snapshots->readers[reader].pinned, IDLE,
+                   __ATOMIC_RELEASE);
+}
+
+/* Returns the number of the current version. */
+long currentSnapshotNumber(GraphSnapshots *snapshots)
+{
+  GraphVersion *version =
+      __atomic_load_n(&snapshots->current, __ATOMIC_ACQUIRE);
+  return version->number;
+}
+
+/***** Writers **************************************************************/
+
+/* Starts a new draft of the next version of 'snapshots'. Returns false, with
+ * no draft open, if memory could not be allocated.
+ */
+bool beginDraft(GraphSnapshots *snapshots, GraphDraft *draft)
+{
+  pthread_mutex_lock(&snapshots->writerLock);
+  GraphVersion *current = snapshots->current;
+  GraphVersion *version = calloc(1, sizeof(GraphVersion));
+  int n = current->graph.numVertices;
+  Vertex **vertices = malloc(sizeof(Vertex *) * (n + 1));
+  if (version == NULL || vertices == NULL)
+  {
+    free(version);
+    free(vertices);
+    pthread_mutex_unlock(&snapshots->writerLock);
+    return false;
+  }
+  memcpy(vertices, current->graph.vertices, sizeof(Vertex *) * n);
+  version->graph = current->graph;
+  version->graph.vertices = vertices;
+  version->number = current->number + 1;
+  draft->snapshots = snapshots;
+  draft->version = version;
+  return true;
+}
+
+/* Returns the edge from 'vertex' to 'neighbour' in the adjacency list of
+ * 'vertex', or NULL if there is none.
+ */
+static Edge *findEdge(Vertex *vertex, int neighbour)
+{
+  for (EdgeList *cur = vertex->adjList; cur != NULL; cur = cur->next)
+  {
+    if (otherEndpoint(cur->edge, vertex->id) == neighbour)
+    {
+      return cur->edge;
+    }
+  }
+  return NULL;
+}
+
+/* Returns a copy of 'vertex' and its adjacency list in a single block, in
+ * which the edge to 'neighbour' has weight 'weight' (appended at the end of
+ * the list if 'vertex' had no such edge). Returns NULL if memory could not
+ * be allocated.
+ */
+static Vertex *copyWithEdge(Vertex *vertex, int neighbour, int weight)
+{
+  int degree = findEdge(vertex, neighbour) == NULL ? 1 : 0;
+  for (EdgeList *cur = vertex->adjList; cur != NULL; cur = cur->next)
+  {
+    degree++;
+  }
+  Vertex *res = malloc(sizeof(Vertex) +
+                       (sizeof(EdgeList) + sizeof(Edge)) * degree);
+  if (res == NULL)
+  {
+    return NULL;
+  }
+  EdgeList *lists = (EdgeList *)(res + 1);
+  Edge *edges = (Edge *)(lists + degree);
+  res->id = vertex->id;
+  res->value = vertex->value;
+  res->adjList = degree > 0 ? lists : NULL;
+
+  int i = 0;
+  bool found = false;
+  for (EdgeList *cur = vertex->adjList; cur != NULL; cur = cur->next, i++)
+  {
+    edges[i] = *cur->edge;
+    if (!found && otherEndpoint(cur->edge, vertex->id) == neighbour)
+    {
+      edges[i].weight = weight;
+      found = true;
+    }
+  }
+  if (!found)
+  {
+    edges[i].fromVertex = vertex->id;
+    edges[i].toVertex = neighbour;
+    edges[i].weight = weight;
+  }
+  for (i = 0; i < degree; i++)
+  {
+    lists[i].edge = &edges[i];
+    lists[i].next = i + 1 < degree ? &lists[i + 1] : NULL;
+  }
+  return res;
+}
+
+/* Makes 'block' vertex 'v' of the draft 'version', whose predecessor is
+ * 'current'. Room for one more entry in 'changed' and 'replaced' must have
+ * been made.
+ */
+static void install(GraphSnapshots *snapshots, GraphVersion *version,
+                    GraphVersion *current, int v, Vertex *block)
+{
+  Vertex *old = version->graph.vertices[v];
+  if (old != current->graph.vertices[v])
+  {
+    free(old);  // an earlier copy in this draft; no reader has seen it
+  }
+  else
+  {
+    version->changed[version->numChanged++] = v;
+    if (snapshots->copied[v])
+    {
+      version->replaced[version->numReplaced++] = old;
+    }
+  }
+  version->graph.vertices[v] = block;
+}
+
+/* Gives the edge from 'fromVertex' to 'toVertex' the weight 'weight' in
+ * 'draft', adding the edge if there is none; in an undirected graph, in both
+ * directions. Returns false, leaving the draft unchanged, if a vertex is not
+ * valid, the weight is negative, or memory could not be allocated.
+ */
+bool draftSetEdge(GraphDraft *draft, int fromVertex, int toVertex, int weight)
+{
+  GraphSnapshots *snapshots = draft->snapshots;
+  GraphVersion *version = draft->version;
+  GraphVersion *current = snapshots->current;
+  Graph *graph = &version->graph;
+  if (fromVertex < 0 || fromVertex >= graph->numVertices || toVertex < 0 ||
+      toVertex >= graph->numVertices || weight < 0)
+  {
+    return false;
+  }
+
+  if (version->capacity < version->numChanged + 2)
+  {
+    int capacity = 2 * version->capacity + 2;
+    int *changed = realloc(version->changed, sizeof(int) * capacity);
+    if (changed != NULL)
+    {
+      version->changed = changed;
+    }
+    Vertex **replaced = realloc(version->replaced, sizeof(Vertex *) * capacity);
+    if (replaced != NULL)
+    {
+      version->replaced = replaced;
+    }
+    if (changed == NULL || replaced == NULL)
+    {
+      return false;
+    }
+    version->capacity = capacity;
+  }
+
+  Vertex *from = graph->vertices[fromVertex];
+  Vertex *to = graph->vertices[toVertex];
+  bool added = findEdge(from, toVertex) == NULL;
+  bool both = snapshots->symmetric && fromVertex != toVertex;
+  Vertex *fromCopy = copyWithEdge(from, toVertex, weight);
+  Vertex *toCopy = both ? copyWithEdge(to, fromVertex, weight) : NULL;
+  if (fromCopy == NULL || (both && toCopy == NULL))
+  {
+    free(fromCopy);
+    free(toCopy);
+    return false;
+  }
+  install(snapshots, version, current, fromVertex, fromCopy);
+  if (both)
+  {
+    install(snapshots, version, current, toVertex, toCopy);
+  }
+  if (added)
+  {
+    graph->numEdges++;
+  }
+  return true;
+}
+
+/* Returns the smallest epoch announced by a reader with a version pinned,
+ * or 'limit' if every announced epoch is at least 'limit'.
+ */
+static unsigned long oldestPinned(GraphSnapshots *snapshots,
+                                  unsigned long limit)
+{
+  unsigned long oldest = limit;
+  for (int r = 0; r < MAX_SNAPSHOT_READERS; r++)
+  {
+    unsigned long pinned =
+        __atomic_load_n(&snapshots->readers[r].pinned, __ATOMIC_SEQ_CST);
+    if (pinned != IDLE && pinned < oldest)
+    {
+      oldest = pinned;
+    }
+  }
+  return oldest;
+}
+
+/* Frees every replaced version that no reader can still see. The caller
+ * holds the writer lock.
+ */
+static void reclaim(GraphSnapshots *snapshots)
+{
+  unsigned long oldest = oldestPinned(
+      snapshots, __atomic_load_n(&snapshots->epoch, __ATOMIC_SEQ_CST));
+  GraphVersion **link = &snapshots->retired;
+  while (*link != NULL)
+  {
+    GraphVersion *version = *link;
+    // Readers that pinned after the version was replaced cannot see it.
+    if (version->retiredEpoch < oldest)
+    {
+      *link = version->nextRetired;
+      freeVersion(version);
+      snapshots->numRetired--;
+    }
+    else
+    {
+      link = &version->nextRetired;
+    }
+  }
+}
+
+/* Makes 'draft' the current version, frees every old version that no
+ * reader can still see, and returns the new version's number.
+ */
+long publishDraft(GraphDraft *draft)
+{
+  GraphSnapshots *snapshots = draft->snapshots;
+  GraphVersion *version = draft->version;
+  GraphVersion *previous = snapshots->current;
+  for (int i = 0; i < version->numChanged; i++)
+  {
+    snapshots->copied[version->changed[i]] = true;
+  }
+  previous->dropped = version->replaced;
+  previous->numDropped = version->numReplaced;
+  free(version->changed);
+  version->changed = NULL;
+  version->replaced = NULL;
+  version->numChanged = version->numReplaced = version->capacity = 0;
+
+  __atomic_store_n(&snapshots->current, version, __ATOMIC_SEQ_CST);
+  previous->retiredEpoch =
+      __atomic_fetch_add(&snapshots->epoch, 1, __ATOMIC_SEQ_CST);
+  previous->nextRetired = snapshots->retired;
+  snapshots->retired = previous;
+  snapshots->numRetired++;
+  reclaim(snapshots);
+
+  long number = version->number;
+  pthread_mutex_unlock(&snapshots->writerLock);
+  draft->version = NULL;
+  return number;
+}
+
+/* Throws 'draft' away without publishing it. */
+void discardDraft(GraphDraft *draft)
+{
+  GraphSnapshots *snapshots = draft->snapshots;
+  GraphVersion *version = draft->version;
+  for (int i = 0; i < version->numChanged; i++)
+  {
+    free(version->graph.vertices[version->changed[i]]);
+  }
+  free(version->replaced);  // still part of the current version
+  version->replaced = NULL;
+  version->numReplaced = 0;
+  freeVersion(version);
+  pthread_mutex_unlock(&snapshots->writerLock);
+  draft->version = NULL;
+}
+
+/* Frees every old version that no reader can still see, and returns how
+ * many old versions are still waiting for readers.
+ */
+int reclaimSnapshots(GraphSnapshots *snapshots)
+{
+  pthread_mutex_lock(&snapshots->writerLock);
+  reclaim(snapshots);
+  int waiting = snapshots->numRetired;
+  pthread_mutex_unlock(&snapshots->writerLock);
+  return waiting;
+}
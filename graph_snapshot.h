@@ -0,0 +1,112 @@
+/*
+ * Header file for versioned, copy-on-write snapshots of a graph.
+ *
+ * Readers pin the current version and get a plain Graph that no one will
+ * change or free until they unpin it, so any algorithm can run on it. They
+ * take no locks: pinning is one atomic store between two loads. Writers
+ * build the next version as a draft and publish it in one atomic store. A
+ * draft copies the adjacency lists of the vertices it changes, and shares
+ * everything else with the version before it.
+ *
+ * Old versions are reclaimed by epochs. A reader announces the epoch in
+ * which it pinned. A replaced version is tagged with the epoch in which it
+ * was replaced. It is freed once every reader that is still pinned has
+ * announced a later epoch, because such a reader can only have seen a newer
+ * version.
+ *
+ * Publishing copies the array of vertex pointers, so it costs O(V) however
+ * small the change. Writers should batch updates into drafts.
+ */
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "graph.h"
+
+#ifndef __Graph_Snapshot_header
+#define __Graph_Snapshot_header
+
+#define MAX_SNAPSHOT_READERS 64  // most readers registered at once
+
+typedef struct graph_version GraphVersion;
+typedef struct graph_snapshots GraphSnapshots;
+
+typedef struct graph_draft {
+  GraphSnapshots* snapshots;  // the snapshots this draft will be added to
+  GraphVersion* version;      // the version being built
+} GraphDraft;
+
+/* Returns new snapshots whose first version is 'graph', or NULL if memory
+ * could not be allocated. The snapshots take over 'graph': it must not be
+ * used directly, changed or deleted afterwards. They free it with
+ * 'deleteOriginal': deleteGraph, or deleteBuiltGraph for a graph from
+ * buildGraph.
+ */
+GraphSnapshots* newGraphSnapshots(Graph* graph,
+                                  void (*deleteOriginal)(Graph* graph));
+
+/* Frees all versions and all memory allocated for 'snapshots', including
+ * the graph it was created with.
+ * Precondition: no reader has a version pinned and no draft is open
+ */
+void deleteGraphSnapshots(GraphSnapshots* snapshots);
+
+/***** Readers **************************************************************/
+
+/* Registers a reader of 'snapshots' and returns its ID, or -1 if
+ * MAX_SNAPSHOT_READERS are already registered. Each reader is used by one
+ * thread at a time.
+ */
+int registerSnapshotReader(GraphSnapshots* snapshots);
+
+/* Gives back the reader ID 'reader'.
+ * Precondition: 'reader' has no version pinned
+ */
+void unregisterSnapshotReader(GraphSnapshots* snapshots, int reader);
+
+/* Pins the current version of 'snapshots' for reader 'reader' and returns
+ * it. It stays valid and unchanged until unpinSnapshot.
+ * Precondition: 'reader' has no version pinned
+ */
+Graph* pinSnapshot(GraphSnapshots* snapshots, int reader);
+
+/* Releases the version pinned by reader 'reader'. */
+void unpinSnapshot(GraphSnapshots* snapshots, int reader);
+
+/* Returns the number of the current version: 0 for the graph the snapshots
+ * were created with, one more for every published draft.
+ */
+long currentSnapshotNumber(GraphSnapshots* snapshots);
+
+/***** Writers **************************************************************/
+
+/* Starts a new draft of the next version of 'snapshots'; other writers wait
+ * until it is published or discarded. Returns false, with no draft open, if
+ * memory could not be allocated.
+ */
+bool beginDraft(GraphSnapshots* snapshots, GraphDraft* draft);
+
+/* Gives the edge from 'fromVertex' to 'toVertex' the weight 'weight' in
+ * 'draft', adding the edge if there is none. In a symmetric graph (see
+ * graph_symmetric.h) the edge is set in both directions.
+ * Returns false if a vertex is not valid, the weight is negative, or memory
+ * could not be allocated; the draft is then unchanged.
+ */
+bool draftSetEdge(GraphDraft* draft, int fromVertex, int toVertex,
+                  int weight);
+
+/* Makes 'draft' the current version, frees every old version that no
+ * reader can still see, and returns the new version's number.
+ */
+long publishDraft(GraphDraft* draft);
+
+/* Throws 'draft' away without publishing it. */
+void discardDraft(GraphDraft* draft);
+
+/* Frees every old version that no reader can still see, and returns how
+ * many old versions are still waiting for readers.
+ */
+int reclaimSnapshots(GraphSnapshots* snapshots);
+
+#endif
@@ -0,0 +1,58 @@
+/*
+ * Header file for symmetric (undirected) graphs: Graphs in which every Edge
+ * is stored once and shared by the adjacency lists of both of its endpoints.
+ *
+ * Nothing in a Graph records that it is symmetric. A shared Edge is
+ * recognized by being in the list of a vertex other than its 'fromVertex',
+ * so code walking an adjacency list uses otherEndpoint rather than
+ * 'toVertex', and deleteGraph frees every Edge from the list of its
+ * 'fromVertex' only. In a symmetric graph 'numEdges' counts each undirected
+ * edge once.
+ */
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "graph.h"
+
+#ifndef __Graph_Symmetric_header
+#define __Graph_Symmetric_header
+
+/* Returns the endpoint of 'edge' that is not 'vertex' (or 'vertex' itself for
+ * a self-loop). Use this rather than 'toVertex' when walking an adjacency
+ * list, since in a symmetric graph the shared Edge may point back at us.
+ * Precondition: 'vertex' is an endpoint of 'edge'
+ */
+int otherEndpoint(Edge* edge, int vertex);
+
+/* Returns true iff Graph 'graph' is symmetric. Only the first vertex with an
+ * edge to another vertex is looked at, so this takes O(1) for most graphs.
+ * A graph with no such edge is reported as not symmetric.
+ */
+bool isSymmetricGraph(Graph* graph);
+
+/* Returns a newly created symmetric Graph with 'numVertices' vertices, all
+ * already present with empty adjacency lists.
+ * Precondition: numVertices >= 0
+ */
+Graph* newSymmetricGraph(int numVertices);
+
+/* Adds the undirected edge {'u', 'v'} with weight 'weight' to the symmetric
+ * Graph 'graph' in O(1) and returns it, or NULL if memory could not be
+ * allocated. The Edge is stored once, with 'fromVertex' the smaller
+ * endpoint, and linked into the adjacency lists of both 'u' and 'v'. Parallel
+ * edges are kept; mergeSymmetricEdges removes them all at once.
+ * Precondition: 'graph' is symmetric; 0 <= u, v < graph->numVertices
+ */
+Edge* addSymmetricEdge(Graph* graph, int u, int v, int weight);
+
+/* Merges the parallel edges of the symmetric Graph 'graph' in O(V + E): of
+ * the edges with the same endpoints only the first found is kept, with the
+ * smallest of their weights. Returns false, with 'graph' unchanged, if memory
+ * could not be allocated.
+ * Precondition: no edge of 'graph' has a negative weight
+ */
+bool mergeSymmetricEdges(Graph* graph);
+
+#endif
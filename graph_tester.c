@@ -6,10 +6,32 @@
  *
  *  ---------------------------------------------------------------------------
  *   Compile:
- *   gcc -Wall -Werror graph.c minheap.c graph_algos.c graph_tester.c -o tester
+ *   gcc -Wall -Werror graph.c minheap.c graph_algos.c graph_bfs.c \
+ *       graph_batch.c graph_build.c graph_ids.c graph_io.c graph_many.c \
+ *       graph_output.c graph_plan.c graph_query.c graph_view.c parallel.c \
+ *       graph_tester.c -o tester -lpthread
  *
  *   Run:
  *   ./tester sample_input.txt
+ *   ./tester -u sample_input.txt    (undirected: store each edge once)
+ *   ./tester -e edges.txt           (edge stream: "from to weight" lines)
+ *   ./tester -e -u edges.txt        (edge stream, add both directions)
+ *   ./tester -x edges.txt           (edge stream with any 64-bit vertex IDs,
+ *                                    printed back as they were given; the
+ *                                    runs start from the smallest ID)
+ *   ./tester -b sample_input.txt    (binary output; see graph_output.h)
+ *   ./tester -q queries.txt input.txt
+ *                                   (answer a batch of queries, one answer
+ *                                    line each; see graph_batch.h)
+ *   ./tester -m graphs.txt          (many graphs one after another, one
+ *                                    result line each; see graph_many.h)
+ *   ./tester -P auto sample_input.txt
+ *                                   (let the planner choose the engines for
+ *                                    the runs, and log its choice to stderr;
+ *                                    or name them, as in "sssp=radix,mst=
+ *                                    dense"; see graph_plan.h)
+ *   ./tester -t 4 -p ...            (4 worker threads, each pinned to a
+ *                                    CPU; default: one per CPU, unpinned)
  *
  *   SEE FILE expected_output.txt FOR EXPECTED OUTPUT
  *
@@ -23,236 +45,276 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
+#include <unistd.h>
 
 #include "graph.h"
 #include "graph_algos.h"
+#include "graph_batch.h"
+#include "graph_build.h"
+#include "graph_ids.h"
+#include "graph_io.h"
+#include "graph_many.h"
+#include "graph_output.h"
+#include "graph_plan.h"
 #include "minheap.h"
-
-#define MAX_LIMIT 1024
-
-/* functions to create a Graph from a file */
-Graph* createGraph(FILE* f);
-int readVertexID(char* token, int numVertices);
-int readWeight(char* token);
-EdgeList* addEdge(EdgeList* head, int fromVertex, int toVertex, int weight);
-bool updateVertex(Graph* graph, char* line);
+#include "parallel.h"
 
 /* run and print */
-void runPrim(Graph* graph, int startVertex);
-void runDijkstra(Graph* graph, int startVertex);
-int printTree(Edge* mst, int numTreeEdges);
-void printPaths(EdgeList** paths, int numVertices);
+void runPrim(Output* out, Graph* graph, int startVertex,
+             GraphProfile* profile, Plan* plan);
+void runDijkstra(Output* out, Graph* graph, int startVertex,
+                 GraphProfile* profile, Plan* plan);
+int runBatch(Graph* graph, const char* queryFile, int numThreads);
+int runMany(const char* graphFile, int numThreads);
+
+/* the ID 'out' prints for vertex 'vertex' */
+long long printedId(Output* out, int vertex);
 
 /* cleanup */
 void freePaths(EdgeList** paths, int numVertices);
 
 int main(int argc, char* argv[]) {
-  if (argc == 1) {
+  bool symmetric = false;
+  bool edgeStream = false;
+  bool externalIds = false;
+  bool binary = false;
+  bool manyGraphs = false;
+  const char* queryFile = NULL;
+  int numThreads = 0;
+  bool pinThreads = false;
+  Plan planned = defaultPlan();
+  Plan* plan = NULL;
+  int arg = 1;
+  for (; arg < argc && argv[arg][0] == '-'; arg++) {
+    if (strcmp(argv[arg], "-u") == 0) {
+      symmetric = true;
+    } else if (strcmp(argv[arg], "-e") == 0) {
+      edgeStream = true;
+    } else if (strcmp(argv[arg], "-x") == 0) {
+      externalIds = true;
+    } else if (strcmp(argv[arg], "-b") == 0) {
+      binary = true;
+    } else if (strcmp(argv[arg], "-m") == 0) {
+      manyGraphs = true;
+    } else if (strcmp(argv[arg], "-q") == 0 && arg + 1 < argc) {
+      queryFile = argv[++arg];
+    } else if (strcmp(argv[arg], "-t") == 0 && arg + 1 < argc) {
+      numThreads = atoi(argv[++arg]);
+    } else if (strcmp(argv[arg], "-p") == 0) {
+      pinThreads = true;
+    } else if (strcmp(argv[arg], "-P") == 0 && arg + 1 < argc) {
+      if (strcmp(argv[++arg], "auto") != 0 &&
+          !parsePlan(argv[arg], &planned)) {
+        printf("Unknown plan: %s. Please, try again.\n", argv[arg]);
+        return 1;
+      }
+      planned.log = stderr;
+      plan = &planned;
+    } else {
+      printf("Unknown option: %s. Please, try again.\n", argv[arg]);
+      return 1;
+    }
+  }
+  if (arg >= argc) {
     printf("You did not specify an input file. Please, try again.\n");
     return 1;
   }
-  FILE* f = fopen(argv[1], "r");
+  if (externalIds && queryFile != NULL) {
+    printf("Batches of queries need dense vertex IDs. Please, try again.\n");
+    return 1;
+  }
+  if (manyGraphs && (symmetric || edgeStream || externalIds || binary ||
+                     queryFile != NULL || plan != NULL)) {
+    printf("Many graphs are read and run only one way. Please, try "
+           "again.\n");
+    return 1;
+  }
+  configureScheduler(numThreads, pinThreads);
+  if (manyGraphs) return runMany(argv[arg], numThreads);
+  if (planned.numThreads == 0) planned.numThreads = numThreads;
+  FILE* f = fopen(argv[arg], "r");
   if (f == NULL) {
-    fprintf(stderr, "Unable to open the specified input file: %s\n", argv[1]);
+    fprintf(stderr, "Unable to open the specified input file: %s\n",
+            argv[arg]);
     return 1;
   }
 
-  Graph* graph = createGraph(f);
+  IdMap* ids = NULL;
+  Graph* graph = externalIds ? createGraphWithIds(f, symmetric, numThreads,
+                                                  &ids)
+                 : edgeStream ? createGraphFromEdges(f, symmetric)
+                              : createGraph(f, symmetric);
   fclose(f);
+  // Edge streams are loaded with buildGraph.
+  void (*freeGraph)(Graph*) =
+      externalIds || edgeStream ? deleteBuiltGraph : deleteGraph;
+
+  if (queryFile != NULL) {
+    int status = runBatch(graph, queryFile, numThreads);
+    freeGraph(graph);
+    return status;
+  }
 
-  printGraph(graph);
-
-  runPrim(graph, 0);  // try other vertices!
-  runDijkstra(graph, 0);
+  Output* out = newOutput(STDOUT_FILENO, 0, binary);
+  if (out == NULL) {
+    freeGraph(graph);
+    deleteIdMap(ids);
+    return 1;
+  }
+  if (ids != NULL) out->externalIds = ids->externalIds;
+  outputGraph(out, graph);
+
+  // Profile and plan once, for every run on this graph.
+  GraphProfile profile;
+  if (plan != NULL && graph != NULL) {
+    profileGraph(graph, &profile);
+    planned = planAlgorithms(&profile, planned);
+  }
+  runPrim(out, graph, 0, &profile, plan);  // try other vertices!
+  runDijkstra(out, graph, 0, &profile, plan);
 
-  deleteGraph(graph);
-  return 0;
+  bool ok = deleteOutput(out);
+  freeGraph(graph);
+  deleteIdMap(ids);
+  return ok ? 0 : 1;
 }
 
-/* Runs Prim's algorithm on 'graph' starting at vertex 'startVertex',
- * and prints the result.
+/* Runs Prim's algorithm on 'graph' starting at vertex 'startVertex', with
+ * the engines of 'plan' for a graph with profile 'profile' unless 'plan' is
+ * NULL, and prints the result.
  */
-void runPrim(Graph* graph, int startVertex) {
+void runPrim(Output* out, Graph* graph, int startVertex,
+             GraphProfile* profile, Plan* plan) {
   if (graph == NULL) return;
 
   int numTreeEdges = graph->numVertices - 1;
-  Edge* mst = getMSTprim(graph, startVertex);
+  Edge* mst = plan != NULL ? getMSTplanned(graph, startVertex, profile, plan)
+                           : getMSTprim(graph, startVertex);
   if (mst == NULL) return;
 
-  printf("Prim's from %d returned this MST:\n", startVertex);
-  int totalWeight = printTree(mst, numTreeEdges);
-  printf("Total weight: %d\n\n", totalWeight);
+  char heading[96];
+  snprintf(heading, sizeof(heading), "Prim's from %lld returned this MST:\n",
+           printedId(out, startVertex));
+  outputText(out, heading);
+  int totalWeight = outputTree(out, mst, numTreeEdges);
+  outputText(out, "Total weight: ");
+  outputInt(out, totalWeight);
+  outputText(out, "\n\n");
 
   free(mst);
 }
 
 /* Runs Dijkstra's algorithm on 'graph' starting at vertex 'startVertex',
- * runs getShortestPaths on the resulting distance tree, and prints all results.
+ * with the engines of 'plan' for a graph with profile 'profile' unless
+ * 'plan' is NULL, runs getShortestPaths on the resulting distance tree, and
+ * prints all results.
  */
-void runDijkstra(Graph* graph, int startVertex) {
+void runDijkstra(Output* out, Graph* graph, int startVertex,
+                 GraphProfile* profile, Plan* plan) {
   if (graph == NULL) return;
 
-  Edge* distanceTree = getDistanceTreeDijkstra(graph, startVertex);
+  Edge* distanceTree =
+      plan != NULL ? getDistanceTreePlanned(graph, startVertex, profile, plan)
+                   : getDistanceTreeDijkstra(graph, startVertex);
+  if (distanceTree == NULL) {
+    fprintf(stderr, "The engine does not fit this graph.\n");
+    return;
+  }
 
-  printf("Dijkstra's from %d returned this distance tree:\n", startVertex);
-  printTree(distanceTree, graph->numVertices);
-  printf("\n");
+  char heading[96];
+  snprintf(heading, sizeof(heading),
+           "Dijkstra's from %lld returned this distance tree:\n",
+           printedId(out, startVertex));
+  outputText(out, heading);
+  outputTree(out, distanceTree, graph->numVertices);
+  outputText(out, "\n");
 
   EdgeList** paths =
       getShortestPaths(distanceTree, graph->numVertices, startVertex);
 
-  printf("getShortestPaths from %d produced these paths:\n", startVertex);
-  printPaths(paths, graph->numVertices);
+  snprintf(heading, sizeof(heading),
+           "getShortestPaths from %lld produced these paths:\n",
+           printedId(out, startVertex));
+  outputText(out, heading);
+  outputPaths(out, paths, graph->numVertices);
 
   freePaths(paths, graph->numVertices);
   free(paths);
   free(distanceTree);
 }
 
-/* Creates and returns a new Graph from the information in the file 'f'.
- */
-Graph* createGraph(FILE* f) {
-  char line[MAX_LIMIT];
-
-  if (!fgets(line, MAX_LIMIT, f)) {  // read first line
-    printf("Could not read number of vertices from input file. Giving up.\n");
-    return NULL;
-  }
-
-  int numVertices = atoi(line);  // first line is number of vertices
-  if (numVertices < 0) {
-    printf("Number of vertices must be positive. Read: %d. Giving up.\n",
-           numVertices);
-    return NULL;
-  }
-
-  Graph* graph = newGraph(numVertices);
-  if (graph == NULL) {
-    printf("Could not create a new graph. Giving up.\n");
-    return NULL;
-  }
-
-  while (fgets(line, MAX_LIMIT, f)) {  // read next line
-    if (!updateVertex(graph, line)) {  // update vertex info from line
-      printf("Could not get vertex info from a line. Giving up.\n");
-      deleteGraph(graph);
-      return NULL;
-    }
-  }
-  return graph;
-}
-
-/* Updates / populates the corresponding vertex in 'graph' using information
- * from the line 'line' in an input file. Returns true iff update was
- * successful.
+/* Answers the queries in the file 'queryFile' on 'graph' with 'numThreads'
+ * threads (0 for one per worker thread), printing one line per query, and
+ * reports the throughput on stderr. Returns the exit status for main.
  */
-bool updateVertex(Graph* graph, char* line) {
-  if (graph == NULL) return false;
-
-  // parse vertex ID
-  char* token = strtok(line, " ");
-  int id = readVertexID(token, graph->numVertices);
-  if (id == -1) return false;
+int runBatch(Graph* graph, const char* queryFile, int numThreads) {
+  if (graph == NULL) return 1;
 
-  // parse adjacency list
-  EdgeList* head = NULL;
-  int toVertex = 0;
-  int weight = 0;
-  token = strtok(NULL, " ");
-  while (token) {
-    toVertex = readVertexID(token, graph->numVertices);
-    if (toVertex == -1) return false;
-
-    token = strtok(NULL, " ");
-    weight = readWeight(token);
-    if (weight == -1) return false;
-
-    head = addEdge(head, id, toVertex, weight);
-    if (head == NULL) return false;
-    graph->numEdges++;
-
-    token = strtok(NULL, " ");
-  }
-  graph->vertices[id] = newVertex(id, NULL, head);  // no values in our file
-
-  return true;
-}
-
-/* Prepends a new Edge from vertex 'fromVertex' to vertex 'toVertex' with
- * weight 'weight', to the edge list 'head' and returns the result.
- */
-EdgeList* addEdge(EdgeList* head, int fromVertex, int toVertex, int weight) {
-  Edge* edge = newEdge(fromVertex, toVertex, weight);
-  if (edge == NULL) {
-    printf("Could not allocate a new Edge. Giving up.\n");
-    return NULL;
+  FILE* f = fopen(queryFile, "r");
+  if (f == NULL) {
+    fprintf(stderr, "Unable to open the specified query file: %s\n",
+            queryFile);
+    return 1;
   }
-  EdgeList* edgeList = newEdgeList(edge, head);
-  if (edgeList == NULL) {
-    printf("Could not allocate a new EdgeList. Giving up.\n");
-    return NULL;
+  long numQueries;
+  Query* queries = readQueries(f, &numQueries);
+  fclose(f);
+  if (queries == NULL) {
+    fprintf(stderr, "Could not read the queries. Giving up.\n");
+    return 1;
   }
-  return edgeList;
-}
 
-/* Parses and validates a vertex ID for a graph with 'numVertices' vertices,
- * from 'token'. Returns the ID if validation is successful, and -1 if it is
- * not.
- */
-int readVertexID(char* token, int numVertices) {
-  if (!token) {
-    printf("Could not read vertex ID from input file. Giving up.\n");
-    return -1;
-  }
-  int id = atoi(token);
-  if (id < 0 || id >= numVertices) {
-    printf("Invalid vertex ID: %d. Giving up.\n", id);
-    return -1;
-  }
-  return id;
+  if (numThreads < 1) numThreads = defaultThreadCount();
+  struct timespec start, end;
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  long answered = runQueries(graph, queries, numQueries, stdout, numThreads);
+  fflush(stdout);
+  clock_gettime(CLOCK_MONOTONIC, &end);
+
+  double elapsed =
+      (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+  fprintf(stderr, "%ld queries (%ld errors) with %d threads in %.3f s: "
+          "%.0f queries/s\n", numQueries, numQueries - answered, numThreads,
+          elapsed, elapsed > 0 ? numQueries / elapsed : 0.0);
+  free(queries);
+  return 0;
 }
 
-/* Parses and validates an edge weight from 'token'. Returns the weight if
- * validation is successful, and -1 if it not.
+/* Runs every graph in the multi-graph file 'graphFile' with 'numThreads'
+ * threads (0 for one per worker thread), printing one line per graph, and
+ * reports the throughput on stderr. Returns the exit status for main.
  */
-int readWeight(char* token) {
-  if (!token) {
-    printf("Could not read edge weight from input file. Giving up.\n");
-    return -1;
-  }
-  int weight = atoi(token);
-  if (weight < 0) {
-    printf("Invalid edge weight: %d. Giving up.\n", weight);
-    return -1;
+int runMany(const char* graphFile, int numThreads) {
+  FILE* f = fopen(graphFile, "r");
+  if (f == NULL) {
+    fprintf(stderr, "Unable to open the specified input file: %s\n",
+            graphFile);
+    return 1;
   }
-  return weight;
-}
 
-/* Prints the spanning tree 'tree' with 'numTreeEdges' edges. Returns the
- * total weight of 'tree'.
- */
-int printTree(Edge* tree, int numTreeEdges) {
-  if (tree == NULL) return -1;
+  if (numThreads < 1) numThreads = defaultThreadCount();
+  struct timespec start, end;
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  long numErrors;
+  long numGraphs = runManyGraphs(f, stdout, numThreads, &numErrors);
+  fflush(stdout);
+  clock_gettime(CLOCK_MONOTONIC, &end);
+  fclose(f);
 
-  int totalWeight = 0;
-  for (int i = 0; i < numTreeEdges; i++) {
-    printEdge(&tree[i]);
-    printf("\n");
-    totalWeight += tree[i].weight;
-  }
-  return totalWeight;
+  double elapsed =
+      (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+  fprintf(stderr, "%ld graphs (%ld errors) with %d threads in %.3f s: "
+          "%.0f graphs/s\n", numGraphs, numErrors, numThreads, elapsed,
+          elapsed > 0 ? numGraphs / elapsed : 0.0);
+  return 0;
 }
 
-/* Prints all adjacency lists in the array 'paths' of 'numVertices' lists.
+/* Returns the ID 'out' prints for vertex 'vertex': its external ID if 'out'
+ * has them.
  */
-void printPaths(EdgeList** paths, int numVertices) {
-  if (paths == NULL) return;
-
-  for (int i = 0; i < numVertices; i++) {
-    printf("From vertex %d: ", i);
-    printEdgeList(paths[i]);
-    printf("\n");
-  }
+long long printedId(Output* out, int vertex) {
+  return out->externalIds != NULL ? out->externalIds[vertex] : vertex;
 }
 
 /* Frees memory for all adjacency lists in the array 'paths' of 'numVertices'
@@ -262,3 +324,4 @@ void freePaths(EdgeList** paths, int numVertices) {
   if (paths == NULL) return;
   for (int i = 0; i < numVertices; i++) deleteEdgeList(paths[i]);
 }
+
@@ -0,0 +1,193 @@
+/*
+ * Graph views: a Graph with some vertices and edges left out.
+ */
+
+#include <limits.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "graph_symmetric.h"
+#include "graph_view.h"
+
+/* Returns a newly created view of Graph 'graph' with every vertex and edge
+ * in it, or NULL if memory could not be allocated.
+ */
+GraphView *newGraphView(Graph *graph)
+{
+  GraphView *view = malloc(sizeof(GraphView));
+  if (view == NULL)
+  {
+    return NULL;
+  }
+  view->graph = graph;
+  view->vertexMask = NULL;
+  view->excludedEdges = NULL;
+  view->numExcludedEdges = 0;
+  view->excludedCapacity = 0;
+  view->maxWeight = INT_MAX;
+  view->filter = NULL;
+  view->context = NULL;
+  return view;
+}
+
+/* Frees all memory allocated for 'view', but not its graph. */
+void deleteGraphView(GraphView *view)
+{
+  if (view == NULL)
+  {
+    return;
+  }
+  free(view->vertexMask);
+  free(view->excludedEdges);
+  free(view);
+}
+
+/* Leaves vertex 'vertex' out of 'view'. Returns false if 'vertex' is not
+ * valid or memory could not be allocated.
+ */
+bool excludeVertex(GraphView *view, int vertex)
+{
+  if (vertex < 0 || vertex >= view->graph->numVertices)
+  {
+    return false;
+  }
+  if (view->vertexMask == NULL)
+  {
+    size_t numBytes = ((size_t)view->graph->numVertices + 7) / 8;
+    view->vertexMask = malloc(numBytes);
+    if (view->vertexMask == NULL)
+    {
+      return false;
+    }
+    memset(view->vertexMask, 0xFF, numBytes);
+  }
+  view->vertexMask[vertex / 8] &= ~(1u << (vertex % 8));
+  return true;
+}
+
+/* Returns the slot at which the search for 'edge' starts in a hash set with
+ * 'mask' + 1 slots.
+ */
+static unsigned long hashEdge(Edge *edge, unsigned long mask)
+{
+  unsigned long long h = (uintptr_t)edge >> 2;  // Edges are 4-aligned
+  h *= 0x9E3779B97F4A7C15ull;
+  return (unsigned long)(h ^ h >> 32) & mask;
+}
+
+/* Adds 'edge' to the excluded edges of 'view', which have room for it. */
+static void addExcluded(GraphView *view, Edge *edge)
+{
+  unsigned long mask = view->excludedCapacity - 1;
+  for (unsigned long h = hashEdge(edge, mask);; h = (h + 1) & mask)
+  {
+    if (view->excludedEdges[h] == edge)
+    {
+      return;
+    }
+    if (view->excludedEdges[h] == NULL)
+    {
+      view->excludedEdges[h] = edge;
+      view->numExcludedEdges++;
+      return;
+    }
+  }
+}
+
+/* Leaves 'edge' out of 'view'. The set of excluded edges is kept at most
+ * 3/4 full. Returns false if memory could not be allocated.
+ */
+bool excludeEdge(GraphView *view, Edge *edge)
+{
+  if (4L * (view->numExcludedEdges + 1) > 3L * view->excludedCapacity)
+  {
+    int capacity = view->excludedCapacity > 0 ? 2 * view->excludedCapacity
+                                              : 16;
+    Edge **old = view->excludedEdges;
+    int oldCapacity = view->excludedCapacity;
+    view->excludedEdges = calloc(capacity, sizeof(Edge *));
+    if (view->excludedEdges == NULL)
+    {
+      view->excludedEdges = old;
+      return false;
+    }
+    view->excludedCapacity = capacity;
+    view->numExcludedEdges = 0;
+    for (int i = 0; i < oldCapacity; i++)
+    {
+      if (old[i] != NULL)
+      {
+        addExcluded(view, old[i]);
+      }
+    }
+    free(old);
+  }
+  addExcluded(view, edge);
+  return true;
+}
+
+/* Leaves every edge from 'u' to 'v' out of 'view' and returns their number,
+ * or -1 if a vertex is not valid or memory could not be allocated.
+ */
+int excludeEdgesBetween(GraphView *view, int u, int v)
+{
+  Graph *graph = view->graph;
+  if (u < 0 || u >= graph->numVertices || v < 0 || v >= graph->numVertices)
+  {
+    return -1;
+  }
+  int count = 0;
+  for (EdgeList *adjList = graph->vertices[u]->adjList; adjList != NULL;
+       adjList = adjList->next)
+  {
+    if (otherEndpoint(adjList->edge, u) == v)
+    {
+      if (!excludeEdge(view, adjList->edge))
+      {
+        return -1;
+      }
+      count++;
+    }
+  }
+  return count;
+}
+
+/* Returns true iff 'vertex' is a valid vertex in 'view'. */
+bool viewHasVertex(GraphView *view, int vertex)
+{
+  return vertex >= 0 && vertex < view->graph->numVertices &&
+         (view->vertexMask == NULL ||
+          (view->vertexMask[vertex / 8] >> (vertex % 8) & 1));
+}
+
+/* Returns true iff the edge is in the set of excluded edges of 'view'. */
+static bool isExcluded(GraphView *view, Edge *edge)
+{
+  unsigned long mask = view->excludedCapacity - 1;
+  for (unsigned long h = hashEdge(edge, mask);; h = (h + 1) & mask)
+  {
+    if (view->excludedEdges[h] == edge)
+    {
+      return true;
+    }
+    if (view->excludedEdges[h] == NULL)
+    {
+      return false;
+    }
+  }
+}
+
+/* Returns true iff 'edge', scanned from its endpoint 'fromVertex', is in
+ * 'view'. The cheap tests go first, and the set of excluded edges is only
+ * probed if it holds any.
+ */
+bool viewHasEdge(GraphView *view, Edge *edge, int fromVertex)
+{
+  return edge->weight <= view->maxWeight &&
+         (view->vertexMask == NULL ||
+          (viewHasVertex(view, fromVertex) &&
+           viewHasVertex(view, otherEndpoint(edge, fromVertex)))) &&
+         (view->numExcludedEdges == 0 || !isExcluded(view, edge)) &&
+         (view->filter == NULL || view->filter(edge, fromVertex,
+                                               view->context));
+}
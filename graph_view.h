@@ -0,0 +1,77 @@
+/*
+ * Header file for graph views: a Graph seen with some vertices and edges
+ * left out, for searches under constraints (closed roads, weight limits,
+ * vertices to avoid) without building a new Graph.
+ *
+ * A view never copies the graph. It is created in O(1); excluding a vertex
+ * costs O(1) after a bitmask of numVertices bits is allocated on the first
+ * one, and excluding an edge adds its pointer to a hash set. The algorithms
+ * in graph_algos_view.h take a view and ask it about every edge they scan.
+ *
+ * In a symmetric graph an Edge is shared by both of its directions, so
+ * excluding it closes both; in a directed graph each direction is its own
+ * Edge.
+ */
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "graph.h"
+
+#ifndef __Graph_View_header
+#define __Graph_View_header
+
+/* Decides whether 'edge', scanned from vertex 'fromVertex', is in a view. */
+typedef bool (*EdgeFilter)(Edge* edge, int fromVertex, void* context);
+
+typedef struct graph_view {
+  Graph* graph;                  // the graph seen through this view
+  unsigned char* vertexMask;     // bit v % 8 of vertexMask[v / 8] is set iff
+                                 //   v is in the view; NULL if all are
+  Edge** excludedEdges;          // hash set of the excluded Edges; empty
+                                 //   slots are NULL
+  int numExcludedEdges;          // the number of Edges in the set
+  int excludedCapacity;          // the number of slots, 0 or a power of 2
+  int maxWeight;                 // edges heavier than this are left out;
+                                 //   INT_MAX (the default) keeps all
+  EdgeFilter filter;             // if not NULL, edges for which it returns
+                                 //   false are left out
+  void* context;                 // passed to 'filter'
+} GraphView;
+
+/* Returns a newly created view of Graph 'graph' with every vertex and edge
+ * in it, or NULL if memory could not be allocated. 'maxWeight', 'filter'
+ * and 'context' may be set directly. The view must be deleted before
+ * 'graph' is.
+ */
+GraphView* newGraphView(Graph* graph);
+
+/* Frees all memory allocated for 'view', but not its graph. */
+void deleteGraphView(GraphView* view);
+
+/* Leaves vertex 'vertex', and so every edge at it, out of 'view'. Returns
+ * false if 'vertex' is not valid or memory could not be allocated.
+ */
+bool excludeVertex(GraphView* view, int vertex);
+
+/* Leaves 'edge', an Edge of the graph of 'view', out of 'view'. Returns
+ * false if memory could not be allocated.
+ */
+bool excludeEdge(GraphView* view, Edge* edge);
+
+/* Leaves every edge from 'u' to 'v' out of 'view' and returns their number,
+ * or -1 if a vertex is not valid or memory could not be allocated.
+ */
+int excludeEdgesBetween(GraphView* view, int u, int v);
+
+/* Returns true iff 'vertex' is a valid vertex in 'view'. */
+bool viewHasVertex(GraphView* view, int vertex);
+
+/* Returns true iff 'edge', scanned from its endpoint 'fromVertex', is in
+ * 'view': both endpoints are, it is not excluded, not heavier than
+ * view->maxWeight, and view->filter accepts it.
+ */
+bool viewHasEdge(GraphView* view, Edge* edge, int fromVertex);
+
+#endif
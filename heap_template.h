@@ -0,0 +1,142 @@
+/*
+ * Template for d-ary min-heaps with decrease-key, specialized at compile
+ * time for one key type, one ID type and one arity.
+ *
+ * There is no include guard: every inclusion generates one more heap. Define
+ * these first; they are undefined again at the end:
+ *   HEAP_PREFIX   prefix of the generated names, e.g. dist16 for the type
+ *                 dist16_Heap and the functions dist16_heapPush, ...
+ *   HEAP_KEY      the key type
+ *   HEAP_KEY_MAX  its largest value, which no key may have
+ *   HEAP_ID       an unsigned ID type; IDs must be below its largest value
+ *   HEAP_ARITY    the number of children per node
+ * The functions are static, for the file that includes the template.
+ *
+ * Compared with MinHeap, the key, ID and arity are constants of the
+ * generated code, not run-time values: the loop over the children of a node
+ * is unrolled, and picking the smallest child compiles to conditional moves
+ * rather than branches. The nodes are followed by HEAP_ARITY nodes with key
+ * HEAP_KEY_MAX, and every node past the last one has that key, so no child
+ * needs a bounds check. Narrow keys and IDs keep nodes small: with 16-bit
+ * keys and IDs a node is 4 bytes, against 8 for a HeapNode.
+ */
+
+#include <stdbool.h>
+#include <stdlib.h>
+
+#define HEAP_CAT2(a, b) a##_##b
+#define HEAP_CAT(a, b) HEAP_CAT2(a, b)
+#define HEAP_FN(name) HEAP_CAT(HEAP_PREFIX, name)
+#define HEAP_NONE ((HEAP_ID)-1)  // position of an ID that is not in the heap
+
+typedef struct {
+  HEAP_KEY key;
+  HEAP_ID id;
+} HEAP_FN(HeapNode);
+
+typedef struct {
+  int size;                  // the number of nodes in this heap
+  HEAP_FN(HeapNode)* nodes;  // the heap, then HEAP_ARITY or more nodes with
+                             //   key HEAP_KEY_MAX
+  HEAP_ID* positions;        // positions[id]: index of id's node in 'nodes',
+                             //   or HEAP_NONE
+} HEAP_FN(Heap);
+
+/* Makes 'heap' an empty heap for IDs below 'capacity'. Returns false if
+ * memory could not be allocated.
+ * Precondition: capacity < HEAP_NONE
+ */
+static bool HEAP_FN(heapInit)(HEAP_FN(Heap)* heap, int capacity) {
+  heap->size = 0;
+  heap->nodes = malloc(sizeof(HEAP_FN(HeapNode)) * (capacity + HEAP_ARITY));
+  heap->positions = malloc(sizeof(HEAP_ID) * (capacity > 0 ? capacity : 1));
+  if (heap->nodes == NULL || heap->positions == NULL) {
+    free(heap->nodes);
+    free(heap->positions);
+    return false;
+  }
+  for (int i = 0; i < capacity + HEAP_ARITY; i++) {
+    heap->nodes[i].key = HEAP_KEY_MAX;
+    heap->nodes[i].id = HEAP_NONE;
+  }
+  for (int id = 0; id < capacity; id++) {
+    heap->positions[id] = HEAP_NONE;
+  }
+  return true;
+}
+
+/* Frees the memory of 'heap'. */
+static void HEAP_FN(heapFree)(HEAP_FN(Heap)* heap) {
+  free(heap->nodes);
+  free(heap->positions);
+}
+
+/* Moves 'node' up from index 'i' of 'heap' to where it belongs. */
+static void HEAP_FN(heapSiftUp)(HEAP_FN(Heap)* heap, int i,
+                                HEAP_FN(HeapNode) node) {
+  while (i > 0) {
+    int parent = (i - 1) / HEAP_ARITY;
+    if (!(node.key < heap->nodes[parent].key)) break;
+    heap->nodes[i] = heap->nodes[parent];
+    heap->positions[heap->nodes[i].id] = i;
+    i = parent;
+  }
+  heap->nodes[i] = node;
+  heap->positions[node.id] = i;
+}
+
+/* Moves 'node' down from index 'i' of 'heap' to where it belongs. */
+static void HEAP_FN(heapSiftDown)(HEAP_FN(Heap)* heap, int i,
+                                  HEAP_FN(HeapNode) node) {
+  for (;;) {
+    int first = i * HEAP_ARITY + 1;
+    if (first >= heap->size) break;
+    int best = first;
+    for (int c = 1; c < HEAP_ARITY; c++) {
+      // Past the last node the keys are HEAP_KEY_MAX: never picked.
+      best = heap->nodes[first + c].key < heap->nodes[best].key ? first + c
+                                                                 : best;
+    }
+    if (!(heap->nodes[best].key < node.key)) break;
+    heap->nodes[i] = heap->nodes[best];
+    heap->positions[heap->nodes[i].id] = i;
+    i = best;
+  }
+  heap->nodes[i] = node;
+  heap->positions[node.id] = i;
+}
+
+/* Inserts 'id' into 'heap' with key 'key', or lowers its key to 'key' if it
+ * is in 'heap' already.
+ * Precondition: key < HEAP_KEY_MAX, and not above the key 'id' has in 'heap'
+ */
+static void HEAP_FN(heapPush)(HEAP_FN(Heap)* heap, HEAP_KEY key, HEAP_ID id) {
+  HEAP_FN(HeapNode) node = {key, id};
+  HEAP_ID position = heap->positions[id];
+  int i = position == HEAP_NONE ? heap->size++ : (int)position;
+  HEAP_FN(heapSiftUp)(heap, i, node);
+}
+
+/* Removes and returns the node with the smallest key in 'heap'.
+ * Precondition: heap->size > 0
+ */
+static HEAP_FN(HeapNode) HEAP_FN(heapPop)(HEAP_FN(Heap)* heap) {
+  HEAP_FN(HeapNode) top = heap->nodes[0];
+  heap->positions[top.id] = HEAP_NONE;
+  HEAP_FN(HeapNode) last = heap->nodes[--heap->size];
+  heap->nodes[heap->size].key = HEAP_KEY_MAX;
+  if (heap->size > 0) {
+    HEAP_FN(heapSiftDown)(heap, 0, last);
+  }
+  return top;
+}
+
+#undef HEAP_CAT2
+#undef HEAP_CAT
+#undef HEAP_FN
+#undef HEAP_NONE
+#undef HEAP_PREFIX
+#undef HEAP_KEY
+#undef HEAP_KEY_MAX
+#undef HEAP_ID
+#undef HEAP_ARITY
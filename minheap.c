@@ -5,6 +5,7 @@
  */
 
 #include "minheap.h"
+#include "minheap_build.h"
 
 #define ROOT_INDEX 1
 #define NOTHING -1
@@ -247,6 +248,33 @@ void insert(MinHeap *heap, int priority, int id)
        bubbleUp(heap, heap->size);
 }
 
+/* Replaces the contents of minheap 'heap' with the 'n' nodes with IDs
+ * ids[0], ..., ids[n-1] and priorities priorities[0], ..., priorities[n-1],
+ * in O(n) time.
+ * Precondition: the IDs are unique within this minheap
+ *               0 <= ids[i] < heap->capacity
+ *               0 <= n <= heap->capacity
+ */
+void buildHeap(MinHeap *heap, int *ids, int *priorities, int n)
+{
+       for (int i = ROOT_INDEX; i <= heap->size; i++)
+       {
+              heap->indexMap[heap->arr[i].id] = NOTHING;
+       }
+       heap->size = n;
+       for (int i = 0; i < n; i++)
+       {
+              heap->arr[i + ROOT_INDEX].id = ids[i];
+              heap->arr[i + ROOT_INDEX].priority = priorities[i];
+              heap->indexMap[ids[i]] = i + ROOT_INDEX;
+       }
+       // Leaves are heaps already; sift down every inner node, last first.
+       for (int i = n / 2; i >= ROOT_INDEX; i--)
+       {
+              bubbleDown(heap, i);
+       }
+}
+
 /* Sets priority of node with ID 'id' in minheap 'heap' to 'newPriority', if
  * such a node exists in 'heap' and its priority is larger than
  * 'newPriority', and returns True. Has no effect and returns False, otherwise.
@@ -0,0 +1,26 @@
+/*
+ * Header file for building a minheap (see minheap.h) from many nodes at
+ * once. minheap.h is fixed, so the bulk operations it does not declare are
+ * declared here; they are implemented in minheap.c.
+ */
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "minheap.h"
+
+#ifndef __MinHeap_Build_header
+#define __MinHeap_Build_header
+
+/* Replaces the contents of minheap 'heap' with the 'n' nodes with IDs
+ * ids[0], ..., ids[n-1] and priorities priorities[0], ..., priorities[n-1].
+ * Lays the nodes out in one pass and restores the heap property bottom-up,
+ * in O(n) time rather than the O(n log n) of 'n' calls to insert.
+ * Precondition: the IDs are unique within this minheap
+ *               0 <= ids[i] < heap->capacity
+ *               0 <= n <= heap->capacity
+ */
+void buildHeap(MinHeap* heap, int* ids, int* priorities, int n);
+
+#endif
@@ -0,0 +1,257 @@
+/*
+ * Our MultiQueue implementation.
+ */
+
+#include <limits.h>
+
+#include "multiqueue.h"
+
+#define CACHE_LINE 64
+
+typedef struct locked_heap
+{
+  HeapNode *nodes;  // a binary min-heap of 'size' nodes; duplicates allowed
+  int size;         // atomic: read without the lock to skip empty heaps
+  int capacity;     // room in 'nodes'
+  int top;          // atomic: the smallest priority, INT_MAX if empty
+  bool locked;      // atomic: true while a thread works on the heap
+} __attribute__((aligned(CACHE_LINE))) LockedHeap;  // one cache line each
+
+struct multi_queue
+{
+  int numHeaps;
+  LockedHeap *heaps;
+  StaleTest isStale;  // NULL if no node is ever stale
+  void *context;      // passed to isStale
+};
+
+/* Returns the next number of the xorshift generator 'state'. */
+static unsigned nextXorshift(unsigned *state)
+{
+  *state ^= *state << 13;
+  *state ^= *state >> 17;
+  *state ^= *state << 5;
+  return *state;
+}
+
+/* Takes the lock of 'heap' if no thread holds it and returns true, or
+ * returns false at once.
+ */
+static bool tryLock(LockedHeap *heap)
+{
+  return !__atomic_load_n(&heap->locked, __ATOMIC_RELAXED) &&
+         !__atomic_exchange_n(&heap->locked, true, __ATOMIC_ACQUIRE);
+}
+
+/* Publishes the size and minimum of 'heap' and releases its lock. */
+static void unlock(LockedHeap *heap)
+{
+  int top = heap->size > 0 ? heap->nodes[0].priority : INT_MAX;
+  __atomic_store_n(&heap->top, top, __ATOMIC_RELAXED);
+  __atomic_store_n(&heap->locked, false, __ATOMIC_RELEASE);
+}
+
+/* Returns the number of nodes in 'heap' as last published. */
+static int publishedSize(LockedHeap *heap)
+{
+  return __atomic_load_n(&heap->size, __ATOMIC_RELAXED);
+}
+
+/* Returns the smallest priority in 'heap' as last published, INT_MAX if it
+ * was empty.
+ */
+static int publishedTop(LockedHeap *heap)
+{
+  return __atomic_load_n(&heap->top, __ATOMIC_RELAXED);
+}
+
+/* Returns a newly created empty MultiQueue for 'numThreads' threads, or NULL
+ * if memory could not be allocated. Deletes drop the nodes 'isStale' finds
+ * stale, with 'context', unless 'isStale' is NULL.
+ * Precondition: numThreads >= 1
+ */
+MultiQueue *newMultiQueue(int numThreads, StaleTest isStale, void *context)
+{
+  MultiQueue *queue = malloc(sizeof(MultiQueue));
+  if (queue == NULL)
+  {
+    return NULL;
+  }
+  queue->numHeaps = MULTIQUEUE_FACTOR * numThreads;
+  queue->isStale = isStale;
+  queue->context = context;
+  void *heaps = NULL;
+  if (posix_memalign(&heaps, CACHE_LINE,
+                     sizeof(LockedHeap) * queue->numHeaps) != 0)
+  {
+    free(queue);
+    return NULL;
+  }
+  queue->heaps = heaps;
+  for (int i = 0; i < queue->numHeaps; i++)
+  {
+    queue->heaps[i].nodes = NULL;
+    queue->heaps[i].size = 0;
+    queue->heaps[i].capacity = 0;
+    queue->heaps[i].top = INT_MAX;
+    queue->heaps[i].locked = false;
+  }
+  return queue;
+}
+
+/* Frees all memory allocated for 'queue'. */
+void deleteMultiQueue(MultiQueue *queue)
+{
+  if (queue == NULL)
+  {
+    return;
+  }
+  for (int i = 0; i < queue->numHeaps; i++)
+  {
+    free(queue->heaps[i].nodes);
+  }
+  free(queue->heaps);
+  free(queue);
+}
+
+/* Inserts a node with priority 'priority' and ID 'id' into 'queue', into a
+ * heap picked with the calling thread's random state 'seed'. Returns false
+ * if memory could not be allocated.
+ * Precondition: *seed != 0
+ */
+bool multiQueueInsert(MultiQueue *queue, int priority, int id,
+                      unsigned *seed)
+{
+  HeapNode node = {priority, id};
+  return multiQueueInsertMany(queue, &node, 1, seed);
+}
+
+/* Inserts the 'count' nodes in 'nodes' into 'queue', all into one heap
+ * picked with the calling thread's random state 'seed', under one lock.
+ * Returns false if memory could not be allocated; then none is inserted.
+ * Precondition: *seed != 0, count >= 0
+ */
+bool multiQueueInsertMany(MultiQueue *queue, const HeapNode *nodes, int count,
+                          unsigned *seed)
+{
+  LockedHeap *heap;
+  do
+  {
+    heap = &queue->heaps[nextXorshift(seed) % queue->numHeaps];
+  } while (!tryLock(heap));
+
+  if (heap->size + count > heap->capacity)
+  {
+    int capacity = heap->capacity > 0 ? 2 * heap->capacity : 16;
+    while (capacity < heap->size + count)
+    {
+      capacity *= 2;
+    }
+    HeapNode *grown = realloc(heap->nodes, sizeof(HeapNode) * capacity);
+    if (grown == NULL)
+    {
+      unlock(heap);
+      return false;
+    }
+    heap->nodes = grown;
+    heap->capacity = capacity;
+  }
+  for (int k = 0; k < count; k++)
+  {
+    // Sift the new node up from the end.
+    int i = heap->size + k;
+    while (i > 0 && heap->nodes[(i - 1) / 2].priority > nodes[k].priority)
+    {
+      heap->nodes[i] = heap->nodes[(i - 1) / 2];
+      i = (i - 1) / 2;
+    }
+    heap->nodes[i] = nodes[k];
+  }
+  __atomic_store_n(&heap->size, heap->size + count, __ATOMIC_RELAXED);
+  unlock(heap);
+  return true;
+}
+
+/* Returns a heap of 'queue' with nodes in it, or NULL if all were empty. */
+static LockedHeap *anyNonEmpty(MultiQueue *queue)
+{
+  for (int i = 0; i < queue->numHeaps; i++)
+  {
+    if (publishedSize(&queue->heaps[i]) > 0)
+    {
+      return &queue->heaps[i];
+    }
+  }
+  return NULL;
+}
+
+/* Removes the root of 'heap', which holds its lock and at least one node. */
+static void removeTop(LockedHeap *heap)
+{
+  int size = heap->size - 1;
+  HeapNode last = heap->nodes[size];
+  // Sift the last node down from the root.
+  int i = 0;
+  for (int child = 1; child < size; child = 2 * i + 1)
+  {
+    if (child + 1 < size &&
+        heap->nodes[child + 1].priority < heap->nodes[child].priority)
+    {
+      child++;
+    }
+    if (last.priority <= heap->nodes[child].priority)
+    {
+      break;
+    }
+    heap->nodes[i] = heap->nodes[child];
+    i = child;
+  }
+  heap->nodes[i] = last;
+  __atomic_store_n(&heap->size, size, __ATOMIC_RELAXED);
+}
+
+/* Removes a node with a small priority that is not stale from 'queue' and
+ * stores it in 'node', using the calling thread's random state 'seed'.
+ * Returns false if every heap of 'queue' was empty when looked at; with
+ * other threads inserting, that does not mean 'queue' is empty now. Either
+ * way stores in '*numDropped' the number of stale nodes it removed.
+ * Precondition: *seed != 0
+ */
+bool multiQueueExtractMin(MultiQueue *queue, HeapNode *node, unsigned *seed,
+                          int *numDropped)
+{
+  *numDropped = 0;
+  for (;;)
+  {
+    LockedHeap *a = &queue->heaps[nextXorshift(seed) % queue->numHeaps];
+    LockedHeap *b = &queue->heaps[nextXorshift(seed) % queue->numHeaps];
+    if (publishedSize(a) == 0 || publishedTop(b) < publishedTop(a))
+    {
+      a = b;
+    }
+    if (publishedSize(a) == 0 && (a = anyNonEmpty(queue)) == NULL)
+    {
+      return false;
+    }
+    if (!tryLock(a))
+    {
+      continue;
+    }
+    // Drop the stale nodes on top while we hold the lock anyway.
+    while (a->size > 0 && queue->isStale != NULL &&
+           queue->isStale(queue->context, a->nodes[0]))
+    {
+      removeTop(a);
+      (*numDropped)++;
+    }
+    if (a->size == 0)
+    {
+      unlock(a);  // emptied since we looked
+      continue;
+    }
+    *node = a->nodes[0];
+    removeTop(a);
+    unlock(a);
+    return true;
+  }
+}
@@ -0,0 +1,76 @@
+/*
+ * Header file for our MultiQueue: a relaxed Priority Queue that any number
+ * of threads can use at the same time.
+ *
+ * It keeps MULTIQUEUE_FACTOR binary heaps per thread, each behind a lock
+ * that is only ever tried, never waited on. An insert goes to a heap picked
+ * at random. A delete picks two heaps at random and takes the minimum of
+ * the one whose minimum is smaller, so it returns one of the smallest
+ * O(threads) priorities rather than the smallest; in exchange threads
+ * rarely touch the same heap, and a busy heap is simply skipped for
+ * another one.
+ *
+ * There is no decreasePriority: the heaps hold any number of nodes with the
+ * same ID, so a node is decreased by inserting it again with its new
+ * priority. The old copy is then stale, and a delete that finds it on top
+ * of its heap drops it while it still holds the lock, if the queue was
+ * given a test that recognises stale nodes; a search on a graph with many
+ * decreases would otherwise spend most of its deletes on them.
+ */
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "minheap.h"
+
+#ifndef __MultiQueue_header
+#define __MultiQueue_header
+
+#define MULTIQUEUE_FACTOR 2  // heaps per thread
+
+typedef struct multi_queue MultiQueue;
+
+/* Returns true if 'node' is stale: superseded by a copy with a smaller
+ * priority. 'context' is the one given to newMultiQueue. Called by any
+ * thread, with the lock of the heap that holds 'node'.
+ */
+typedef bool (*StaleTest)(void* context, HeapNode node);
+
+/* Returns a newly created empty MultiQueue for 'numThreads' threads, or NULL
+ * if memory could not be allocated. Deletes drop the nodes 'isStale' finds
+ * stale, with 'context', unless 'isStale' is NULL.
+ * Precondition: numThreads >= 1
+ */
+MultiQueue* newMultiQueue(int numThreads, StaleTest isStale, void* context);
+
+/* Frees all memory allocated for 'queue'. */
+void deleteMultiQueue(MultiQueue* queue);
+
+/* Inserts a node with priority 'priority' and ID 'id' into 'queue', into a
+ * heap picked with the calling thread's random state 'seed'. Returns false
+ * if memory could not be allocated.
+ * Precondition: *seed != 0
+ */
+bool multiQueueInsert(MultiQueue* queue, int priority, int id,
+                      unsigned* seed);
+
+/* Inserts the 'count' nodes in 'nodes' into 'queue', all into one heap
+ * picked with the calling thread's random state 'seed', under one lock.
+ * Returns false if memory could not be allocated; then none is inserted.
+ * Precondition: *seed != 0, count >= 0
+ */
+bool multiQueueInsertMany(MultiQueue* queue, const HeapNode* nodes, int count,
+                          unsigned* seed);
+
+/* Removes a node with a small priority that is not stale from 'queue' and
+ * stores it in 'node', using the calling thread's random state 'seed'.
+ * Returns false if every heap of 'queue' was empty when looked at; with
+ * other threads inserting, that does not mean 'queue' is empty now. Either
+ * way stores in '*numDropped' the number of stale nodes it removed.
+ * Precondition: *seed != 0
+ */
+bool multiQueueExtractMin(MultiQueue* queue, HeapNode* node, unsigned* seed,
+                          int* numDropped);
+
+#endif
@@ -0,0 +1,222 @@
+/*
+ * Our pairing heap implementation.
+ */
+
+#include "pairing_heap.h"
+
+/* Makes the root with the larger priority of roots 'a' and 'b' the first
+ * child of the other, and returns the resulting root.
+ */
+static PairingNode *meld(PairingNode *a, PairingNode *b)
+{
+  if (a == NULL)
+    return b;
+  if (b == NULL)
+    return a;
+  if (b->priority < a->priority)
+  {
+    PairingNode *tmp = a;
+    a = b;
+    b = tmp;
+  }
+  b->prev = a;
+  b->sibling = a->child;
+  if (a->child != NULL)
+  {
+    a->child->prev = b;
+  }
+  a->child = b;
+  a->sibling = NULL;
+  a->prev = NULL;
+  return a;
+}
+
+/* Combines the list of siblings starting at 'first' into one tree with the
+ * standard two-pass pairing: meld pairs left to right, then meld the results
+ * right to left. Returns the root of the tree.
+ */
+static PairingNode *combineSiblings(PairingNode *first)
+{
+  if (first == NULL)
+  {
+    return NULL;
+  }
+  // First pass: meld pairs, keeping the results on a stack linked through
+  // 'prev'.
+  PairingNode *stack = NULL;
+  while (first != NULL)
+  {
+    PairingNode *a = first;
+    PairingNode *b = a->sibling;
+    first = b != NULL ? b->sibling : NULL;
+    a->sibling = NULL;
+    if (b != NULL)
+    {
+      b->sibling = NULL;
+    }
+    PairingNode *pair = meld(a, b);
+    pair->prev = stack;
+    stack = pair;
+  }
+  // Second pass: meld from the last pair back to the first.
+  PairingNode *res = stack;
+  stack = stack->prev;
+  while (stack != NULL)
+  {
+    PairingNode *next = stack->prev;
+    res = meld(res, stack);
+    stack = next;
+  }
+  res->prev = NULL;
+  return res;
+}
+
+/* Returns the node with minimum priority in pairing heap 'heap'.
+ * Precondition: heap is non-empty
+ */
+HeapNode pairingGetMin(PairingHeap *heap)
+{
+  HeapNode res;
+  res.priority = heap->root->priority;
+  res.id = heap->root->id;
+  return res;
+}
+
+/* Removes and returns the node with minimum priority in pairing heap 'heap'.
+ * Precondition: heap is non-empty
+ */
+HeapNode pairingExtractMin(PairingHeap *heap)
+{
+  HeapNode res = pairingGetMin(heap);
+  PairingNode *root = heap->root;
+  heap->root = combineSiblings(root->child);
+  root->child = NULL;
+  root->inHeap = false;
+  heap->size--;
+  return res;
+}
+
+/* Inserts a new node with priority 'priority' and ID 'id' into pairing heap
+ * 'heap'.
+ * Precondition: 'id' is unique within this heap
+ *               0 <= 'id' < heap->capacity
+ */
+void pairingInsert(PairingHeap *heap, int priority, int id)
+{
+  if (id < 0 || id >= heap->capacity || heap->nodes[id].inHeap)
+  {
+    return;
+  }
+  PairingNode *node = &heap->nodes[id];
+  node->priority = priority;
+  node->inHeap = true;
+  node->child = NULL;
+  node->sibling = NULL;
+  node->prev = NULL;
+  heap->root = meld(heap->root, node);
+  heap->size++;
+}
+
+/* Returns priority of the node with ID 'id' in 'heap'.
+ * Precondition: 'id' is a valid node ID in 'heap'.
+ */
+int pairingGetPriority(PairingHeap *heap, int id)
+{
+  return heap->nodes[id].priority;
+}
+
+/* Sets priority of node with ID 'id' in pairing heap 'heap' to
+ * 'newPriority', if such a node exists in 'heap' and its priority is larger
+ * than 'newPriority', and returns True. Has no effect and returns False,
+ * otherwise.
+ * Note: a non-root node is cut from its parent, together with its subtree,
+ * and melded with the root.
+ */
+bool pairingDecreasePriority(PairingHeap *heap, int id, int newPriority)
+{
+  PairingNode *node = &heap->nodes[id];
+  if (!node->inHeap || node->priority <= newPriority)
+  {
+    return false;
+  }
+  node->priority = newPriority;
+  if (node == heap->root)
+  {
+    return true;
+  }
+  if (node->prev->child == node)
+  {
+    node->prev->child = node->sibling;
+  }
+  else
+  {
+    node->prev->sibling = node->sibling;
+  }
+  if (node->sibling != NULL)
+  {
+    node->sibling->prev = node->prev;
+  }
+  node->sibling = NULL;
+  node->prev = NULL;
+  heap->root = meld(heap->root, node);
+  return true;
+}
+
+/* Returns a newly created empty pairing heap with capacity 'capacity'.
+ * Precondition: capacity >= 0
+ */
+PairingHeap *newPairingHeap(int capacity)
+{
+  PairingHeap *heap = malloc(sizeof(PairingHeap));
+  if (heap == NULL)
+  {
+    fprintf(stderr, "Memory is not enough\n");
+    return NULL;
+  }
+  heap->size = 0;
+  heap->capacity = capacity;
+  heap->root = NULL;
+  heap->nodes = malloc(sizeof(PairingNode) * (capacity + 1));
+  if (heap->nodes == NULL)
+  {
+    fprintf(stderr, "Memory is not enough\n");
+    free(heap);
+    return NULL;
+  }
+  for (int i = 0; i < capacity; i++)
+  {
+    heap->nodes[i].id = i;
+    heap->nodes[i].priority = -1;
+    heap->nodes[i].inHeap = false;
+  }
+  return heap;
+}
+
+/* Frees all memory allocated for pairing heap 'heap'.
+ */
+void deletePairingHeap(PairingHeap *heap)
+{
+  free(heap->nodes);
+  free(heap);
+}
+
+/* Prints the subtree rooted at 'node' and its right siblings, indented by
+ * 'depth'.
+ */
+static void printPairingNodes(PairingNode *node, int depth)
+{
+  for (; node != NULL; node = node->sibling)
+  {
+    printf("%*s%d [%d]\n", 2 * depth, "", node->priority, node->id);
+    printPairingNodes(node->child, depth + 1);
+  }
+}
+
+void printPairingHeap(PairingHeap *heap)
+{
+  printf("PairingHeap with size: %d\n\tcapacity: %d\n\n", heap->size,
+         heap->capacity);
+  printf("priority [ID]\n");
+  printPairingNodes(heap->root, 0);
+  printf("\n\n");
+}
@@ -0,0 +1,79 @@
+/*
+ * Header file for our pairing heap: a Priority Queue with the same
+ * operations as MinHeap (see minheap.h) and O(1) insert and (amortized)
+ * cheap decreasePriority, for workloads dominated by decrease-key.
+ *
+ * Nodes come from a pool allocated with the heap: the node with ID id is
+ * nodes[id], so no operation allocates memory.
+ */
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "minheap.h"
+
+#ifndef __PairingHeap_header
+#define __PairingHeap_header
+
+typedef struct pairing_node {
+  int priority;                  // priority of this node
+  int id;                        // the unique ID of this node
+  bool inHeap;                   // true iff this node is in the heap
+  struct pairing_node* child;    // first (leftmost) child
+  struct pairing_node* sibling;  // next sibling to the right
+  struct pairing_node* prev;     // previous sibling, or the parent if this is
+                                 //   the first child
+} PairingNode;
+
+typedef struct pairing_heap {
+  int size;            // the number of nodes in this heap
+  int capacity;        // the number of nodes that can be stored in this heap
+  PairingNode* nodes;  // the node pool; nodes[id] is the node with ID id
+  PairingNode* root;   // the node with minimum priority; NULL if empty
+} PairingHeap;
+
+/* Returns the node with minimum priority in pairing heap 'heap'.
+ * Precondition: heap is non-empty
+ */
+HeapNode pairingGetMin(PairingHeap* heap);
+
+/* Removes and returns the node with minimum priority in pairing heap 'heap'.
+ * Precondition: heap is non-empty
+ */
+HeapNode pairingExtractMin(PairingHeap* heap);
+
+/* Inserts a new node with priority 'priority' and ID 'id' into pairing heap
+ * 'heap'.
+ * Precondition: 'id' is unique within this heap
+ *               0 <= 'id' < heap->capacity
+ */
+void pairingInsert(PairingHeap* heap, int priority, int id);
+
+/* Returns priority of the node with ID 'id' in 'heap'.
+ * Precondition: 'id' is a valid node ID in 'heap'.
+ */
+int pairingGetPriority(PairingHeap* heap, int id);
+
+/* Sets priority of node with ID 'id' in pairing heap 'heap' to
+ * 'newPriority', if such a node exists in 'heap' and its priority is larger
+ * than 'newPriority', and returns True. Has no effect and returns False,
+ * otherwise.
+ */
+bool pairingDecreasePriority(PairingHeap* heap, int id, int newPriority);
+
+/* Prints the contents of this heap: size, capacity, and the ID and priority
+ * of every node in it, as a tree.
+ */
+void printPairingHeap(PairingHeap* heap);
+
+/* Returns a newly created empty pairing heap with capacity 'capacity'.
+ * Precondition: capacity >= 0
+ */
+PairingHeap* newPairingHeap(int capacity);
+
+/* Frees all memory allocated for pairing heap 'heap'.
+ */
+void deletePairingHeap(PairingHeap* heap);
+
+#endif
@@ -0,0 +1,625 @@
+/*
+ * Our thread helpers: a work-stealing scheduler.
+ *
+ * Each worker owns a Chase-Lev deque (Chase and Lev, "Dynamic circular
+ * work-stealing deque", SPAA 2005, with the memory orders of Le et al.,
+ * PPoPP 2013). The owner pushes and takes at the bottom; thieves steal at
+ * the top. The deques have a fixed size, and a task that does not fit is
+ * run at once by the thread that spawns it.
+ *
+ * Only the workers run tasks. A thread that is not a worker hands its tasks
+ * to the workers through a shared queue and sleeps until they are done.
+ * This way it never runs a task it did not ask for, and never adds to the
+ * number of busy threads.
+ */
+
+#define _GNU_SOURCE  // for pthread_setaffinity_np, where there is one
+
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+
+#include "parallel.h"
+
+#define DEQUE_SIZE 4096  // tasks a worker can have waiting; a power of 2
+#define IDLE_ROUNDS 64   // failed rounds of stealing before a worker sleeps
+
+typedef struct deque
+{
+  long top;                    // next task to steal; only ever grows
+  char topLine[64 - sizeof(long)];
+  long bottom;                 // next free slot; written only by the owner
+  char bottomLine[64 - sizeof(long)];
+  Task *slots[DEQUE_SIZE];     // task i is in slots[i % DEQUE_SIZE]
+} Deque;
+
+typedef struct scheduler
+{
+  int numWorkers;        // number of worker threads
+  bool pinWorkers;       // pin worker i to CPU i (modulo the CPUs)
+  bool started;
+  Deque *deques;         // deques[i] belongs to worker i
+  // Tasks spawned by threads that are not workers:
+  pthread_mutex_t queueLock;
+  Task **queue;          // a ring of 'queueCapacity' tasks
+  long queueHead;        // index of the oldest queued task
+  long queueSize;
+  long queueCapacity;
+  // Idle workers sleep on 'wake':
+  pthread_mutex_t sleepLock;
+  pthread_cond_t wake;
+  int sleepers;          // workers asleep or about to be
+  // Threads that are not workers wait for their task groups on 'done':
+  pthread_mutex_t doneLock;
+  pthread_cond_t done;
+  int waiters;           // such threads waiting or about to be
+} Scheduler;
+
+static Scheduler scheduler = {
+    .queueLock = PTHREAD_MUTEX_INITIALIZER,
+    .sleepLock = PTHREAD_MUTEX_INITIALIZER,
+    .wake = PTHREAD_COND_INITIALIZER,
+    .doneLock = PTHREAD_MUTEX_INITIALIZER,
+    .done = PTHREAD_COND_INITIALIZER,
+};
+static pthread_mutex_t startLock = PTHREAD_MUTEX_INITIALIZER;
+
+// The index of the calling thread's deque, or -1 if it is not a worker.
+static __thread int workerIndex = -1;
+static __thread unsigned stealSeed = 1;
+
+/* Returns the number of online CPUs (at least 1). */
+static int cpuCount(void)
+{
+  long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+  return cpus < 1 ? 1 : (int)cpus;
+}
+
+/***** Deques ***************************************************************/
+
+/* Pushes 'task' onto the bottom of the calling worker's 'deque'. Returns
+ * false if the deque is full.
+ */
+static bool pushTask(Deque *deque, Task *task)
+{
+  long bottom = __atomic_load_n(&deque->bottom, __ATOMIC_RELAXED);
+  long top = __atomic_load_n(&deque->top, __ATOMIC_ACQUIRE);
+  if (bottom - top >= DEQUE_SIZE)
+  {
+    return false;
+  }
+  __atomic_store_n(&deque->slots[bottom % DEQUE_SIZE], task,
+                   __ATOMIC_RELAXED);
+  __atomic_thread_fence(__ATOMIC_RELEASE);
+  __atomic_store_n(&deque->bottom, bottom + 1, __ATOMIC_RELAXED);
+  return true;
+}
+
+/* Takes the newest task from the bottom of the calling worker's 'deque', or
+ * returns NULL if it is empty.
+ */
+static Task *takeTask(Deque *deque)
+{
+  long bottom = __atomic_load_n(&deque->bottom, __ATOMIC_RELAXED) - 1;
+  __atomic_store_n(&deque->bottom, bottom, __ATOMIC_RELAXED);
+  __atomic_thread_fence(__ATOMIC_SEQ_CST);
+  long top = __atomic_load_n(&deque->top, __ATOMIC_RELAXED);
+  Task *task = NULL;
+  if (top <= bottom)
+  {
+    task = __atomic_load_n(&deque->slots[bottom % DEQUE_SIZE],
+                           __ATOMIC_RELAXED);
+    if (top == bottom)
+    {
+      // The last task: race the thieves for it.
+      if (!__atomic_compare_exchange_n(&deque->top, &top, top + 1, false,
+                                       __ATOMIC_SEQ_CST, __ATOMIC_RELAXED))
+      {
+        task = NULL;
+      }
+      __atomic_store_n(&deque->bottom, bottom + 1, __ATOMIC_RELAXED);
+    }
+  }
+  else
+  {
+    __atomic_store_n(&deque->bottom, bottom + 1, __ATOMIC_RELAXED);
+  }
+  return task;
+}
+
+/* Steals the oldest task from the top of 'deque', or returns NULL if it is
+ * empty or another thread got there first.
+ */
+static Task *stealTask(Deque *deque)
+{
+  long top = __atomic_load_n(&deque->top, __ATOMIC_ACQUIRE);
+  __atomic_thread_fence(__ATOMIC_SEQ_CST);
+  long bottom = __atomic_load_n(&deque->bottom, __ATOMIC_ACQUIRE);
+  if (top >= bottom)
+  {
+    return NULL;
+  }
+  Task *task =
+      __atomic_load_n(&deque->slots[top % DEQUE_SIZE], __ATOMIC_RELAXED);
+  if (!__atomic_compare_exchange_n(&deque->top, &top, top + 1, false,
+                                   __ATOMIC_SEQ_CST, __ATOMIC_RELAXED))
+  {
+    return NULL;
+  }
+  return task;
+}
+
+/* Returns true iff 'deque' looks non-empty. */
+static bool hasTasks(Deque *deque)
+{
+  return __atomic_load_n(&deque->top, __ATOMIC_SEQ_CST) <
+         __atomic_load_n(&deque->bottom, __ATOMIC_SEQ_CST);
+}
+
+/***** The shared queue *****************************************************/
+
+/* Adds 'task' to the queue of tasks from threads that are not workers.
+ * Returns false if memory runs out.
+ */
+static bool enqueueTask(Task *task)
+{
+  pthread_mutex_lock(&scheduler.queueLock);
+  if (scheduler.queueSize == scheduler.queueCapacity)
+  {
+    long capacity = 2 * scheduler.queueCapacity + 16;
+    Task **queue = malloc(sizeof(Task *) * capacity);
+    if (queue == NULL)
+    {
+      pthread_mutex_unlock(&scheduler.queueLock);
+      return false;
+    }
+    for (long i = 0; i < scheduler.queueSize; i++)
+    {
+      queue[i] = scheduler.queue[(scheduler.queueHead + i) %
+                                 scheduler.queueCapacity];
+    }
+    free(scheduler.queue);
+    scheduler.queue = queue;
+    scheduler.queueHead = 0;
+    scheduler.queueCapacity = capacity;
+  }
+  scheduler.queue[(scheduler.queueHead + scheduler.queueSize) %
+                  scheduler.queueCapacity] = task;
+  __atomic_store_n(&scheduler.queueSize, scheduler.queueSize + 1,
+                   __ATOMIC_SEQ_CST);
+  pthread_mutex_unlock(&scheduler.queueLock);
+  return true;
+}
+
+/* Removes and returns the oldest task in the shared queue, or NULL. */
+static Task *dequeueTask(void)
+{
+  if (__atomic_load_n(&scheduler.queueSize, __ATOMIC_SEQ_CST) == 0)
+  {
+    return NULL;
+  }
+  Task *task = NULL;
+  pthread_mutex_lock(&scheduler.queueLock);
+  if (scheduler.queueSize > 0)
+  {
+    task = scheduler.queue[scheduler.queueHead];
+    scheduler.queueHead = (scheduler.queueHead + 1) % scheduler.queueCapacity;
+    __atomic_store_n(&scheduler.queueSize, scheduler.queueSize - 1,
+                     __ATOMIC_SEQ_CST);
+  }
+  pthread_mutex_unlock(&scheduler.queueLock);
+  return task;
+}
+
+/***** Workers **************************************************************/
+
+/* Returns a task for the calling worker: its own newest, or the oldest in
+ * the shared queue, or one stolen from a worker picked at random. Returns
+ * NULL if none was found.
+ */
+static Task *findTask(void)
+{
+  Task *task = takeTask(&scheduler.deques[workerIndex]);
+  if (task == NULL)
+  {
+    task = dequeueTask();
+  }
+  int numWorkers = scheduler.numWorkers;
+  if (task == NULL && numWorkers > 1)
+  {
+    stealSeed = stealSeed * 1103515245 + 12345;
+    int first = (int)((stealSeed >> 16) % numWorkers);
+    for (int i = 0; i < numWorkers && task == NULL; i++)
+    {
+      int victim = (first + i) % numWorkers;
+      if (victim != workerIndex)
+      {
+        task = stealTask(&scheduler.deques[victim]);
+      }
+    }
+  }
+  return task;
+}
+
+/* Returns true iff any task seems to be waiting anywhere. */
+static bool workAvailable(void)
+{
+  if (__atomic_load_n(&scheduler.queueSize, __ATOMIC_SEQ_CST) > 0)
+  {
+    return true;
+  }
+  for (int i = 0; i < scheduler.numWorkers; i++)
+  {
+    if (hasTasks(&scheduler.deques[i]))
+    {
+      return true;
+    }
+  }
+  return false;
+}
+
+/* Runs 'task' and counts it as finished in its group, waking the threads
+ * that wait in waitTasks if it was the group's last.
+ */
+static void runTask(Task *task)
+{
+  TaskGroup *group = task->group;  // 'task' may be gone once it is counted
+  task->func(task->arg);
+  // Pairs with waitTasks: either the waiter sees the count reach 0, or we
+  // see the waiter.
+  if (__atomic_sub_fetch(&group->pending, 1, __ATOMIC_SEQ_CST) == 0 &&
+      __atomic_load_n(&scheduler.waiters, __ATOMIC_SEQ_CST) > 0)
+  {
+    pthread_mutex_lock(&scheduler.doneLock);
+    pthread_cond_broadcast(&scheduler.done);
+    pthread_mutex_unlock(&scheduler.doneLock);
+  }
+}
+
+/* Wakes a sleeping worker, if there is one, after a task was added. */
+static void wakeWorker(void)
+{
+  // Pairs with the fence in workerLoop: either the sleeper sees the new
+  // task, or we see the sleeper.
+  __atomic_thread_fence(__ATOMIC_SEQ_CST);
+  if (__atomic_load_n(&scheduler.sleepers, __ATOMIC_RELAXED) > 0)
+  {
+    pthread_mutex_lock(&scheduler.sleepLock);
+    pthread_cond_signal(&scheduler.wake);
+    pthread_mutex_unlock(&scheduler.sleepLock);
+  }
+}
+
+/* pthread entry point of worker 'arg': runs tasks forever,
+ * sleeping when there are none.
+ */
+static void *workerLoop(void *arg)
+{
+  workerIndex = (int)(long)arg;
+  stealSeed = 2 * workerIndex + 1;
+  int idleRounds = 0;
+  while (true)
+  {
+    Task *task = findTask();
+    if (task != NULL)
+    {
+      runTask(task);
+      idleRounds = 0;
+    }
+    else if (++idleRounds < IDLE_ROUNDS)
+    {
+      sched_yield();
+    }
+    else
+    {
+      pthread_mutex_lock(&scheduler.sleepLock);
+      __atomic_fetch_add(&scheduler.sleepers, 1, __ATOMIC_RELAXED);
+      __atomic_thread_fence(__ATOMIC_SEQ_CST);
+      if (!workAvailable())
+      {
+        pthread_cond_wait(&scheduler.wake, &scheduler.sleepLock);
+      }
+      __atomic_fetch_sub(&scheduler.sleepers, 1, __ATOMIC_RELAXED);
+      pthread_mutex_unlock(&scheduler.sleepLock);
+      idleRounds = 0;
+    }
+  }
+  return NULL;
+}
+
+/* Starts the workers, once. Returns the number of workers, which is 0 if
+ * none could be started.
+ */
+static int startScheduler(void)
+{
+  if (__atomic_load_n(&scheduler.started, __ATOMIC_ACQUIRE))
+  {
+    return scheduler.numWorkers;
+  }
+  pthread_mutex_lock(&startLock);
+  if (!scheduler.started)
+  {
+    if (scheduler.numWorkers <= 0)
+    {
+      scheduler.numWorkers = cpuCount();
+    }
+    scheduler.deques = calloc(scheduler.numWorkers, sizeof(Deque));
+    int started = 0;
+    for (; scheduler.deques != NULL && started < scheduler.numWorkers;
+         started++)
+    {
+      pthread_t thread;
+      if (pthread_create(&thread, NULL, workerLoop, (void *)(long)started) !=
+          0)
+      {
+        break;
+      }
+      pthread_detach(thread);
+#ifdef CPU_SET  // pinning is left out where there is no affinity API
+      if (scheduler.pinWorkers)
+      {
+        cpu_set_t cpus;
+        CPU_ZERO(&cpus);
+        CPU_SET(started % cpuCount(), &cpus);
+        pthread_setaffinity_np(thread, sizeof(cpu_set_t), &cpus);
+      }
+#endif
+    }
+    // Workers that could not be created simply do not exist.
+    scheduler.numWorkers = started;
+    __atomic_store_n(&scheduler.started, true, __ATOMIC_RELEASE);
+  }
+  pthread_mutex_unlock(&startLock);
+  return scheduler.numWorkers;
+}
+
+/* Sets the number of worker threads (0 for one per online CPU) and whether
+ * each is pinned to its own CPU. Returns false if the scheduler has already
+ * started.
+ */
+bool configureScheduler(int numWorkers, bool pinWorkers)
+{
+  pthread_mutex_lock(&startLock);
+  bool ok = !scheduler.started;
+  if (ok)
+  {
+    scheduler.numWorkers = numWorkers > 0 ? numWorkers : 0;
+    scheduler.pinWorkers = pinWorkers;
+  }
+  pthread_mutex_unlock(&startLock);
+  return ok;
+}
+
+/* Returns the scheduler's number of workers (at least 1). */
+int defaultThreadCount(void)
+{
+  int numWorkers = startScheduler();
+  return numWorkers > 0 ? numWorkers : 1;
+}
+
+/***** Fork/join ************************************************************/
+
+/* Starts func(arg) as a task in 'group', using 'task' as its record. */
+void spawnTask(Task *task, TaskGroup *group, TaskFunc func, void *arg)
+{
+  startScheduler();
+  task->func = func;
+  task->arg = arg;
+  task->group = group;
+  __atomic_fetch_add(&group->pending, 1, __ATOMIC_RELAXED);
+  bool queued = workerIndex >= 0
+                    ? pushTask(&scheduler.deques[workerIndex], task)
+                    : scheduler.numWorkers > 0 && enqueueTask(task);
+  if (!queued)
+  {
+    runTask(task);  // no room, or no workers at all
+    return;
+  }
+  wakeWorker();
+}
+
+/* Returns once every task spawned in 'group' has finished. A worker runs
+ * tasks in the meantime, its own first; any other thread sleeps.
+ */
+void waitTasks(TaskGroup *group)
+{
+  if (workerIndex < 0)
+  {
+    pthread_mutex_lock(&scheduler.doneLock);
+    __atomic_fetch_add(&scheduler.waiters, 1, __ATOMIC_SEQ_CST);
+    while (__atomic_load_n(&group->pending, __ATOMIC_SEQ_CST) > 0)
+    {
+      pthread_cond_wait(&scheduler.done, &scheduler.doneLock);
+    }
+    __atomic_fetch_sub(&scheduler.waiters, 1, __ATOMIC_RELAXED);
+    pthread_mutex_unlock(&scheduler.doneLock);
+    return;
+  }
+  while (__atomic_load_n(&group->pending, __ATOMIC_ACQUIRE) > 0)
+  {
+    Task *task = findTask();
+    if (task != NULL)
+    {
+      runTask(task);
+    }
+    else
+    {
+      sched_yield();
+    }
+  }
+}
+
+typedef struct part_args
+{
+  ParallelBody body; // the work to run
+  void *ctx;         // shared argument of 'body'
+  int thread;        // which part this is
+  int numThreads;    // how many parts there are
+} PartArgs;
+
+/* Task and pthread entry point: runs one part. */
+static void runPart(void *arg)
+{
+  PartArgs *args = (PartArgs *)arg;
+  args->body(args->ctx, args->thread, args->numThreads);
+}
+
+/* Runs 'body' for threads 0 .. numThreads-1 on the scheduler and returns once
+ * all of them have finished. A worker runs part 0 itself.
+ * Precondition: numThreads >= 1
+ */
+void parallelRun(int numThreads, ParallelBody body, void *ctx)
+{
+  PartArgs *args = malloc(sizeof(PartArgs) * numThreads);
+  Task *tasks = malloc(sizeof(Task) * numThreads);
+  if (args == NULL || tasks == NULL)
+  {
+    free(args);
+    free(tasks);
+    for (int t = 0; t < numThreads; t++)
+    {
+      body(ctx, t, numThreads);
+    }
+    return;
+  }
+
+  TaskGroup group = {0};
+  for (int t = 0; t < numThreads; t++)
+  {
+    args[t].body = body;
+    args[t].ctx = ctx;
+    args[t].thread = t;
+    args[t].numThreads = numThreads;
+  }
+  int first = workerIndex >= 0 ? 1 : 0;
+  for (int t = first; t < numThreads; t++)
+  {
+    spawnTask(&tasks[t], &group, runPart, &args[t]);
+  }
+  if (first == 1)
+  {
+    runPart(&args[0]);
+  }
+  waitTasks(&group);
+  free(args);
+  free(tasks);
+}
+
+typedef struct range_args
+{
+  RangeBody body;
+  void *ctx;
+  long begin;
+  long end;
+  long grain;
+} RangeArgs;
+
+/* Task entry point of parallelFor: runs 'arg's range, handing off the upper
+ * half of it as long as it is larger than the grain.
+ */
+static void runRange(void *arg)
+{
+  RangeArgs *range = (RangeArgs *)arg;
+  if (range->end - range->begin <= range->grain)
+  {
+    range->body(range->ctx, range->begin, range->end);
+    return;
+  }
+  long middle = range->begin + (range->end - range->begin) / 2;
+  RangeArgs upper = *range;
+  upper.begin = middle;
+  RangeArgs lower = *range;
+  lower.end = middle;
+
+  TaskGroup group = {0};
+  Task task;
+  spawnTask(&task, &group, runRange, &upper);
+  runRange(&lower);
+  waitTasks(&group);
+}
+
+/* Runs 'body' on the range begin .. end-1, split in halves until pieces
+ * have at most 'grain' indices, and returns once all pieces have run.
+ */
+void parallelFor(long begin, long end, long grain, RangeBody body, void *ctx)
+{
+  if (begin >= end)
+  {
+    return;
+  }
+  RangeArgs range = {body, ctx, begin, end, grain < 1 ? 1 : grain};
+  if (workerIndex >= 0)
+  {
+    runRange(&range);
+    return;
+  }
+  TaskGroup group = {0};
+  Task task;
+  spawnTask(&task, &group, runRange, &range);
+  waitTasks(&group);
+}
+
+/***** Dedicated threads ****************************************************/
+
+/* pthread entry point of runThreads: runs one part. */
+static void *runThreadPart(void *arg)
+{
+  runPart(arg);
+  return NULL;
+}
+
+/* Runs 'body' for threads 0 .. numThreads-1 on threads of their own, all at
+ * the same time, and returns once all of them have finished. Thread 0 runs
+ * on the calling thread.
+ * Precondition: numThreads >= 1
+ */
+void runThreads(int numThreads, ParallelBody body, void *ctx)
+{
+  pthread_t *threads = malloc(sizeof(pthread_t) * numThreads);
+  PartArgs *args = malloc(sizeof(PartArgs) * numThreads);
+  bool *started = malloc(sizeof(bool) * numThreads);
+  if (threads == NULL || args == NULL || started == NULL)
+  {
+    free(threads);
+    free(args);
+    free(started);
+    for (int t = 0; t < numThreads; t++)
+    {
+      body(ctx, t, numThreads);
+    }
+    return;
+  }
+
+  for (int t = 0; t < numThreads; t++)
+  {
+    args[t].body = body;
+    args[t].ctx = ctx;
+    args[t].thread = t;
+    args[t].numThreads = numThreads;
+    started[t] = t > 0 && pthread_create(&threads[t], NULL, runThreadPart,
+                                         &args[t]) == 0;
+  }
+  runPart(&args[0]);
+  for (int t = 1; t < numThreads; t++)
+  {
+    if (started[t])
+    {
+      pthread_join(threads[t], NULL);
+    }
+    else
+    {
+      runPart(&args[t]);
+    }
+  }
+  free(threads);
+  free(args);
+  free(started);
+}
+
+/* Returns the start of part 'part' when 'n' items are split into 'numParts'
+ * contiguous parts of (almost) equal size; part 'numParts' starts at 'n'.
+ */
+long partStart(long n, int part, int numParts)
+{
+  return n * part / numParts;
+}
@@ -0,0 +1,97 @@
+/*
+ * Header file for our thread helpers.
+ *
+ * Parallel code in this library does not create threads of its own. It
+ * hands its work to one shared work-stealing scheduler: a fixed set of
+ * worker threads, each with a deque of tasks. A worker runs its own newest
+ * task first and, when it has none, steals the oldest task of another
+ * worker. Threads that are not workers (the main thread, server threads)
+ * submit through a shared queue and sleep until their work is done. Nested
+ * and concurrent parallel calls therefore share the same workers instead of
+ * oversubscribing the cores.
+ *
+ * There are three ways in:
+ *   parallelRun   split work into a fixed number of parts (for code that
+ *                 keeps per-part state, such as histograms)
+ *   parallelFor   split a range of indices as finely as the load requires
+ *   spawnTask /   fork/join: start tasks and wait for a group of them
+ *   waitTasks
+ */
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#ifndef __Parallel_header
+#define __Parallel_header
+
+/* A piece of parallel work: called once for every 'thread' in
+ * 0 .. numThreads-1, with the 'ctx' given to parallelRun.
+ */
+typedef void (*ParallelBody)(void* ctx, int thread, int numThreads);
+
+/* A piece of parallelFor work: the indices begin .. end-1. */
+typedef void (*RangeBody)(void* ctx, long begin, long end);
+
+typedef void (*TaskFunc)(void* arg);
+
+typedef struct task_group {
+  long pending;  // tasks spawned in the group that have not finished
+} TaskGroup;     // initialize with {0}
+
+typedef struct task {
+  TaskFunc func;     // runs as func(arg)
+  void* arg;
+  TaskGroup* group;  // the group whose 'pending' it counts in
+} Task;
+
+/* Sets the number of worker threads (0 for one per online CPU) and whether
+ * each is pinned to its own CPU. Takes effect only if called before the
+ * scheduler is first used; returns false otherwise.
+ */
+bool configureScheduler(int numWorkers, bool pinWorkers);
+
+/* Returns the number of threads to use when the caller did not ask for a
+ * particular number: the scheduler's number of workers (by default, the
+ * number of online CPUs).
+ */
+int defaultThreadCount(void);
+
+/* Runs 'body' for threads 0 .. numThreads-1 on the scheduler and returns once
+ * all of them have finished. The parts run concurrently as far as workers
+ * are free, so a part must never wait for another part to start.
+ * Precondition: numThreads >= 1
+ */
+void parallelRun(int numThreads, ParallelBody body, void* ctx);
+
+/* Runs 'body' on the range begin .. end-1, split in halves until pieces
+ * have at most 'grain' indices (at least 1), and returns once all pieces
+ * have run. Idle workers steal the largest pieces left.
+ */
+void parallelFor(long begin, long end, long grain, RangeBody body, void* ctx);
+
+/* Starts func(arg) as a task in 'group', using 'task' as its record. The
+ * caller keeps 'task' alive until waitTasks(group) returns.
+ */
+void spawnTask(Task* task, TaskGroup* group, TaskFunc func, void* arg);
+
+/* Returns once every task spawned in 'group' has finished. A worker runs
+ * tasks (of any group) in the meantime; any other thread sleeps.
+ */
+void waitTasks(TaskGroup* group);
+
+/* Runs 'body' for threads 0 .. numThreads-1 on threads of their own, all at
+ * the same time, and returns once all of them have finished. Only for work
+ * that blocks (on I/O, or on the other parts); everything else should use
+ * parallelRun. Falls back to running the parts one after another if threads
+ * cannot be created.
+ * Precondition: numThreads >= 1
+ */
+void runThreads(int numThreads, ParallelBody body, void* ctx);
+
+/* Returns the start of part 'part' when 'n' items are split into 'numParts'
+ * contiguous parts of (almost) equal size; part 'numParts' starts at 'n'.
+ */
+long partStart(long n, int part, int numParts);
+
+#endif
@@ -0,0 +1,302 @@
+/*
+ * Our rank-pairing heap implementation.
+ */
+
+#include "rank_pairing_heap.h"
+
+// Ranks are O(log n); 2^31 nodes need far fewer buckets than this.
+#define MAX_RANK 96
+
+/* Returns the rank of 'node', or -1 for a missing node. */
+static int rankOf(RankPairingNode *node)
+{
+  return node == NULL ? -1 : node->rank;
+}
+
+/* Adds the half tree rooted at 'root' to the root list of 'heap'. */
+static void addRoot(RankPairingHeap *heap, RankPairingNode *root)
+{
+  root->parent = NULL;
+  root->right = NULL;
+  if (heap->min == NULL)
+  {
+    root->next = root;
+    heap->min = root;
+    return;
+  }
+  root->next = heap->min->next;
+  heap->min->next = root;
+  if (root->priority < heap->min->priority)
+  {
+    heap->min = root;
+  }
+}
+
+/* Links the half trees rooted at 'a' and 'b', which have equal rank: the
+ * root with the larger priority becomes the left child of the other, whose
+ * old left subtree becomes the right subtree of the loser. Returns the new
+ * root.
+ */
+static RankPairingNode *linkRoots(RankPairingNode *a, RankPairingNode *b)
+{
+  if (b->priority < a->priority)
+  {
+    RankPairingNode *tmp = a;
+    a = b;
+    b = tmp;
+  }
+  b->right = a->left;
+  if (b->right != NULL)
+  {
+    b->right->parent = b;
+  }
+  b->parent = a;
+  a->left = b;
+  a->rank++;
+  return a;
+}
+
+/* Returns the node with minimum priority in rank-pairing heap 'heap'.
+ * Precondition: heap is non-empty
+ */
+HeapNode rankPairingGetMin(RankPairingHeap *heap)
+{
+  HeapNode res;
+  res.priority = heap->min->priority;
+  res.id = heap->min->id;
+  return res;
+}
+
+/* Puts half tree 'root' into the bucket for its rank, or, if that bucket is
+ * taken, links the two and adds the result to the list 'linked'.
+ */
+static void bucketRoot(RankPairingHeap *heap, RankPairingNode *root,
+                       RankPairingNode **linked)
+{
+  root->parent = NULL;
+  root->right = NULL;
+  RankPairingNode *other = heap->buckets[root->rank];
+  if (other == NULL)
+  {
+    heap->buckets[root->rank] = root;
+    return;
+  }
+  heap->buckets[root->rank] = NULL;
+  RankPairingNode *res = linkRoots(root, other);
+  res->next = *linked;
+  *linked = res;
+}
+
+/* Removes and returns the node with minimum priority in rank-pairing heap
+ * 'heap'. The right spine of the minimum's left subtree becomes a list of
+ * new half trees; together with the other roots, they are linked in one pass
+ * over buckets by rank.
+ * Precondition: heap is non-empty
+ */
+HeapNode rankPairingExtractMin(RankPairingHeap *heap)
+{
+  HeapNode res = rankPairingGetMin(heap);
+  RankPairingNode *min = heap->min;
+  RankPairingNode *linked = NULL;
+
+  RankPairingNode *child = min->left;
+  while (child != NULL)
+  {
+    RankPairingNode *next = child->right;
+    child->rank = rankOf(child->left) + 1;
+    bucketRoot(heap, child, &linked);
+    child = next;
+  }
+  RankPairingNode *root = min->next;
+  while (root != min)
+  {
+    RankPairingNode *next = root->next;
+    bucketRoot(heap, root, &linked);
+    root = next;
+  }
+
+  min->inHeap = false;
+  min->left = NULL;
+  heap->min = NULL;
+  heap->size--;
+  while (linked != NULL)
+  {
+    RankPairingNode *next = linked->next;
+    addRoot(heap, linked);
+    linked = next;
+  }
+  for (int r = 0; r < MAX_RANK; r++)
+  {
+    if (heap->buckets[r] != NULL)
+    {
+      addRoot(heap, heap->buckets[r]);
+      heap->buckets[r] = NULL;
+    }
+  }
+  return res;
+}
+
+/* Inserts a new node with priority 'priority' and ID 'id' into rank-pairing
+ * heap 'heap'.
+ * Precondition: 'id' is unique within this heap
+ *               0 <= 'id' < heap->capacity
+ */
+void rankPairingInsert(RankPairingHeap *heap, int priority, int id)
+{
+  if (id < 0 || id >= heap->capacity || heap->nodes[id].inHeap)
+  {
+    return;
+  }
+  RankPairingNode *node = &heap->nodes[id];
+  node->priority = priority;
+  node->rank = 0;
+  node->inHeap = true;
+  node->left = NULL;
+  addRoot(heap, node);
+  heap->size++;
+}
+
+/* Returns priority of the node with ID 'id' in 'heap'.
+ * Precondition: 'id' is a valid node ID in 'heap'.
+ */
+int rankPairingGetPriority(RankPairingHeap *heap, int id)
+{
+  return heap->nodes[id].priority;
+}
+
+/* Sets priority of node with ID 'id' in rank-pairing heap 'heap' to
+ * 'newPriority', if such a node exists in 'heap' and its priority is larger
+ * than 'newPriority', and returns True. Has no effect and returns False,
+ * otherwise.
+ * Note: a non-root node is cut out together with its left subtree and
+ * becomes a new half tree; its right subtree takes its place, and the ranks
+ * of its ancestors are lowered as far as the type-1 rank rule allows.
+ */
+bool rankPairingDecreasePriority(RankPairingHeap *heap, int id,
+                                 int newPriority)
+{
+  RankPairingNode *node = &heap->nodes[id];
+  if (!node->inHeap || node->priority <= newPriority)
+  {
+    return false;
+  }
+  node->priority = newPriority;
+  RankPairingNode *parent = node->parent;
+  if (parent == NULL)
+  {
+    if (newPriority < heap->min->priority)
+    {
+      heap->min = node;
+    }
+    return true;
+  }
+
+  if (parent->left == node)
+  {
+    parent->left = node->right;
+  }
+  else
+  {
+    parent->right = node->right;
+  }
+  if (node->right != NULL)
+  {
+    node->right->parent = parent;
+  }
+  node->rank = rankOf(node->left) + 1;
+  addRoot(heap, node);
+
+  while (parent != NULL)
+  {
+    int rank;
+    if (parent->parent == NULL)
+    {
+      rank = rankOf(parent->left) + 1;
+    }
+    else
+    {
+      int leftRank = rankOf(parent->left);
+      int rightRank = rankOf(parent->right);
+      int maxRank = leftRank > rightRank ? leftRank : rightRank;
+      int diff = leftRank > rightRank ? leftRank - rightRank
+                                      : rightRank - leftRank;
+      rank = diff > 1 ? maxRank : maxRank + 1;
+    }
+    if (rank >= parent->rank)
+    {
+      break;
+    }
+    parent->rank = rank;
+    parent = parent->parent;
+  }
+  return true;
+}
+
+/* Returns a newly created empty rank-pairing heap with capacity 'capacity'.
+ * Precondition: capacity >= 0
+ */
+RankPairingHeap *newRankPairingHeap(int capacity)
+{
+  RankPairingHeap *heap = malloc(sizeof(RankPairingHeap));
+  if (heap == NULL)
+  {
+    fprintf(stderr, "Memory is not enough\n");
+    return NULL;
+  }
+  heap->size = 0;
+  heap->capacity = capacity;
+  heap->min = NULL;
+  heap->nodes = malloc(sizeof(RankPairingNode) * (capacity + 1));
+  heap->buckets = calloc(MAX_RANK, sizeof(RankPairingNode *));
+  if (heap->nodes == NULL || heap->buckets == NULL)
+  {
+    fprintf(stderr, "Memory is not enough\n");
+    deleteRankPairingHeap(heap);
+    return NULL;
+  }
+  for (int i = 0; i < capacity; i++)
+  {
+    heap->nodes[i].id = i;
+    heap->nodes[i].priority = -1;
+    heap->nodes[i].inHeap = false;
+  }
+  return heap;
+}
+
+/* Frees all memory allocated for rank-pairing heap 'heap'.
+ */
+void deleteRankPairingHeap(RankPairingHeap *heap)
+{
+  free(heap->nodes);
+  free(heap->buckets);
+  free(heap);
+}
+
+/* Prints the half tree rooted at 'node', indented by 'depth'. */
+static void printRankPairingNodes(RankPairingNode *node, int depth)
+{
+  if (node == NULL)
+  {
+    return;
+  }
+  printf("%*s%d [%d] rank %d\n", 2 * depth, "", node->priority, node->id,
+         node->rank);
+  printRankPairingNodes(node->left, depth + 1);
+  printRankPairingNodes(node->right, depth);
+}
+
+void printRankPairingHeap(RankPairingHeap *heap)
+{
+  printf("RankPairingHeap with size: %d\n\tcapacity: %d\n\n", heap->size,
+         heap->capacity);
+  printf("priority [ID] rank\n");
+  RankPairingNode *root = heap->min;
+  do
+  {
+    if (root == NULL)
+      break;
+    printRankPairingNodes(root, 0);
+    root = root->next;
+  } while (root != heap->min);
+  printf("\n\n");
+}
@@ -0,0 +1,86 @@
+/*
+ * Header file for our rank-pairing heap (type 1, Haeupler, Sen and Tarjan):
+ * a Priority Queue with the same operations as MinHeap (see minheap.h), O(1)
+ * insert and O(1) amortized decreasePriority.
+ *
+ * The heap is a list of half-ordered binary trees ("half trees"): a node's
+ * priority is at most that of every node in its left subtree. Nodes come
+ * from a pool allocated with the heap: the node with ID id is nodes[id], so
+ * no operation allocates memory.
+ */
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "minheap.h"
+
+#ifndef __RankPairingHeap_header
+#define __RankPairingHeap_header
+
+typedef struct rank_pairing_node {
+  int priority;                     // priority of this node
+  int id;                           // the unique ID of this node
+  int rank;                         // rank of this node
+  bool inHeap;                      // true iff this node is in the heap
+  struct rank_pairing_node* left;   // left child
+  struct rank_pairing_node* right;  // right child; NULL for roots
+  struct rank_pairing_node* parent; // parent; NULL for roots
+  struct rank_pairing_node* next;   // next root in the circular root list;
+                                    //   only meaningful for roots
+} RankPairingNode;
+
+typedef struct rank_pairing_heap {
+  int size;                 // the number of nodes in this heap
+  int capacity;             // the number of nodes that can be stored
+  RankPairingNode* nodes;   // the node pool; nodes[id] is the node with ID id
+  RankPairingNode* min;     // the root with minimum priority; NULL if empty
+  RankPairingNode** buckets;  // scratch space for extractMin, one per rank
+} RankPairingHeap;
+
+/* Returns the node with minimum priority in rank-pairing heap 'heap'.
+ * Precondition: heap is non-empty
+ */
+HeapNode rankPairingGetMin(RankPairingHeap* heap);
+
+/* Removes and returns the node with minimum priority in rank-pairing heap
+ * 'heap'.
+ * Precondition: heap is non-empty
+ */
+HeapNode rankPairingExtractMin(RankPairingHeap* heap);
+
+/* Inserts a new node with priority 'priority' and ID 'id' into rank-pairing
+ * heap 'heap'.
+ * Precondition: 'id' is unique within this heap
+ *               0 <= 'id' < heap->capacity
+ */
+void rankPairingInsert(RankPairingHeap* heap, int priority, int id);
+
+/* Returns priority of the node with ID 'id' in 'heap'.
+ * Precondition: 'id' is a valid node ID in 'heap'.
+ */
+int rankPairingGetPriority(RankPairingHeap* heap, int id);
+
+/* Sets priority of node with ID 'id' in rank-pairing heap 'heap' to
+ * 'newPriority', if such a node exists in 'heap' and its priority is larger
+ * than 'newPriority', and returns True. Has no effect and returns False,
+ * otherwise.
+ */
+bool rankPairingDecreasePriority(RankPairingHeap* heap, int id,
+                                 int newPriority);
+
+/* Prints the contents of this heap: size, capacity, and the ID, priority and
+ * rank of every node in it, tree by tree.
+ */
+void printRankPairingHeap(RankPairingHeap* heap);
+
+/* Returns a newly created empty rank-pairing heap with capacity 'capacity'.
+ * Precondition: capacity >= 0
+ */
+RankPairingHeap* newRankPairingHeap(int capacity);
+
+/* Frees all memory allocated for rank-pairing heap 'heap'.
+ */
+void deleteRankPairingHeap(RankPairingHeap* heap);
+
+#endif
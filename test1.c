@@ -2,9 +2,38 @@
 #include <stdlib.h>
 #include <string.h>
 #include <assert.h>
+#include <sys/socket.h>
+#include <sys/un.h>
 #include "graph.c"
 #include "graph_algos.c"
+#include "graph_apsp.c"
+#include "graph_batch.c"
+#include "graph_bfs.c"
+#include "graph_compact.c"
+#include "graph_external.c"
+#include "graph_ids.c"
+#include "graph_build.c"
+#include "graph_io.c"
+#include "graph_labels.c"
+#include "graph_many.c"
+#include "graph_oracle.c"
+#include "graph_output.c"
+#include "graph_paths.c"
+#include "graph_parallel.c"
+#include "graph_plan.c"
+#include "graph_query.c"
+#include "graph_snapshot.c"
+#include "graph_view.c"
 #include "minheap.c"
+#include "multiqueue.c"
+#include "pairing_heap.c"
+#include "parallel.c"
+#include "rank_pairing_heap.c"
+
+// The programs under test have their own main
+#define main graphServerMain
+#include "graph_server.c"
+#undef main
 
 // Helper function to add an undirected edge to the graph
 void addUndirectedEdge(Graph *graph, int from, int to, int weight)
@@ -61,8 +90,1413 @@ void testGetMSTprim()
     free(mst);
 }
 
+// Returns a connected graph with 'numVertices' vertices, about 'percent'
+// percent of all possible undirected edges, and weights in [1, maxWeight]
+Graph *randomUndirectedGraph(int numVertices, int percent, int maxWeight)
+{
+    Graph *graph = newGraph(numVertices);
+    for (int i = 0; i < graph->numVertices; i++)
+    {
+        graph->vertices[i] = newVertex(i, NULL, NULL);
+    }
+    for (int u = 0; u < numVertices; u++)
+    {
+        for (int v = u + 1; v < numVertices; v++)
+        {
+            if (v == u + 1 || rand() % 100 < percent)
+            {
+                addUndirectedEdge(graph, u, v, 1 + rand() % maxWeight);
+            }
+        }
+    }
+    return graph;
+}
+
+// Returns the total weight of the 'numEdges' edges in 'edges'
+long totalWeight(Edge *edges, int numEdges)
+{
+    long total = 0;
+    for (int i = 0; i < numEdges; i++)
+    {
+        total += edges[i].weight;
+    }
+    return total;
+}
+
+// Test function to verify that dense Prim finds an MST of the same weight as
+// the heap-based getMSTprim, from a Graph and from an adjacency matrix
+void testGetMSTprimDense()
+{
+    srand(1);
+    Graph *graph = randomUndirectedGraph(100, 40, 1000);
+    int n = graph->numVertices;
+    int *weights = malloc(sizeof(int) * n * n);
+    for (int i = 0; i < n * n; i++)
+    {
+        weights[i] = -1;
+    }
+    for (int u = 0; u < n; u++)
+    {
+        for (EdgeList *cur = graph->vertices[u]->adjList; cur != NULL;
+             cur = cur->next)
+        {
+            weights[u * n + cur->edge->toVertex] = cur->edge->weight;
+        }
+    }
+
+    Edge *heap = getMSTprim(graph, 0);
+    Edge *dense = getMSTprimDense(graph, 0);
+    Edge *matrix = getMSTprimMatrix(weights, n, 0);
+    assert(heap != NULL && dense != NULL && matrix != NULL);
+    assert(totalWeight(dense, n - 1) == totalWeight(heap, n - 1));
+    assert(totalWeight(matrix, n - 1) == totalWeight(heap, n - 1));
+
+    free(heap);
+    free(dense);
+    free(matrix);
+    free(weights);
+    deleteGraph(graph);
+}
+
+// Test function to verify that the breadth-first search finds the same
+// distances as getDistanceTreeDijkstra when all weights are the same
+void testGetDistanceTreeBFS()
+{
+    srand(2);
+    Graph *graph = randomUndirectedGraph(300, 2, 1);
+    int n = graph->numVertices;
+    for (int u = 0; u < n; u++)
+    {
+        for (EdgeList *cur = graph->vertices[u]->adjList; cur != NULL;
+             cur = cur->next)
+        {
+            cur->edge->weight = 3;
+        }
+    }
+
+    for (int threads = 1; threads <= 4; threads *= 2)
+    {
+        Edge *heap = getDistanceTreeDijkstra(graph, 5);
+        Edge *bfs = getDistanceTreeBFS(graph, 5, 3, threads);
+        assert(heap != NULL && bfs != NULL);
+        int *distance = malloc(sizeof(int) * n);
+        for (int i = 0; i < n; i++)
+        {
+            distance[heap[i].fromVertex] = heap[i].weight;
+        }
+        for (int i = 0; i < n; i++)
+        {
+            assert(bfs[i].weight == distance[bfs[i].fromVertex]);
+        }
+        free(distance);
+        free(heap);
+        free(bfs);
+    }
+    deleteGraph(graph);
+}
+
+// Test function to verify that a symmetric graph with merged parallel edges
+// has the MST of the same graph built with two Edges per undirected edge
+void testSymmetricGraph()
+{
+    Graph *symmetric = newSymmetricGraph(4);
+    addSymmetricEdge(symmetric, 0, 1, 10);
+    addSymmetricEdge(symmetric, 1, 0, 12);
+    addSymmetricEdge(symmetric, 0, 2, 6);
+    addSymmetricEdge(symmetric, 0, 3, 5);
+    addSymmetricEdge(symmetric, 3, 1, 15);
+    addSymmetricEdge(symmetric, 2, 3, 4);
+    addSymmetricEdge(symmetric, 3, 2, 4);
+    assert(isSymmetricGraph(symmetric));
+    assert(mergeSymmetricEdges(symmetric));
+    assert(symmetric->numEdges == 5);
+
+    Graph *directed = newGraph(4);
+    for (int i = 0; i < directed->numVertices; i++)
+    {
+        directed->vertices[i] = newVertex(i, NULL, NULL);
+    }
+    addUndirectedEdge(directed, 0, 1, 10);
+    addUndirectedEdge(directed, 0, 2, 6);
+    addUndirectedEdge(directed, 0, 3, 5);
+    addUndirectedEdge(directed, 1, 3, 15);
+    addUndirectedEdge(directed, 2, 3, 4);
+    assert(!isSymmetricGraph(directed));
+
+    Edge *mst = getMSTprim(symmetric, 0);
+    Edge *expected = getMSTprim(directed, 0);
+    assert(totalWeight(mst, 3) == 19);
+    assert(totalWeight(mst, 3) == totalWeight(expected, 3));
+
+    free(mst);
+    free(expected);
+    deleteGraph(symmetric);
+    deleteGraph(directed);
+}
+
+// Test function to verify that a distance table reports distances longer
+// than INT_MAX, and marks unreachable and invalid vertices
+void testGetDistanceTable()
+{
+    // 0 -- 1 -- 2 with two heavy edges, and 3 on its own
+    Graph *graph = newGraph(4);
+    for (int i = 0; i < graph->numVertices; i++)
+    {
+        graph->vertices[i] = newVertex(i, NULL, NULL);
+    }
+    addUndirectedEdge(graph, 0, 1, INT_MAX - 1);
+    addUndirectedEdge(graph, 1, 2, INT_MAX - 1);
+
+    int sources[] = {0, 2, 9};
+    int targets[] = {2, 1, 3, 0};
+    int64_t table[3 * 4];
+    for (int threads = 1; threads <= 2; threads++)
+    {
+        assert(getDistanceTable(graph, sources, 3, targets, 4, table,
+                                threads));
+        assert(table[0] == 2 * (int64_t)(INT_MAX - 1));
+        assert(table[1] == INT_MAX - 1);
+        assert(table[2] == TABLE_UNREACHABLE);
+        assert(table[3] == 0);
+        assert(table[4] == 0);
+        assert(table[5] == INT_MAX - 1);
+        assert(table[6] == TABLE_UNREACHABLE);
+        assert(table[7] == 2 * (int64_t)(INT_MAX - 1));
+        for (int j = 8; j < 12; j++)
+        {
+            assert(table[j] == -1);
+        }
+    }
+    deleteGraph(graph);
+}
+
+// Test function to verify that buildHeap lays out a valid minheap, with
+// duplicate priorities, that decreasePriority and extractMin then keep valid
+void testBuildHeap()
+{
+    int ids[] = {7, 2, 9, 0, 5, 3, 8, 1};
+    int priorities[] = {40, 15, 40, 90, 15, 70, 5, 60};
+    MinHeap *heap = newHeap(10);
+    buildHeap(heap, ids, priorities, 8);
+    assert(heap->size == 8);
+
+    assert(decreasePriority(heap, 0, 1));
+    assert(decreasePriority(heap, 3, 15));
+    assert(decreasePriority(heap, 9, 10));
+    int expected[] = {1, 5, 10, 15, 15, 15, 40, 60};
+    for (int i = 0; i < 8; i++)
+    {
+        // Every node is where indexMap says, and no child is above its parent
+        for (int j = 1; j <= heap->size; j++)
+        {
+            assert(heap->indexMap[heap->arr[j].id] == j);
+            assert(j == 1 ||
+                   heap->arr[j / 2].priority <= heap->arr[j].priority);
+        }
+        assert(extractMin(heap).priority == expected[i]);
+    }
+    assert(heap->size == 0);
+    deleteHeap(heap);
+}
+
+// Test function to verify that the pairing and rank-pairing heaps hand out
+// their nodes in priority order after inserts and decreases, and refuse to
+// decrease nodes that are larger or no longer in the heap
+void testPairingHeaps()
+{
+    int priorities[] = {40, 15, 40, 90, 15, 70, 5, 60};
+    PairingHeap *pairing = newPairingHeap(10);
+    RankPairingHeap *rankPairing = newRankPairingHeap(10);
+    for (int id = 0; id < 8; id++)
+    {
+        pairingInsert(pairing, priorities[id], id);
+        rankPairingInsert(rankPairing, priorities[id], id);
+    }
+    assert(pairingGetMin(pairing).id == 6);
+    assert(rankPairingGetMin(rankPairing).id == 6);
+
+    // 3 and 7 overtake everything; 1 may not go up
+    assert(pairingDecreasePriority(pairing, 3, 1));
+    assert(pairingDecreasePriority(pairing, 7, 2));
+    assert(!pairingDecreasePriority(pairing, 1, 30));
+    assert(rankPairingDecreasePriority(rankPairing, 3, 1));
+    assert(rankPairingDecreasePriority(rankPairing, 7, 2));
+    assert(!rankPairingDecreasePriority(rankPairing, 1, 30));
+    assert(pairingGetPriority(pairing, 3) == 1);
+    assert(rankPairingGetPriority(rankPairing, 7) == 2);
+
+    int expectedIds[] = {3, 7, 6};
+    for (int i = 0; i < 3; i++)
+    {
+        assert(pairingExtractMin(pairing).id == expectedIds[i]);
+        assert(rankPairingExtractMin(rankPairing).id == expectedIds[i]);
+    }
+    assert(!pairingDecreasePriority(pairing, 6, 0));
+    assert(!rankPairingDecreasePriority(rankPairing, 6, 0));
+
+    // Decrease after extracting, then insert a new minimum
+    assert(pairingDecreasePriority(pairing, 5, 20));
+    assert(rankPairingDecreasePriority(rankPairing, 5, 20));
+    pairingInsert(pairing, 3, 9);
+    rankPairingInsert(rankPairing, 3, 9);
+    int expected[] = {3, 15, 15, 20, 40, 40};
+    for (int i = 0; i < 6; i++)
+    {
+        assert(pairingExtractMin(pairing).priority == expected[i]);
+        assert(rankPairingExtractMin(rankPairing).priority == expected[i]);
+    }
+    assert(pairing->size == 0 && pairing->root == NULL);
+    deletePairingHeap(pairing);
+    deleteRankPairingHeap(rankPairing);
+}
+
+// Test function to verify that a query server worker answers every kind of
+// request over its Unix domain socket, one line each, and stops cleanly
+void testGraphServer()
+{
+    Graph *graph = newGraph(4);
+    for (int i = 0; i < graph->numVertices; i++)
+    {
+        graph->vertices[i] = newVertex(i, NULL, NULL);
+    }
+    addUndirectedEdge(graph, 0, 1, 2);
+    addUndirectedEdge(graph, 1, 2, 3);
+    addUndirectedEdge(graph, 0, 2, 10);
+    addUndirectedEdge(graph, 2, 3, 4);
+
+    char socketPath[64];
+    snprintf(socketPath, sizeof(socketPath), "/tmp/test1-%d.sock", getpid());
+    Server server;
+    server.graph = graph;
+    server.mstWeight = getMSTWeight(graph);
+    server.listener = openListener(socketPath);
+    assert(server.listener >= 0);
+    server.numWorkers = 1;
+    server.workers = calloc(1, sizeof(Worker));
+    server.stopping = false;
+    pthread_mutex_init(&server.clientsLock, NULL);
+    Worker *worker = &server.workers[0];
+    worker->server = &server;
+    worker->client = -1;
+    worker->workspace = newQueryWorkspace(graph->numVertices);
+    worker->path = malloc(sizeof(int) * (graph->numVertices + 1));
+    assert(pthread_create(&worker->thread, NULL, serveConnections, worker) ==
+           0);
+
+    struct sockaddr_un address;
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    strcpy(address.sun_path, socketPath);
+    int client = socket(AF_UNIX, SOCK_STREAM, 0);
+    assert(connect(client, (struct sockaddr *)&address, sizeof(address)) ==
+           0);
+    FILE *in = fdopen(client, "r");
+    FILE *out = fdopen(dup(client), "w");
+    fprintf(out, "DIST 0 3\nPATH 0 3\nKNN 0 2\nMST\nINFO\nDIST 0 9\n"
+                 "BOGUS\nSTATS\nQUIT\n");
+    fflush(out);
+    const char *expected[] = {"9\n", "9 0 1 2 3\n", "2 0:0 1:2\n", "9\n",
+                              "vertices 4 edges 8 workers 1\n",
+                              "ERROR no such vertex\n",
+                              "ERROR unknown request: BOGUS\n"};
+    char line[MAX_REQUEST];
+    for (int i = 0; i < 7; i++)
+    {
+        assert(fgets(line, sizeof(line), in) != NULL);
+        assert(strcmp(line, expected[i]) == 0);
+    }
+    // STATS counts the requests answered before it
+    assert(fgets(line, sizeof(line), in) != NULL);
+    assert(strncmp(line, "queries 7 p50 ", 14) == 0);
+    // QUIT closes the connection
+    assert(fgets(line, sizeof(line), in) == NULL);
+    fclose(out);
+    fclose(in);
+
+    pthread_mutex_lock(&server.clientsLock);
+    server.stopping = true;
+    shutdown(server.listener, SHUT_RDWR);
+    pthread_mutex_unlock(&server.clientsLock);
+    pthread_join(worker->thread, NULL);
+    close(server.listener);
+    unlink(socketPath);
+    pthread_mutex_destroy(&server.clientsLock);
+    deleteQueryWorkspace(worker->workspace);
+    free(worker->path);
+    free(server.workers);
+    deleteGraph(graph);
+}
+
+// Test function to verify that a batch of queries is read with its errors,
+// and answered in order whatever the number of threads, also when it has
+// more answers than fit in the window held back for ordering
+void testRunQueries()
+{
+    // 0 -- 1 -- 2 -- 3 with a long way round from 0 to 2, and 4 on its own
+    Graph *graph = newGraph(5);
+    for (int i = 0; i < graph->numVertices; i++)
+    {
+        graph->vertices[i] = newVertex(i, NULL, NULL);
+    }
+    addUndirectedEdge(graph, 0, 1, 2);
+    addUndirectedEdge(graph, 1, 2, 3);
+    addUndirectedEdge(graph, 0, 2, 10);
+    addUndirectedEdge(graph, 2, 3, 4);
+
+    char text[] = "# every kind of query\n\nprim 0\ndijkstra 0\ndist 0 3\n"
+                  "path 0 3\npath 0 4\nknn 0 2\ndist 0 9\nfoo 1\ndist 1\n";
+    FILE *f = fmemopen(text, strlen(text), "r");
+    long numQueries;
+    Query *queries = readQueries(f, &numQueries);
+    fclose(f);
+    assert(numQueries == 9);
+    assert(queries[0].type == QUERY_PRIM && queries[0].line == 3);
+    assert(queries[7].type == QUERY_ERROR && queries[7].line == 10);
+
+    const char *expected = "prim 0 -1\n"
+                           "dijkstra 0 0 2 5 9 -1\n"
+                           "dist 0 3 9\n"
+                           "path 0 3 9 0 1 2 3\n"
+                           "path 0 4 -1\n"
+                           "knn 0 2 2 0:0 1:2\n"
+                           "error 9\n"
+                           "error 10\n"
+                           "error 11\n";
+    char *output;
+    size_t length;
+    for (int threads = 1; threads <= 3; threads += 2)
+    {
+        FILE *out = open_memstream(&output, &length);
+        assert(runQueries(graph, queries, numQueries, out, threads) == 6);
+        fclose(out);
+        assert(strcmp(output, expected) == 0);
+        free(output);
+    }
+    free(queries);
+
+    // Three windows' worth of queries, from sources 0, 1, 2, 3 in turn
+    long numMany = 3 * WINDOW;
+    Query *many = malloc(sizeof(Query) * numMany);
+    for (long i = 0; i < numMany; i++)
+    {
+        many[i].type = QUERY_DIST;
+        many[i].source = i % 4;
+        many[i].target = 3;
+        many[i].line = i + 1;
+    }
+    int distances[] = {9, 7, 4, 0};
+    for (int threads = 1; threads <= 3; threads += 2)
+    {
+        FILE *out = open_memstream(&output, &length);
+        assert(runQueries(graph, many, numMany, out, threads) == numMany);
+        fclose(out);
+        char *line = output;
+        for (long i = 0; i < numMany; i++)
+        {
+            int s, t, d, used;
+            assert(sscanf(line, "dist %d %d %d\n%n", &s, &t, &d, &used) == 3);
+            assert(s == i % 4 && t == 3 && d == distances[s]);
+            line += used;
+        }
+        assert(*line == '\0');
+        free(output);
+    }
+    free(many);
+    deleteGraph(graph);
+}
+
+// Test function to verify that a pinned snapshot does not see later drafts,
+// that a new one does, and that old versions are freed only once no reader
+// can see them
+void testGraphSnapshots()
+{
+    Graph *symmetric = newSymmetricGraph(4);
+    addSymmetricEdge(symmetric, 0, 1, 10);
+    addSymmetricEdge(symmetric, 1, 2, 3);
+    addSymmetricEdge(symmetric, 2, 3, 4);
+    GraphSnapshots *snapshots = newGraphSnapshots(symmetric, deleteGraph);
+    int first = registerSnapshotReader(snapshots);
+    Graph *old = pinSnapshot(snapshots, first);
+    assert(currentSnapshotNumber(snapshots) == 0);
+
+    GraphDraft draft;
+    assert(beginDraft(snapshots, &draft));
+    assert(draftSetEdge(&draft, 0, 1, 2));
+    assert(draftSetEdge(&draft, 3, 0, 7));
+    assert(!draftSetEdge(&draft, 0, 9, 1));
+    assert(!draftSetEdge(&draft, 0, 1, -1));
+    assert(publishDraft(&draft) == 1);
+
+    // The pinned version is unchanged
+    assert(edgeWeight(old, 0, 1) == 10 && edgeWeight(old, 1, 0) == 10);
+    assert(edgeWeight(old, 0, 3) == INT_MAX);
+    assert(edgeWeight(old, 3, 0) == INT_MAX);
+    assert(old->numEdges == 3);
+
+    // The new one has both changes in both directions
+    int second = registerSnapshotReader(snapshots);
+    Graph *current = pinSnapshot(snapshots, second);
+    assert(edgeWeight(current, 0, 1) == 2 && edgeWeight(current, 1, 0) == 2);
+    assert(edgeWeight(current, 0, 3) == 7 && edgeWeight(current, 3, 0) == 7);
+    assert(edgeWeight(current, 1, 2) == 3 && edgeWeight(current, 3, 2) == 4);
+    assert(current->numEdges == 4);
+
+    // A discarded draft changes nothing
+    assert(beginDraft(snapshots, &draft));
+    assert(draftSetEdge(&draft, 1, 2, 99));
+    discardDraft(&draft);
+    assert(currentSnapshotNumber(snapshots) == 1);
+    assert(edgeWeight(current, 1, 2) == 3);
+
+    // Version 0 waits for the first reader only
+    assert(reclaimSnapshots(snapshots) == 1);
+    unpinSnapshot(snapshots, first);
+    assert(reclaimSnapshots(snapshots) == 0);
+    unpinSnapshot(snapshots, second);
+    unregisterSnapshotReader(snapshots, first);
+    unregisterSnapshotReader(snapshots, second);
+    deleteGraphSnapshots(snapshots);
+}
+
+// Helper function for testScheduler: counts every index of a range once
+void countRange(void *ctx, long begin, long end)
+{
+    int *counts = ctx;
+    for (long i = begin; i < end; i++)
+    {
+        __atomic_add_fetch(&counts[i], 1, __ATOMIC_RELAXED);
+    }
+}
+
+// Helper function for testScheduler: marks the part it is run for
+void markPart(void *ctx, int thread, int numThreads)
+{
+    int *counts = ctx;
+    assert(thread >= 0 && thread < numThreads);
+    __atomic_add_fetch(&counts[thread], 1, __ATOMIC_RELAXED);
+}
+
+// Helper function for testScheduler: waits until every part has started,
+// which only works if all of them run at the same time
+void meetParts(void *ctx, int thread, int numThreads)
+{
+    (void)thread;
+    int *arrived = ctx;
+    __atomic_add_fetch(arrived, 1, __ATOMIC_RELAXED);
+    while (__atomic_load_n(arrived, __ATOMIC_RELAXED) < numThreads)
+    {
+        sched_yield();
+    }
+}
+
+typedef struct fibonacci
+{
+    int n;
+    long result;
+} Fibonacci;
+
+// Helper function for testScheduler: computes a Fibonacci number with one
+// task per call, nested as deep as n
+void fibonacciTask(void *arg)
+{
+    Fibonacci *fib = arg;
+    if (fib->n < 2)
+    {
+        fib->result = fib->n;
+        return;
+    }
+    Fibonacci left = {fib->n - 1, 0};
+    Fibonacci right = {fib->n - 2, 0};
+    TaskGroup group = {0};
+    Task task;
+    spawnTask(&task, &group, fibonacciTask, &left);
+    fibonacciTask(&right);
+    waitTasks(&group);
+    fib->result = left.result + right.result;
+}
+
+// Test function to verify that the scheduler runs every part and every
+// index exactly once, nested tasks to completion, and blocking parts at the
+// same time
+void testScheduler()
+{
+    int counts[100000] = {0};
+    parallelFor(0, 100000, 7, countRange, counts);
+    parallelFor(50000, 100000, 100000, countRange, counts);
+    parallelFor(10, 10, 1, countRange, counts);
+    for (int i = 0; i < 100000; i++)
+    {
+        assert(counts[i] == (i < 50000 ? 1 : 2));
+    }
+
+    // More parts than workers
+    int parts[64] = {0};
+    parallelRun(64, markPart, parts);
+    for (int i = 0; i < 64; i++)
+    {
+        assert(parts[i] == 1);
+    }
+
+    Fibonacci fib = {20, 0};
+    fibonacciTask(&fib);
+    assert(fib.result == 6765);
+
+    int arrived = 0;
+    runThreads(4, meetParts, &arrived);
+    assert(arrived == 4);
+
+    assert(partStart(10, 0, 3) == 0);
+    assert(partStart(10, 3, 3) == 10);
+    for (int part = 0; part < 3; part++)
+    {
+        long size = partStart(10, part + 1, 3) - partStart(10, part, 3);
+        assert(size == 3 || size == 4);
+    }
+}
+
+// Test function to verify that distance oracles stay within their stretch
+// of the true distances, find unreachable and invalid vertices, and answer
+// the same after a save and load
+void testDistanceOracle()
+{
+    Graph *graph = randomUndirectedGraph(60, 10, 100);
+    int n = graph->numVertices;
+    int *all = malloc(sizeof(int) * n);
+    for (int v = 0; v < n; v++)
+    {
+        all[v] = v;
+    }
+    int64_t *exact = malloc(sizeof(int64_t) * n * n);
+    assert(getDistanceTable(graph, all, n, all, n, exact, 1));
+
+    for (int k = 1; k <= 3; k++)
+    {
+        DistanceOracle *oracle = newDistanceOracle(graph, k, 7, 2);
+        assert(oracle != NULL);
+        FILE *f = tmpfile();
+        assert(saveOracle(oracle, f));
+        rewind(f);
+        DistanceOracle *loaded = loadOracle(f);
+        fclose(f);
+        assert(loaded != NULL && loaded->numEntries == oracle->numEntries);
+        for (int u = 0; u < n; u++)
+        {
+            for (int v = 0; v < n; v++)
+            {
+                int64_t estimate = getOracleDistance(oracle, u, v);
+                assert(estimate >= exact[u * n + v]);
+                assert(estimate <= (2 * k - 1) * exact[u * n + v]);
+                assert(getOracleDistance(loaded, u, v) == estimate);
+            }
+        }
+        assert(getOracleDistance(oracle, 0, n) == -1);
+        deleteDistanceOracle(oracle);
+        deleteDistanceOracle(loaded);
+    }
+    assert(newDistanceOracle(graph, 0, 7, 1) == NULL);
+    free(exact);
+    free(all);
+    deleteGraph(graph);
+
+    // 0 -- 1, and 2 on its own
+    graph = newGraph(3);
+    for (int i = 0; i < graph->numVertices; i++)
+    {
+        graph->vertices[i] = newVertex(i, NULL, NULL);
+    }
+    addUndirectedEdge(graph, 0, 1, 5);
+    DistanceOracle *oracle = newDistanceOracle(graph, 2, 7, 1);
+    assert(getOracleDistance(oracle, 1, 0) == 5);
+    assert(getOracleDistance(oracle, 2, 2) == 0);
+    assert(getOracleDistance(oracle, 0, 2) == ORACLE_UNREACHABLE);
+    deleteDistanceOracle(oracle);
+    deleteGraph(graph);
+
+    // Not an oracle
+    FILE *f = tmpfile();
+    fprintf(f, "not an oracle");
+    rewind(f);
+    assert(loadOracle(f) == NULL);
+    fclose(f);
+}
+
+// Helper function to run getMSTexternal on 'edges' with the smallest memory
+// budget, and return the total weight of the forest it writes, checking
+// that it comes in order of weight
+long externalForestWeight(FILE *edges, bool text, ExternalStats *stats)
+{
+    rewind(edges);
+    FILE *treeFile = tmpfile();
+    Output *tree = newOutput(fileno(treeFile), 0, true);
+    bool ok = getMSTexternal(edges, text, tree, 3 * MIN_MERGE_BUFFER, NULL,
+                             stats);
+    assert(deleteOutput(tree));
+    long total = ok ? 0 : -1;
+    rewind(treeFile);
+    Edge edge;
+    int lastWeight = 0;
+    for (long i = 0; ok && fread(&edge, sizeof(Edge), 1, treeFile) == 1; i++)
+    {
+        assert(edge.weight >= lastWeight);
+        lastWeight = edge.weight;
+        total += edge.weight;
+        assert(i < stats->numTreeEdges);
+    }
+    fclose(treeFile);
+    return total;
+}
+
+// Test function to verify that the external MST matches Prim's algorithm
+// when the edges need several runs and a merge pass, from binary and text
+// edge files, and rejects invalid edges
+void testGetMSTexternal()
+{
+    Graph *graph = randomUndirectedGraph(600, 30, 1000);
+    int n = graph->numVertices;
+    FILE *binary = tmpfile();
+    FILE *text = tmpfile();
+    fprintf(text, "%d\n", n);
+    long numEdges = 0;
+    for (int u = 0; u < n; u++)
+    {
+        for (EdgeList *cur = graph->vertices[u]->adjList; cur != NULL;
+             cur = cur->next)
+        {
+            if (cur->edge->toVertex > u)
+            {
+                fwrite(cur->edge, sizeof(Edge), 1, binary);
+                fprintf(text, "%d %d %d\n", u, cur->edge->toVertex,
+                        cur->edge->weight);
+                numEdges++;
+            }
+        }
+    }
+    Edge *mst = getMSTprim(graph, 0);
+    long expected = totalWeight(mst, n - 1);
+
+    ExternalStats stats;
+    assert(externalForestWeight(binary, false, &stats) == expected);
+    assert(stats.numEdges == numEdges && stats.numVertices == n);
+    assert(stats.numRuns > 2 && stats.numMergePasses >= 1);
+    assert(stats.numTreeEdges == n - 1 && stats.totalWeight == expected);
+    assert(externalForestWeight(text, true, &stats) == expected);
+    assert(stats.numEdges == numEdges && stats.numTreeEdges == n - 1);
+
+    // A negative weight
+    Edge bad = {1, 2, -5};
+    fseek(binary, 0, SEEK_END);
+    fwrite(&bad, sizeof(Edge), 1, binary);
+    assert(externalForestWeight(binary, false, &stats) == -1);
+
+    fclose(binary);
+    fclose(text);
+    free(mst);
+    deleteGraph(graph);
+}
+
+// Test function to verify that hub labels give exact distances, padded
+// labels in rank order, and the same answers after a save and load
+void testHubLabels()
+{
+    Graph *graph = randomUndirectedGraph(80, 8, 100);
+    int n = graph->numVertices;
+    int *all = malloc(sizeof(int) * n);
+    for (int v = 0; v < n; v++)
+    {
+        all[v] = v;
+    }
+    int64_t *exact = malloc(sizeof(int64_t) * n * n);
+    assert(getDistanceTable(graph, all, n, all, n, exact, 1));
+
+    HubLabels *labels = newHubLabels(graph);
+    assert(labels != NULL);
+    FILE *f = tmpfile();
+    assert(saveHubLabels(labels, f));
+    rewind(f);
+    HubLabels *loaded = loadHubLabels(f);
+    fclose(f);
+    assert(loaded != NULL && loaded->numEntries == labels->numEntries);
+    for (int v = 0; v < n; v++)
+    {
+        long start = labels->labelStart[v];
+        long end = labels->labelStart[v + 1];
+        assert((end - start) % HUB_BLOCK == 0);
+        assert(labels->hubs[end - 1] == HUB_END);
+        for (long i = start + 1; i < end && labels->hubs[i] != HUB_END; i++)
+        {
+            assert(labels->hubs[i - 1] < labels->hubs[i]);
+        }
+    }
+    for (int s = 0; s < n; s++)
+    {
+        for (int t = 0; t < n; t++)
+        {
+            assert(getLabelDistance(labels, s, t) == exact[s * n + t]);
+            assert(getLabelDistance(loaded, s, t) == exact[s * n + t]);
+        }
+    }
+    assert(getLabelDistance(labels, -1, 0) == -1);
+    assert(getLabelDistance(labels, 0, n) == -1);
+    deleteHubLabels(labels);
+    deleteHubLabels(loaded);
+    free(exact);
+    free(all);
+    deleteGraph(graph);
+
+    // A symmetric graph: 0 -- 1 -- 2, and 3 on its own
+    Graph *symmetric = newSymmetricGraph(4);
+    addSymmetricEdge(symmetric, 0, 1, 4);
+    addSymmetricEdge(symmetric, 1, 2, 6);
+    labels = newHubLabels(symmetric);
+    assert(getLabelDistance(labels, 2, 0) == 10);
+    assert(getLabelDistance(labels, 3, 3) == 0);
+    assert(getLabelDistance(labels, 0, 3) == INT_MAX);
+    deleteHubLabels(labels);
+    deleteGraph(symmetric);
+
+    f = tmpfile();
+    fprintf(f, "no labels here");
+    rewind(f);
+    assert(loadHubLabels(f) == NULL);
+    fclose(f);
+}
+
+// Helper function to collect in 'distances' the distance of every loopless
+// path from 'u', at 'distance' so far, to 'target' in 'graph', where
+// 'onPath' marks the vertices already on the path
+void allPathDistances(Graph *graph, int u, int target, long distance,
+                      bool *onPath, long *distances, int *numDistances)
+{
+    if (u == target)
+    {
+        distances[(*numDistances)++] = distance;
+        return;
+    }
+    onPath[u] = true;
+    for (int v = 0; v < graph->numVertices; v++)
+    {
+        int weight = edgeWeight(graph, u, v);
+        if (!onPath[v] && weight != INT_MAX)
+        {
+            allPathDistances(graph, v, target, distance + weight, onPath,
+                             distances, numDistances);
+        }
+    }
+    onPath[u] = false;
+}
+
+// Helper function to order distances with qsort
+int compareLongs(const void *a, const void *b)
+{
+    long x = *(const long *)a, y = *(const long *)b;
+    return (x > y) - (x < y);
+}
+
+// Test function to verify that the k shortest paths are loopless, distinct,
+// and as short as the shortest of all loopless paths found by brute force
+void testGetKShortestPaths()
+{
+    Graph *graph = randomUndirectedGraph(8, 40, 20);
+    int n = graph->numVertices;
+    bool onPath[8] = {false};
+    long *distances = malloc(sizeof(long) * 100000);
+    int numPaths = 0;
+    allPathDistances(graph, 0, n - 1, 0, onPath, distances, &numPaths);
+    qsort(distances, numPaths, sizeof(long), compareLongs);
+
+    int k = 50;
+    int numRoutes;
+    Route *routes = getKShortestPaths(graph, 0, n - 1, k, &numRoutes);
+    assert(routes != NULL);
+    assert(numRoutes == (numPaths < k ? numPaths : k));
+    for (int r = 0; r < numRoutes; r++)
+    {
+        Route *route = &routes[r];
+        assert(route->distance == distances[r]);
+        assert(route->vertices[0] == 0);
+        assert(route->vertices[route->numVertices - 1] == n - 1);
+        long distance = 0;
+        bool seen[8] = {false};
+        for (int i = 0; i < route->numVertices; i++)
+        {
+            assert(!seen[route->vertices[i]]);
+            seen[route->vertices[i]] = true;
+            if (i > 0)
+            {
+                distance += edgeWeight(graph, route->vertices[i - 1],
+                                       route->vertices[i]);
+            }
+        }
+        assert(distance == route->distance);
+        for (int other = 0; other < r; other++)
+        {
+            assert(!sameRoute(route, &routes[other]));
+        }
+    }
+    deleteRoutes(routes, numRoutes);
+    assert(getKShortestPaths(graph, 0, n, 1, &numRoutes) == NULL);
+    assert(getKShortestPaths(graph, 0, 1, 0, &numRoutes) == NULL);
+    free(distances);
+    deleteGraph(graph);
+
+    // 0 -- 1, and 2 on its own
+    graph = newGraph(3);
+    for (int i = 0; i < graph->numVertices; i++)
+    {
+        graph->vertices[i] = newVertex(i, NULL, NULL);
+    }
+    addUndirectedEdge(graph, 0, 1, 5);
+    routes = getKShortestPaths(graph, 0, 2, 3, &numRoutes);
+    assert(routes != NULL && numRoutes == 0);
+    deleteRoutes(routes, numRoutes);
+    deleteGraph(graph);
+}
+
+// Helper function to load 'text' as an edge stream with external IDs
+Graph *loadWithIds(const char *text, bool symmetric, int numThreads,
+                   IdMap **ids)
+{
+    FILE *f = tmpfile();
+    fputs(text, f);
+    rewind(f);
+    Graph *graph = createGraphWithIds(f, symmetric, numThreads, ids);
+    fclose(f);
+    return graph;
+}
+
+// Test function to verify that 64-bit vertex IDs are numbered in increasing
+// order whatever the number of threads, that dense IDs keep their values,
+// and that malformed streams are refused
+void testGraphWithIds()
+{
+    const char *text = "3\n9000000000 -5 7\n42 9000000000 3\n"
+                       "-5 42 2\n42 -5 1\n";
+    for (int threads = 1; threads <= 3; threads += 2)
+    {
+        IdMap *ids;
+        Graph *graph = loadWithIds(text, false, threads, &ids);
+        assert(graph != NULL && graph->numVertices == 3);
+        assert(ids->externalIds[0] == -5 && ids->externalIds[1] == 42);
+        assert(ids->externalIds[2] == 9000000000LL);
+        assert(getInternalId(ids, 9000000000LL) == 2);
+        assert(getInternalId(ids, 7) == -1);
+        assert(edgeWeight(graph, 2, 0) == 7);
+        assert(edgeWeight(graph, 1, 2) == 3);
+        assert(edgeWeight(graph, 0, 1) == 2);
+        assert(edgeWeight(graph, 1, 0) == 1);
+        assert(edgeWeight(graph, 0, 2) == INT_MAX);
+        deleteBuiltGraph(graph);
+        deleteIdMap(ids);
+
+        // Both directions, keeping the lighter of the two -5 -- 42 edges
+        graph = loadWithIds(text, true, threads, &ids);
+        assert(edgeWeight(graph, 0, 2) == 7 && edgeWeight(graph, 2, 1) == 3);
+        assert(edgeWeight(graph, 0, 1) == 1 && edgeWeight(graph, 1, 0) == 1);
+        deleteBuiltGraph(graph);
+        deleteIdMap(ids);
+    }
+
+    // Dense IDs stay as they are
+    IdMap *ids;
+    Graph *graph = loadWithIds("4\n3 1 5\n0 2 6\n1 0 4\n2 3 1\n", false,
+                               2, &ids);
+    for (int v = 0; v < 4; v++)
+    {
+        assert(ids->externalIds[v] == v && getInternalId(ids, v) == v);
+    }
+    assert(edgeWeight(graph, 3, 1) == 5);
+    deleteBuiltGraph(graph);
+    deleteIdMap(ids);
+
+    // Enough sparse IDs to fill many slots of the table
+    size_t length = 0;
+    char *many;
+    FILE *f = open_memstream(&many, &length);
+    fprintf(f, "0\n");
+    for (long long i = 0; i < 20000; i++)
+    {
+        fprintf(f, "%lld %lld 1\n", 1000000000000LL + i * 1000003,
+                -(i % 777) * 4099);
+    }
+    fclose(f);
+    graph = loadWithIds(many, false, 3, &ids);
+    assert(graph != NULL && graph->numVertices == 20000 + 777);
+    for (int v = 0; v < ids->numVertices; v++)
+    {
+        assert(v == 0 || ids->externalIds[v - 1] < ids->externalIds[v]);
+        assert(getInternalId(ids, ids->externalIds[v]) == v);
+    }
+    deleteBuiltGraph(graph);
+    deleteIdMap(ids);
+    free(many);
+
+    assert(loadWithIds("2\n1 2 3\n1 x 3\n", false, 1, &ids) == NULL);
+    assert(loadWithIds("2\n1 2 -3\n", false, 1, &ids) == NULL);
+}
+
+// Helper function to check that the distance tree 'tree' of 'graph' from
+// vertex 0 has the distances of 'expected', and a predecessor on a shortest
+// path for every vertex
+void checkDistanceTree(Graph *graph, Edge *tree, Edge *expected)
+{
+    int n = graph->numVertices;
+    int *distances = malloc(sizeof(int) * n);
+    int *expectedDistances = malloc(sizeof(int) * n);
+    for (int i = 0; i < n; i++)
+    {
+        distances[tree[i].fromVertex] = tree[i].weight;
+        expectedDistances[expected[i].fromVertex] = expected[i].weight;
+        assert(i == 0 || tree[i - 1].weight <= tree[i].weight);
+    }
+    assert(tree[0].fromVertex == 0 && tree[0].weight == 0);
+    for (int i = 1; i < n; i++)
+    {
+        int v = tree[i].fromVertex;
+        int predecessor = tree[i].toVertex;
+        assert(distances[v] == expectedDistances[v]);
+        assert(distances[v] ==
+               distances[predecessor] + edgeWeight(graph, predecessor, v));
+    }
+    free(distances);
+    free(expectedDistances);
+}
+
+// Test function to verify that every shortest-path and spanning-tree engine
+// matches the binary heap, and refuses graphs whose weights it cannot take
+void testPlannedEngines()
+{
+    Graph *graph = randomUndirectedGraph(300, 3, 100);
+    int n = graph->numVertices;
+    GraphProfile profile;
+    profileGraph(graph, &profile);
+    assert(profile.numVertices == n && profile.undirected);
+    assert(profile.numArcs == graph->numEdges && !profile.uniformWeights);
+    assert(profile.minWeight >= 1 && profile.maxWeight <= 100);
+
+    Edge *expected = getDistanceTreeDijkstra(graph, 0);
+    Edge *mst = getMSTprim(graph, 0);
+    SsspEngine ssspEngines[] = {SSSP_BINARY_HEAP, SSSP_BUCKETS,
+                                SSSP_RADIX_HEAP};
+    MstEngine mstEngines[] = {MST_PRIM_HEAP, MST_PRIM_DENSE,
+                              MST_PRIM_BUCKETS};
+    for (int e = 0; e < 3; e++)
+    {
+        Plan plan = defaultPlan();
+        plan.sssp = ssspEngines[e];
+        plan.mst = mstEngines[e];
+        Edge *tree = getDistanceTreePlanned(graph, 0, &profile, &plan);
+        checkDistanceTree(graph, tree, expected);
+        free(tree);
+
+        tree = getMSTplanned(graph, 0, &profile, &plan);
+        assert(totalWeight(tree, n - 1) == totalWeight(mst, n - 1));
+        for (int i = 0; i < n - 1; i++)
+        {
+            assert(edgeWeight(graph, tree[i].fromVertex, tree[i].toVertex) ==
+                   tree[i].weight);
+        }
+        free(tree);
+    }
+    Plan plan = defaultPlan();
+    plan.sssp = SSSP_BFS;
+    assert(getDistanceTreePlanned(graph, 0, &profile, &plan) == NULL);
+    plan.sssp = SSSP_RADIX_HEAP;
+    assert(getDistanceTreePlanned(graph, n, &profile, &plan) == NULL);
+    free(expected);
+    free(mst);
+    deleteGraph(graph);
+
+    // Weights too large for buckets, then all the same for BFS
+    graph = randomUndirectedGraph(100, 10, 1);
+    graph->vertices[0]->adjList->edge->weight = BUCKET_MAX_WEIGHT;
+    profileGraph(graph, &profile);
+    assert(profile.maxWeight == BUCKET_MAX_WEIGHT && !profile.undirected);
+    plan.sssp = SSSP_BUCKETS;
+    plan.mst = MST_PRIM_BUCKETS;
+    assert(getDistanceTreePlanned(graph, 0, &profile, &plan) == NULL);
+    assert(getMSTplanned(graph, 0, &profile, &plan) == NULL);
+    graph->vertices[0]->adjList->edge->weight = 1;
+    profileGraph(graph, &profile);
+    assert(profile.uniformWeights && profile.undirected);
+    expected = getDistanceTreeDijkstra(graph, 0);
+    plan.sssp = SSSP_BFS;
+    Edge *tree = getDistanceTreePlanned(graph, 0, &profile, &plan);
+    checkDistanceTree(graph, tree, expected);
+    free(tree);
+    free(expected);
+    deleteGraph(graph);
+}
+
+// Test function to verify that many graphs are run and reported in input
+// order whatever the number of threads, including disconnected, malformed
+// and single-vertex graphs, and that a count that cannot be read ends them
+void testRunManyGraphs()
+{
+    char text[] = "4\n0 1 7 3 5\n1 0 7 2 3\n2 1 3\n3 0 5\n\n"
+                  "3\n0 1 2\n1 0 2\n2\n"
+                  "2\n0 1 x\n1\n"
+                  "1\n0\n"
+                  "not a number of vertices\n2\n0\n1\n";
+    const char *expected = "graph 0: mst 15 dijkstra 0 7 10 5\n"
+                           "graph 1: mst -1 dijkstra 0 2 -1\n"
+                           "graph 2: error at line 12\n"
+                           "graph 3: mst 0 dijkstra 0\n"
+                           "graph 4: error at line 16\n";
+    char *output;
+    size_t length;
+    long numErrors;
+    for (int threads = 1; threads <= 3; threads += 2)
+    {
+        FILE *in = fmemopen(text, strlen(text), "r");
+        FILE *out = open_memstream(&output, &length);
+        assert(runManyGraphs(in, out, threads, &numErrors) == 5);
+        fclose(in);
+        fclose(out);
+        assert(numErrors == 2);
+        assert(strcmp(output, expected) == 0);
+        free(output);
+    }
+
+    // Enough graphs to keep every thread busy, each an edge of its own weight
+    char *many;
+    size_t manyLength;
+    FILE *f = open_memstream(&many, &manyLength);
+    for (int i = 0; i < 2000; i++)
+    {
+        fprintf(f, "2\n0 1 %d\n1 0 %d\n", i + 1, i + 1);
+    }
+    fclose(f);
+    for (int threads = 1; threads <= 3; threads += 2)
+    {
+        FILE *in = fmemopen(many, manyLength, "r");
+        FILE *out = open_memstream(&output, &length);
+        assert(runManyGraphs(in, out, threads, &numErrors) == 2000);
+        fclose(in);
+        fclose(out);
+        assert(numErrors == 0);
+        char *line = output;
+        for (int i = 0; i < 2000; i++)
+        {
+            int index, weight, zero, distance, used;
+            assert(sscanf(line, "graph %d: mst %d dijkstra %d %d\n%n", &index,
+                          &weight, &zero, &distance, &used) == 4);
+            assert(index == i && weight == i + 1 && zero == 0 &&
+                   distance == i + 1);
+            line += used;
+        }
+        assert(*line == '\0');
+        free(output);
+    }
+    free(many);
+}
+
+// Test function to verify that blocked Floyd-Warshall matches Dijkstra's
+// distances on a directed graph that spans several tiles, and that its next
+// hops trace shortest paths
+void testGetAllPairsFloydWarshall()
+{
+    // Directed edges among all but the last vertex, which stays unreachable
+    int n = 2 * APSP_TILE + 22;
+    Graph *graph = newGraph(n);
+    for (int i = 0; i < n; i++)
+    {
+        graph->vertices[i] = newVertex(i, NULL, NULL);
+    }
+    for (int u = 0; u < n - 1; u++)
+    {
+        for (int v = 0; v < n - 1; v++)
+        {
+            if (u != v && rand() % 100 < 3)
+            {
+                Edge *edge = newEdge(u, v, 1 + rand() % 1000);
+                graph->vertices[u]->adjList =
+                    newEdgeList(edge, graph->vertices[u]->adjList);
+                graph->numEdges++;
+            }
+        }
+    }
+    int *all = malloc(sizeof(int) * n);
+    for (int v = 0; v < n; v++)
+    {
+        all[v] = v;
+    }
+    int64_t *exact = malloc(sizeof(int64_t) * n * n);
+    assert(getDistanceTable(graph, all, n, all, n, exact, 1));
+
+    int *path = malloc(sizeof(int) * n);
+    for (int threads = 1; threads <= 2; threads++)
+    {
+        DistanceMatrix *matrix = getAllPairsFloydWarshall(graph, threads == 2,
+                                                          threads);
+        assert(matrix->numVertices == n && matrix->stride % APSP_TILE == 0);
+        for (int u = 0; u < n; u++)
+        {
+            for (int v = 0; v < n; v++)
+            {
+                int distance = matrix->distances[u * matrix->stride + v];
+                int64_t expected = exact[u * n + v];
+                assert(expected == TABLE_UNREACHABLE
+                           ? distance == APSP_UNREACHABLE
+                           : distance == expected);
+                if (threads == 1)
+                {
+                    assert(getMatrixPath(matrix, u, v, path) == -1);
+                    continue;
+                }
+                int length = getMatrixPath(matrix, u, v, path);
+                if (expected == TABLE_UNREACHABLE)
+                {
+                    assert(length == -1);
+                    continue;
+                }
+                assert(path[0] == u && path[length - 1] == v);
+                long total = 0;
+                for (int i = 1; i < length; i++)
+                {
+                    total += edgeWeight(graph, path[i - 1], path[i]);
+                }
+                assert(total == expected);
+            }
+        }
+        deleteDistanceMatrix(matrix);
+    }
+    free(path);
+    free(exact);
+    free(all);
+    deleteGraph(graph);
+}
+
+// Helper function for testMultiQueue: a node is stale if its vertex has a
+// smaller priority in 'ctx' by now
+bool isStaleCopy(void *ctx, HeapNode node)
+{
+    int *priorities = ctx;
+    return node.priority > priorities[node.id];
+}
+
+typedef struct queue_counts
+{
+    MultiQueue *queue;
+    int *counts;  // counts[id]: the times a node with ID id was taken out
+} QueueCounts;
+
+// Helper function for testMultiQueue: inserts this part's share of 40000
+// IDs, five at a time, then takes nodes out until there are none
+void fillAndDrain(void *ctx, int thread, int numThreads)
+{
+    QueueCounts *test = ctx;
+    unsigned seed = 12345u * (thread + 1);
+    HeapNode batch[5];
+    int count = 0;
+    for (int id = thread; id < 40000; id += numThreads)
+    {
+        batch[count].priority = id % 1000;
+        batch[count++].id = id;
+        if (count == 5 || id + numThreads >= 40000)
+        {
+            assert(multiQueueInsertMany(test->queue, batch, count, &seed));
+            count = 0;
+        }
+    }
+    HeapNode node;
+    int numDropped;
+    while (multiQueueExtractMin(test->queue, &node, &seed, &numDropped))
+    {
+        assert(numDropped == 0);
+        __atomic_add_fetch(&test->counts[node.id], 1, __ATOMIC_RELAXED);
+    }
+}
+
+// Test function to verify that a MultiQueue hands out every node once, also
+// with several threads, drops stale copies, and that the parallel Dijkstra
+// search built on it finds the same distances as Dijkstra's algorithm
+void testMultiQueue()
+{
+    // One thread: stale copies are dropped and counted, fresh ones returned
+    int priorities[100];
+    MultiQueue *queue = newMultiQueue(1, isStaleCopy, priorities);
+    unsigned seed = 1;
+    for (int id = 0; id < 100; id++)
+    {
+        priorities[id] = 1000 + id;
+        assert(multiQueueInsert(queue, priorities[id], id, &seed));
+    }
+    for (int id = 0; id < 100; id += 2)
+    {
+        priorities[id] = id;
+        assert(multiQueueInsert(queue, priorities[id], id, &seed));
+    }
+    int seen[100] = {0};
+    int totalDropped = 0;
+    HeapNode node;
+    int numDropped;
+    while (multiQueueExtractMin(queue, &node, &seed, &numDropped))
+    {
+        totalDropped += numDropped;
+        assert(node.priority == priorities[node.id]);
+        seen[node.id]++;
+    }
+    totalDropped += numDropped;
+    assert(totalDropped == 50);
+    for (int id = 0; id < 100; id++)
+    {
+        assert(seen[id] == 1);
+    }
+    deleteMultiQueue(queue);
+
+    // Four threads filling and draining one queue at the same time
+    QueueCounts test;
+    test.queue = newMultiQueue(4, NULL, NULL);
+    test.counts = calloc(40000, sizeof(int));
+    runThreads(4, fillAndDrain, &test);
+    for (int id = 0; id < 40000; id++)
+    {
+        assert(test.counts[id] == 1);
+    }
+    free(test.counts);
+    deleteMultiQueue(test.queue);
+
+    Graph *graph = randomUndirectedGraph(400, 2, 1000);
+    Edge *expected = getDistanceTreeDijkstra(graph, 0);
+    for (int threads = 1; threads <= 4; threads *= 2)
+    {
+        SearchStats stats;
+        Edge *tree = getDistanceTreeMultiQueue(graph, 0, threads, &stats);
+        checkDistanceTree(graph, tree, expected);
+        assert(stats.settles == stats.pops - stats.stalePops);
+        assert(stats.settles >= graph->numVertices);
+        free(tree);
+    }
+    assert(getDistanceTreeMultiQueue(graph, 400, 2, NULL) == NULL);
+    free(expected);
+    deleteGraph(graph);
+}
+
+// Helper function to check Dijkstra's and Prim's algorithms on 'compact',
+// a compact copy of 'graph', against the distances in 'exact' from vertex 0
+// and the weight 'mstWeight' of the spanning tree from it
+void checkCompactGraph(Graph *graph, CompactGraph *compact, int64_t *exact,
+                       int64_t mstWeight)
+{
+    int n = graph->numVertices;
+    int64_t *distances = malloc(sizeof(int64_t) * n);
+    int *predecessors = malloc(sizeof(int) * n);
+    assert(getDistancesCompact(compact, 0, distances, predecessors));
+    assert(predecessors[0] == -1);
+    for (int v = 0; v < n; v++)
+    {
+        bool reachable = exact[v] != TABLE_UNREACHABLE;
+        assert(distances[v] ==
+               (reachable ? exact[v] : (int64_t)COMPACT_UNREACHABLE));
+        if (v > 0 && reachable)
+        {
+            int p = predecessors[v];
+            assert(distances[v] == distances[p] + edgeWeight(graph, p, v));
+        }
+        else if (v > 0)
+        {
+            assert(predecessors[v] == -1);
+        }
+    }
+    int64_t total = getSpanningTreeCompact(compact, 0, predecessors);
+    assert(total == mstWeight);
+    int64_t edgesTotal = 0;
+    for (int v = 1; v < n; v++)
+    {
+        if (predecessors[v] != -1)
+        {
+            edgesTotal += edgeWeight(graph, predecessors[v], v);
+        }
+    }
+    assert(edgesTotal == total);
+    assert(!getDistancesCompact(compact, n, distances, predecessors));
+    assert(getSpanningTreeCompact(compact, -1, predecessors) == -1);
+    free(distances);
+    free(predecessors);
+}
+
+// Test function to verify that every compact layout a graph fits gives
+// Dijkstra's distances and Prim's tree weight, that the narrowest one is
+// picked, and that distances past INT_MAX and unreachable vertices are kept
+void testCompactGraphs()
+{
+    Graph *graph = randomUndirectedGraph(300, 2, 1000);
+    int n = graph->numVertices;
+    int sources[] = {0};
+    int *all = malloc(sizeof(int) * n);
+    for (int v = 0; v < n; v++)
+    {
+        all[v] = v;
+    }
+    int64_t *exact = malloc(sizeof(int64_t) * n);
+    assert(getDistanceTable(graph, sources, 1, all, n, exact, 1));
+    Edge *mst = getMSTprim(graph, 0);
+    int64_t mstWeight = totalWeight(mst, n - 1);
+
+    CompactGraph *compact = newCompactGraph(graph, COMPACT_NARROWEST);
+    assert(compact->layout == COMPACT_ID16_W16_D32);
+    assert(compact->numArcs == graph->numEdges);
+    deleteCompactGraph(compact);
+    for (CompactLayout layout = COMPACT_ID16_W16_D32;
+         layout <= COMPACT_ID32_W32_D64; layout++)
+    {
+        compact = newCompactGraph(graph, layout);
+        assert(compact != NULL && compact->layout == layout);
+        checkCompactGraph(graph, compact, exact, mstWeight);
+        deleteCompactGraph(compact);
+    }
+    free(mst);
+    free(exact);
+    free(all);
+    deleteGraph(graph);
+
+    // 0 -- 1 -- 2 -- 3 with weights that only fit 32 bits, and paths that
+    // only fit 64, and 4 on its own
+    graph = newGraph(5);
+    for (int i = 0; i < graph->numVertices; i++)
+    {
+        graph->vertices[i] = newVertex(i, NULL, NULL);
+    }
+    for (int v = 0; v < 3; v++)
+    {
+        addUndirectedEdge(graph, v, v + 1, INT_MAX - 1);
+    }
+    compact = newCompactGraph(graph, COMPACT_NARROWEST);
+    assert(compact->layout == COMPACT_ID32_W32_D64);
+    int64_t expected[] = {0, INT_MAX - 1, 2 * (int64_t)(INT_MAX - 1),
+                          3 * (int64_t)(INT_MAX - 1), TABLE_UNREACHABLE};
+    checkCompactGraph(graph, compact, expected, expected[3]);
+    deleteCompactGraph(compact);
+    assert(newCompactGraph(graph, COMPACT_ID16_W16_D32) == NULL);
+    assert(newCompactGraph(graph, COMPACT_ID32_W32_D32) == NULL);
+    graph->vertices[0]->adjList->edge->weight = -1;
+    assert(newCompactGraph(graph, COMPACT_NARROWEST) == NULL);
+    deleteGraph(graph);
+}
+
 int main()
 {
+    testGetMSTprimDense();
+    testGetDistanceTreeBFS();
+    testSymmetricGraph();
+    testBuildHeap();
+    testGetDistanceTable();
+    testPairingHeaps();
+    testGraphServer();
+    testRunQueries();
+    testGraphSnapshots();
+    testScheduler();
+    testDistanceOracle();
+    testGetMSTexternal();
+    testHubLabels();
+    testGetKShortestPaths();
+    testGraphWithIds();
+    testPlannedEngines();
+    testRunManyGraphs();
+    testGetAllPairsFloydWarshall();
+    testMultiQueue();
+    testCompactGraphs();
+
     Graph *graph = newGraph(4);
 
     // Initialize vertices